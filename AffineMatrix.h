@@ -0,0 +1,202 @@
+#pragma once
+#include <cmath>
+
+#include "MathTypes.h"
+
+/// <summary>
+/// AffineMatrixBaseが表す変換の種類
+/// </summary>
+enum class AffineKind {
+    General, // 拡縮(不均一も可)、回転、移動
+    Rigid, // 回転と移動だけ。線形部分が直交行列なので、逆行列は転置で求まる
+};
+
+/// <summary>
+/// 4列目が常に(0, 0, 0, 1)の行列を、その列を省いた4行3列で持つ。並びはMatrix4x4と同じ行ベクトル形式で、m[3]が移動
+/// 合成は36回、逆行列はGeneralで3x3の余因子、Rigidで転置の乗算で済み、1つあたり48byteで持てる
+/// Matrix4x4にするのはGPUに送るときと、透視投影のような一般の行列とかけるときだけにする
+/// </summary>
+template<AffineKind Kind>
+struct AffineMatrixBase {
+    float m[4][3];
+};
+
+using AffineMatrix = AffineMatrixBase<AffineKind::General>;
+using RigidTransform = AffineMatrixBase<AffineKind::Rigid>;
+
+/// <summary>
+/// 2つを合成したときの種類。どちらかがGeneralならGeneral
+/// </summary>
+template<AffineKind Kind1, AffineKind Kind2>
+constexpr AffineKind kComposedAffineKind = (Kind1 == AffineKind::Rigid && Kind2 == AffineKind::Rigid) ? AffineKind::Rigid : AffineKind::General;
+
+template<AffineKind Kind>
+constexpr AffineMatrixBase<Kind> MakeIdentityAffine()
+{
+    return { { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, 0.0f } } };
+}
+
+/// <summary>
+/// RigidTransformをAffineMatrixとして扱う
+/// </summary>
+constexpr AffineMatrix ToAffineMatrix(const RigidTransform& rigid)
+{
+    return { {
+        { rigid.m[0][0], rigid.m[0][1], rigid.m[0][2] },
+        { rigid.m[1][0], rigid.m[1][1], rigid.m[1][2] },
+        { rigid.m[2][0], rigid.m[2][1], rigid.m[2][2] },
+        { rigid.m[3][0], rigid.m[3][1], rigid.m[3][2] },
+    } };
+}
+
+/// <summary>
+/// 省いていた4列目を足したMatrix4x4
+/// </summary>
+template<AffineKind Kind>
+constexpr Matrix4x4 ToMatrix4x4(const AffineMatrixBase<Kind>& affine)
+{
+    return {
+        affine.m[0][0], affine.m[0][1], affine.m[0][2], 0.0f,
+        affine.m[1][0], affine.m[1][1], affine.m[1][2], 0.0f,
+        affine.m[2][0], affine.m[2][1], affine.m[2][2], 0.0f,
+        affine.m[3][0], affine.m[3][1], affine.m[3][2], 1.0f,
+    };
+}
+
+/// <summary>
+/// m1 * m2。線形部分の27回と移動の9回で36回の乗算
+/// </summary>
+template<AffineKind Kind1, AffineKind Kind2>
+constexpr AffineMatrixBase<kComposedAffineKind<Kind1, Kind2>> Multiply(const AffineMatrixBase<Kind1>& m1, const AffineMatrixBase<Kind2>& m2)
+{
+    AffineMatrixBase<kComposedAffineKind<Kind1, Kind2>> result;
+    result.m[0][0] = m1.m[0][0] * m2.m[0][0] + m1.m[0][1] * m2.m[1][0] + m1.m[0][2] * m2.m[2][0];
+    result.m[0][1] = m1.m[0][0] * m2.m[0][1] + m1.m[0][1] * m2.m[1][1] + m1.m[0][2] * m2.m[2][1];
+    result.m[0][2] = m1.m[0][0] * m2.m[0][2] + m1.m[0][1] * m2.m[1][2] + m1.m[0][2] * m2.m[2][2];
+
+    result.m[1][0] = m1.m[1][0] * m2.m[0][0] + m1.m[1][1] * m2.m[1][0] + m1.m[1][2] * m2.m[2][0];
+    result.m[1][1] = m1.m[1][0] * m2.m[0][1] + m1.m[1][1] * m2.m[1][1] + m1.m[1][2] * m2.m[2][1];
+    result.m[1][2] = m1.m[1][0] * m2.m[0][2] + m1.m[1][1] * m2.m[1][2] + m1.m[1][2] * m2.m[2][2];
+
+    result.m[2][0] = m1.m[2][0] * m2.m[0][0] + m1.m[2][1] * m2.m[1][0] + m1.m[2][2] * m2.m[2][0];
+    result.m[2][1] = m1.m[2][0] * m2.m[0][1] + m1.m[2][1] * m2.m[1][1] + m1.m[2][2] * m2.m[2][1];
+    result.m[2][2] = m1.m[2][0] * m2.m[0][2] + m1.m[2][1] * m2.m[1][2] + m1.m[2][2] * m2.m[2][2];
+
+    result.m[3][0] = m1.m[3][0] * m2.m[0][0] + m1.m[3][1] * m2.m[1][0] + m1.m[3][2] * m2.m[2][0] + m2.m[3][0];
+    result.m[3][1] = m1.m[3][0] * m2.m[0][1] + m1.m[3][1] * m2.m[1][1] + m1.m[3][2] * m2.m[2][1] + m2.m[3][1];
+    result.m[3][2] = m1.m[3][0] * m2.m[0][2] + m1.m[3][1] * m2.m[1][2] + m1.m[3][2] * m2.m[2][2] + m2.m[3][2];
+    return result;
+}
+
+/// <summary>
+/// m1 * m2 (m2は透視投影などの一般の行列)。m1の4列目が(0, 0, 0, 1)なので48回の乗算で済む
+/// </summary>
+template<AffineKind Kind>
+constexpr Matrix4x4 Multiply(const AffineMatrixBase<Kind>& m1, const Matrix4x4& m2)
+{
+    Matrix4x4 result;
+    result.m[0][0] = m1.m[0][0] * m2.m[0][0] + m1.m[0][1] * m2.m[1][0] + m1.m[0][2] * m2.m[2][0];
+    result.m[0][1] = m1.m[0][0] * m2.m[0][1] + m1.m[0][1] * m2.m[1][1] + m1.m[0][2] * m2.m[2][1];
+    result.m[0][2] = m1.m[0][0] * m2.m[0][2] + m1.m[0][1] * m2.m[1][2] + m1.m[0][2] * m2.m[2][2];
+    result.m[0][3] = m1.m[0][0] * m2.m[0][3] + m1.m[0][1] * m2.m[1][3] + m1.m[0][2] * m2.m[2][3];
+
+    result.m[1][0] = m1.m[1][0] * m2.m[0][0] + m1.m[1][1] * m2.m[1][0] + m1.m[1][2] * m2.m[2][0];
+    result.m[1][1] = m1.m[1][0] * m2.m[0][1] + m1.m[1][1] * m2.m[1][1] + m1.m[1][2] * m2.m[2][1];
+    result.m[1][2] = m1.m[1][0] * m2.m[0][2] + m1.m[1][1] * m2.m[1][2] + m1.m[1][2] * m2.m[2][2];
+    result.m[1][3] = m1.m[1][0] * m2.m[0][3] + m1.m[1][1] * m2.m[1][3] + m1.m[1][2] * m2.m[2][3];
+
+    result.m[2][0] = m1.m[2][0] * m2.m[0][0] + m1.m[2][1] * m2.m[1][0] + m1.m[2][2] * m2.m[2][0];
+    result.m[2][1] = m1.m[2][0] * m2.m[0][1] + m1.m[2][1] * m2.m[1][1] + m1.m[2][2] * m2.m[2][1];
+    result.m[2][2] = m1.m[2][0] * m2.m[0][2] + m1.m[2][1] * m2.m[1][2] + m1.m[2][2] * m2.m[2][2];
+    result.m[2][3] = m1.m[2][0] * m2.m[0][3] + m1.m[2][1] * m2.m[1][3] + m1.m[2][2] * m2.m[2][3];
+
+    result.m[3][0] = m1.m[3][0] * m2.m[0][0] + m1.m[3][1] * m2.m[1][0] + m1.m[3][2] * m2.m[2][0] + m2.m[3][0];
+    result.m[3][1] = m1.m[3][0] * m2.m[0][1] + m1.m[3][1] * m2.m[1][1] + m1.m[3][2] * m2.m[2][1] + m2.m[3][1];
+    result.m[3][2] = m1.m[3][0] * m2.m[0][2] + m1.m[3][1] * m2.m[1][2] + m1.m[3][2] * m2.m[2][2] + m2.m[3][2];
+    result.m[3][3] = m1.m[3][0] * m2.m[0][3] + m1.m[3][1] * m2.m[1][3] + m1.m[3][2] * m2.m[2][3] + m2.m[3][3];
+    return result;
+}
+
+/// <summary>
+/// 逆行列。Rigidなら回転を転置して移動を戻すだけ、Generalなら3x3の線形部分を余因子で反転する
+/// Generalで線形部分の行列式が0なら結果は無限大かNaNになる
+/// </summary>
+template<AffineKind Kind>
+constexpr AffineMatrixBase<Kind> Inverse(const AffineMatrixBase<Kind>& m)
+{
+    AffineMatrixBase<Kind> result;
+    if constexpr (Kind == AffineKind::Rigid) {
+        // clang-format off
+        result.m[0][0] = m.m[0][0]; result.m[0][1] = m.m[1][0]; result.m[0][2] = m.m[2][0];
+        result.m[1][0] = m.m[0][1]; result.m[1][1] = m.m[1][1]; result.m[1][2] = m.m[2][1];
+        result.m[2][0] = m.m[0][2]; result.m[2][1] = m.m[1][2]; result.m[2][2] = m.m[2][2];
+        // clang-format on
+    } else {
+        // clang-format off
+        float cofactor00 = m.m[1][1] * m.m[2][2] - m.m[1][2] * m.m[2][1];
+        float cofactor01 = m.m[1][2] * m.m[2][0] - m.m[1][0] * m.m[2][2];
+        float cofactor02 = m.m[1][0] * m.m[2][1] - m.m[1][1] * m.m[2][0];
+        float recpDeterminant = 1.0f / (m.m[0][0] * cofactor00 + m.m[0][1] * cofactor01 + m.m[0][2] * cofactor02);
+        result.m[0][0] = cofactor00 * recpDeterminant;
+        result.m[0][1] = (m.m[0][2] * m.m[2][1] - m.m[0][1] * m.m[2][2]) * recpDeterminant;
+        result.m[0][2] = (m.m[0][1] * m.m[1][2] - m.m[0][2] * m.m[1][1]) * recpDeterminant;
+        result.m[1][0] = cofactor01 * recpDeterminant;
+        result.m[1][1] = (m.m[0][0] * m.m[2][2] - m.m[0][2] * m.m[2][0]) * recpDeterminant;
+        result.m[1][2] = (m.m[0][2] * m.m[1][0] - m.m[0][0] * m.m[1][2]) * recpDeterminant;
+        result.m[2][0] = cofactor02 * recpDeterminant;
+        result.m[2][1] = (m.m[0][1] * m.m[2][0] - m.m[0][0] * m.m[2][1]) * recpDeterminant;
+        result.m[2][2] = (m.m[0][0] * m.m[1][1] - m.m[0][1] * m.m[1][0]) * recpDeterminant;
+        // clang-format on
+    }
+    // 移動は反転した線形部分で戻す
+    result.m[3][0] = -(m.m[3][0] * result.m[0][0] + m.m[3][1] * result.m[1][0] + m.m[3][2] * result.m[2][0]);
+    result.m[3][1] = -(m.m[3][0] * result.m[0][1] + m.m[3][1] * result.m[1][1] + m.m[3][2] * result.m[2][1]);
+    result.m[3][2] = -(m.m[3][0] * result.m[0][2] + m.m[3][1] * result.m[1][2] + m.m[3][2] * result.m[2][2]);
+    return result;
+}
+
+/// <summary>
+/// 点(w = 1)を変換する
+/// </summary>
+template<AffineKind Kind>
+constexpr Vector3 TransformPoint(const Vector3& point, const AffineMatrixBase<Kind>& m)
+{
+    return {
+        point.x * m.m[0][0] + point.y * m.m[1][0] + point.z * m.m[2][0] + m.m[3][0],
+        point.x * m.m[0][1] + point.y * m.m[1][1] + point.z * m.m[2][1] + m.m[3][1],
+        point.x * m.m[0][2] + point.y * m.m[1][2] + point.z * m.m[2][2] + m.m[3][2],
+    };
+}
+
+/// <summary>
+/// X→Y→Zの順の回転行列を展開して作る
+/// </summary>
+inline RigidTransform MakeRigidTransform(const Vector3& rotate, const Vector3& translate)
+{
+    float sinX = std::sin(rotate.x);
+    float cosX = std::cos(rotate.x);
+    float sinY = std::sin(rotate.y);
+    float cosY = std::cos(rotate.y);
+    float sinZ = std::sin(rotate.z);
+    float cosZ = std::cos(rotate.z);
+    return { {
+        { cosY * cosZ, cosY * sinZ, -sinY },
+        { sinX * sinY * cosZ - cosX * sinZ, sinX * sinY * sinZ + cosX * cosZ, sinX * cosY },
+        { cosX * sinY * cosZ + sinX * sinZ, cosX * sinY * sinZ - sinX * cosZ, cosX * cosY },
+        { translate.x, translate.y, translate.z },
+    } };
+}
+
+/// <summary>
+/// MakeAffineMatrixと同じ拡縮→X→Y→Z回転→移動の行列
+/// </summary>
+inline AffineMatrix MakeAffineTransform(const Vector3& scale, const Vector3& rotate, const Vector3& translate)
+{
+    RigidTransform rigid = MakeRigidTransform(rotate, translate);
+    return { {
+        { rigid.m[0][0] * scale.x, rigid.m[0][1] * scale.x, rigid.m[0][2] * scale.x },
+        { rigid.m[1][0] * scale.y, rigid.m[1][1] * scale.y, rigid.m[1][2] * scale.y },
+        { rigid.m[2][0] * scale.z, rigid.m[2][1] * scale.z, rigid.m[2][2] * scale.z },
+        { rigid.m[3][0], rigid.m[3][1], rigid.m[3][2] },
+    } };
+}
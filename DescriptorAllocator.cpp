@@ -0,0 +1,128 @@
+#include "DescriptorAllocator.h"
+
+#include <algorithm>
+#include <cassert>
+
+void DescriptorAllocator::Initialize(uint32_t capacity, uint32_t persistentCount)
+{
+    assert(persistentCount <= capacity);
+    persistentCount_ = persistentCount;
+    freeCount_ = persistentCount;
+    freeRanges_.clear();
+    if (persistentCount != 0) {
+        freeRanges_.push_back({ 0, persistentCount });
+    }
+    frameFrees_.clear();
+    pendingFrees_.clear();
+    transientRing_.Initialize(capacity - persistentCount);
+}
+
+uint32_t DescriptorAllocator::AllocatePersistent(uint32_t count)
+{
+    if (count == 0) {
+        return kInvalidIndex;
+    }
+    for (size_t i = 0; i < freeRanges_.size(); ++i) {
+        DescriptorRange& range = freeRanges_[i];
+        if (range.count < count) {
+            continue;
+        }
+        uint32_t index = range.begin;
+        range.begin += count;
+        range.count -= count;
+        if (range.count == 0) {
+            freeRanges_.erase(freeRanges_.begin() + i);
+        }
+        freeCount_ -= count;
+        return index;
+    }
+    return kInvalidIndex;
+}
+
+void DescriptorAllocator::FreePersistent(uint32_t index, uint32_t count)
+{
+    assert(count != 0 && index + count <= persistentCount_);
+    frameFrees_.push_back({ index, count });
+}
+
+uint32_t DescriptorAllocator::AllocateTransient(uint32_t count)
+{
+    uint64_t offset = transientRing_.Allocate(count, 1);
+    if (offset == UploadRingAllocator::kInvalidOffset) {
+        return kInvalidIndex;
+    }
+    return persistentCount_ + static_cast<uint32_t>(offset);
+}
+
+void DescriptorAllocator::FinishFrame(uint64_t fenceValue)
+{
+    for (const DescriptorRange& range : frameFrees_) {
+        pendingFrees_.push_back({ range, fenceValue });
+    }
+    frameFrees_.clear();
+    transientRing_.FinishFrame(fenceValue);
+}
+
+void DescriptorAllocator::Retire(uint64_t completedFenceValue)
+{
+    size_t retiredCount = 0;
+    while (retiredCount < pendingFrees_.size() && pendingFrees_[retiredCount].fenceValue <= completedFenceValue) {
+        InsertFreeRange(pendingFrees_[retiredCount].range);
+        ++retiredCount;
+    }
+    pendingFrees_.erase(pendingFrees_.begin(), pendingFrees_.begin() + retiredCount);
+    transientRing_.Retire(completedFenceValue);
+}
+
+uint32_t DescriptorAllocator::GetPendingFreeCount() const
+{
+    uint32_t count = 0;
+    for (const DescriptorRange& range : frameFrees_) {
+        count += range.count;
+    }
+    for (const PendingFree& pending : pendingFrees_) {
+        count += pending.range.count;
+    }
+    return count;
+}
+
+uint32_t DescriptorAllocator::GetLargestFreeRange() const
+{
+    uint32_t largest = 0;
+    for (const DescriptorRange& range : freeRanges_) {
+        largest = (std::max)(largest, range.count);
+    }
+    return largest;
+}
+
+float DescriptorAllocator::GetFragmentation() const
+{
+    if (freeCount_ == 0) {
+        return 0.0f;
+    }
+    return 1.0f - static_cast<float>(GetLargestFreeRange()) / static_cast<float>(freeCount_);
+}
+
+void DescriptorAllocator::InsertFreeRange(DescriptorRange range)
+{
+    auto next = std::lower_bound(freeRanges_.begin(), freeRanges_.end(), range.begin,
+        [](const DescriptorRange& freeRange, uint32_t begin) { return freeRange.begin < begin; });
+    // 二重解放や確保していない範囲の解放は、空きと重なる
+    assert(next == freeRanges_.end() || range.begin + range.count <= next->begin);
+    assert(next == freeRanges_.begin() || (next - 1)->begin + (next - 1)->count <= range.begin);
+    freeCount_ += range.count;
+
+    bool mergePrev = next != freeRanges_.begin() && (next - 1)->begin + (next - 1)->count == range.begin;
+    bool mergeNext = next != freeRanges_.end() && range.begin + range.count == next->begin;
+    if (mergePrev && mergeNext) {
+        (next - 1)->count += range.count + next->count;
+        freeRanges_.erase(next);
+    } else if (mergePrev) {
+        (next - 1)->count += range.count;
+    } else if (mergeNext) {
+        next->begin = range.begin;
+        next->count += range.count;
+    } else {
+        freeRanges_.insert(next, range);
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include "UploadRing.h"
+
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// 1つのDescriptorHeapの番号(ヒープ先頭からのインデックス)を管理する。デバイスには触れない
+/// [0, persistentCount)は長く使うSRVなどの永続領域で、空きリストから確保して解放する
+/// [persistentCount, capacity)はフレームごとに作り捨てるDescriptorTable用の領域で、リングバッファとして先頭から順に切り出す
+/// 解放した永続領域とフレームで切り出したリング領域は、そのフレームのSignal値にGPUが届くまで再利用しない
+/// </summary>
+class DescriptorAllocator {
+public:
+    static constexpr uint32_t kInvalidIndex = UINT32_MAX;
+
+    /// <summary>
+    /// capacity個のヒープのうち、先頭のpersistentCount個を永続領域、残りをフレームごとの領域にして空にする
+    /// </summary>
+    void Initialize(uint32_t capacity, uint32_t persistentCount);
+
+    /// <summary>
+    /// 永続領域から連続したcount個を確保し、最初の番号を返す。収まる空きがなければkInvalidIndex
+    /// 空きのうち最も先頭に近いものから切り出す
+    /// </summary>
+    uint32_t AllocatePersistent(uint32_t count = 1);
+
+    /// <summary>
+    /// AllocatePersistentで確保した範囲を解放する。今のフレームまではGPUが使っているかもしれないので、
+    /// 空きに戻すのはFinishFrameで渡したSignal値にGPUが届いた後
+    /// </summary>
+    void FreePersistent(uint32_t index, uint32_t count = 1);
+
+    /// <summary>
+    /// 今のフレーム用にフレームごとの領域から連続したcount個を切り出し、最初の番号を返す
+    /// 末尾に収まらなければ先頭から切り出す。GPUが使い終わっていない範囲に重なるならkInvalidIndex
+    /// </summary>
+    uint32_t AllocateTransient(uint32_t count);
+
+    /// <summary>
+    /// 今のフレームで解放・切り出した範囲を、GPUがfenceValueに届くまで使うものとして閉じる
+    /// </summary>
+    void FinishFrame(uint64_t fenceValue);
+
+    /// <summary>
+    /// GPUがcompletedFenceValueまで届いたので、それまでに閉じたフレームの範囲を再利用できるようにする
+    /// </summary>
+    void Retire(uint64_t completedFenceValue);
+
+    uint32_t GetCapacity() const { return persistentCount_ + static_cast<uint32_t>(transientRing_.GetCapacity()); }
+    uint32_t GetPersistentCount() const { return persistentCount_; }
+    uint32_t GetTransientCount() const { return static_cast<uint32_t>(transientRing_.GetCapacity()); }
+
+    /// <summary>
+    /// 永続領域で確保中の数(解放してGPUを待っている分を含む)
+    /// </summary>
+    uint32_t GetPersistentUsedCount() const { return persistentCount_ - freeCount_; }
+
+    /// <summary>
+    /// 解放してGPUが使い終わるのを待っている数
+    /// </summary>
+    uint32_t GetPendingFreeCount() const;
+
+    /// <summary>
+    /// 永続領域の最も大きい連続した空きの数
+    /// </summary>
+    uint32_t GetLargestFreeRange() const;
+
+    /// <summary>
+    /// 永続領域の空きの断片化の度合い。1 - 最大の連続した空き / 空きの合計で、空きが1か所にまとまっていれば0
+    /// </summary>
+    float GetFragmentation() const;
+
+    /// <summary>
+    /// フレームごとの領域でGPUが使い終わっていない数と今のフレームの数(折り返しで飛ばした末尾を含む)
+    /// </summary>
+    uint32_t GetTransientUsedCount() const { return static_cast<uint32_t>(transientRing_.GetUsedSize()); }
+
+private:
+    /// <summary>
+    /// 連続した番号の範囲
+    /// </summary>
+    struct DescriptorRange {
+        uint32_t begin;
+        uint32_t count;
+    };
+
+    /// <summary>
+    /// 解放した範囲。GPUがfenceValueに届いたら空きに戻す
+    /// </summary>
+    struct PendingFree {
+        DescriptorRange range;
+        uint64_t fenceValue;
+    };
+
+    /// <summary>
+    /// 空きリストに範囲を戻し、前後の空きとつなげる
+    /// </summary>
+    void InsertFreeRange(DescriptorRange range);
+
+    uint32_t persistentCount_ = 0; //!< 永続領域の数
+    uint32_t freeCount_ = 0; //!< 永続領域の空きの合計(GPUを待っている分は含まない)
+    std::vector<DescriptorRange> freeRanges_; //!< 永続領域の空き。先頭に近い順で、隣り合う空きはつなげておく
+    std::vector<DescriptorRange> frameFrees_; //!< 今のフレームで解放した範囲
+    std::vector<PendingFree> pendingFrees_; //!< GPUが使い終わるのを待っている範囲。古い順
+    UploadRingAllocator transientRing_; //!< フレームごとの領域での番号(persistentCount_からのずれ)を切り出す
+};
@@ -0,0 +1,100 @@
+#include "DrawPacket.h"
+
+#include <algorithm>
+#include <cassert>
+
+uint64_t MakeDrawSortKey(uint32_t pass, uint32_t pipeline, uint32_t texture, uint32_t material, uint32_t depthBucket)
+{
+    assert(pass < (1u << 4) && pipeline < (1u << 12) && texture < (1u << 16) && material < (1u << 16) && depthBucket < (1u << 16));
+    return (static_cast<uint64_t>(pass) << 60) | (static_cast<uint64_t>(pipeline) << 48) |
+        (static_cast<uint64_t>(texture) << 32) | (static_cast<uint64_t>(material) << 16) | static_cast<uint64_t>(depthBucket);
+}
+
+uint32_t QuantizeDrawDepth(float viewDepth, float nearClip, float farClip)
+{
+    float t = (viewDepth - nearClip) / (farClip - nearClip);
+    t = (std::clamp)(t, 0.0f, 1.0f);
+    return static_cast<uint32_t>(t * 65535.0f + 0.5f);
+}
+
+void DrawQueue::Clear()
+{
+    packets_.clear();
+}
+
+void DrawQueue::Add(const DrawPacket& packet)
+{
+    packets_.push_back(packet);
+}
+
+void DrawQueue::Sort()
+{
+    const size_t count = packets_.size();
+    keys_.resize(count);
+    order_.resize(count);
+    scratchKeys_.resize(count);
+    scratchOrder_.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        keys_[i] = packets_[i].sortKey;
+        order_[i] = static_cast<uint32_t>(i);
+    }
+
+    // 全ての桁のヒストグラムを1回の走査で数える
+    uint32_t histograms[8][256] = {};
+    for (uint64_t key : keys_) {
+        for (uint32_t digit = 0; digit < 8; ++digit) {
+            ++histograms[digit][(key >> (digit * 8)) & 0xFF];
+        }
+    }
+
+    // 下位の桁から安定に分配する。全ての描画で同じ値の桁は並びが変わらないので飛ばす
+    uint32_t sortedDigitCount = 0;
+    for (uint32_t digit = 0; digit < 8; ++digit) {
+        uint32_t* histogram = histograms[digit];
+        if (count == 0 || histogram[(keys_[0] >> (digit * 8)) & 0xFF] == count) {
+            continue;
+        }
+        uint32_t offset = 0;
+        for (uint32_t bucket = 0; bucket < 256; ++bucket) {
+            uint32_t bucketCount = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketCount;
+        }
+        const uint32_t shift = digit * 8;
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t destination = histogram[(keys_[i] >> shift) & 0xFF]++;
+            scratchKeys_[destination] = keys_[i];
+            scratchOrder_[destination] = order_[i];
+        }
+        keys_.swap(scratchKeys_);
+        order_.swap(scratchOrder_);
+        ++sortedDigitCount;
+    }
+
+    // 前の描画と比べて変わった状態を調べる
+    commands_.resize(count);
+    stats_ = {};
+    stats_.drawCount = static_cast<uint32_t>(count);
+    stats_.sortedDigitCount = sortedDigitCount;
+    stats_.naiveStateChangeCount = static_cast<uint32_t>(count) * kDrawStateCount;
+    const DrawPacket* previous = nullptr;
+    for (size_t i = 0; i < count; ++i) {
+        const DrawPacket& packet = packets_[order_[i]];
+        uint32_t changedStates = kDrawStateAll;
+        if (previous != nullptr) {
+            changedStates = (packet.pipeline != previous->pipeline ? kDrawStatePipeline : 0u) |
+                (packet.geometry != previous->geometry ? kDrawStateGeometry : 0u) |
+                (packet.material != previous->material ? kDrawStateMaterial : 0u) |
+                (packet.transform != previous->transform ? kDrawStateTransform : 0u) |
+                (packet.texture != previous->texture ? kDrawStateTexture : 0u);
+        }
+        commands_[i] = { order_[i], changedStates };
+        for (uint32_t state = 0; state < kDrawStateCount; ++state) {
+            stats_.stateChanges[state] += (changedStates >> state) & 1u;
+        }
+        previous = &packet;
+    }
+    for (uint32_t state = 0; state < kDrawStateCount; ++state) {
+        stats_.stateChangeCount += stats_.stateChanges[state];
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// 描画の状態の種類。DrawCommand::changedStatesで、前の描画から変わったものを表す
+constexpr uint32_t kDrawStatePipeline = 1u << 0; // PSO
+constexpr uint32_t kDrawStateGeometry = 1u << 1; // VBVとIBV
+constexpr uint32_t kDrawStateMaterial = 1u << 2; // マテリアルのCBuffer
+constexpr uint32_t kDrawStateTransform = 1u << 3; // TransformationMatrixのCBuffer
+constexpr uint32_t kDrawStateTexture = 1u << 4; // SRVのDescriptorTable
+constexpr uint32_t kDrawStateCount = 5;
+constexpr uint32_t kDrawStateAll = (1u << kDrawStateCount) - 1;
+
+/// <summary>
+/// 1回の描画。状態はデバイスのオブジェクトではなく、使う側が持つ表の番号で表す
+/// </summary>
+struct DrawPacket {
+    uint64_t sortKey; // MakeDrawSortKeyで作る。小さい順に描く
+    uint32_t pipeline;
+    uint32_t geometry;
+    uint32_t material;
+    uint32_t transform;
+    uint32_t texture;
+    uint32_t indexStart;
+    uint32_t indexCount;
+    uint32_t instanceCount = 1; // transformの配列から読むインスタンスの数
+};
+
+/// <summary>
+/// 上位からパス(4bit)、PSO(12bit)、Texture(16bit)、マテリアル(16bit)、深度(16bit)を詰めたキー
+/// 小さい順に並べると、パスの中で切り替えの重い状態ほどまとまり、同じ状態の中では深度の小さい順になる
+/// </summary>
+uint64_t MakeDrawSortKey(uint32_t pass, uint32_t pipeline, uint32_t texture, uint32_t material, uint32_t depthBucket);
+
+/// <summary>
+/// カメラからの距離をnearClip~farClipで16bitの深度に量子化する。範囲外は端に丸める
+/// 奥から描きたいパスでは0xFFFFから引いて使う
+/// </summary>
+uint32_t QuantizeDrawDepth(float viewDepth, float nearClip, float farClip);
+
+/// <summary>
+/// 並べた後の1回の描画。changedStatesのものだけ設定し直してから描く
+/// </summary>
+struct DrawCommand {
+    uint32_t packetIndex; // Addした順の番号
+    uint32_t changedStates; // kDrawStateXxxの組み合わせ。最初の描画は全て
+};
+
+struct DrawQueueStats {
+    uint32_t drawCount;
+    uint32_t stateChangeCount; // 設定した状態の数
+    uint32_t naiveStateChangeCount; // 描画ごとに全ての状態を設定したときの数
+    uint32_t stateChanges[kDrawStateCount]; // 種類ごとの設定した数
+    uint32_t sortedDigitCount; // 基数ソートで分配した8bitの桁の数。全ての描画で同じ値の桁は数えない
+};
+
+/// <summary>
+/// フレームごとに描画を集め、キーの小さい順に並べて、前の描画から変わった状態だけを設定するコマンドにする
+/// デバイスには触れず、コマンドを実際のSetXxxとDrawに置き換えるのは使う側
+/// </summary>
+class DrawQueue {
+public:
+    /// <summary>
+    /// 集めた描画を空にする。確保したメモリは次のフレームで使い回す
+    /// </summary>
+    void Clear();
+
+    void Add(const DrawPacket& packet);
+
+    /// <summary>
+    /// キーの小さい順(同じキーはAddした順)に並べ、前の描画と状態を比べたコマンドと統計を作る
+    /// キーは下位から8bitずつの基数ソートで並べ、全ての描画で同じ値の桁は飛ばす
+    /// </summary>
+    void Sort();
+
+    const std::vector<DrawCommand>& GetCommands() const { return commands_; }
+    const DrawPacket& GetPacket(uint32_t packetIndex) const { return packets_[packetIndex]; }
+    const DrawQueueStats& GetStats() const { return stats_; }
+
+private:
+    std::vector<DrawPacket> packets_; //!< Addした順
+    std::vector<uint64_t> keys_; //!< 並べ替え中のキー
+    std::vector<uint32_t> order_; //!< keys_と同じ並びの描画の番号
+    std::vector<uint64_t> scratchKeys_; //!< 基数ソートの1桁分の出力先
+    std::vector<uint32_t> scratchOrder_; //!< 基数ソートの1桁分の出力先
+    std::vector<DrawCommand> commands_; //!< 並べた後のコマンド
+    DrawQueueStats stats_{}; //!< 最後にSortしたときの統計
+};
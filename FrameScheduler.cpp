@@ -0,0 +1,65 @@
+#include "FrameScheduler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+void FrameScheduler::Initialize(FrameQueue* queue, uint32_t maxFramesInFlight, uint32_t framesInFlight)
+{
+    assert(queue != nullptr && maxFramesInFlight >= 1);
+    queue_ = queue;
+    slotFenceValues_.assign(maxFramesInFlight, 0);
+    submittedFenceValues_.clear();
+    framesInFlight_ = (std::clamp)(framesInFlight, 1u, maxFramesInFlight);
+    slot_ = 0;
+    frameCount_ = 0;
+    pendingFrameCount_ = 0;
+    waitTime_ = 0.0;
+}
+
+uint32_t FrameScheduler::BeginFrame()
+{
+    slot_ = static_cast<uint32_t>(frameCount_ % framesInFlight_);
+    ++frameCount_;
+
+    // この組を前に使ったフレームをGPUが終えるまで待つ。それより前のフレームは終わっているので、待つのは高々framesInFlight_ - 1フレーム分
+    auto waitStart = std::chrono::steady_clock::now();
+    uint64_t slotFenceValue = slotFenceValues_[slot_];
+    if (slotFenceValue != 0 && queue_->GetCompletedValue() < slotFenceValue) {
+        queue_->Wait(slotFenceValue);
+    }
+    waitTime_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - waitStart).count();
+
+    uint64_t completedValue = queue_->GetCompletedValue();
+    std::erase_if(submittedFenceValues_, [completedValue](uint64_t value) { return value <= completedValue; });
+    pendingFrameCount_ = static_cast<uint32_t>(submittedFenceValues_.size());
+    return slot_;
+}
+
+uint64_t FrameScheduler::EndFrame()
+{
+    uint64_t fenceValue = queue_->Signal();
+    slotFenceValues_[slot_] = fenceValue;
+    submittedFenceValues_.push_back(fenceValue);
+    return fenceValue;
+}
+
+void FrameScheduler::WaitIdle()
+{
+    if (!submittedFenceValues_.empty()) {
+        queue_->Wait(submittedFenceValues_.back());
+        submittedFenceValues_.clear();
+    }
+}
+
+void FrameScheduler::SetFramesInFlight(uint32_t framesInFlight)
+{
+    framesInFlight = (std::clamp)(framesInFlight, 1u, GetMaxFramesInFlight());
+    if (framesInFlight == framesInFlight_) {
+        return;
+    }
+    // 組の割り当てが変わるので、どの組もGPUが使っていない状態にしてから切り替える
+    WaitIdle();
+    framesInFlight_ = framesInFlight;
+    frameCount_ = 0;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// FrameSchedulerがGPUの進み具合を調べるためのキュー。D3D12ではコマンドキューとFenceで実装し、確かめるときは偽物に置き換える
+/// </summary>
+class FrameQueue {
+public:
+    virtual ~FrameQueue() = default;
+
+    /// <summary>
+    /// ここまでに送ったコマンドの後に、前より大きい値のSignalを積んでその値を返す
+    /// </summary>
+    virtual uint64_t Signal() = 0;
+
+    /// <summary>
+    /// GPUが届いたSignal値
+    /// </summary>
+    virtual uint64_t GetCompletedValue() = 0;
+
+    /// <summary>
+    /// GPUがvalueに届くまでCPUを止める
+    /// </summary>
+    virtual void Wait(uint64_t value) = 0;
+};
+
+/// <summary>
+/// CPUが先のフレームのコマンドを積む間に、GPUが前のフレームを実行できるようにする
+/// フレームごとのリソース(コマンドアロケータなど)をframesInFlight組用意して順に使い、次に使う組をGPUが使い終わるまでだけ待つ
+/// framesInFlightが1なら、毎フレームGPUが終わるのを待つ
+/// </summary>
+class FrameScheduler {
+public:
+    /// <summary>
+    /// queueは使い終わるまで生きていること。framesInFlightは1以上maxFramesInFlight以下
+    /// </summary>
+    void Initialize(FrameQueue* queue, uint32_t maxFramesInFlight, uint32_t framesInFlight);
+
+    /// <summary>
+    /// フレームを始める。これから使う組をGPUが使い終わるまで待ち、その組の番号(0~maxFramesInFlight-1)を返す
+    /// </summary>
+    uint32_t BeginFrame();
+
+    /// <summary>
+    /// 今のフレームのコマンドを全て送った後に呼ぶ。Signalを積み、その値を返す。この値に届けばフレームの組は再利用できる
+    /// </summary>
+    uint64_t EndFrame();
+
+    /// <summary>
+    /// 送ったフレームをGPUが全て終えるまで待つ。終了時やリソースを作り直す前に呼ぶ
+    /// </summary>
+    void WaitIdle();
+
+    /// <summary>
+    /// 同時に進めるフレームの数を変える。GPUが全て終えるのを待ってから切り替える
+    /// </summary>
+    void SetFramesInFlight(uint32_t framesInFlight);
+
+    uint32_t GetFramesInFlight() const { return framesInFlight_; }
+    uint32_t GetMaxFramesInFlight() const { return static_cast<uint32_t>(slotFenceValues_.size()); }
+
+    /// <summary>
+    /// 今のフレームを始めたときに、GPUがまだ終えていなかった送信済みのフレームの数(CPUがGPUより何フレーム先にいるか)
+    /// </summary>
+    uint32_t GetPendingFrameCount() const { return pendingFrameCount_; }
+
+    /// <summary>
+    /// 今のフレームを始めるときにGPUを待った時間(秒)
+    /// </summary>
+    double GetWaitTime() const { return waitTime_; }
+
+private:
+    FrameQueue* queue_ = nullptr;
+    uint32_t framesInFlight_ = 1; //!< 同時に進めるフレームの数
+    uint32_t slot_ = 0; //!< 今のフレームが使う組
+    uint64_t frameCount_ = 0; //!< 始めたフレームの数
+    std::vector<uint64_t> slotFenceValues_; //!< 組ごとに、最後に使ったフレームのSignal値。0なら未使用
+    std::vector<uint64_t> submittedFenceValues_; //!< 送ったフレームのSignal値。GPUが終えたものは取り除く
+    uint32_t pendingFrameCount_ = 0; //!< 今のフレームを始めたときの未完了のフレームの数
+    double waitTime_ = 0.0; //!< 今のフレームを始めるときにGPUを待った時間
+};
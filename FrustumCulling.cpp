@@ -0,0 +1,242 @@
+#include "FrustumCulling.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "MatrixSimd.h"
+
+namespace {
+
+/// <summary>
+/// 1オブジェクトを6平面と比べ、どれかの外側にあればtrue
+/// 平面までの距離が、箱をその法線へ投影した半分の長さと球の半径の小さい方より外ならその平面の外
+/// </summary>
+bool IsOutside(const CullingBoundsSoA& bounds, size_t index, const Frustum& frustum)
+{
+    float centerX = bounds.centerX[index];
+    float centerY = bounds.centerY[index];
+    float centerZ = bounds.centerZ[index];
+    float extentX = bounds.extentX[index];
+    float extentY = bounds.extentY[index];
+    float extentZ = bounds.extentZ[index];
+    float radius = bounds.radius[index];
+    for (const Vector4& plane : frustum.planes) {
+        float distance = plane.x * centerX + plane.y * centerY + plane.z * centerZ + plane.w;
+        float boxRadius = std::fabs(plane.x) * extentX + std::fabs(plane.y) * extentY + std::fabs(plane.z) * extentZ;
+        if (distance + (std::min)(boxRadius, radius) < 0.0f) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t CullObjectsScalar(const CullingBoundsSoA& bounds, const Frustum& frustum, uint32_t* visibleIndices, size_t begin, uint32_t visibleCount)
+{
+    for (size_t index = begin; index < bounds.GetSize(); ++index) {
+        visibleIndices[visibleCount] = static_cast<uint32_t>(index);
+        visibleCount += IsOutside(bounds, index, frustum) ? 0 : 1;
+    }
+    return visibleCount;
+}
+
+/// <summary>
+/// 4個ずつSSEで比べる。残ったものの番号は分岐せずに書き、残ったときだけ書く位置を進める
+/// </summary>
+SIMD_TARGET_SSE41 uint32_t CullObjectsSse41(const CullingBoundsSoA& bounds, const Frustum& frustum, uint32_t* visibleIndices)
+{
+    constexpr size_t kBatchSize = 4;
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    // 平面ごとに、法線と距離、法線の絶対値を全レーンに広げておく
+    __m128 normalX[6], normalY[6], normalZ[6], planeDistance[6];
+    __m128 absNormalX[6], absNormalY[6], absNormalZ[6];
+    for (int i = 0; i < 6; ++i) {
+        const Vector4& plane = frustum.planes[i];
+        normalX[i] = _mm_set1_ps(plane.x);
+        normalY[i] = _mm_set1_ps(plane.y);
+        normalZ[i] = _mm_set1_ps(plane.z);
+        planeDistance[i] = _mm_set1_ps(plane.w);
+        absNormalX[i] = _mm_and_ps(normalX[i], absMask);
+        absNormalY[i] = _mm_and_ps(normalY[i], absMask);
+        absNormalZ[i] = _mm_and_ps(normalZ[i], absMask);
+    }
+
+    const __m128 zero = _mm_setzero_ps();
+    uint32_t visibleCount = 0;
+    size_t count = bounds.GetSize();
+    const float* centerXData = bounds.centerX.data();
+    const float* centerYData = bounds.centerY.data();
+    const float* centerZData = bounds.centerZ.data();
+    const float* extentXData = bounds.extentX.data();
+    const float* extentYData = bounds.extentY.data();
+    const float* extentZData = bounds.extentZ.data();
+    const float* radiusData = bounds.radius.data();
+    size_t index = 0;
+    for (; index + kBatchSize <= count; index += kBatchSize) {
+        __m128 centerX = _mm_loadu_ps(centerXData + index);
+        __m128 centerY = _mm_loadu_ps(centerYData + index);
+        __m128 centerZ = _mm_loadu_ps(centerZData + index);
+        __m128 extentX = _mm_loadu_ps(extentXData + index);
+        __m128 extentY = _mm_loadu_ps(extentYData + index);
+        __m128 extentZ = _mm_loadu_ps(extentZData + index);
+        __m128 radius = _mm_loadu_ps(radiusData + index);
+        __m128 outside = _mm_setzero_ps();
+        for (int i = 0; i < 6; ++i) {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(normalX[i], centerX), _mm_mul_ps(normalY[i], centerY)), _mm_mul_ps(normalZ[i], centerZ)), planeDistance[i]);
+            __m128 boxRadius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absNormalX[i], extentX), _mm_mul_ps(absNormalY[i], extentY)), _mm_mul_ps(absNormalZ[i], extentZ));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, _mm_min_ps(boxRadius, radius)), zero));
+        }
+        uint32_t visibleMask = ~static_cast<uint32_t>(_mm_movemask_ps(outside));
+        for (uint32_t lane = 0; lane < kBatchSize; ++lane) {
+            visibleIndices[visibleCount] = static_cast<uint32_t>(index) + lane;
+            visibleCount += (visibleMask >> lane) & 1;
+        }
+    }
+    return CullObjectsScalar(bounds, frustum, visibleIndices, index, visibleCount);
+}
+
+/// <summary>
+/// 8個ずつAVX2で比べる。式はSSE4.1と同じで、積和はFMAでまとめる
+/// </summary>
+SIMD_TARGET_AVX2 uint32_t CullObjectsAvx2(const CullingBoundsSoA& bounds, const Frustum& frustum, uint32_t* visibleIndices)
+{
+    constexpr size_t kBatchSize = 8;
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    // 平面ごとに、法線と距離、法線の絶対値を全レーンに広げておく
+    __m256 normalX[6], normalY[6], normalZ[6], planeDistance[6];
+    __m256 absNormalX[6], absNormalY[6], absNormalZ[6];
+    for (int i = 0; i < 6; ++i) {
+        const Vector4& plane = frustum.planes[i];
+        normalX[i] = _mm256_set1_ps(plane.x);
+        normalY[i] = _mm256_set1_ps(plane.y);
+        normalZ[i] = _mm256_set1_ps(plane.z);
+        planeDistance[i] = _mm256_set1_ps(plane.w);
+        absNormalX[i] = _mm256_and_ps(normalX[i], absMask);
+        absNormalY[i] = _mm256_and_ps(normalY[i], absMask);
+        absNormalZ[i] = _mm256_and_ps(normalZ[i], absMask);
+    }
+
+    const __m256 zero = _mm256_setzero_ps();
+    uint32_t visibleCount = 0;
+    size_t count = bounds.GetSize();
+    const float* centerXData = bounds.centerX.data();
+    const float* centerYData = bounds.centerY.data();
+    const float* centerZData = bounds.centerZ.data();
+    const float* extentXData = bounds.extentX.data();
+    const float* extentYData = bounds.extentY.data();
+    const float* extentZData = bounds.extentZ.data();
+    const float* radiusData = bounds.radius.data();
+    size_t index = 0;
+    for (; index + kBatchSize <= count; index += kBatchSize) {
+        __m256 centerX = _mm256_loadu_ps(centerXData + index);
+        __m256 centerY = _mm256_loadu_ps(centerYData + index);
+        __m256 centerZ = _mm256_loadu_ps(centerZData + index);
+        __m256 extentX = _mm256_loadu_ps(extentXData + index);
+        __m256 extentY = _mm256_loadu_ps(extentYData + index);
+        __m256 extentZ = _mm256_loadu_ps(extentZData + index);
+        __m256 radius = _mm256_loadu_ps(radiusData + index);
+        __m256 outside = _mm256_setzero_ps();
+        for (int i = 0; i < 6; ++i) {
+            __m256 distance = _mm256_fmadd_ps(normalX[i], centerX, planeDistance[i]);
+            distance = _mm256_fmadd_ps(normalY[i], centerY, distance);
+            distance = _mm256_fmadd_ps(normalZ[i], centerZ, distance);
+            __m256 boxRadius = _mm256_mul_ps(absNormalX[i], extentX);
+            boxRadius = _mm256_fmadd_ps(absNormalY[i], extentY, boxRadius);
+            boxRadius = _mm256_fmadd_ps(absNormalZ[i], extentZ, boxRadius);
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, _mm256_min_ps(boxRadius, radius)), zero, _CMP_LT_OQ));
+        }
+        uint32_t visibleMask = ~static_cast<uint32_t>(_mm256_movemask_ps(outside));
+        for (uint32_t lane = 0; lane < kBatchSize; ++lane) {
+            visibleIndices[visibleCount] = static_cast<uint32_t>(index) + lane;
+            visibleCount += (visibleMask >> lane) & 1;
+        }
+    }
+    return CullObjectsScalar(bounds, frustum, visibleIndices, index, visibleCount);
+}
+
+} // namespace
+
+Frustum ExtractFrustum(const Matrix4x4& viewProjection)
+{
+    // 行ベクトル形式なので、クリップ座標の各成分は列との内積になる
+    const Matrix4x4& m = viewProjection;
+    Frustum frustum;
+    for (int i = 0; i < 3; ++i) {
+        Vector4 column = { m.m[0][i], m.m[1][i], m.m[2][i], m.m[3][i] };
+        Vector4 w = { m.m[0][3], m.m[1][3], m.m[2][3], m.m[3][3] };
+        if (i < 2) {
+            frustum.planes[i * 2 + 0] = { w.x + column.x, w.y + column.y, w.z + column.z, w.w + column.w };
+            frustum.planes[i * 2 + 1] = { w.x - column.x, w.y - column.y, w.z - column.z, w.w - column.w };
+        } else {
+            // Zは0~wが範囲
+            frustum.planes[4] = column;
+            frustum.planes[5] = { w.x - column.x, w.y - column.y, w.z - column.z, w.w - column.w };
+        }
+    }
+    for (Vector4& plane : frustum.planes) {
+        float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+        plane = { plane.x / length, plane.y / length, plane.z / length, plane.w / length };
+    }
+    return frustum;
+}
+
+void CullingBoundsSoA::Resize(size_t count)
+{
+    centerX.resize(count, 0.0f);
+    centerY.resize(count, 0.0f);
+    centerZ.resize(count, 0.0f);
+    extentX.resize(count, 0.0f);
+    extentY.resize(count, 0.0f);
+    extentZ.resize(count, 0.0f);
+    radius.resize(count, 0.0f);
+}
+
+void CullingBoundsSoA::Set(size_t index, const AABB& bounds, const Sphere& sphere, const AffineMatrix& world)
+{
+    const float(&m)[4][3] = world.m;
+    Vector3 localCenter = {
+        (bounds.min.x + bounds.max.x) * 0.5f,
+        (bounds.min.y + bounds.max.y) * 0.5f,
+        (bounds.min.z + bounds.max.z) * 0.5f,
+    };
+    Vector3 localExtent = { bounds.max.x - localCenter.x, bounds.max.y - localCenter.y, bounds.max.z - localCenter.z };
+    Vector3 center = TransformPoint(localCenter, world);
+
+    // 変換後の箱の各軸への広がりは、各軸の広がりを行列の成分の絶対値でかけて足したもの
+    centerX[index] = center.x;
+    centerY[index] = center.y;
+    centerZ[index] = center.z;
+    extentX[index] = std::fabs(m[0][0]) * localExtent.x + std::fabs(m[1][0]) * localExtent.y + std::fabs(m[2][0]) * localExtent.z;
+    extentY[index] = std::fabs(m[0][1]) * localExtent.x + std::fabs(m[1][1]) * localExtent.y + std::fabs(m[2][1]) * localExtent.z;
+    extentZ[index] = std::fabs(m[0][2]) * localExtent.x + std::fabs(m[1][2]) * localExtent.y + std::fabs(m[2][2]) * localExtent.z;
+
+    float maxScaleSquared = (std::max)({
+        m[0][0] * m[0][0] + m[0][1] * m[0][1] + m[0][2] * m[0][2],
+        m[1][0] * m[1][0] + m[1][1] * m[1][1] + m[1][2] * m[1][2],
+        m[2][0] * m[2][0] + m[2][1] * m[2][1] + m[2][2] * m[2][2],
+    });
+    Vector3 sphereCenter = TransformPoint(sphere.center, world);
+    Vector3 offset = { sphereCenter.x - center.x, sphereCenter.y - center.y, sphereCenter.z - center.z };
+    radius[index] = sphere.radius * std::sqrt(maxScaleSquared) + std::sqrt(offset.x * offset.x + offset.y * offset.y + offset.z * offset.z);
+}
+
+uint32_t CullObjects(const CullingBoundsSoA& bounds, const Frustum& frustum, std::vector<uint32_t>& visibleIndices)
+{
+    // 番号は全部書いてから残った数に縮める
+    visibleIndices.resize(bounds.GetSize());
+    uint32_t visibleCount = 0;
+    switch (GetSimdLevel()) {
+    case SimdLevel::Avx2:
+        visibleCount = CullObjectsAvx2(bounds, frustum, visibleIndices.data());
+        break;
+    case SimdLevel::Sse41:
+        visibleCount = CullObjectsSse41(bounds, frustum, visibleIndices.data());
+        break;
+    default:
+        visibleCount = CullObjectsScalar(bounds, frustum, visibleIndices.data(), 0, 0);
+        break;
+    }
+    visibleIndices.resize(visibleCount);
+    return visibleCount;
+}
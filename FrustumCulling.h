@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "AffineMatrix.h"
+#include "MathTypes.h"
+
+/// <summary>
+/// 視錐台の6平面。(x, y, z)が長さ1の法線、wが原点からの距離で、内側が正
+/// </summary>
+struct Frustum {
+    Vector4 planes[6]; // 左、右、下、上、近、遠
+};
+
+/// <summary>
+/// ビュープロジェクション行列(MakePerspectiveFovMatrixなど、Zが0~wに入るもの)の列から視錐台の6平面を取り出す
+/// </summary>
+Frustum ExtractFrustum(const Matrix4x4& viewProjection);
+
+/// <summary>
+/// カリングするオブジェクトのワールド座標での境界を成分ごとの配列(SoA)で持つ。連続した4個/8個をそのまま128bit/256bitで読める
+/// 箱(中心と半分の大きさ)と球(中心は箱と共通)の両方を持ち、どちらかで外と分かれば除く
+/// </summary>
+struct CullingBoundsSoA {
+    std::vector<float> centerX;
+    std::vector<float> centerY;
+    std::vector<float> centerZ;
+    std::vector<float> extentX; // 箱の各軸の半分の大きさ
+    std::vector<float> extentY;
+    std::vector<float> extentZ;
+    std::vector<float> radius; // centerを中心とする球の半径
+
+    size_t GetSize() const { return centerX.size(); }
+
+    /// <summary>
+    /// 要素数を変える。増えた分は原点の大きさ0の点
+    /// </summary>
+    void Resize(size_t count);
+
+    /// <summary>
+    /// モデル座標の箱と球をworldで変換した境界を入れる。箱は変換後の箱を囲む軸に沿った箱に、球は最も大きい拡縮で広げる
+    /// 球の中心は箱の中心に合わせ、その分半径を広げる
+    /// </summary>
+    void Set(size_t index, const AABB& bounds, const Sphere& sphere, const AffineMatrix& world);
+};
+
+/// <summary>
+/// 視錐台の内側にあるか一部でもかかるオブジェクトの番号を小さい順にvisibleIndicesへ入れ(中身は置き換える)、その数を返す
+/// AVX2なら8個ずつ、SSE4.1なら4個ずつまとめて6平面と比べる。GetSimdLevel()がScalarなら1個ずつ比べる(結果を確かめる基準)
+/// </summary>
+uint32_t CullObjects(const CullingBoundsSoA& bounds, const Frustum& frustum, std::vector<uint32_t>& visibleIndices);
@@ -0,0 +1,159 @@
+#include "Hash.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+constexpr uint64_t kPrime3 = 0x165667B19E3779F9ull;
+constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ull;
+constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ull;
+
+uint64_t RotateLeft(uint64_t value, int shift) { return (value << shift) | (value >> (64 - shift)); }
+
+uint64_t Read64(const uint8_t* p)
+{
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+uint32_t Read32(const uint8_t* p)
+{
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+uint64_t Round(uint64_t accumulator, uint64_t input)
+{
+    accumulator += input * kPrime2;
+    accumulator = RotateLeft(accumulator, 31);
+    return accumulator * kPrime1;
+}
+
+uint64_t MergeRound(uint64_t accumulator, uint64_t value)
+{
+    accumulator ^= Round(0, value);
+    return accumulator * kPrime1 + kPrime4;
+}
+
+/// <summary>
+/// 4本のレーンの初期値
+/// </summary>
+void InitializeLanes(uint64_t lanes[4], uint64_t seed)
+{
+    lanes[0] = seed + kPrime1 + kPrime2;
+    lanes[1] = seed + kPrime2;
+    lanes[2] = seed;
+    lanes[3] = seed - kPrime1;
+}
+
+/// <summary>
+/// 32byteを4本のレーンに混ぜる
+/// </summary>
+void ConsumeStripe(uint64_t lanes[4], const uint8_t* p)
+{
+    lanes[0] = Round(lanes[0], Read64(p));
+    lanes[1] = Round(lanes[1], Read64(p + 8));
+    lanes[2] = Round(lanes[2], Read64(p + 16));
+    lanes[3] = Round(lanes[3], Read64(p + 24));
+}
+
+/// <summary>
+/// レーンをまとめ、32byteに満たない残りを混ぜて最終的な値にする
+/// </summary>
+uint64_t Finalize(const uint64_t lanes[4], uint64_t seed, uint64_t totalSize, const uint8_t* p, const uint8_t* end)
+{
+    uint64_t hash;
+    if (totalSize >= 32) {
+        hash = RotateLeft(lanes[0], 1) + RotateLeft(lanes[1], 7) + RotateLeft(lanes[2], 12) + RotateLeft(lanes[3], 18);
+        hash = MergeRound(hash, lanes[0]);
+        hash = MergeRound(hash, lanes[1]);
+        hash = MergeRound(hash, lanes[2]);
+        hash = MergeRound(hash, lanes[3]);
+    } else {
+        hash = seed + kPrime5;
+    }
+    hash += totalSize;
+
+    // 残りの端数を処理
+    while (p + 8 <= end) {
+        hash ^= Round(0, Read64(p));
+        hash = RotateLeft(hash, 27) * kPrime1 + kPrime4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        hash ^= static_cast<uint64_t>(Read32(p)) * kPrime1;
+        hash = RotateLeft(hash, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    while (p < end) {
+        hash ^= (*p) * kPrime5;
+        hash = RotateLeft(hash, 11) * kPrime1;
+        ++p;
+    }
+
+    // 最後にビットを攪拌する
+    hash ^= hash >> 33;
+    hash *= kPrime2;
+    hash ^= hash >> 29;
+    hash *= kPrime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+} // namespace
+
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    const uint8_t* end = p + size;
+
+    // 32byteずつ4本のレーンで並行して混ぜる
+    uint64_t lanes[4];
+    InitializeLanes(lanes, seed);
+    while (static_cast<size_t>(end - p) >= 32) {
+        ConsumeStripe(lanes, p);
+        p += 32;
+    }
+    return Finalize(lanes, seed, static_cast<uint64_t>(size), p, end);
+}
+
+StreamingHash::StreamingHash(uint64_t seed) : seed_(seed)
+{
+    InitializeLanes(lanes_, seed);
+}
+
+void StreamingHash::Update(const void* data, size_t size)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    const uint8_t* end = p + size;
+    totalSize_ += size;
+
+    // 前回の端数と合わせて32byteになったら混ぜる
+    if (bufferSize_ != 0) {
+        size_t copySize = (std::min)(static_cast<size_t>(32) - bufferSize_, size);
+        std::memcpy(buffer_ + bufferSize_, p, copySize);
+        bufferSize_ += copySize;
+        p += copySize;
+        if (bufferSize_ < 32) {
+            return;
+        }
+        ConsumeStripe(lanes_, buffer_);
+        bufferSize_ = 0;
+    }
+    while (static_cast<size_t>(end - p) >= 32) {
+        ConsumeStripe(lanes_, p);
+        p += 32;
+    }
+    bufferSize_ = static_cast<size_t>(end - p);
+    std::memcpy(buffer_, p, bufferSize_);
+}
+
+uint64_t StreamingHash::Finish() const
+{
+    return Finalize(lanes_, seed_, totalSize_, buffer_, buffer_ + bufferSize_);
+}
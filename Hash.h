@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/// <summary>
+/// 64bitのハッシュ値を計算する(xxHash64)
+/// </summary>
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 0);
+
+/// <summary>
+/// 分けて渡したバイト列のハッシュ値を計算する。まとめてHashBytesに渡したときと同じ値になる
+/// </summary>
+class StreamingHash {
+public:
+    explicit StreamingHash(uint64_t seed = 0);
+
+    /// <summary>
+    /// 続きのバイト列を加える
+    /// </summary>
+    void Update(const void* data, size_t size);
+
+    /// <summary>
+    /// ここまでに加えたバイト列のハッシュ値
+    /// </summary>
+    uint64_t Finish() const;
+
+private:
+    uint64_t lanes_[4]; //!< 32byteごとに混ぜる4本のレーン
+    uint8_t buffer_[32]; //!< 32byteに満たない端数
+    size_t bufferSize_ = 0; //!< buffer_に入っているバイト数
+    uint64_t totalSize_ = 0; //!< 加えたバイト数の合計
+    uint64_t seed_;
+};
+
+/// <summary>
+/// 2つのハッシュ値を順序付きで合成する
+/// </summary>
+inline uint64_t CombineHash(uint64_t hash, uint64_t value)
+{
+    return hash ^ (value + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2));
+}
@@ -0,0 +1,151 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <utility>
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other) {
+        Close();
+#ifdef _WIN32
+        fileHandle_ = std::exchange(other.fileHandle_, nullptr);
+        mappingHandle_ = std::exchange(other.mappingHandle_, nullptr);
+#else
+        fileDescriptor_ = std::exchange(other.fileDescriptor_, -1);
+#endif
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::filesystem::path& filePath)
+{
+    Close();
+
+    // 順次読みであることをOSに伝えて先読みを効かせる
+    HANDLE file = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        return false;
+    }
+    fileHandle_ = file;
+    size_ = static_cast<size_t>(fileSize.QuadPart);
+
+    // 空のファイルはマップできないので、開いただけの状態にしておく
+    if (size_ == 0) {
+        return true;
+    }
+
+    mappingHandle_ = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappingHandle_ == nullptr) {
+        Close();
+        return false;
+    }
+    data_ = static_cast<const char*>(MapViewOfFile(mappingHandle_, FILE_MAP_READ, 0, 0, 0));
+    if (data_ == nullptr) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (data_ != nullptr) {
+        UnmapViewOfFile(data_);
+        data_ = nullptr;
+    }
+    if (mappingHandle_ != nullptr) {
+        CloseHandle(mappingHandle_);
+        mappingHandle_ = nullptr;
+    }
+    if (fileHandle_ != nullptr) {
+        CloseHandle(fileHandle_);
+        fileHandle_ = nullptr;
+    }
+    size_ = 0;
+}
+
+bool MappedFile::IsOpen() const
+{
+    return fileHandle_ != nullptr;
+}
+
+#else
+
+bool MappedFile::Open(const std::filesystem::path& filePath)
+{
+    Close();
+
+    int file = open(filePath.c_str(), O_RDONLY);
+    if (file < 0) {
+        return false;
+    }
+    struct stat status {};
+    if (fstat(file, &status) != 0) {
+        close(file);
+        return false;
+    }
+    fileDescriptor_ = file;
+    size_ = static_cast<size_t>(status.st_size);
+
+    // 空のファイルはマップできないので、開いただけの状態にしておく
+    if (size_ == 0) {
+        return true;
+    }
+
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0);
+    if (data == MAP_FAILED) {
+        Close();
+        return false;
+    }
+    // 順次読みであることをOSに伝えて先読みを効かせる
+    madvise(data, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(data);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (data_ != nullptr) {
+        munmap(const_cast<char*>(data_), size_);
+        data_ = nullptr;
+    }
+    if (fileDescriptor_ >= 0) {
+        close(fileDescriptor_);
+        fileDescriptor_ = -1;
+    }
+    size_ = 0;
+}
+
+bool MappedFile::IsOpen() const
+{
+    return fileDescriptor_ >= 0;
+}
+
+#endif
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+
+/// <summary>
+/// 読み取り専用でファイルをメモリにマップする
+/// </summary>
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    /// <summary>
+    /// ファイルを開いてマップする。失敗したらfalse
+    /// </summary>
+    bool Open(const std::filesystem::path& filePath);
+
+    /// <summary>
+    /// マップを解除してファイルを閉じる
+    /// </summary>
+    void Close();
+
+    bool IsOpen() const;
+    const char* GetData() const { return data_; }
+    size_t GetSize() const { return size_; }
+
+private:
+#ifdef _WIN32
+    void* fileHandle_ = nullptr; //!< ファイルのハンドル
+    void* mappingHandle_ = nullptr; //!< ファイルマッピングオブジェクトのハンドル
+#else
+    int fileDescriptor_ = -1; //!< ファイル記述子。テストとベンチマークをLinuxでビルドするときに使う
+#endif
+    const char* data_ = nullptr; //!< マップされた先頭アドレス
+    size_t size_ = 0; //!< ファイルサイズ
+};
@@ -0,0 +1,307 @@
+#include "MathFunctions.h"
+
+#include <cmath>
+
+float Dot(const Vector3& v1, const Vector3& v2) { return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z; }
+
+float Length(const Vector3& v) { return std::sqrt(Dot(v, v)); }
+
+Vector3 Normalize(const Vector3& v) {
+    float length = Length(v);
+    if (length == 0.0f) {
+        return v;
+    }
+    return { v.x / length, v.y / length, v.z / length };
+}
+
+Matrix4x4 Add(const Matrix4x4& m1, const Matrix4x4& m2) {
+    Matrix4x4 result;
+    result.m[0][0] = m1.m[0][0] + m2.m[0][0];
+    result.m[0][1] = m1.m[0][1] + m2.m[0][1];
+    result.m[0][2] = m1.m[0][2] + m2.m[0][2];
+    result.m[0][3] = m1.m[0][3] + m2.m[0][3];
+
+    result.m[1][0] = m1.m[1][0] + m2.m[1][0];
+    result.m[1][1] = m1.m[1][1] + m2.m[1][1];
+    result.m[1][2] = m1.m[1][2] + m2.m[1][2];
+    result.m[1][3] = m1.m[1][3] + m2.m[1][3];
+
+    result.m[2][0] = m1.m[2][0] + m2.m[2][0];
+    result.m[2][1] = m1.m[2][1] + m2.m[2][1];
+    result.m[2][2] = m1.m[2][2] + m2.m[2][2];
+    result.m[2][3] = m1.m[2][3] + m2.m[2][3];
+
+    result.m[3][0] = m1.m[3][0] + m2.m[3][0];
+    result.m[3][1] = m1.m[3][1] + m2.m[3][1];
+    result.m[3][2] = m1.m[3][2] + m2.m[3][2];
+    result.m[3][3] = m1.m[3][3] + m2.m[3][3];
+    return result;
+}
+
+// 2. 行列の減法
+Matrix4x4 Subtract(const Matrix4x4& m1, const Matrix4x4& m2) {
+    Matrix4x4 result;
+    result.m[0][0] = m1.m[0][0] - m2.m[0][0];
+    result.m[0][1] = m1.m[0][1] - m2.m[0][1];
+    result.m[0][2] = m1.m[0][2] - m2.m[0][2];
+    result.m[0][3] = m1.m[0][3] - m2.m[0][3];
+
+    result.m[1][0] = m1.m[1][0] - m2.m[1][0];
+    result.m[1][1] = m1.m[1][1] - m2.m[1][1];
+    result.m[1][2] = m1.m[1][2] - m2.m[1][2];
+    result.m[1][3] = m1.m[1][3] - m2.m[1][3];
+
+    result.m[2][0] = m1.m[2][0] - m2.m[2][0];
+    result.m[2][1] = m1.m[2][1] - m2.m[2][1];
+    result.m[2][2] = m1.m[2][2] - m2.m[2][2];
+    result.m[2][3] = m1.m[2][3] - m2.m[2][3];
+
+    result.m[3][0] = m1.m[3][0] - m2.m[3][0];
+    result.m[3][1] = m1.m[3][1] - m2.m[3][1];
+    result.m[3][2] = m1.m[3][2] - m2.m[3][2];
+    result.m[3][3] = m1.m[3][3] - m2.m[3][3];
+    return result;
+}
+
+Matrix4x4 Inverse(const Matrix4x4& m) {
+    // clang-format off
+    float determinant = +m.m[0][0] * m.m[1][1] * m.m[2][2] * m.m[3][3]
+        + m.m[0][0] * m.m[1][2] * m.m[2][3] * m.m[3][1]
+        + m.m[0][0] * m.m[1][3] * m.m[2][1] * m.m[3][2]
+
+        - m.m[0][0] * m.m[1][3] * m.m[2][2] * m.m[3][1]
+        - m.m[0][0] * m.m[1][2] * m.m[2][1] * m.m[3][3]
+        - m.m[0][0] * m.m[1][1] * m.m[2][3] * m.m[3][2]
+
+        - m.m[0][1] * m.m[1][0] * m.m[2][2] * m.m[3][3]
+        - m.m[0][2] * m.m[1][0] * m.m[2][3] * m.m[3][1]
+        - m.m[0][3] * m.m[1][0] * m.m[2][1] * m.m[3][2]
+
+        + m.m[0][3] * m.m[1][0] * m.m[2][2] * m.m[3][1]
+        + m.m[0][2] * m.m[1][0] * m.m[2][1] * m.m[3][3]
+        + m.m[0][1] * m.m[1][0] * m.m[2][3] * m.m[3][2]
+
+        + m.m[0][1] * m.m[1][2] * m.m[2][0] * m.m[3][3]
+        + m.m[0][2] * m.m[1][3] * m.m[2][0] * m.m[3][1]
+        + m.m[0][3] * m.m[1][1] * m.m[2][0] * m.m[3][2]
+
+        - m.m[0][3] * m.m[1][2] * m.m[2][0] * m.m[3][1]
+        - m.m[0][2] * m.m[1][1] * m.m[2][0] * m.m[3][3]
+        - m.m[0][1] * m.m[1][3] * m.m[2][0] * m.m[3][2]
+
+        - m.m[0][1] * m.m[1][2] * m.m[2][3] * m.m[3][0]
+        - m.m[0][2] * m.m[1][3] * m.m[2][1] * m.m[3][0]
+        - m.m[0][3] * m.m[1][1] * m.m[2][2] * m.m[3][0]
+
+        + m.m[0][3] * m.m[1][2] * m.m[2][1] * m.m[3][0]
+        + m.m[0][2] * m.m[1][1] * m.m[2][3] * m.m[3][0]
+        + m.m[0][1] * m.m[1][3] * m.m[2][2] * m.m[3][0];
+
+    Matrix4x4 result;
+    float recpDeterminant = 1.0f / determinant;
+    result.m[0][0] = (m.m[1][1] * m.m[2][2] * m.m[3][3] + m.m[1][2] * m.m[2][3] * m.m[3][1] +
+        m.m[1][3] * m.m[2][1] * m.m[3][2] - m.m[1][3] * m.m[2][2] * m.m[3][1] -
+        m.m[1][2] * m.m[2][1] * m.m[3][3] - m.m[1][1] * m.m[2][3] * m.m[3][2]) * recpDeterminant;
+    result.m[0][1] = (-m.m[0][1] * m.m[2][2] * m.m[3][3] - m.m[0][2] * m.m[2][3] * m.m[3][1] -
+        m.m[0][3] * m.m[2][1] * m.m[3][2] + m.m[0][3] * m.m[2][2] * m.m[3][1] +
+        m.m[0][2] * m.m[2][1] * m.m[3][3] + m.m[0][1] * m.m[2][3] * m.m[3][2]) * recpDeterminant;
+    result.m[0][2] = (m.m[0][1] * m.m[1][2] * m.m[3][3] + m.m[0][2] * m.m[1][3] * m.m[3][1] +
+        m.m[0][3] * m.m[1][1] * m.m[3][2] - m.m[0][3] * m.m[1][2] * m.m[3][1] -
+        m.m[0][2] * m.m[1][1] * m.m[3][3] - m.m[0][1] * m.m[1][3] * m.m[3][2]) * recpDeterminant;
+    result.m[0][3] = (-m.m[0][1] * m.m[1][2] * m.m[2][3] - m.m[0][2] * m.m[1][3] * m.m[2][1] -
+        m.m[0][3] * m.m[1][1] * m.m[2][2] + m.m[0][3] * m.m[1][2] * m.m[2][1] +
+        m.m[0][2] * m.m[1][1] * m.m[2][3] + m.m[0][1] * m.m[1][3] * m.m[2][2]) * recpDeterminant;
+
+    result.m[1][0] = (-m.m[1][0] * m.m[2][2] * m.m[3][3] - m.m[1][2] * m.m[2][3] * m.m[3][0] -
+        m.m[1][3] * m.m[2][0] * m.m[3][2] + m.m[1][3] * m.m[2][2] * m.m[3][0] +
+        m.m[1][2] * m.m[2][0] * m.m[3][3] + m.m[1][0] * m.m[2][3] * m.m[3][2]) * recpDeterminant;
+    result.m[1][1] = (m.m[0][0] * m.m[2][2] * m.m[3][3] + m.m[0][2] * m.m[2][3] * m.m[3][0] +
+        m.m[0][3] * m.m[2][0] * m.m[3][2] - m.m[0][3] * m.m[2][2] * m.m[3][0] -
+        m.m[0][2] * m.m[2][0] * m.m[3][3] - m.m[0][0] * m.m[2][3] * m.m[3][2]) * recpDeterminant;
+    result.m[1][2] = (-m.m[0][0] * m.m[1][2] * m.m[3][3] - m.m[0][2] * m.m[1][3] * m.m[3][0] -
+        m.m[0][3] * m.m[1][0] * m.m[3][2] + m.m[0][3] * m.m[1][2] * m.m[3][0] +
+        m.m[0][2] * m.m[1][0] * m.m[3][3] + m.m[0][0] * m.m[1][3] * m.m[3][2]) * recpDeterminant;
+    result.m[1][3] = (m.m[0][0] * m.m[1][2] * m.m[2][3] + m.m[0][2] * m.m[1][3] * m.m[2][0] +
+        m.m[0][3] * m.m[1][0] * m.m[2][2] - m.m[0][3] * m.m[1][2] * m.m[2][0] -
+        m.m[0][2] * m.m[1][0] * m.m[2][3] - m.m[0][0] * m.m[1][3] * m.m[2][2]) * recpDeterminant;
+
+    result.m[2][0] = (m.m[1][0] * m.m[2][1] * m.m[3][3] + m.m[1][1] * m.m[2][3] * m.m[3][0] +
+        m.m[1][3] * m.m[2][0] * m.m[3][1] - m.m[1][3] * m.m[2][1] * m.m[3][0] -
+        m.m[1][1] * m.m[2][0] * m.m[3][3] - m.m[1][0] * m.m[2][3] * m.m[3][1]) * recpDeterminant;
+    result.m[2][1] = (-m.m[0][0] * m.m[2][1] * m.m[3][3] - m.m[0][1] * m.m[2][3] * m.m[3][0] -
+        m.m[0][3] * m.m[2][0] * m.m[3][1] + m.m[0][3] * m.m[2][1] * m.m[3][0] +
+        m.m[0][1] * m.m[2][0] * m.m[3][3] + m.m[0][0] * m.m[2][3] * m.m[3][1]) * recpDeterminant;
+    result.m[2][2] = (m.m[0][0] * m.m[1][1] * m.m[3][3] + m.m[0][1] * m.m[1][3] * m.m[3][0] +
+        m.m[0][3] * m.m[1][0] * m.m[3][1] - m.m[0][3] * m.m[1][1] * m.m[3][0] -
+        m.m[0][1] * m.m[1][0] * m.m[3][3] - m.m[0][0] * m.m[1][3] * m.m[3][1]) * recpDeterminant;
+    result.m[2][3] = (-m.m[0][0] * m.m[1][1] * m.m[2][3] - m.m[0][1] * m.m[1][3] * m.m[2][0] -
+        m.m[0][3] * m.m[1][0] * m.m[2][1] + m.m[0][3] * m.m[1][1] * m.m[2][0] +
+        m.m[0][1] * m.m[1][0] * m.m[2][3] + m.m[0][0] * m.m[1][3] * m.m[2][1]) * recpDeterminant;
+
+    result.m[3][0] = (-m.m[1][0] * m.m[2][1] * m.m[3][2] - m.m[1][1] * m.m[2][2] * m.m[3][0] -
+        m.m[1][2] * m.m[2][0] * m.m[3][1] + m.m[1][2] * m.m[2][1] * m.m[3][0] +
+        m.m[1][1] * m.m[2][0] * m.m[3][2] + m.m[1][0] * m.m[2][2] * m.m[3][1]) * recpDeterminant;
+    result.m[3][1] = (m.m[0][0] * m.m[2][1] * m.m[3][2] + m.m[0][1] * m.m[2][2] * m.m[3][0] +
+        m.m[0][2] * m.m[2][0] * m.m[3][1] - m.m[0][2] * m.m[2][1] * m.m[3][0] -
+        m.m[0][1] * m.m[2][0] * m.m[3][2] - m.m[0][0] * m.m[2][2] * m.m[3][1]) * recpDeterminant;
+    result.m[3][2] = (-m.m[0][0] * m.m[1][1] * m.m[3][2] - m.m[0][1] * m.m[1][2] * m.m[3][0] -
+        m.m[0][2] * m.m[1][0] * m.m[3][1] + m.m[0][2] * m.m[1][1] * m.m[3][0] +
+        m.m[0][1] * m.m[1][0] * m.m[3][2] + m.m[0][0] * m.m[1][2] * m.m[3][1]) * recpDeterminant;
+    result.m[3][3] = (m.m[0][0] * m.m[1][1] * m.m[2][2] + m.m[0][1] * m.m[1][2] * m.m[2][0] +
+        m.m[0][2] * m.m[1][0] * m.m[2][1] - m.m[0][2] * m.m[1][1] * m.m[2][0] -
+        m.m[0][1] * m.m[1][0] * m.m[2][2] - m.m[0][0] * m.m[1][2] * m.m[2][1]) * recpDeterminant;
+
+    return result;
+    // clang-format on
+}
+
+Matrix4x4 Transpose(const Matrix4x4& m) {
+    Matrix4x4 result;
+    result.m[0][0] = m.m[0][0];
+    result.m[0][1] = m.m[1][0];
+    result.m[0][2] = m.m[2][0];
+    result.m[0][3] = m.m[3][0];
+
+    result.m[1][0] = m.m[0][1];
+    result.m[1][1] = m.m[1][1];
+    result.m[1][2] = m.m[2][1];
+    result.m[1][3] = m.m[3][1];
+
+    result.m[2][0] = m.m[0][2];
+    result.m[2][1] = m.m[1][2];
+    result.m[2][2] = m.m[2][2];
+    result.m[2][3] = m.m[3][2];
+
+    result.m[3][0] = m.m[0][3];
+    result.m[3][1] = m.m[1][3];
+    result.m[3][2] = m.m[2][3];
+    result.m[3][3] = m.m[3][3];
+
+    return result;
+}
+
+Matrix4x4 MakeIdentity4x4() {
+    // clang-format off
+    Matrix4x4 identity;
+    identity.m[0][0] = 1.0f;	identity.m[0][1] = 0.0f;	identity.m[0][2] = 0.0f;	identity.m[0][3] = 0.0f;
+    identity.m[1][0] = 0.0f;	identity.m[1][1] = 1.0f;	identity.m[1][2] = 0.0f;	identity.m[1][3] = 0.0f;
+    identity.m[2][0] = 0.0f;	identity.m[2][1] = 0.0f;	identity.m[2][2] = 1.0f;	identity.m[2][3] = 0.0f;
+    identity.m[3][0] = 0.0f;	identity.m[3][1] = 0.0f;	identity.m[3][2] = 0.0f;	identity.m[3][3] = 1.0f;
+    return identity;
+    // clang-format on
+}
+
+Matrix4x4 MakeTranslateMatrix(const Vector3& translate) {
+    return {
+      1.0f, 0.0f, 0.0f, 0.0f,
+      0.0f, 1.0f, 0.0f, 0.0f,
+      0.0f, 0.0f, 1.0f, 0.0f,
+      translate.x, translate.y, translate.z, 1.0f,
+    };
+}
+
+Matrix4x4 MakeScaleMatrix(const Vector3& scale) {
+    return {
+      scale.x, 0.0f, 0.0f, 0.0f,
+      0.0f, scale.y, 0.0f, 0.0f,
+      0.0f, 0.0f, scale.z, 0.0f,
+      0.0f, 0.0f, 0.0f, 1.0f,
+    };
+}
+
+Matrix4x4 MakeRotateXMatrix(float radian) {
+    float cosTheta = std::cos(radian);
+    float sinTheta = std::sin(radian);
+    return { 1.0f, 0.0f, 0.0f, 0.0f,
+            0.0f, cosTheta, sinTheta, 0.0f,
+            0.0f, -sinTheta, cosTheta, 0.0f,
+            0.0f, 0.0f, 0.0f, 1.0f };
+}
+
+Matrix4x4 MakeRotateYMatrix(float radian) {
+    float cosTheta = std::cos(radian);
+    float sinTheta = std::sin(radian);
+    return { cosTheta, 0.0f, -sinTheta, 0.0f,
+            0.0f, 1.0f, 0.0f, 0.0f,
+            sinTheta, 0.0f, cosTheta, 0.0f,
+            0.0f, 0.0f, 0.0f, 1.0f };
+}
+
+Matrix4x4 MakeRotateZMatrix(float radian) {
+    float cosTheta = std::cos(radian);
+    float sinTheta = std::sin(radian);
+    return { cosTheta, sinTheta, 0.0f, 0.0f,
+            -sinTheta, cosTheta, 0.0f , 0.0f,
+            0.0f, 0.0f, 1.0f, 0.0f,
+            0.0f, 0.0f, 0.0f, 1.0f };
+}
+
+
+Matrix4x4 Multiply(const Matrix4x4& m1, const Matrix4x4& m2) {
+    Matrix4x4 result;
+    result.m[0][0] = m1.m[0][0] * m2.m[0][0] + m1.m[0][1] * m2.m[1][0] + m1.m[0][2] * m2.m[2][0] + m1.m[0][3] * m2.m[3][0];
+    result.m[0][1] = m1.m[0][0] * m2.m[0][1] + m1.m[0][1] * m2.m[1][1] + m1.m[0][2] * m2.m[2][1] + m1.m[0][3] * m2.m[3][1];
+    result.m[0][2] = m1.m[0][0] * m2.m[0][2] + m1.m[0][1] * m2.m[1][2] + m1.m[0][2] * m2.m[2][2] + m1.m[0][3] * m2.m[3][2];
+    result.m[0][3] = m1.m[0][0] * m2.m[0][3] + m1.m[0][1] * m2.m[1][3] + m1.m[0][2] * m2.m[2][3] + m1.m[0][3] * m2.m[3][3];
+
+    result.m[1][0] = m1.m[1][0] * m2.m[0][0] + m1.m[1][1] * m2.m[1][0] + m1.m[1][2] * m2.m[2][0] + m1.m[1][3] * m2.m[3][0];
+    result.m[1][1] = m1.m[1][0] * m2.m[0][1] + m1.m[1][1] * m2.m[1][1] + m1.m[1][2] * m2.m[2][1] + m1.m[1][3] * m2.m[3][1];
+    result.m[1][2] = m1.m[1][0] * m2.m[0][2] + m1.m[1][1] * m2.m[1][2] + m1.m[1][2] * m2.m[2][2] + m1.m[1][3] * m2.m[3][2];
+    result.m[1][3] = m1.m[1][0] * m2.m[0][3] + m1.m[1][1] * m2.m[1][3] + m1.m[1][2] * m2.m[2][3] + m1.m[1][3] * m2.m[3][3];
+
+    result.m[2][0] = m1.m[2][0] * m2.m[0][0] + m1.m[2][1] * m2.m[1][0] + m1.m[2][2] * m2.m[2][0] + m1.m[2][3] * m2.m[3][0];
+    result.m[2][1] = m1.m[2][0] * m2.m[0][1] + m1.m[2][1] * m2.m[1][1] + m1.m[2][2] * m2.m[2][1] + m1.m[2][3] * m2.m[3][1];
+    result.m[2][2] = m1.m[2][0] * m2.m[0][2] + m1.m[2][1] * m2.m[1][2] + m1.m[2][2] * m2.m[2][2] + m1.m[2][3] * m2.m[3][2];
+    result.m[2][3] = m1.m[2][0] * m2.m[0][3] + m1.m[2][1] * m2.m[1][3] + m1.m[2][2] * m2.m[2][3] + m1.m[2][3] * m2.m[3][3];
+
+    result.m[3][0] = m1.m[3][0] * m2.m[0][0] + m1.m[3][1] * m2.m[1][0] + m1.m[3][2] * m2.m[2][0] + m1.m[3][3] * m2.m[3][0];
+    result.m[3][1] = m1.m[3][0] * m2.m[0][1] + m1.m[3][1] * m2.m[1][1] + m1.m[3][2] * m2.m[2][1] + m1.m[3][3] * m2.m[3][1];
+    result.m[3][2] = m1.m[3][0] * m2.m[0][2] + m1.m[3][1] * m2.m[1][2] + m1.m[3][2] * m2.m[2][2] + m1.m[3][3] * m2.m[3][2];
+    result.m[3][3] = m1.m[3][0] * m2.m[0][3] + m1.m[3][1] * m2.m[1][3] + m1.m[3][2] * m2.m[2][3] + m1.m[3][3] * m2.m[3][3];
+
+    return result;
+}
+
+Matrix4x4 MakeAffineMatrix(const Vector3& scale, const Vector3& rotate, const Vector3& translate) {
+    Matrix4x4 result = Multiply(Multiply(MakeRotateXMatrix(rotate.x), MakeRotateYMatrix(rotate.y)), MakeRotateZMatrix(rotate.z));
+    result.m[0][0] *= scale.x;
+    result.m[0][1] *= scale.x;
+    result.m[0][2] *= scale.x;
+
+    result.m[1][0] *= scale.y;
+    result.m[1][1] *= scale.y;
+    result.m[1][2] *= scale.y;
+
+    result.m[2][0] *= scale.z;
+    result.m[2][1] *= scale.z;
+    result.m[2][2] *= scale.z;
+
+    result.m[3][0] = translate.x;
+    result.m[3][1] = translate.y;
+    result.m[3][2] = translate.z;
+    return result;
+}
+
+// clang-format off
+Matrix4x4 MakePerspectiveFovMatrix(float fovY, float aspectRatio, float nearClip, float farClip)
+{
+    float cotHalfFovV = 1.0f / std::tan(fovY / 2.0f);
+    return {
+        (cotHalfFovV / aspectRatio), 0.0f, 0.0f, 0.0f,
+        0.0f, cotHalfFovV, 0.0f, 0.0f,
+        0.0f, 0.0f, farClip / (farClip - nearClip), 1.0f,
+        0.0f, 0.0f, -(nearClip * farClip) / (farClip - nearClip), 0.0f
+    };
+}
+
+Matrix4x4 MakeOrthographicMatrix(float left, float top, float right, float bottom, float nearClip, float farClip)
+{
+    return {
+        2.0f / (right - left), 0.0f, 0.0f, 0.0f,
+        0.0f, 2.0f / (top - bottom), 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f / (farClip - nearClip), 0.0f,
+        (left + right) / (left - right), (top + bottom) / (bottom - top), nearClip / (nearClip - farClip), 1.0f,
+    };
+}
+
+// clang-format on
@@ -0,0 +1,56 @@
+#pragma once
+#include "MathTypes.h"
+
+// 行列は行ベクトル形式(v * M)で、m[3]が移動
+
+float Dot(const Vector3& v1, const Vector3& v2);
+
+float Length(const Vector3& v);
+
+/// <summary>
+/// 長さ1にしたベクトル。長さ0ならそのまま返す
+/// </summary>
+Vector3 Normalize(const Vector3& v);
+
+Matrix4x4 Add(const Matrix4x4& m1, const Matrix4x4& m2);
+
+Matrix4x4 Subtract(const Matrix4x4& m1, const Matrix4x4& m2);
+
+/// <summary>
+/// 逆行列。行列式と余因子を展開した式で求める。行列式が0なら結果は無限大かNaNになる
+/// </summary>
+Matrix4x4 Inverse(const Matrix4x4& m);
+
+Matrix4x4 Transpose(const Matrix4x4& m);
+
+Matrix4x4 MakeIdentity4x4();
+
+Matrix4x4 MakeTranslateMatrix(const Vector3& translate);
+
+Matrix4x4 MakeScaleMatrix(const Vector3& scale);
+
+Matrix4x4 MakeRotateXMatrix(float radian);
+
+Matrix4x4 MakeRotateYMatrix(float radian);
+
+Matrix4x4 MakeRotateZMatrix(float radian);
+
+/// <summary>
+/// m1 * m2
+/// </summary>
+Matrix4x4 Multiply(const Matrix4x4& m1, const Matrix4x4& m2);
+
+/// <summary>
+/// 拡縮→X→Y→Z回転→移動の順にかけた行列
+/// </summary>
+Matrix4x4 MakeAffineMatrix(const Vector3& scale, const Vector3& rotate, const Vector3& translate);
+
+/// <summary>
+/// 透視投影行列。Zはnear~farを0~1に写す
+/// </summary>
+Matrix4x4 MakePerspectiveFovMatrix(float fovY, float aspectRatio, float nearClip, float farClip);
+
+/// <summary>
+/// 正射影行列。Zはnear~farを0~1に写す
+/// </summary>
+Matrix4x4 MakeOrthographicMatrix(float left, float top, float right, float bottom, float nearClip, float farClip);
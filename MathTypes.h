@@ -0,0 +1,39 @@
+#pragma once
+
+struct Vector2 {
+    float x;
+    float y;
+};
+
+struct Vector3 {
+    float x;
+    float y;
+    float z;
+};
+
+struct Vector4 {
+    float x;
+    float y;
+    float z;
+    float w;
+};
+
+struct Matrix4x4 {
+    float m[4][4];
+};
+
+struct Transform {
+    Vector3 scale;
+    Vector3 rotate;
+    Vector3 translate;
+};
+
+struct AABB {
+    Vector3 min;
+    Vector3 max;
+};
+
+struct Sphere {
+    Vector3 center;
+    float radius;
+};
@@ -0,0 +1,433 @@
+#include "MatrixSimd.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <immintrin.h>
+
+#include <atomic>
+
+namespace {
+
+/// <summary>
+/// 命令セットごとの計算の入口
+/// </summary>
+struct MatrixKernels {
+    SimdLevel level;
+    Matrix4x4A (*multiply)(const Matrix4x4A&, const Matrix4x4A&);
+    Matrix4x4A (*transpose)(const Matrix4x4A&);
+    Matrix4x4A (*inverse)(const Matrix4x4A&);
+    void (*transformVectors)(const Vector4*, Vector4*, size_t, const Matrix4x4A&);
+};
+
+Matrix4x4A MultiplyScalar(const Matrix4x4A& m1, const Matrix4x4A& m2)
+{
+    Matrix4x4A result;
+    for (int row = 0; row < 4; ++row) {
+        for (int column = 0; column < 4; ++column) {
+            result.m[row][column] = m1.m[row][0] * m2.m[0][column] + m1.m[row][1] * m2.m[1][column] +
+                m1.m[row][2] * m2.m[2][column] + m1.m[row][3] * m2.m[3][column];
+        }
+    }
+    return result;
+}
+
+Matrix4x4A TransposeScalar(const Matrix4x4A& m)
+{
+    Matrix4x4A result;
+    for (int row = 0; row < 4; ++row) {
+        for (int column = 0; column < 4; ++column) {
+            result.m[row][column] = m.m[column][row];
+        }
+    }
+    return result;
+}
+
+Matrix4x4A InverseScalar(const Matrix4x4A& m)
+{
+    // 上2行と下2行から作れる2x2の小行列式を先に求め、余因子を組み立てる
+    float s0 = m.m[0][0] * m.m[1][1] - m.m[1][0] * m.m[0][1];
+    float s1 = m.m[0][0] * m.m[1][2] - m.m[1][0] * m.m[0][2];
+    float s2 = m.m[0][0] * m.m[1][3] - m.m[1][0] * m.m[0][3];
+    float s3 = m.m[0][1] * m.m[1][2] - m.m[1][1] * m.m[0][2];
+    float s4 = m.m[0][1] * m.m[1][3] - m.m[1][1] * m.m[0][3];
+    float s5 = m.m[0][2] * m.m[1][3] - m.m[1][2] * m.m[0][3];
+
+    float c5 = m.m[2][2] * m.m[3][3] - m.m[3][2] * m.m[2][3];
+    float c4 = m.m[2][1] * m.m[3][3] - m.m[3][1] * m.m[2][3];
+    float c3 = m.m[2][1] * m.m[3][2] - m.m[3][1] * m.m[2][2];
+    float c2 = m.m[2][0] * m.m[3][3] - m.m[3][0] * m.m[2][3];
+    float c1 = m.m[2][0] * m.m[3][2] - m.m[3][0] * m.m[2][2];
+    float c0 = m.m[2][0] * m.m[3][1] - m.m[3][0] * m.m[2][1];
+
+    float recpDeterminant = 1.0f / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+
+    // clang-format off
+    Matrix4x4A result;
+    result.m[0][0] = ( m.m[1][1] * c5 - m.m[1][2] * c4 + m.m[1][3] * c3) * recpDeterminant;
+    result.m[0][1] = (-m.m[0][1] * c5 + m.m[0][2] * c4 - m.m[0][3] * c3) * recpDeterminant;
+    result.m[0][2] = ( m.m[3][1] * s5 - m.m[3][2] * s4 + m.m[3][3] * s3) * recpDeterminant;
+    result.m[0][3] = (-m.m[2][1] * s5 + m.m[2][2] * s4 - m.m[2][3] * s3) * recpDeterminant;
+
+    result.m[1][0] = (-m.m[1][0] * c5 + m.m[1][2] * c2 - m.m[1][3] * c1) * recpDeterminant;
+    result.m[1][1] = ( m.m[0][0] * c5 - m.m[0][2] * c2 + m.m[0][3] * c1) * recpDeterminant;
+    result.m[1][2] = (-m.m[3][0] * s5 + m.m[3][2] * s2 - m.m[3][3] * s1) * recpDeterminant;
+    result.m[1][3] = ( m.m[2][0] * s5 - m.m[2][2] * s2 + m.m[2][3] * s1) * recpDeterminant;
+
+    result.m[2][0] = ( m.m[1][0] * c4 - m.m[1][1] * c2 + m.m[1][3] * c0) * recpDeterminant;
+    result.m[2][1] = (-m.m[0][0] * c4 + m.m[0][1] * c2 - m.m[0][3] * c0) * recpDeterminant;
+    result.m[2][2] = ( m.m[3][0] * s4 - m.m[3][1] * s2 + m.m[3][3] * s0) * recpDeterminant;
+    result.m[2][3] = (-m.m[2][0] * s4 + m.m[2][1] * s2 - m.m[2][3] * s0) * recpDeterminant;
+
+    result.m[3][0] = (-m.m[1][0] * c3 + m.m[1][1] * c1 - m.m[1][2] * c0) * recpDeterminant;
+    result.m[3][1] = ( m.m[0][0] * c3 - m.m[0][1] * c1 + m.m[0][2] * c0) * recpDeterminant;
+    result.m[3][2] = (-m.m[3][0] * s3 + m.m[3][1] * s1 - m.m[3][2] * s0) * recpDeterminant;
+    result.m[3][3] = ( m.m[2][0] * s3 - m.m[2][1] * s1 + m.m[2][2] * s0) * recpDeterminant;
+    // clang-format on
+    return result;
+}
+
+void TransformVectorsScalar(const Vector4* vectors, Vector4* result, size_t count, const Matrix4x4A& m)
+{
+    for (size_t i = 0; i < count; ++i) {
+        Vector4 v = vectors[i];
+        result[i] = {
+            v.x * m.m[0][0] + v.y * m.m[1][0] + v.z * m.m[2][0] + v.w * m.m[3][0],
+            v.x * m.m[0][1] + v.y * m.m[1][1] + v.z * m.m[2][1] + v.w * m.m[3][1],
+            v.x * m.m[0][2] + v.y * m.m[1][2] + v.z * m.m[2][2] + v.w * m.m[3][2],
+            v.x * m.m[0][3] + v.y * m.m[1][3] + v.z * m.m[2][3] + v.w * m.m[3][3],
+        };
+    }
+}
+
+// 以下のSSE4.1とAVX2の関数は、その命令セットがあるCPUでしか呼ばない
+
+/// <summary>
+/// 行ベクトルvとmの行(row0~row3)の積
+/// </summary>
+SIMD_TARGET_SSE41 __m128 TransformRowSse(__m128 v, __m128 row0, __m128 row1, __m128 row2, __m128 row3)
+{
+    __m128 result = _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)), row0);
+    result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)), row1));
+    result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)), row2));
+    return _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3)), row3));
+}
+
+SIMD_TARGET_SSE41 Matrix4x4A MultiplySse41(const Matrix4x4A& m1, const Matrix4x4A& m2)
+{
+    __m128 row0 = _mm_load_ps(m2.m[0]);
+    __m128 row1 = _mm_load_ps(m2.m[1]);
+    __m128 row2 = _mm_load_ps(m2.m[2]);
+    __m128 row3 = _mm_load_ps(m2.m[3]);
+    Matrix4x4A result;
+    for (int row = 0; row < 4; ++row) {
+        _mm_store_ps(result.m[row], TransformRowSse(_mm_load_ps(m1.m[row]), row0, row1, row2, row3));
+    }
+    return result;
+}
+
+SIMD_TARGET_SSE41 Matrix4x4A TransposeSse41(const Matrix4x4A& m)
+{
+    __m128 row0 = _mm_load_ps(m.m[0]);
+    __m128 row1 = _mm_load_ps(m.m[1]);
+    __m128 row2 = _mm_load_ps(m.m[2]);
+    __m128 row3 = _mm_load_ps(m.m[3]);
+    _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+    Matrix4x4A result;
+    _mm_store_ps(result.m[0], row0);
+    _mm_store_ps(result.m[1], row1);
+    _mm_store_ps(result.m[2], row2);
+    _mm_store_ps(result.m[3], row3);
+    return result;
+}
+
+// 2x2の行列を1つの__m128に(m00, m01, m10, m11)の順で入れて計算する。A#はAの余因子行列
+
+/// <summary>
+/// a * b
+/// </summary>
+SIMD_TARGET_SSE41 __m128 Multiply2x2(__m128 a, __m128 b)
+{
+    return _mm_add_ps(_mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 3, 0))),
+        _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+}
+
+/// <summary>
+/// a# * b
+/// </summary>
+SIMD_TARGET_SSE41 __m128 AdjugateMultiply2x2(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 3, 3)), b),
+        _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 1, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2))));
+}
+
+/// <summary>
+/// a * b#
+/// </summary>
+SIMD_TARGET_SSE41 __m128 MultiplyAdjugate2x2(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 3, 0, 3))),
+        _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+}
+
+SIMD_TARGET_SSE41 Matrix4x4A InverseSse41(const Matrix4x4A& m)
+{
+    // M = | A B |
+    //     | C D | と2x2の小行列に分け、M^-1 = 1/|M| * | X Y | の各小行列の余因子行列を求める
+    //                                              | Z W |
+    __m128 row0 = _mm_load_ps(m.m[0]);
+    __m128 row1 = _mm_load_ps(m.m[1]);
+    __m128 row2 = _mm_load_ps(m.m[2]);
+    __m128 row3 = _mm_load_ps(m.m[3]);
+    __m128 a = _mm_movelh_ps(row0, row1);
+    __m128 b = _mm_movehl_ps(row1, row0);
+    __m128 c = _mm_movelh_ps(row2, row3);
+    __m128 d = _mm_movehl_ps(row3, row2);
+
+    // (|A|, |B|, |C|, |D|)
+    __m128 subDeterminants = _mm_sub_ps(
+        _mm_mul_ps(_mm_shuffle_ps(row0, row2, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(row1, row3, _MM_SHUFFLE(3, 1, 3, 1))),
+        _mm_mul_ps(_mm_shuffle_ps(row0, row2, _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(row1, row3, _MM_SHUFFLE(2, 0, 2, 0))));
+    __m128 determinantA = _mm_shuffle_ps(subDeterminants, subDeterminants, _MM_SHUFFLE(0, 0, 0, 0));
+    __m128 determinantB = _mm_shuffle_ps(subDeterminants, subDeterminants, _MM_SHUFFLE(1, 1, 1, 1));
+    __m128 determinantC = _mm_shuffle_ps(subDeterminants, subDeterminants, _MM_SHUFFLE(2, 2, 2, 2));
+    __m128 determinantD = _mm_shuffle_ps(subDeterminants, subDeterminants, _MM_SHUFFLE(3, 3, 3, 3));
+
+    __m128 adjugateDC = AdjugateMultiply2x2(d, c);
+    __m128 adjugateAB = AdjugateMultiply2x2(a, b);
+    // X# = |D|A - B(D#C), W# = |A|D - C(A#B), Y# = |B|C - D(A#B)#, Z# = |C|B - A(D#C)#
+    __m128 x = _mm_sub_ps(_mm_mul_ps(determinantD, a), Multiply2x2(b, adjugateDC));
+    __m128 w = _mm_sub_ps(_mm_mul_ps(determinantA, d), Multiply2x2(c, adjugateAB));
+    __m128 y = _mm_sub_ps(_mm_mul_ps(determinantB, c), MultiplyAdjugate2x2(d, adjugateAB));
+    __m128 z = _mm_sub_ps(_mm_mul_ps(determinantC, b), MultiplyAdjugate2x2(a, adjugateDC));
+
+    // |M| = |A||D| + |B||C| - tr((A#B)(D#C))
+    __m128 trace = _mm_mul_ps(adjugateAB, _mm_shuffle_ps(adjugateDC, adjugateDC, _MM_SHUFFLE(3, 1, 2, 0)));
+    trace = _mm_hadd_ps(trace, trace);
+    trace = _mm_hadd_ps(trace, trace);
+    __m128 determinant = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(determinantA, determinantD), _mm_mul_ps(determinantB, determinantC)), trace);
+
+    // 余因子行列に戻すときの符号をかけておく
+    __m128 recpDeterminant = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), determinant);
+    x = _mm_mul_ps(x, recpDeterminant);
+    y = _mm_mul_ps(y, recpDeterminant);
+    z = _mm_mul_ps(z, recpDeterminant);
+    w = _mm_mul_ps(w, recpDeterminant);
+
+    // 余因子行列への並べ替えと、行ごとへの並べ替えを一度にする
+    Matrix4x4A result;
+    _mm_store_ps(result.m[0], _mm_shuffle_ps(x, y, _MM_SHUFFLE(1, 3, 1, 3)));
+    _mm_store_ps(result.m[1], _mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 2, 0, 2)));
+    _mm_store_ps(result.m[2], _mm_shuffle_ps(z, w, _MM_SHUFFLE(1, 3, 1, 3)));
+    _mm_store_ps(result.m[3], _mm_shuffle_ps(z, w, _MM_SHUFFLE(0, 2, 0, 2)));
+    return result;
+}
+
+SIMD_TARGET_SSE41 void TransformVectorsSse41(const Vector4* vectors, Vector4* result, size_t count, const Matrix4x4A& m)
+{
+    __m128 row0 = _mm_load_ps(m.m[0]);
+    __m128 row1 = _mm_load_ps(m.m[1]);
+    __m128 row2 = _mm_load_ps(m.m[2]);
+    __m128 row3 = _mm_load_ps(m.m[3]);
+    for (size_t i = 0; i < count; ++i) {
+        _mm_storeu_ps(&result[i].x, TransformRowSse(_mm_loadu_ps(&vectors[i].x), row0, row1, row2, row3));
+    }
+}
+
+/// <summary>
+/// 2つの行ベクトル(下位と上位の128bit)それぞれと、両方の128bitに同じ行を入れたrow0~row3の積
+/// </summary>
+SIMD_TARGET_AVX2 __m256 TransformRowsAvx2(__m256 v, __m256 row0, __m256 row1, __m256 row2, __m256 row3)
+{
+    __m256 result = _mm256_mul_ps(_mm256_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)), row0);
+    result = _mm256_fmadd_ps(_mm256_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)), row1, result);
+    result = _mm256_fmadd_ps(_mm256_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)), row2, result);
+    return _mm256_fmadd_ps(_mm256_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3)), row3, result);
+}
+
+SIMD_TARGET_AVX2 Matrix4x4A MultiplyAvx2(const Matrix4x4A& m1, const Matrix4x4A& m2)
+{
+    __m256 row0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m2.m[0]));
+    __m256 row1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m2.m[1]));
+    __m256 row2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m2.m[2]));
+    __m256 row3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m2.m[3]));
+    // m1の2行ずつまとめて計算する
+    Matrix4x4A result;
+    _mm256_store_ps(result.m[0], TransformRowsAvx2(_mm256_load_ps(m1.m[0]), row0, row1, row2, row3));
+    _mm256_store_ps(result.m[2], TransformRowsAvx2(_mm256_load_ps(m1.m[2]), row0, row1, row2, row3));
+    return result;
+}
+
+SIMD_TARGET_AVX2 void TransformVectorsAvx2(const Vector4* vectors, Vector4* result, size_t count, const Matrix4x4A& m)
+{
+    __m256 row0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m.m[0]));
+    __m256 row1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m.m[1]));
+    __m256 row2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m.m[2]));
+    __m256 row3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m.m[3]));
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        _mm256_storeu_ps(&result[i].x, TransformRowsAvx2(_mm256_loadu_ps(&vectors[i].x), row0, row1, row2, row3));
+    }
+    if (i < count) {
+        __m128 v = _mm_loadu_ps(&vectors[i].x);
+        __m128 transformed = _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)), _mm256_castps256_ps128(row0));
+        transformed = _mm_fmadd_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)), _mm256_castps256_ps128(row1), transformed);
+        transformed = _mm_fmadd_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)), _mm256_castps256_ps128(row2), transformed);
+        transformed = _mm_fmadd_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3)), _mm256_castps256_ps128(row3), transformed);
+        _mm_storeu_ps(&result[i].x, transformed);
+    }
+}
+
+// 転置と逆行列は4x4が128bitの4行にちょうど収まり、256bitにしても並べ替えが増えるだけなのでAVX2でもSSE4.1の関数を使う
+constexpr MatrixKernels kScalarKernels = { SimdLevel::Scalar, MultiplyScalar, TransposeScalar, InverseScalar, TransformVectorsScalar };
+constexpr MatrixKernels kSse41Kernels = { SimdLevel::Sse41, MultiplySse41, TransposeSse41, InverseSse41, TransformVectorsSse41 };
+constexpr MatrixKernels kAvx2Kernels = { SimdLevel::Avx2, MultiplyAvx2, TransposeSse41, InverseSse41, TransformVectorsAvx2 };
+
+const MatrixKernels& GetKernels(SimdLevel level)
+{
+    switch (level) {
+    case SimdLevel::Avx2:
+        return kAvx2Kernels;
+    case SimdLevel::Sse41:
+        return kSse41Kernels;
+    default:
+        return kScalarKernels;
+    }
+}
+
+std::atomic<const MatrixKernels*> currentKernels = nullptr; //!< 今使っている命令セットの計算の入口。最初に使うときに決める
+
+const MatrixKernels& LoadKernels()
+{
+    const MatrixKernels* kernels = currentKernels.load(std::memory_order_relaxed);
+    if (!kernels) {
+        kernels = &GetKernels(GetSupportedSimdLevel());
+        currentKernels.store(kernels, std::memory_order_relaxed);
+    }
+    return *kernels;
+}
+
+/// <summary>
+/// CPUIDのleaf(subleaf)を読む。registersはEAX、EBX、ECX、EDXの順
+/// </summary>
+void ReadCpuid(int registers[4], int leaf, int subleaf)
+{
+#ifdef _MSC_VER
+    __cpuidex(registers, leaf, subleaf);
+#else
+    unsigned int eax = 0;
+    unsigned int ebx = 0;
+    unsigned int ecx = 0;
+    unsigned int edx = 0;
+    __cpuid_count(static_cast<unsigned int>(leaf), static_cast<unsigned int>(subleaf), eax, ebx, ecx, edx);
+    registers[0] = static_cast<int>(eax);
+    registers[1] = static_cast<int>(ebx);
+    registers[2] = static_cast<int>(ecx);
+    registers[3] = static_cast<int>(edx);
+#endif
+}
+
+/// <summary>
+/// OSが退避するレジスタの種類(XCR0)。OSXSAVEがあるときだけ呼ぶ
+/// </summary>
+uint64_t ReadXcr0()
+{
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned int eax = 0;
+    unsigned int edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+} // namespace
+
+SimdLevel GetSupportedSimdLevel()
+{
+    static const SimdLevel supportedLevel = [] {
+        int registers[4];
+        ReadCpuid(registers, 0, 0);
+        int maxLeaf = registers[0];
+        ReadCpuid(registers, 1, 0);
+        int features = registers[2];
+        bool hasSse3 = (features & (1 << 0)) != 0;
+        bool hasSsse3 = (features & (1 << 9)) != 0;
+        bool hasFma = (features & (1 << 12)) != 0;
+        bool hasSse41 = (features & (1 << 19)) != 0;
+        bool hasOsXsave = (features & (1 << 27)) != 0;
+        bool hasAvx = (features & (1 << 28)) != 0;
+        if (!hasSse3 || !hasSsse3 || !hasSse41) {
+            return SimdLevel::Scalar;
+        }
+
+        // AVXのレジスタはOSが退避してくれるときだけ使える
+        bool osSavesYmm = hasOsXsave && (ReadXcr0() & 0x6) == 0x6;
+        bool hasAvx2 = false;
+        if (maxLeaf >= 7) {
+            ReadCpuid(registers, 7, 0);
+            hasAvx2 = (registers[1] & (1 << 5)) != 0;
+        }
+        if (hasAvx && hasAvx2 && hasFma && osSavesYmm) {
+            return SimdLevel::Avx2;
+        }
+        return SimdLevel::Sse41;
+    }();
+    return supportedLevel;
+}
+
+SimdLevel GetSimdLevel()
+{
+    return LoadKernels().level;
+}
+
+void SetSimdLevel(SimdLevel level)
+{
+    SimdLevel supportedLevel = GetSupportedSimdLevel();
+    if (static_cast<int>(level) > static_cast<int>(supportedLevel)) {
+        level = supportedLevel;
+    }
+    currentKernels.store(&GetKernels(level), std::memory_order_relaxed);
+}
+
+const char* GetSimdLevelName(SimdLevel level)
+{
+    switch (level) {
+    case SimdLevel::Avx2:
+        return "AVX2";
+    case SimdLevel::Sse41:
+        return "SSE4.1";
+    default:
+        return "Scalar";
+    }
+}
+
+Matrix4x4A Multiply(const Matrix4x4A& m1, const Matrix4x4A& m2)
+{
+    return LoadKernels().multiply(m1, m2);
+}
+
+Matrix4x4A Transpose(const Matrix4x4A& m)
+{
+    return LoadKernels().transpose(m);
+}
+
+Matrix4x4A Inverse(const Matrix4x4A& m)
+{
+    return LoadKernels().inverse(m);
+}
+
+Vector4 TransformVector(const Vector4& v, const Matrix4x4A& m)
+{
+    Vector4 result;
+    LoadKernels().transformVectors(&v, &result, 1, m);
+    return result;
+}
+
+void TransformVectors(const Vector4* vectors, Vector4* result, size_t count, const Matrix4x4A& m)
+{
+    LoadKernels().transformVectors(vectors, result, count, m);
+}
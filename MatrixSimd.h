@@ -0,0 +1,99 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "MathTypes.h"
+
+/// <summary>
+/// SIMD命令で計算するためのMatrix4x4。並びはMatrix4x4と同じ行ベクトル形式
+/// 64byte境界に置くので1つの行列がちょうど1キャッシュラインに収まり、2行ずつ256bitでそのまま読み書きできる
+/// </summary>
+struct alignas(64) Matrix4x4A {
+    float m[4][4];
+};
+
+/// <summary>
+/// Matrix4x4Aの計算に使う命令セット
+/// </summary>
+enum class SimdLevel {
+    Scalar, // SIMDを使わない。他の結果を確かめるときの基準
+    Sse41,
+    Avx2, // AVX2とFMA
+};
+
+// SSE4.1とAVX2の関数に付ける。GCCとClangはファイル全体の命令セットを上げずに、その関数だけをその命令セットでコンパイルする
+// MSVCは指定しなくても全ての組み込み関数を使える
+#if defined(__GNUC__) || defined(__clang__)
+#define SIMD_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define SIMD_TARGET_SSE41
+#define SIMD_TARGET_AVX2
+#endif
+
+/// <summary>
+/// CPUIDで調べた、このCPUとOSで使える最も新しい命令セット
+/// </summary>
+SimdLevel GetSupportedSimdLevel();
+
+/// <summary>
+/// 今使っている命令セット。最初はGetSupportedSimdLevel()
+/// </summary>
+SimdLevel GetSimdLevel();
+
+/// <summary>
+/// 使う命令セットを変える。比べるとき用で、対応していない命令セットを指定したら対応している中で最も新しいものになる
+/// </summary>
+void SetSimdLevel(SimdLevel level);
+
+/// <summary>
+/// 命令セットの名前
+/// </summary>
+const char* GetSimdLevelName(SimdLevel level);
+
+inline Matrix4x4A ToMatrix4x4A(const Matrix4x4& matrix)
+{
+    Matrix4x4A result;
+    for (int row = 0; row < 4; ++row) {
+        for (int column = 0; column < 4; ++column) {
+            result.m[row][column] = matrix.m[row][column];
+        }
+    }
+    return result;
+}
+
+inline Matrix4x4 ToMatrix4x4(const Matrix4x4A& matrix)
+{
+    Matrix4x4 result;
+    for (int row = 0; row < 4; ++row) {
+        for (int column = 0; column < 4; ++column) {
+            result.m[row][column] = matrix.m[row][column];
+        }
+    }
+    return result;
+}
+
+/// <summary>
+/// m1 * m2
+/// </summary>
+Matrix4x4A Multiply(const Matrix4x4A& m1, const Matrix4x4A& m2);
+
+/// <summary>
+/// 転置行列
+/// </summary>
+Matrix4x4A Transpose(const Matrix4x4A& m);
+
+/// <summary>
+/// 逆行列。2x2の小行列に分けて余因子を求める。行列式が0なら結果は無限大かNaNになる
+/// </summary>
+Matrix4x4A Inverse(const Matrix4x4A& m);
+
+/// <summary>
+/// 行ベクトルvとmの積(v * m)
+/// </summary>
+Vector4 TransformVector(const Vector4& v, const Matrix4x4A& m);
+
+/// <summary>
+/// count個の行ベクトルそれぞれとmの積をresultに書く。vectorsとresultは同じでもよい
+/// </summary>
+void TransformVectors(const Vector4* vectors, Vector4* result, size_t count, const Matrix4x4A& m);
@@ -0,0 +1,293 @@
+#include "MeshCache.h"
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "Hash.h"
+#include "MappedFile.h"
+#include "MeshSimplifier.h"
+#include "Meshlet.h"
+#include "VertexPacking.h"
+
+namespace {
+
+using namespace MeshCacheFormat;
+
+/// <summary>
+/// 書き出し待ちのセクション
+/// </summary>
+struct PendingSection {
+    SectionType type;
+    uint32_t elementSize;
+    const void* data;
+    uint64_t size;
+};
+
+uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+/// <summary>
+/// セクションの本体を配列にコピーする。要素のサイズが合わなければfalse
+/// </summary>
+template<typename T>
+bool CopySection(const MappedFile& file, const Section& section, std::vector<T>& output)
+{
+    if (section.elementSize != sizeof(T) || section.size % sizeof(T) != 0) {
+        return false;
+    }
+    const T* begin = reinterpret_cast<const T*>(file.GetData() + section.offset);
+    output.assign(begin, begin + section.size / sizeof(T));
+    return true;
+}
+
+} // namespace
+
+uint64_t HashFileContents(const std::filesystem::path& filePath)
+{
+    MappedFile file;
+    if (!file.Open(filePath)) {
+        return 0;
+    }
+    return HashBytes(file.GetData(), file.GetSize());
+}
+
+bool WriteMeshCache(const std::filesystem::path& cachePath, uint64_t sourceHash, const ModelData& modelData)
+{
+    // マテリアル名は'\0'区切りで1つの文字列にまとめる
+    std::string materialNames;
+    for (const MaterialData& material : modelData.materials) {
+        materialNames += material.name;
+        materialNames += '\0';
+    }
+
+    const PendingSection pendingSections[] = {
+        { SectionType::Vertices, sizeof(VertexData), modelData.vertices.data(), sizeof(VertexData) * modelData.vertices.size() },
+        { SectionType::Indices, sizeof(uint32_t), modelData.indices.data(), sizeof(uint32_t) * modelData.indices.size() },
+        { SectionType::SubMeshes, sizeof(SubMesh), modelData.subMeshes.data(), sizeof(SubMesh) * modelData.subMeshes.size() },
+        { SectionType::MaterialLibrary, 1, modelData.materialLibrary.data(), modelData.materialLibrary.size() },
+        { SectionType::MaterialNames, 1, materialNames.data(), materialNames.size() },
+        { SectionType::Meshlets, sizeof(Meshlet), modelData.meshlets.data(), sizeof(Meshlet) * modelData.meshlets.size() },
+        { SectionType::MeshletVertices, sizeof(uint32_t), modelData.meshletVertices.data(), sizeof(uint32_t) * modelData.meshletVertices.size() },
+        { SectionType::MeshletTriangles, sizeof(uint8_t), modelData.meshletTriangles.data(), modelData.meshletTriangles.size() },
+        { SectionType::Lods, sizeof(MeshLod), modelData.lods.data(), sizeof(MeshLod) * modelData.lods.size() },
+    };
+    constexpr uint32_t kSectionCount = static_cast<uint32_t>(sizeof(pendingSections) / sizeof(pendingSections[0]));
+
+    Header header{};
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.sourceHash = sourceHash;
+    header.bounds = modelData.bounds;
+    header.boundingSphere = modelData.boundingSphere;
+    header.sectionCount = kSectionCount;
+    header.vertexFormat = modelData.vertexFormat;
+
+    // 各セクションの配置を決める
+    Section sections[kSectionCount]{};
+    uint64_t offset = AlignUp(sizeof(Header) + sizeof(Section) * kSectionCount, kSectionAlignment);
+    for (uint32_t i = 0; i < kSectionCount; ++i) {
+        sections[i].type = pendingSections[i].type;
+        sections[i].elementSize = pendingSections[i].elementSize;
+        sections[i].offset = offset;
+        sections[i].size = pendingSections[i].size;
+        offset = AlignUp(offset + pendingSections[i].size, kSectionAlignment);
+    }
+
+    // 一時ファイルに書き出す
+    std::filesystem::path temporaryPath = cachePath;
+    temporaryPath += ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(sections), sizeof(sections));
+        const char padding[kSectionAlignment] = {};
+        for (uint32_t i = 0; i < kSectionCount; ++i) {
+            uint64_t position = static_cast<uint64_t>(file.tellp());
+            file.write(padding, static_cast<std::streamsize>(sections[i].offset - position));
+            file.write(static_cast<const char*>(pendingSections[i].data), static_cast<std::streamsize>(pendingSections[i].size));
+        }
+        if (!file) {
+            return false;
+        }
+    }
+
+    // 書き終わってから差し替える
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, cachePath, error);
+    if (error) {
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+    return true;
+}
+
+bool ReadMeshCache(const std::filesystem::path& cachePath, uint64_t sourceHash, ModelData& modelData, std::vector<std::string>& materialNames)
+{
+    MappedFile file;
+    if (!file.Open(cachePath) || file.GetSize() < sizeof(Header)) {
+        return false;
+    }
+
+    // ヘッダーを確認する。元ファイルの内容が変わっていたら古いキャッシュとして使わない
+    Header header;
+    std::memcpy(&header, file.GetData(), sizeof(header));
+    if (header.magic != kMagic || header.version != kVersion || header.sourceHash != sourceHash) {
+        return false;
+    }
+    if (header.vertexFormat > VertexFormat::PackedQuantized) {
+        return false;
+    }
+    uint64_t tableEnd = sizeof(Header) + sizeof(Section) * static_cast<uint64_t>(header.sectionCount);
+    if (tableEnd > file.GetSize()) {
+        return false;
+    }
+
+    ModelData result;
+    std::vector<std::string> names;
+    result.bounds = header.bounds;
+    result.boundingSphere = header.boundingSphere;
+    result.vertexFormat = header.vertexFormat;
+    const char* table = file.GetData() + sizeof(Header);
+    for (uint32_t i = 0; i < header.sectionCount; ++i) {
+        Section section;
+        std::memcpy(&section, table + sizeof(Section) * i, sizeof(section));
+        if (section.offset > file.GetSize() || section.size > file.GetSize() - section.offset) {
+            return false;
+        }
+
+        bool copied = true;
+        switch (section.type) {
+        case SectionType::Vertices:
+            copied = CopySection(file, section, result.vertices);
+            break;
+        case SectionType::Indices:
+            copied = CopySection(file, section, result.indices);
+            break;
+        case SectionType::SubMeshes:
+            copied = CopySection(file, section, result.subMeshes);
+            break;
+        case SectionType::MaterialLibrary:
+            result.materialLibrary.assign(file.GetData() + section.offset, static_cast<size_t>(section.size));
+            break;
+        case SectionType::Meshlets:
+            copied = CopySection(file, section, result.meshlets);
+            break;
+        case SectionType::MeshletVertices:
+            copied = CopySection(file, section, result.meshletVertices);
+            break;
+        case SectionType::MeshletTriangles:
+            copied = CopySection(file, section, result.meshletTriangles);
+            break;
+        case SectionType::Lods:
+            copied = CopySection(file, section, result.lods);
+            break;
+        case SectionType::MaterialNames: {
+            const char* name = file.GetData() + section.offset;
+            const char* end = name + section.size;
+            while (name < end) {
+                const char* terminator = static_cast<const char*>(std::memchr(name, '\0', static_cast<size_t>(end - name)));
+                if (!terminator) {
+                    return false;
+                }
+                names.emplace_back(name, terminator);
+                name = terminator + 1;
+            }
+            break;
+        }
+        default:
+            // 知らないセクションは読み飛ばす
+            break;
+        }
+        if (!copied) {
+            return false;
+        }
+    }
+
+    // 描画範囲がIndexバッファからはみ出していないか確認する
+    for (const SubMesh& subMesh : result.subMeshes) {
+        if (static_cast<uint64_t>(subMesh.indexStart) + subMesh.indexCount > result.indices.size() || subMesh.materialIndex >= names.size()) {
+            return false;
+        }
+    }
+
+    // 頂点を指していないIndexがあれば、描画でVertexバッファの外を読むので使わない
+    for (uint32_t index : result.indices) {
+        if (index >= result.vertices.size()) {
+            return false;
+        }
+    }
+
+    // LODがSubMeshの範囲に収まっているか確認する。LOD0は必ずある
+    if (result.lods.empty()) {
+        return false;
+    }
+    for (const MeshLod& lod : result.lods) {
+        if (static_cast<uint64_t>(lod.subMeshStart) + lod.subMeshCount > result.subMeshes.size()) {
+            return false;
+        }
+    }
+
+    // メッシュレットが頂点と三角形の配列からはみ出していないか確認する
+    for (const Meshlet& meshlet : result.meshlets) {
+        if (static_cast<uint64_t>(meshlet.vertexOffset) + meshlet.vertexCount > result.meshletVertices.size() ||
+            (static_cast<uint64_t>(meshlet.triangleOffset) + meshlet.triangleCount * 3ull) > result.meshletTriangles.size() ||
+            meshlet.materialIndex >= names.size()) {
+            return false;
+        }
+    }
+    for (uint32_t vertex : result.meshletVertices) {
+        if (vertex >= result.vertices.size()) {
+            return false;
+        }
+    }
+
+    modelData = std::move(result);
+    materialNames = std::move(names);
+    return true;
+}
+
+ModelData LoadModel(const std::string& directoryPath, const std::string& filename, uint32_t threadCount, MeshOptimizationReport* optimizationReport,
+    const ModelImportSettings& importSettings)
+{
+    std::filesystem::path sourcePath = directoryPath + "/" + filename;
+    std::filesystem::path cachePath = sourcePath;
+    cachePath += ".cmesh";
+
+    // 元ファイルのハッシュが一致するキャッシュがあればそれを使う
+    uint64_t sourceHash = HashFileContents(sourcePath);
+    ModelData modelData;
+    std::vector<std::string> materialNames;
+    if (ReadMeshCache(cachePath, sourceHash, modelData, materialNames)) {
+        // マテリアルは小さいので毎回MTLファイルから引き直す
+        modelData.materials = ResolveMaterials(directoryPath, modelData.materialLibrary, materialNames);
+        return modelData;
+    }
+
+    // 大きなファイルは属性をメモリに全部持たずにキャッシュを書き出し、それを読む。失敗したらメモリに読む方で作り直す
+    std::error_code error;
+    uint64_t sourceSize = std::filesystem::file_size(sourcePath, error);
+    if (!error && sourceSize >= importSettings.streamingFileSize &&
+        ImportObjFileStreaming(directoryPath, filename, importSettings.streaming) &&
+        ReadMeshCache(cachePath, sourceHash, modelData, materialNames)) {
+        modelData.materials = ResolveMaterials(directoryPath, modelData.materialLibrary, materialNames);
+        return modelData;
+    }
+
+    // なければOBJを読み、LODを作って描画順を最適化してからキャッシュを作る
+    modelData = LoadObjFile(directoryPath, filename, threadCount);
+    GenerateLods(modelData);
+    MeshOptimizationReport report = OptimizeMesh(modelData);
+    if (optimizationReport) {
+        *optimizationReport = report;
+    }
+    modelData.vertexFormat = SelectVertexFormat(modelData);
+    BuildMeshlets(modelData);
+    WriteMeshCache(cachePath, sourceHash, modelData);
+    return modelData;
+}
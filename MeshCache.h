@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "MeshOptimizer.h"
+#include "ObjLoader.h"
+#include "ObjStreamingImport.h"
+
+/// <summary>
+/// 調理済みメッシュキャッシュ(.cmesh)の形式
+/// ヘッダー、セクション表、各セクションの本体の順に並ぶ。本体は16byte境界に置く
+/// </summary>
+namespace MeshCacheFormat {
+
+constexpr uint32_t kMagic = 0x48534D43; // "CMSH"
+constexpr uint32_t kVersion = 7;
+constexpr uint64_t kSectionAlignment = 16;
+
+enum class SectionType : uint32_t {
+    Vertices, // VertexDataの配列
+    Indices, // uint32_tの配列
+    SubMeshes, // SubMeshの配列
+    MaterialLibrary, // mtllibのファイル名(終端なし)
+    MaterialNames, // usemtlのマテリアル名を'\0'で区切って並べたもの。SubMesh::materialIndexの順
+    Meshlets, // Meshletの配列
+    MeshletVertices, // uint32_tの配列
+    MeshletTriangles, // uint8_tの配列
+    Lods, // MeshLodの配列
+};
+
+struct Header {
+    uint32_t magic; // kMagic
+    uint32_t version; // kVersion
+    uint64_t sourceHash; // 元のOBJファイルの内容のハッシュ
+    AABB bounds; // 全頂点を囲む箱
+    Sphere boundingSphere; // 全頂点を囲む球
+    uint32_t sectionCount; // ヘッダーの直後に続くSectionの数
+    VertexFormat vertexFormat; // 読み込み時に選んだGPUに送る頂点の形式
+};
+
+struct Section {
+    SectionType type;
+    uint32_t elementSize; // 1要素のサイズ。文字列は1
+    uint64_t offset; // ファイル先頭からの位置
+    uint64_t size; // バイト数
+};
+
+} // namespace MeshCacheFormat
+
+/// <summary>
+/// ファイルの内容のハッシュを求める。読めなければ0
+/// </summary>
+uint64_t HashFileContents(const std::filesystem::path& filePath);
+
+/// <summary>
+/// キャッシュを書き出す。一時ファイルに書いてから置き換えるので、途中で失敗しても壊れたキャッシュは残らない
+/// </summary>
+bool WriteMeshCache(const std::filesystem::path& cachePath, uint64_t sourceHash, const ModelData& modelData);
+
+/// <summary>
+/// キャッシュをマップして読み込む。ファイルがない、形式が違う、sourceHashが一致しない場合はfalse
+/// 各ストリームは要素ごとの解析をせず、マップした領域からまとめてコピーする
+/// マテリアルはMTLファイルから引く必要があるので、名前だけをmaterialNamesに返す
+/// </summary>
+bool ReadMeshCache(const std::filesystem::path& cachePath, uint64_t sourceHash, ModelData& modelData, std::vector<std::string>& materialNames);
+
+/// <summary>
+/// LoadModelでキャッシュがなかったときのOBJの読み方
+/// </summary>
+struct ModelImportSettings {
+    uint64_t streamingFileSize = static_cast<uint64_t>(1) << 30; // OBJファイルがこのバイト数以上ならImportObjFileStreamingで読む
+    ObjStreamingImportSettings streaming; // ImportObjFileStreamingに渡す設定
+};
+
+/// <summary>
+/// モデルを読み込む
+/// 元ファイルと内容が一致するキャッシュがあればそれを使い、なければOBJを読んでLODの作成、最適化、頂点形式の選択、メッシュレットの作成をし、キャッシュを書き出す
+/// OBJファイルがimportSettings.streamingFileSize以上なら、ImportObjFileStreamingでキャッシュを直接書き出してそれを読む(LODとメッシュレットは作らない)
+/// OBJから作り直したときだけoptimizationReportに最適化の前後の効率を入れる
+/// </summary>
+ModelData LoadModel(const std::string& directoryPath, const std::string& filename, uint32_t threadCount, MeshOptimizationReport* optimizationReport = nullptr,
+    const ModelImportSettings& importSettings = {});
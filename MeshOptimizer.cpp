@@ -0,0 +1,401 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace {
+
+constexpr uint32_t kInvalidIndex = 0xFFFFFFFFu;
+
+/// <summary>
+/// 時刻を使ってFIFOの頂点キャッシュを模擬する
+/// 頂点を入れた時刻を覚えておき、それからcacheSize回以上入れ替えがあれば追い出されたとみなす
+/// </summary>
+class FifoVertexCache {
+public:
+    FifoVertexCache(size_t vertexCount, uint32_t cacheSize)
+        : timestamps_(vertexCount, 0), cacheSize_(cacheSize), timestamp_(cacheSize + 1) {}
+
+    /// <summary>
+    /// 頂点を使う。キャッシュになく変換が必要ならtrue
+    /// </summary>
+    bool Use(uint32_t vertex)
+    {
+        if (timestamp_ - timestamps_[vertex] > cacheSize_) {
+            timestamps_[vertex] = timestamp_++;
+            return true;
+        }
+        return false;
+    }
+
+    /// <summary>
+    /// キャッシュを空にする
+    /// </summary>
+    void Flush() { timestamp_ += cacheSize_ + 1; }
+
+private:
+    std::vector<uint32_t> timestamps_; //!< 頂点ごとのキャッシュに入れた時刻
+    uint32_t cacheSize_; //!< キャッシュの大きさ
+    uint32_t timestamp_; //!< 次に入れる頂点の時刻
+};
+
+/// <summary>
+/// 最後に使った順に並べた配列でLRUの頂点キャッシュを模擬する
+/// </summary>
+class LruVertexCache {
+public:
+    explicit LruVertexCache(uint32_t cacheSize)
+        : cacheSize_(cacheSize) { entries_.reserve(cacheSize); }
+
+    /// <summary>
+    /// 頂点を使う。キャッシュになく変換が必要ならtrue
+    /// </summary>
+    bool Use(uint32_t vertex)
+    {
+        auto it = std::find(entries_.begin(), entries_.end(), vertex);
+        bool miss = it == entries_.end();
+        if (miss) {
+            if (entries_.size() == cacheSize_) {
+                entries_.pop_back();
+            }
+            entries_.insert(entries_.begin(), vertex);
+        } else {
+            // 先頭に移す
+            std::rotate(entries_.begin(), it, it + 1);
+        }
+        return miss;
+    }
+
+private:
+    std::vector<uint32_t> entries_; //!< 先頭ほど最近使った頂点
+    uint32_t cacheSize_; //!< キャッシュの大きさ
+};
+
+/// <summary>
+/// 頂点ごとに、それを使う三角形の一覧を作る
+/// </summary>
+struct VertexAdjacency {
+    std::vector<uint32_t> offsets; // 頂点ごとのtrianglesの開始位置。頂点数+1個
+    std::vector<uint32_t> triangles; // 三角形の番号
+
+    VertexAdjacency(const uint32_t* indices, size_t indexCount, size_t vertexCount)
+        : offsets(vertexCount + 1, 0), triangles(indexCount)
+    {
+        for (size_t i = 0; i < indexCount; ++i) {
+            ++offsets[indices[i] + 1];
+        }
+        for (size_t v = 0; v < vertexCount; ++v) {
+            offsets[v + 1] += offsets[v];
+        }
+        std::vector<uint32_t> writePositions(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indexCount; ++i) {
+            triangles[writePositions[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+};
+
+Vector3 Subtract(const Vector3& a, const Vector3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+
+Vector3 Cross(const Vector3& a, const Vector3& b)
+{
+    return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+Vector3 ToVector3(const Vector4& v) { return { v.x, v.y, v.z }; }
+
+} // namespace
+
+VertexCacheStatistics AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize, VertexCacheModel model)
+{
+    VertexCacheStatistics statistics{};
+    if (indexCount == 0) {
+        return statistics;
+    }
+
+    FifoVertexCache fifo(model == VertexCacheModel::Fifo ? vertexCount : 0, cacheSize);
+    LruVertexCache lru(cacheSize);
+    std::vector<bool> used(vertexCount, false);
+    size_t usedVertexCount = 0;
+    for (size_t i = 0; i < indexCount; ++i) {
+        uint32_t vertex = indices[i];
+        assert(vertex < vertexCount);
+        bool miss = model == VertexCacheModel::Fifo ? fifo.Use(vertex) : lru.Use(vertex);
+        statistics.vertexTransformCount += miss ? 1 : 0;
+        if (!used[vertex]) {
+            used[vertex] = true;
+            ++usedVertexCount;
+        }
+    }
+    statistics.acmr = static_cast<float>(statistics.vertexTransformCount) / static_cast<float>(indexCount / 3);
+    statistics.atvr = static_cast<float>(statistics.vertexTransformCount) / static_cast<float>(usedVertexCount);
+    return statistics;
+}
+
+void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize, std::vector<uint32_t>* clusterStarts)
+{
+    assert(indexCount % 3 == 0);
+    size_t triangleCount = indexCount / 3;
+    if (clusterStarts) {
+        clusterStarts->clear();
+    }
+    if (triangleCount == 0) {
+        return;
+    }
+
+    VertexAdjacency adjacency(indices, indexCount, vertexCount);
+
+    // 頂点ごとのまだ出力していない三角形の数
+    std::vector<uint32_t> liveTriangles(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+    }
+    std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> deadEndStack;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> output;
+    output.reserve(indexCount);
+
+    uint32_t timestamp = cacheSize + 1;
+    uint32_t cursor = 0;
+    uint32_t fanningVertex = 0;
+    while (fanningVertex < vertexCount && liveTriangles[fanningVertex] == 0) {
+        ++fanningVertex;
+    }
+    if (clusterStarts) {
+        clusterStarts->push_back(0);
+    }
+
+    while (fanningVertex != kInvalidIndex) {
+        // 扇の中心の頂点を使う三角形をすべて出力する
+        candidates.clear();
+        for (uint32_t a = adjacency.offsets[fanningVertex]; a < adjacency.offsets[fanningVertex + 1]; ++a) {
+            uint32_t triangle = adjacency.triangles[a];
+            if (emitted[triangle]) {
+                continue;
+            }
+            for (uint32_t corner = 0; corner < 3; ++corner) {
+                uint32_t vertex = indices[triangle * 3 + corner];
+                output.push_back(vertex);
+                deadEndStack.push_back(vertex);
+                candidates.push_back(vertex);
+                --liveTriangles[vertex];
+                if (timestamp - cacheTimestamps[vertex] > cacheSize) {
+                    cacheTimestamps[vertex] = timestamp++;
+                }
+            }
+            emitted[triangle] = true;
+        }
+
+        // 次の扇の中心を、キャッシュに残っているうちで最も古い頂点から選ぶ
+        uint32_t nextVertex = kInvalidIndex;
+        uint32_t bestPriority = 0;
+        for (uint32_t vertex : candidates) {
+            if (liveTriangles[vertex] == 0) {
+                continue;
+            }
+            uint32_t priority = 0;
+            // 残りの三角形を出力してもキャッシュから追い出されない頂点だけを選ぶ
+            if (timestamp - cacheTimestamps[vertex] + 2 * liveTriangles[vertex] <= cacheSize) {
+                priority = timestamp - cacheTimestamps[vertex];
+            }
+            if (nextVertex == kInvalidIndex || priority > bestPriority) {
+                nextVertex = vertex;
+                bestPriority = priority;
+            }
+        }
+
+        if (nextVertex == kInvalidIndex) {
+            // 行き詰まったら最近出力した頂点から、それもなければ番号順に探す
+            // ここでキャッシュの連続性が途切れるので、かたまりの境目にする
+            while (!deadEndStack.empty()) {
+                uint32_t vertex = deadEndStack.back();
+                deadEndStack.pop_back();
+                if (liveTriangles[vertex] > 0) {
+                    nextVertex = vertex;
+                    break;
+                }
+            }
+            while (nextVertex == kInvalidIndex && cursor < vertexCount) {
+                if (liveTriangles[cursor] > 0) {
+                    nextVertex = cursor;
+                }
+                ++cursor;
+            }
+            if (clusterStarts && nextVertex != kInvalidIndex) {
+                clusterStarts->push_back(static_cast<uint32_t>(output.size() / 3));
+            }
+        }
+        fanningVertex = nextVertex;
+    }
+
+    assert(output.size() == indexCount);
+    std::copy(output.begin(), output.end(), indices);
+}
+
+void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const std::vector<VertexData>& vertices, const std::vector<uint32_t>& clusterStarts, uint32_t cacheSize, float threshold)
+{
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0 || clusterStarts.empty()) {
+        return;
+    }
+
+    // キャッシュが途切れる境目の間を、ACMRの悪化がthreshold倍に収まるところでさらに区切る
+    FifoVertexCache cache(vertices.size(), cacheSize);
+    std::vector<uint32_t> clusters;
+    for (size_t c = 0; c < clusterStarts.size(); ++c) {
+        uint32_t start = clusterStarts[c];
+        uint32_t end = c + 1 < clusterStarts.size() ? clusterStarts[c + 1] : static_cast<uint32_t>(triangleCount);
+
+        cache.Flush();
+        uint32_t clusterMisses = 0;
+        for (uint32_t t = start; t < end; ++t) {
+            for (uint32_t corner = 0; corner < 3; ++corner) {
+                clusterMisses += cache.Use(indices[t * 3 + corner]) ? 1 : 0;
+            }
+        }
+        float thresholdAcmr = static_cast<float>(clusterMisses) / static_cast<float>(end - start) * threshold;
+
+        cache.Flush();
+        clusters.push_back(start);
+        uint32_t runningMisses = 0;
+        uint32_t runningTriangles = 0;
+        for (uint32_t t = start; t < end; ++t) {
+            for (uint32_t corner = 0; corner < 3; ++corner) {
+                runningMisses += cache.Use(indices[t * 3 + corner]) ? 1 : 0;
+            }
+            ++runningTriangles;
+            if (t + 1 < end && static_cast<float>(runningMisses) <= thresholdAcmr * static_cast<float>(runningTriangles)) {
+                clusters.push_back(t + 1);
+                cache.Flush();
+                runningMisses = 0;
+                runningTriangles = 0;
+            }
+        }
+    }
+
+    // メッシュ全体の中心
+    Vector3 meshCenter{};
+    float meshArea = 0.0f;
+    struct Cluster {
+        uint32_t start;
+        uint32_t end;
+        Vector3 center; // 面積で重み付けした中心
+        Vector3 normal; // 面積で重み付けした法線の和
+        float area;
+        float sortKey;
+    };
+    std::vector<Cluster> clusterInfos(clusters.size());
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        Cluster& cluster = clusterInfos[c];
+        cluster.start = clusters[c];
+        cluster.end = c + 1 < clusters.size() ? clusters[c + 1] : static_cast<uint32_t>(triangleCount);
+        cluster.center = {};
+        cluster.normal = {};
+        cluster.area = 0.0f;
+        for (uint32_t t = cluster.start; t < cluster.end; ++t) {
+            Vector3 p0 = ToVector3(vertices[indices[t * 3 + 0]].position);
+            Vector3 p1 = ToVector3(vertices[indices[t * 3 + 1]].position);
+            Vector3 p2 = ToVector3(vertices[indices[t * 3 + 2]].position);
+            Vector3 normal = Cross(Subtract(p1, p0), Subtract(p2, p0));
+            float area = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+            cluster.center.x += (p0.x + p1.x + p2.x) * area;
+            cluster.center.y += (p0.y + p1.y + p2.y) * area;
+            cluster.center.z += (p0.z + p1.z + p2.z) * area;
+            cluster.normal.x += normal.x;
+            cluster.normal.y += normal.y;
+            cluster.normal.z += normal.z;
+            cluster.area += area;
+        }
+        meshCenter.x += cluster.center.x;
+        meshCenter.y += cluster.center.y;
+        meshCenter.z += cluster.center.z;
+        meshArea += cluster.area;
+        if (cluster.area > 0.0f) {
+            float inverse = 1.0f / (cluster.area * 3.0f);
+            cluster.center = { cluster.center.x * inverse, cluster.center.y * inverse, cluster.center.z * inverse };
+        }
+    }
+    if (meshArea > 0.0f) {
+        float inverse = 1.0f / (meshArea * 3.0f);
+        meshCenter = { meshCenter.x * inverse, meshCenter.y * inverse, meshCenter.z * inverse };
+    }
+
+    // 中心から外を向いているかたまりほど手前にある見込みが高いので先に描く
+    for (Cluster& cluster : clusterInfos) {
+        Vector3 offset = Subtract(cluster.center, meshCenter);
+        float length = std::sqrt(cluster.normal.x * cluster.normal.x + cluster.normal.y * cluster.normal.y + cluster.normal.z * cluster.normal.z);
+        cluster.sortKey = 0.0f;
+        if (length > 0.0f) {
+            cluster.sortKey = (offset.x * cluster.normal.x + offset.y * cluster.normal.y + offset.z * cluster.normal.z) / length;
+        }
+    }
+    std::stable_sort(clusterInfos.begin(), clusterInfos.end(),
+        [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+    std::vector<uint32_t> output;
+    output.reserve(indexCount);
+    for (const Cluster& cluster : clusterInfos) {
+        output.insert(output.end(), indices + cluster.start * 3, indices + cluster.end * 3);
+    }
+    std::copy(output.begin(), output.end(), indices);
+}
+
+void OptimizeVertexFetch(std::vector<VertexData>& vertices, std::vector<uint32_t>& indices)
+{
+    std::vector<uint32_t> remap(vertices.size(), kInvalidIndex);
+    std::vector<VertexData> output;
+    output.reserve(vertices.size());
+    for (uint32_t& index : indices) {
+        if (remap[index] == kInvalidIndex) {
+            remap[index] = static_cast<uint32_t>(output.size());
+            output.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices = std::move(output);
+}
+
+MeshOptimizationReport OptimizeMesh(ModelData& modelData, const MeshOptimizationSettings& settings)
+{
+    MeshOptimizationReport report{};
+    report.before = AnalyzeVertexCache(modelData.indices.data(), modelData.indices.size(), modelData.vertices.size(), settings.cacheSize, settings.analysisModel);
+
+    // SubMeshごとに、使われている頂点だけの番号に振り直してから並べ替える
+    std::vector<uint32_t> globalToLocal(modelData.vertices.size(), kInvalidIndex);
+    std::vector<uint32_t> localToGlobal;
+    std::vector<VertexData> localVertices;
+    std::vector<uint32_t> localIndices;
+    std::vector<uint32_t> clusterStarts;
+    for (const SubMesh& subMesh : modelData.subMeshes) {
+        uint32_t* indices = modelData.indices.data() + subMesh.indexStart;
+        localToGlobal.clear();
+        localVertices.clear();
+        localIndices.resize(subMesh.indexCount);
+        for (uint32_t i = 0; i < subMesh.indexCount; ++i) {
+            uint32_t& local = globalToLocal[indices[i]];
+            if (local == kInvalidIndex) {
+                local = static_cast<uint32_t>(localToGlobal.size());
+                localToGlobal.push_back(indices[i]);
+                localVertices.push_back(modelData.vertices[indices[i]]);
+            }
+            localIndices[i] = local;
+        }
+
+        OptimizeVertexCache(localIndices.data(), localIndices.size(), localVertices.size(), settings.cacheSize, &clusterStarts);
+        OptimizeOverdraw(localIndices.data(), localIndices.size(), localVertices, clusterStarts, settings.cacheSize, settings.overdrawThreshold);
+
+        for (uint32_t i = 0; i < subMesh.indexCount; ++i) {
+            indices[i] = localToGlobal[localIndices[i]];
+        }
+        for (uint32_t global : localToGlobal) {
+            globalToLocal[global] = kInvalidIndex;
+        }
+    }
+
+    OptimizeVertexFetch(modelData.vertices, modelData.indices);
+
+    report.after = AnalyzeVertexCache(modelData.indices.data(), modelData.indices.size(), modelData.vertices.size(), settings.cacheSize, settings.analysisModel);
+    return report;
+}
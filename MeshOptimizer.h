@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ObjLoader.h"
+
+/// <summary>
+/// 頂点キャッシュの置き換え方
+/// </summary>
+enum class VertexCacheModel {
+    Fifo, // 古く入ったものから追い出す
+    Lru, // 最後に使ったのが古いものから追い出す
+};
+
+/// <summary>
+/// 頂点キャッシュを模擬して求めた効率
+/// </summary>
+struct VertexCacheStatistics {
+    uint32_t vertexTransformCount; // 頂点シェーダーが実行される回数
+    float acmr; // 三角形1つあたりの頂点変換数(Average Cache Miss Ratio)。0.5に近いほど良い
+    float atvr; // 使われている頂点1つあたりの頂点変換数(Average Transformed Vertex Ratio)。1が最良
+};
+
+/// <summary>
+/// OptimizeMeshの設定
+/// </summary>
+struct MeshOptimizationSettings {
+    uint32_t cacheSize = 16; // 最適化と計測で想定する頂点キャッシュの大きさ
+    float overdrawThreshold = 1.05f; // 重ね描き削減のためにACMRが何倍まで悪化してよいか
+    VertexCacheModel analysisModel = VertexCacheModel::Fifo; // 計測に使うキャッシュのモデル
+};
+
+/// <summary>
+/// OptimizeMeshの前後の頂点キャッシュの効率
+/// </summary>
+struct MeshOptimizationReport {
+    VertexCacheStatistics before;
+    VertexCacheStatistics after;
+};
+
+/// <summary>
+/// 三角形リストを先頭から描いたときの頂点キャッシュの効率をCPUで模擬して求める
+/// </summary>
+VertexCacheStatistics AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize, VertexCacheModel model);
+
+/// <summary>
+/// 頂点キャッシュに残っている頂点を続けて使うよう三角形を並べ替える(Tipsify)
+/// 各三角形の頂点の順番は変えないので表裏は保たれる
+/// clusterStartsには、キャッシュが途切れて並べ直しても効率が落ちない三角形の番号を入れる(先頭の0を含む)
+/// </summary>
+void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize, std::vector<uint32_t>* clusterStarts = nullptr);
+
+/// <summary>
+/// OptimizeVertexCacheの結果をかたまりに分け、外を向いているかたまりから描くよう並べ替える
+/// ACMRがthreshold倍に収まる範囲でかたまりを細かくする
+/// </summary>
+void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const std::vector<VertexData>& vertices, const std::vector<uint32_t>& clusterStarts, uint32_t cacheSize, float threshold);
+
+/// <summary>
+/// 頂点をIndexバッファで初めて使われる順に並べ替え、使われていない頂点を取り除く
+/// </summary>
+void OptimizeVertexFetch(std::vector<VertexData>& vertices, std::vector<uint32_t>& indices);
+
+/// <summary>
+/// 読み込んだメッシュの描画順を最適化する
+/// SubMeshごとに頂点キャッシュ、重ね描きの順で三角形を並べ替え、最後に頂点を並べ替える
+/// </summary>
+MeshOptimizationReport OptimizeMesh(ModelData& modelData, const MeshOptimizationSettings& settings = {});
@@ -0,0 +1,662 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+
+constexpr uint32_t kInvalidIndex = 0xFFFFFFFFu;
+constexpr double kEdgeWeight = 10.0; // 開いた縁とシームの形を保つための平面の重み
+constexpr double kPassErrorScale = 1.5; // 1回の走査で行う縮約の誤差の上限。目標に必要な数番目の縮約の誤差に対する倍率
+
+Vector3 Subtract(const Vector3& a, const Vector3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+
+float Dot(const Vector3& a, const Vector3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+Vector3 Cross(const Vector3& a, const Vector3& b)
+{
+    return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+float Length(const Vector3& v) { return std::sqrt(Dot(v, v)); }
+
+/// <summary>
+/// 頂点の動かし方の種類
+/// </summary>
+enum class VertexKind : uint8_t {
+    Manifold, // 周りが閉じている。どの隣の頂点へも縮められる
+    Border, // 開いた縁の上。縁に沿ってだけ縮められる
+    Seam, // テクスチャ座標か法線の境目の上。境目に沿ってだけ、両側の頂点をそろえて縮める
+    Locked, // 動かさない
+};
+
+/// <summary>
+/// 平面までの距離の2乗の和を表す二次形式。x^T A x + 2 b^T x + c を重みの合計で割ったものが誤差
+/// </summary>
+struct Quadric {
+    double a00, a11, a22, a10, a20, a21; // 対称行列A
+    double b0, b1, b2;
+    double c;
+    double weight; // 足した平面の重みの合計
+};
+
+/// <summary>
+/// dot(normal, x) + distance = 0 の平面を重みつきで足す
+/// 縁を保つための平面はaddWeightをfalseにし、面の誤差が薄まらないよう重みの合計に入れない
+/// </summary>
+void AddPlane(Quadric& quadric, const Vector3& normal, double distance, double weight, bool addWeight = true)
+{
+    double a = normal.x;
+    double b = normal.y;
+    double c = normal.z;
+    quadric.a00 += weight * a * a;
+    quadric.a11 += weight * b * b;
+    quadric.a22 += weight * c * c;
+    quadric.a10 += weight * b * a;
+    quadric.a20 += weight * c * a;
+    quadric.a21 += weight * c * b;
+    quadric.b0 += weight * a * distance;
+    quadric.b1 += weight * b * distance;
+    quadric.b2 += weight * c * distance;
+    quadric.c += weight * distance * distance;
+    quadric.weight += addWeight ? weight : 0.0;
+}
+
+void AddQuadric(Quadric& quadric, const Quadric& other)
+{
+    quadric.a00 += other.a00;
+    quadric.a11 += other.a11;
+    quadric.a22 += other.a22;
+    quadric.a10 += other.a10;
+    quadric.a20 += other.a20;
+    quadric.a21 += other.a21;
+    quadric.b0 += other.b0;
+    quadric.b1 += other.b1;
+    quadric.b2 += other.b2;
+    quadric.c += other.c;
+    quadric.weight += other.weight;
+}
+
+/// <summary>
+/// 点を置いたときの、平面までの距離の2乗の重みつき平均
+/// </summary>
+double EvaluateQuadric(const Quadric& quadric, const Vector3& point)
+{
+    double x = point.x;
+    double y = point.y;
+    double z = point.z;
+    double result = quadric.a00 * x * x + quadric.a11 * y * y + quadric.a22 * z * z +
+        2.0 * (quadric.a10 * x * y + quadric.a20 * x * z + quadric.a21 * y * z) +
+        2.0 * (quadric.b0 * x + quadric.b1 * y + quadric.b2 * z) + quadric.c;
+    return quadric.weight > 0.0 ? std::fabs(result) / quadric.weight : 0.0;
+}
+
+/// <summary>
+/// 頂点を使っている三角形の一覧
+/// </summary>
+struct VertexTriangles {
+    std::vector<uint32_t> offsets; // 頂点ごとの開始位置。頂点数+1個
+    std::vector<uint32_t> triangles;
+
+    void Build(const std::vector<uint32_t>& indices, size_t vertexCount)
+    {
+        offsets.assign(vertexCount + 1, 0);
+        for (uint32_t index : indices) {
+            ++offsets[index + 1];
+        }
+        for (size_t v = 0; v < vertexCount; ++v) {
+            offsets[v + 1] += offsets[v];
+        }
+        triangles.resize(indices.size());
+        std::vector<uint32_t> writePositions(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); ++i) {
+            triangles[writePositions[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+};
+
+/// <summary>
+/// 三角形の中でvertexの次の角の頂点
+/// </summary>
+uint32_t GetNextCorner(const std::vector<uint32_t>& indices, uint32_t triangle, uint32_t vertex)
+{
+    const uint32_t* corners = &indices[triangle * 3];
+    return corners[0] == vertex ? corners[1] : corners[1] == vertex ? corners[2] : corners[0];
+}
+
+/// <summary>
+/// a→bの向きの辺を持つ三角形があるか
+/// </summary>
+bool HasEdge(const VertexTriangles& adjacency, const std::vector<uint32_t>& indices, uint32_t a, uint32_t b)
+{
+    for (uint32_t k = adjacency.offsets[a]; k < adjacency.offsets[a + 1]; ++k) {
+        if (GetNextCorner(indices, adjacency.triangles[k], a) == b) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// <summary>
+/// 辺の縮約の候補。sourceをtargetの位置へ寄せる
+/// </summary>
+struct Collapse {
+    uint32_t source;
+    uint32_t target;
+    double error;
+};
+
+/// <summary>
+/// 簡略化の途中の状態
+/// </summary>
+class MeshSimplifier {
+public:
+    MeshSimplifier(const std::vector<VertexData>& vertices, std::vector<uint32_t>& indices, std::vector<uint32_t>& triangleMaterials)
+        : indices_(indices), triangleMaterials_(triangleMaterials)
+    {
+        size_t vertexCount = vertices.size();
+        positions_.resize(vertexCount);
+        for (size_t v = 0; v < vertexCount; ++v) {
+            positions_[v] = { vertices[v].position.x, vertices[v].position.y, vertices[v].position.z };
+        }
+        BuildPositionGroups();
+        RemoveDegenerateTriangles();
+        BuildQuadrics();
+    }
+
+    /// <summary>
+    /// 三角形がtargetTriangleCount以下になるか、縮められる辺がなくなるまで縮約を繰り返す
+    /// </summary>
+    double Simplify(size_t targetTriangleCount)
+    {
+        double maxError = 0.0;
+        std::vector<Collapse> collapses;
+        std::vector<uint32_t> collapseRemap(positions_.size());
+        std::vector<uint8_t> positionLocked(positions_.size());
+        while (indices_.size() / 3 > targetTriangleCount) {
+            adjacency_.Build(indices_, positions_.size());
+            ClassifyVertices();
+            PickCollapses(collapses);
+            if (collapses.empty()) {
+                break;
+            }
+
+            // 誤差の小さい順に、周りが重ならない縮約をまとめて行う
+            std::stable_sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+            size_t triangleGoal = indices_.size() / 3 - targetTriangleCount;
+            size_t edgeGoal = (std::min)(collapses.size(), triangleGoal / 2 + 1);
+            double errorLimit = collapses[edgeGoal - 1].error * kPassErrorScale;
+
+            std::iota(collapseRemap.begin(), collapseRemap.end(), 0u);
+            std::fill(positionLocked.begin(), positionLocked.end(), uint8_t(0));
+            size_t removedTriangleCount = 0;
+            size_t performedCount = 0;
+            for (const Collapse& collapse : collapses) {
+                // 上限までに1つも縮められなければ、上限を超えたものも使う
+                if (removedTriangleCount >= triangleGoal || (collapse.error > errorLimit && performedCount != 0)) {
+                    break;
+                }
+                uint32_t sourcePosition = remap_[collapse.source];
+                uint32_t targetPosition = remap_[collapse.target];
+                if (positionLocked[sourcePosition] || positionLocked[targetPosition] ||
+                    BreaksManifold(collapse.source, collapse.target) || HasTriangleFlips(collapse.source, collapse.target)) {
+                    continue;
+                }
+
+                if (kinds_[collapse.source] == VertexKind::Seam) {
+                    uint32_t sourceWedge = wedge_[collapse.source];
+                    collapseRemap[collapse.source] = collapse.target;
+                    collapseRemap[sourceWedge] = FindSeamTarget(sourceWedge, targetPosition);
+                } else {
+                    collapseRemap[collapse.source] = collapse.target;
+                }
+                AddQuadric(quadrics_[targetPosition], quadrics_[sourcePosition]);
+
+                // 形の変わる三角形の頂点は、この走査ではもう動かさない
+                uint32_t vertex = collapse.source;
+                do {
+                    for (uint32_t k = adjacency_.offsets[vertex]; k < adjacency_.offsets[vertex + 1]; ++k) {
+                        uint32_t triangle = adjacency_.triangles[k];
+                        bool removed = false;
+                        for (uint32_t corner = 0; corner < 3; ++corner) {
+                            uint32_t position = remap_[indices_[triangle * 3 + corner]];
+                            positionLocked[position] = 1;
+                            removed = removed || position == targetPosition;
+                        }
+                        removedTriangleCount += removed ? 1 : 0;
+                    }
+                    vertex = wedge_[vertex];
+                } while (vertex != collapse.source);
+
+                maxError = (std::max)(maxError, collapse.error);
+                ++performedCount;
+            }
+            if (performedCount == 0) {
+                break;
+            }
+
+            for (uint32_t& index : indices_) {
+                index = collapseRemap[index];
+            }
+            RemoveDegenerateTriangles();
+        }
+        return std::sqrt(maxError);
+    }
+
+private:
+    /// <summary>
+    /// 使われている頂点を位置でまとめ、代表の頂点(remap_)と同じ位置の頂点をたどる輪(wedge_)を作る
+    /// </summary>
+    void BuildPositionGroups()
+    {
+        size_t vertexCount = positions_.size();
+        remap_.resize(vertexCount);
+        wedge_.resize(vertexCount);
+        std::iota(remap_.begin(), remap_.end(), 0u);
+        std::iota(wedge_.begin(), wedge_.end(), 0u);
+
+        std::vector<uint8_t> referenced(vertexCount, 0);
+        for (uint32_t index : indices_) {
+            referenced[index] = 1;
+        }
+        std::vector<uint32_t> order;
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            if (referenced[v]) {
+                order.push_back(v);
+            }
+        }
+        auto lessPosition = [this](uint32_t a, uint32_t b) {
+            const Vector3& pa = positions_[a];
+            const Vector3& pb = positions_[b];
+            if (pa.x != pb.x) {
+                return pa.x < pb.x;
+            }
+            if (pa.y != pb.y) {
+                return pa.y < pb.y;
+            }
+            return pa.z < pb.z;
+        };
+        // 同じ位置の中は頂点番号順にして、代表を最も小さい番号にする
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            if (lessPosition(a, b) || lessPosition(b, a)) {
+                return lessPosition(a, b);
+            }
+            return a < b;
+        });
+        size_t groupStart = 0;
+        for (size_t i = 1; i <= order.size(); ++i) {
+            if (i < order.size() && !lessPosition(order[groupStart], order[i])) {
+                continue;
+            }
+            for (size_t k = groupStart; k < i; ++k) {
+                remap_[order[k]] = order[groupStart];
+                wedge_[order[k]] = order[k + 1 < i ? k + 1 : groupStart];
+            }
+            groupStart = i;
+        }
+    }
+
+    /// <summary>
+    /// 同じ位置の頂点を2つ以上使う三角形を消す
+    /// </summary>
+    void RemoveDegenerateTriangles()
+    {
+        size_t writeTriangle = 0;
+        for (size_t triangle = 0; triangle < indices_.size() / 3; ++triangle) {
+            uint32_t p0 = remap_[indices_[triangle * 3 + 0]];
+            uint32_t p1 = remap_[indices_[triangle * 3 + 1]];
+            uint32_t p2 = remap_[indices_[triangle * 3 + 2]];
+            if (p0 == p1 || p1 == p2 || p2 == p0) {
+                continue;
+            }
+            std::copy_n(&indices_[triangle * 3], 3, &indices_[writeTriangle * 3]);
+            triangleMaterials_[writeTriangle] = triangleMaterials_[triangle];
+            ++writeTriangle;
+        }
+        indices_.resize(writeTriangle * 3);
+        triangleMaterials_.resize(writeTriangle);
+    }
+
+    /// <summary>
+    /// 面の平面を位置ごとに面積の重みで足し、開いた縁とシームには面に垂直な平面を足す
+    /// </summary>
+    void BuildQuadrics()
+    {
+        quadrics_.assign(positions_.size(), Quadric{});
+        adjacency_.Build(indices_, positions_.size());
+        for (size_t triangle = 0; triangle < indices_.size() / 3; ++triangle) {
+            const uint32_t* corners = &indices_[triangle * 3];
+            const Vector3& p0 = positions_[corners[0]];
+            Vector3 normal = Cross(Subtract(positions_[corners[1]], p0), Subtract(positions_[corners[2]], p0));
+            float length = Length(normal);
+            if (length == 0.0f) {
+                continue;
+            }
+            normal = { normal.x / length, normal.y / length, normal.z / length };
+            double distance = -static_cast<double>(Dot(normal, p0));
+            for (uint32_t corner = 0; corner < 3; ++corner) {
+                AddPlane(quadrics_[remap_[corners[corner]]], normal, distance, length * 0.5);
+            }
+
+            for (uint32_t corner = 0; corner < 3; ++corner) {
+                uint32_t a = corners[corner];
+                uint32_t b = corners[(corner + 1) % 3];
+                if (HasEdge(adjacency_, indices_, b, a)) {
+                    continue;
+                }
+                Vector3 edge = Subtract(positions_[b], positions_[a]);
+                Vector3 edgeNormal = Cross(edge, normal);
+                float edgeNormalLength = Length(edgeNormal);
+                if (edgeNormalLength == 0.0f) {
+                    continue;
+                }
+                edgeNormal = { edgeNormal.x / edgeNormalLength, edgeNormal.y / edgeNormalLength, edgeNormal.z / edgeNormalLength };
+                double edgeDistance = -static_cast<double>(Dot(edgeNormal, positions_[a]));
+                double edgeWeight = static_cast<double>(Dot(edge, edge)) * kEdgeWeight;
+                AddPlane(quadrics_[remap_[a]], edgeNormal, edgeDistance, edgeWeight, false);
+                AddPlane(quadrics_[remap_[b]], edgeNormal, edgeDistance, edgeWeight, false);
+            }
+        }
+    }
+
+    /// <summary>
+    /// 各頂点の種類と、逆向きのない辺(開いた辺)でつながる頂点を求める
+    /// 開いた辺が2本以上あるときはopenIn_/openOut_を自分自身にする
+    /// </summary>
+    void ClassifyVertices()
+    {
+        size_t vertexCount = positions_.size();
+        openIn_.assign(vertexCount, kInvalidIndex);
+        openOut_.assign(vertexCount, kInvalidIndex);
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            for (uint32_t k = adjacency_.offsets[v]; k < adjacency_.offsets[v + 1]; ++k) {
+                uint32_t next = GetNextCorner(indices_, adjacency_.triangles[k], v);
+                if (!HasEdge(adjacency_, indices_, next, v)) {
+                    openOut_[v] = openOut_[v] == kInvalidIndex ? next : v;
+                    openIn_[next] = openIn_[next] == kInvalidIndex ? v : next;
+                }
+            }
+        }
+
+        // 違うマテリアルの三角形に使われている位置は動かさない
+        std::vector<uint32_t> positionMaterials(vertexCount, kInvalidIndex);
+        std::vector<uint8_t> materialBoundary(vertexCount, 0);
+        for (size_t triangle = 0; triangle < triangleMaterials_.size(); ++triangle) {
+            for (uint32_t corner = 0; corner < 3; ++corner) {
+                uint32_t position = remap_[indices_[triangle * 3 + corner]];
+                if (positionMaterials[position] == kInvalidIndex) {
+                    positionMaterials[position] = triangleMaterials_[triangle];
+                } else if (positionMaterials[position] != triangleMaterials_[triangle]) {
+                    materialBoundary[position] = 1;
+                }
+            }
+        }
+
+        kinds_.assign(vertexCount, VertexKind::Locked);
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            if (remap_[v] != v || materialBoundary[v]) {
+                continue;
+            }
+            if (wedge_[v] == v) {
+                // 同じ位置にほかの頂点がなければ、開いた辺があるかで決まる
+                if (openIn_[v] == kInvalidIndex && openOut_[v] == kInvalidIndex) {
+                    kinds_[v] = VertexKind::Manifold;
+                } else if (IsSingleOpenEdge(v)) {
+                    kinds_[v] = VertexKind::Border;
+                }
+            } else if (wedge_[wedge_[v]] == v) {
+                // 2つの頂点がそれぞれ1本ずつ開いた辺を持ち、互いに逆向きで重なっていればシーム
+                uint32_t w = wedge_[v];
+                if (IsSingleOpenEdge(v) && IsSingleOpenEdge(w) &&
+                    remap_[openIn_[v]] == remap_[openOut_[w]] && remap_[openOut_[v]] == remap_[openIn_[w]] &&
+                    remap_[openIn_[v]] != remap_[openOut_[v]]) {
+                    kinds_[v] = VertexKind::Seam;
+                }
+            }
+        }
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            kinds_[v] = kinds_[remap_[v]];
+        }
+    }
+
+    /// <summary>
+    /// 入る向きと出る向きの開いた辺がちょうど1本ずつあるか
+    /// </summary>
+    bool IsSingleOpenEdge(uint32_t vertex) const
+    {
+        return openIn_[vertex] != kInvalidIndex && openIn_[vertex] != vertex && openOut_[vertex] != kInvalidIndex && openOut_[vertex] != vertex;
+    }
+
+    /// <summary>
+    /// シームの反対側の頂点sourceWedgeを、開いた辺でつながるtargetPositionの位置の頂点へ寄せる。なければkInvalidIndex
+    /// </summary>
+    uint32_t FindSeamTarget(uint32_t sourceWedge, uint32_t targetPosition) const
+    {
+        if (remap_[openOut_[sourceWedge]] == targetPosition) {
+            return openOut_[sourceWedge];
+        }
+        if (remap_[openIn_[sourceWedge]] == targetPosition) {
+            return openIn_[sourceWedge];
+        }
+        return kInvalidIndex;
+    }
+
+    /// <summary>
+    /// sourceをtargetへ縮めてよいか
+    /// </summary>
+    bool CanCollapse(uint32_t source, uint32_t target) const
+    {
+        VertexKind sourceKind = kinds_[source];
+        VertexKind targetKind = kinds_[target];
+        switch (sourceKind) {
+        case VertexKind::Manifold:
+            return true;
+        case VertexKind::Border:
+            return (targetKind == VertexKind::Border || targetKind == VertexKind::Locked) &&
+                (openOut_[source] == target || openIn_[source] == target);
+        case VertexKind::Seam:
+            return (targetKind == VertexKind::Seam || targetKind == VertexKind::Locked) &&
+                (openOut_[source] == target || openIn_[source] == target) &&
+                FindSeamTarget(wedge_[source], remap_[target]) != kInvalidIndex;
+        default:
+            return false;
+        }
+    }
+
+    /// <summary>
+    /// 各辺について、縮められる向きのうち誤差の小さい方を候補にする
+    /// </summary>
+    void PickCollapses(std::vector<Collapse>& collapses) const
+    {
+        collapses.clear();
+        for (size_t i = 0; i < indices_.size(); ++i) {
+            uint32_t v0 = indices_[i];
+            uint32_t v1 = indices_[i % 3 == 2 ? i - 2 : i + 1];
+            // 閉じた辺は両側の三角形に現れるので片側だけ調べる
+            if (v0 > v1 && HasEdge(adjacency_, indices_, v1, v0)) {
+                continue;
+            }
+            bool canCollapse0 = CanCollapse(v0, v1);
+            bool canCollapse1 = CanCollapse(v1, v0);
+            double error0 = canCollapse0 ? EvaluateQuadric(quadrics_[remap_[v0]], positions_[v1]) : 0.0;
+            double error1 = canCollapse1 ? EvaluateQuadric(quadrics_[remap_[v1]], positions_[v0]) : 0.0;
+            if (canCollapse0 && (!canCollapse1 || error0 <= error1)) {
+                collapses.push_back({ v0, v1, error0 });
+            } else if (canCollapse1) {
+                collapses.push_back({ v1, v0, error1 });
+            }
+        }
+    }
+
+    /// <summary>
+    /// 位置positionの頂点を使う三角形の、ほかの角の位置をneighborsに集める(重複あり)
+    /// </summary>
+    void CollectNeighborPositions(uint32_t position, std::vector<uint32_t>& neighbors) const
+    {
+        neighbors.clear();
+        uint32_t vertex = position;
+        do {
+            for (uint32_t k = adjacency_.offsets[vertex]; k < adjacency_.offsets[vertex + 1]; ++k) {
+                uint32_t next = GetNextCorner(indices_, adjacency_.triangles[k], vertex);
+                neighbors.push_back(remap_[next]);
+                neighbors.push_back(remap_[GetNextCorner(indices_, adjacency_.triangles[k], next)]);
+            }
+            vertex = wedge_[vertex];
+        } while (vertex != position);
+        std::sort(neighbors.begin(), neighbors.end());
+        neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+    }
+
+    /// <summary>
+    /// 縮約で面が折り重なるか。両端に共通して隣り合う位置が、辺を挟む三角形の頂点以外にもあれば重なる
+    /// </summary>
+    bool BreaksManifold(uint32_t source, uint32_t target)
+    {
+        uint32_t sourcePosition = remap_[source];
+        uint32_t targetPosition = remap_[target];
+        CollectNeighborPositions(sourcePosition, sourceNeighbors_);
+        CollectNeighborPositions(targetPosition, targetNeighbors_);
+        size_t commonCount = 0;
+        for (uint32_t position : sourceNeighbors_) {
+            commonCount += std::binary_search(targetNeighbors_.begin(), targetNeighbors_.end(), position) ? 1 : 0;
+        }
+
+        // 辺を挟む三角形の、辺の向かいの頂点の数
+        size_t edgeTriangleCount = 0;
+        uint32_t vertex = sourcePosition;
+        do {
+            for (uint32_t k = adjacency_.offsets[vertex]; k < adjacency_.offsets[vertex + 1]; ++k) {
+                uint32_t next = GetNextCorner(indices_, adjacency_.triangles[k], vertex);
+                uint32_t previous = GetNextCorner(indices_, adjacency_.triangles[k], next);
+                edgeTriangleCount += (remap_[next] == targetPosition || remap_[previous] == targetPosition) ? 1 : 0;
+            }
+            vertex = wedge_[vertex];
+        } while (vertex != sourcePosition);
+        return commonCount > edgeTriangleCount;
+    }
+
+    /// <summary>
+    /// sourceの位置をtargetへ動かしたとき、残る三角形のどれかが裏返るか
+    /// </summary>
+    bool HasTriangleFlips(uint32_t source, uint32_t target) const
+    {
+        uint32_t targetPosition = remap_[target];
+        const Vector3& moved = positions_[target];
+        uint32_t vertex = source;
+        do {
+            for (uint32_t k = adjacency_.offsets[vertex]; k < adjacency_.offsets[vertex + 1]; ++k) {
+                uint32_t triangle = adjacency_.triangles[k];
+                uint32_t next = GetNextCorner(indices_, triangle, vertex);
+                uint32_t previous = GetNextCorner(indices_, triangle, next);
+                // targetを含む三角形は縮約で消える
+                if (remap_[next] == targetPosition || remap_[previous] == targetPosition) {
+                    continue;
+                }
+                const Vector3& p1 = positions_[next];
+                const Vector3& p2 = positions_[previous];
+                Vector3 before = Cross(Subtract(p1, positions_[vertex]), Subtract(p2, positions_[vertex]));
+                Vector3 after = Cross(Subtract(p1, moved), Subtract(p2, moved));
+                if (Dot(before, after) <= 0.0f) {
+                    return true;
+                }
+            }
+            vertex = wedge_[vertex];
+        } while (vertex != source);
+        return false;
+    }
+
+    std::vector<uint32_t>& indices_;
+    std::vector<uint32_t>& triangleMaterials_;
+    std::vector<Vector3> positions_;
+    std::vector<uint32_t> remap_; //!< 同じ位置の頂点のうち最も小さい番号
+    std::vector<uint32_t> wedge_; //!< 同じ位置の次の頂点。1周すると自分に戻る
+    std::vector<Quadric> quadrics_; //!< 位置(remap_の番号)ごとの誤差
+    VertexTriangles adjacency_;
+    std::vector<VertexKind> kinds_;
+    std::vector<uint32_t> openIn_; //!< 開いた辺でこの頂点へ入ってくる頂点
+    std::vector<uint32_t> openOut_; //!< 開いた辺でこの頂点から出ていく頂点
+    std::vector<uint32_t> sourceNeighbors_; //!< BreaksManifoldの作業用
+    std::vector<uint32_t> targetNeighbors_; //!< BreaksManifoldの作業用
+};
+
+} // namespace
+
+float SimplifyMesh(const std::vector<VertexData>& vertices, std::vector<uint32_t>& indices, std::vector<uint32_t>& triangleMaterials, size_t targetTriangleCount)
+{
+    MeshSimplifier simplifier(vertices, indices, triangleMaterials);
+    return static_cast<float>(simplifier.Simplify(targetTriangleCount));
+}
+
+void GenerateLods(ModelData& modelData, const LodSettings& settings)
+{
+    if (modelData.lods.empty()) {
+        return;
+    }
+
+    // LOD0の三角形をマテリアル番号つきで集める
+    const MeshLod baseLod = modelData.lods[0];
+    std::vector<uint32_t> indices;
+    std::vector<uint32_t> triangleMaterials;
+    uint32_t materialCount = 0;
+    for (uint32_t i = baseLod.subMeshStart; i < baseLod.subMeshStart + baseLod.subMeshCount; ++i) {
+        const SubMesh& subMesh = modelData.subMeshes[i];
+        indices.insert(indices.end(), modelData.indices.begin() + subMesh.indexStart, modelData.indices.begin() + subMesh.indexStart + subMesh.indexCount);
+        triangleMaterials.insert(triangleMaterials.end(), subMesh.indexCount / 3, subMesh.materialIndex);
+        materialCount = (std::max)(materialCount, subMesh.materialIndex + 1);
+    }
+    size_t baseTriangleCount = triangleMaterials.size();
+
+    float error = baseLod.error;
+    std::vector<uint32_t> materialStarts;
+    for (float ratio : settings.triangleRatios) {
+        size_t previousTriangleCount = triangleMaterials.size();
+        size_t targetTriangleCount = static_cast<size_t>(static_cast<double>(baseTriangleCount) * ratio);
+        if (targetTriangleCount >= previousTriangleCount) {
+            continue;
+        }
+        float stepError = SimplifyMesh(modelData.vertices, indices, triangleMaterials, targetTriangleCount);
+        if (triangleMaterials.empty() || static_cast<double>(triangleMaterials.size()) > static_cast<double>(previousTriangleCount) * settings.minReduction) {
+            break;
+        }
+        // 前のLODからのずれを足して、元の形からのずれの上限にする
+        error += stepError;
+
+        // マテリアル番号順にまとめてSubMeshにする
+        materialStarts.assign(materialCount + 1, 0);
+        for (uint32_t material : triangleMaterials) {
+            ++materialStarts[material + 1];
+        }
+        for (uint32_t material = 0; material < materialCount; ++material) {
+            materialStarts[material + 1] += materialStarts[material];
+        }
+        uint32_t indexBase = static_cast<uint32_t>(modelData.indices.size());
+        MeshLod lod{ static_cast<uint32_t>(modelData.subMeshes.size()), 0, error };
+        for (uint32_t material = 0; material < materialCount; ++material) {
+            uint32_t triangleCount = materialStarts[material + 1] - materialStarts[material];
+            if (triangleCount != 0) {
+                modelData.subMeshes.push_back({ indexBase + materialStarts[material] * 3, triangleCount * 3, material });
+                ++lod.subMeshCount;
+            }
+        }
+        modelData.indices.resize(indexBase + indices.size());
+        for (size_t triangle = 0; triangle < triangleMaterials.size(); ++triangle) {
+            uint32_t writeTriangle = materialStarts[triangleMaterials[triangle]]++;
+            std::copy_n(&indices[triangle * 3], 3, &modelData.indices[indexBase + writeTriangle * 3]);
+        }
+        modelData.lods.push_back(lod);
+    }
+}
+
+uint32_t SelectLod(const ModelData& modelData, float pixelsPerUnit, float maxPixelError)
+{
+    // ずれは粗いLODほど大きいので、収まらなくなったところで止める
+    uint32_t selected = 0;
+    for (uint32_t lod = 1; lod < modelData.lods.size(); ++lod) {
+        if (modelData.lods[lod].error * pixelsPerUnit > maxPixelError) {
+            break;
+        }
+        selected = lod;
+    }
+    return selected;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ObjLoader.h"
+
+/// <summary>
+/// GenerateLodsの設定
+/// </summary>
+struct LodSettings {
+    std::vector<float> triangleRatios = { 0.5f, 0.25f, 0.125f }; // 各LODの三角形数のLOD0に対する割合。大きい順
+    float minReduction = 0.9f; // 前のLODの三角形数のこの割合より減らせないか、三角形がなくなったら、そこでLODを作るのをやめる
+};
+
+/// <summary>
+/// 辺の縮約で三角形をtargetTriangleCountまで減らす(Quadric Error Metrics)
+/// 頂点は既にある頂点へ寄せるだけで新しく作らないので、結果のIndexはそのままverticesを指す
+/// 位置が同じでテクスチャ座標か法線が違う頂点の境目(シーム)と開いた縁は、その線に沿ってだけ縮める。マテリアルの境目の頂点は動かさない
+/// triangleMaterialsは三角形ごとのマテリアル番号で、消えた三角形の分はindicesと一緒に詰める
+/// 同じ入力からは常に同じ結果になる。目標まで減らせないときは、減らせたところで止める
+/// 戻り値は入力の形からの最大のずれ(モデル座標の長さ)
+/// </summary>
+float SimplifyMesh(const std::vector<VertexData>& vertices, std::vector<uint32_t>& indices, std::vector<uint32_t>& triangleMaterials, size_t targetTriangleCount);
+
+/// <summary>
+/// LOD0を順に簡略化したLODを作り、Indexをindicesの後ろ、描画範囲をsubMeshesとlodsの後ろに足す
+/// 各LODは1つ前のLODから作り、ずれは前のLODまでのずれに足して元の形からのずれの上限とする
+/// </summary>
+void GenerateLods(ModelData& modelData, const LodSettings& settings = {});
+
+/// <summary>
+/// 画面上でのずれがmaxPixelError以下に収まる最も粗いLODの番号を返す
+/// pixelsPerUnitは、モデル座標での長さ1が画面上で何ピクセルになるか(投影の拡大率 * ワールドの拡縮 / 距離)
+/// </summary>
+uint32_t SelectLod(const ModelData& modelData, float pixelsPerUnit, float maxPixelError);
@@ -0,0 +1,444 @@
+#include "Meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "FrustumCulling.h"
+
+namespace {
+
+constexpr uint32_t kInvalidIndex = 0xFFFFFFFFu;
+
+Vector3 Subtract(const Vector3& a, const Vector3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+
+float Dot(const Vector3& a, const Vector3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+Vector3 Cross(const Vector3& a, const Vector3& b)
+{
+    return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+float Length(const Vector3& v) { return std::sqrt(Dot(v, v)); }
+
+Vector3 ToVector3(const Vector4& v) { return { v.x, v.y, v.z }; }
+
+/// <summary>
+/// 行ベクトルの点をアフィン行列で変換する
+/// </summary>
+Vector3 TransformPoint(const Vector3& v, const Matrix4x4& m)
+{
+    return {
+        v.x * m.m[0][0] + v.y * m.m[1][0] + v.z * m.m[2][0] + m.m[3][0],
+        v.x * m.m[0][1] + v.y * m.m[1][1] + v.z * m.m[2][1] + m.m[3][1],
+        v.x * m.m[0][2] + v.y * m.m[1][2] + v.z * m.m[2][2] + m.m[3][2],
+    };
+}
+
+/// <summary>
+/// 行ベクトルの方向を行列の3x3部分で変換する
+/// </summary>
+Vector3 TransformDirection(const Vector3& v, const Matrix4x4& m)
+{
+    return {
+        v.x * m.m[0][0] + v.y * m.m[1][0] + v.z * m.m[2][0],
+        v.x * m.m[0][1] + v.y * m.m[1][1] + v.z * m.m[2][1],
+        v.x * m.m[0][2] + v.y * m.m[1][2] + v.z * m.m[2][2],
+    };
+}
+
+/// <summary>
+/// 作成中のメッシュレット
+/// </summary>
+class MeshletBuilder {
+public:
+    MeshletBuilder(const ModelData& modelData, const std::vector<Vector3>& triangleNormals, const std::vector<Vector3>& triangleCentroids)
+        : modelData_(modelData), triangleNormals_(triangleNormals), triangleCentroids_(triangleCentroids), localIndices_(modelData.vertices.size(), kInvalidIndex) {}
+
+    /// <summary>
+    /// 三角形を加えたときに増える頂点の数
+    /// </summary>
+    uint32_t CountNewVertices(uint32_t triangle) const
+    {
+        uint32_t count = 0;
+        for (uint32_t corner = 0; corner < 3; ++corner) {
+            count += localIndices_[modelData_.indices[triangle * 3 + corner]] == kInvalidIndex ? 1 : 0;
+        }
+        return count;
+    }
+
+    /// <summary>
+    /// 三角形を加えられるか
+    /// </summary>
+    bool CanAdd(uint32_t triangle) const
+    {
+        return triangles_.size() / 3 < kMaxMeshletTriangles && vertices_.size() + CountNewVertices(triangle) <= kMaxMeshletVertices;
+    }
+
+    /// <summary>
+    /// 三角形を加える。新しく加わった頂点はnewVerticesに追加する
+    /// </summary>
+    void Add(uint32_t triangle, std::vector<uint32_t>& newVertices)
+    {
+        for (uint32_t corner = 0; corner < 3; ++corner) {
+            uint32_t vertex = modelData_.indices[triangle * 3 + corner];
+            uint32_t& local = localIndices_[vertex];
+            if (local == kInvalidIndex) {
+                local = static_cast<uint32_t>(vertices_.size());
+                vertices_.push_back(vertex);
+                newVertices.push_back(vertex);
+            }
+            triangles_.push_back(static_cast<uint8_t>(local));
+        }
+        const Vector3& normal = triangleNormals_[triangle];
+        normalSum_ = { normalSum_.x + normal.x, normalSum_.y + normal.y, normalSum_.z + normal.z };
+        const Vector3& centroid = triangleCentroids_[triangle];
+        centroidSum_ = { centroidSum_.x + centroid.x, centroidSum_.y + centroid.y, centroidSum_.z + centroid.z };
+        triangleIndices_.push_back(triangle);
+    }
+
+    bool IsFull() const { return triangles_.size() / 3 >= kMaxMeshletTriangles; }
+
+    const Vector3& GetNormalSum() const { return normalSum_; }
+
+    /// <summary>
+    /// 加えた三角形の重心の平均
+    /// </summary>
+    Vector3 GetCenter() const
+    {
+        float inverse = 1.0f / static_cast<float>(triangleIndices_.size());
+        return { centroidSum_.x * inverse, centroidSum_.y * inverse, centroidSum_.z * inverse };
+    }
+
+    /// <summary>
+    /// 作成中のメッシュレットを確定してmodelDataに加え、空にする
+    /// </summary>
+    void Flush(ModelData& output, uint32_t materialIndex)
+    {
+        Meshlet meshlet{};
+        meshlet.vertexOffset = static_cast<uint32_t>(output.meshletVertices.size());
+        meshlet.triangleOffset = static_cast<uint32_t>(output.meshletTriangles.size());
+        meshlet.vertexCount = static_cast<uint32_t>(vertices_.size());
+        meshlet.triangleCount = static_cast<uint32_t>(triangles_.size() / 3);
+        meshlet.materialIndex = materialIndex;
+        ComputeBounds(meshlet);
+        output.meshlets.push_back(meshlet);
+        output.meshletVertices.insert(output.meshletVertices.end(), vertices_.begin(), vertices_.end());
+        output.meshletTriangles.insert(output.meshletTriangles.end(), triangles_.begin(), triangles_.end());
+
+        for (uint32_t vertex : vertices_) {
+            localIndices_[vertex] = kInvalidIndex;
+        }
+        vertices_.clear();
+        triangles_.clear();
+        triangleIndices_.clear();
+        normalSum_ = {};
+        centroidSum_ = {};
+    }
+
+private:
+    /// <summary>
+    /// 囲む球と法線の円錐を求める
+    /// </summary>
+    void ComputeBounds(Meshlet& meshlet) const
+    {
+        // 囲む球はRitterの方法で求める。互いに遠い2点を直径として始め、外れた点を含むように広げる
+        auto position = [this](uint32_t local) { return ToVector3(modelData_.vertices[vertices_[local]].position); };
+        uint32_t farthest = 0;
+        for (uint32_t i = 1; i < vertices_.size(); ++i) {
+            if (position(i).x < position(farthest).x) {
+                farthest = i;
+            }
+        }
+        auto findFarthest = [&](const Vector3& from) {
+            uint32_t result = 0;
+            float maxDistance = -1.0f;
+            for (uint32_t i = 0; i < vertices_.size(); ++i) {
+                float distance = Length(Subtract(position(i), from));
+                if (distance > maxDistance) {
+                    maxDistance = distance;
+                    result = i;
+                }
+            }
+            return result;
+        };
+        Vector3 a = position(findFarthest(position(farthest)));
+        Vector3 b = position(findFarthest(a));
+        Vector3 center = { (a.x + b.x) * 0.5f, (a.y + b.y) * 0.5f, (a.z + b.z) * 0.5f };
+        float radius = Length(Subtract(b, a)) * 0.5f;
+        for (uint32_t i = 0; i < vertices_.size(); ++i) {
+            Vector3 p = position(i);
+            float distance = Length(Subtract(p, center));
+            if (distance > radius) {
+                float newRadius = (radius + distance) * 0.5f;
+                float k = (newRadius - radius) / distance;
+                center = { center.x + (p.x - center.x) * k, center.y + (p.y - center.y) * k, center.z + (p.z - center.z) * k };
+                radius = newRadius;
+            }
+        }
+        meshlet.center = center;
+        meshlet.radius = radius;
+
+        // 法線の円錐。軸は法線の平均で、開きが大きすぎるものは裏向きの判定に使わない
+        meshlet.coneApex = center;
+        meshlet.coneAxis = { 0.0f, 0.0f, 0.0f };
+        meshlet.coneCutoff = 1.0f;
+        float axisLength = Length(normalSum_);
+        if (axisLength <= 0.0f) {
+            return;
+        }
+        Vector3 axis = { normalSum_.x / axisLength, normalSum_.y / axisLength, normalSum_.z / axisLength };
+        float minDot = 1.0f;
+        for (uint32_t triangle : triangleIndices_) {
+            const Vector3& normal = triangleNormals_[triangle];
+            if (Dot(normal, normal) == 0.0f) {
+                continue;
+            }
+            minDot = (std::min)(minDot, Dot(normal, axis));
+        }
+        meshlet.coneAxis = axis;
+        if (minDot <= 0.1f) {
+            return;
+        }
+
+        // 全三角形の面の裏側に入る位置まで軸に沿って円錐の頂点を下げる
+        float maxOffset = 0.0f;
+        for (uint32_t triangle : triangleIndices_) {
+            const Vector3& normal = triangleNormals_[triangle];
+            if (Dot(normal, normal) == 0.0f) {
+                continue;
+            }
+            Vector3 p0 = ToVector3(modelData_.vertices[modelData_.indices[triangle * 3]].position);
+            float offset = Dot(Subtract(center, p0), normal) / Dot(axis, normal);
+            maxOffset = (std::max)(maxOffset, offset);
+        }
+        meshlet.coneApex = { center.x - axis.x * maxOffset, center.y - axis.y * maxOffset, center.z - axis.z * maxOffset };
+        meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+    }
+
+    const ModelData& modelData_; //!< 元のメッシュ
+    const std::vector<Vector3>& triangleNormals_; //!< 三角形ごとの単位法線
+    const std::vector<Vector3>& triangleCentroids_; //!< 三角形ごとの重心
+    std::vector<uint32_t> localIndices_; //!< 頂点ごとのメッシュレット内の番号
+    std::vector<uint32_t> vertices_; //!< メッシュレットの頂点
+    std::vector<uint8_t> triangles_; //!< メッシュレット内の頂点の番号
+    std::vector<uint32_t> triangleIndices_; //!< 加えた三角形の番号
+    Vector3 normalSum_{}; //!< 加えた三角形の法線の和
+    Vector3 centroidSum_{}; //!< 加えた三角形の重心の和
+};
+
+} // namespace
+
+void BuildMeshlets(ModelData& modelData)
+{
+    modelData.meshlets.clear();
+    modelData.meshletVertices.clear();
+    modelData.meshletTriangles.clear();
+
+    // 詳細度を下げたLODはカリングの対象にしないので、LOD0の三角形だけをまとめる
+    const MeshLod& baseLod = modelData.lods.front();
+    size_t baseIndexCount = 0;
+    for (uint32_t i = baseLod.subMeshStart; i < baseLod.subMeshStart + baseLod.subMeshCount; ++i) {
+        baseIndexCount = (std::max)(baseIndexCount, static_cast<size_t>(modelData.subMeshes[i].indexStart) + modelData.subMeshes[i].indexCount);
+    }
+    size_t triangleCount = baseIndexCount / 3;
+    size_t vertexCount = modelData.vertices.size();
+
+    // 三角形ごとの法線。裏表は描画と同じく(p1 - p0) x (p2 - p0)の向きを表とする
+    std::vector<Vector3> triangleNormals(triangleCount);
+    std::vector<Vector3> triangleCentroids(triangleCount);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        Vector3 p0 = ToVector3(modelData.vertices[modelData.indices[t * 3 + 0]].position);
+        Vector3 p1 = ToVector3(modelData.vertices[modelData.indices[t * 3 + 1]].position);
+        Vector3 p2 = ToVector3(modelData.vertices[modelData.indices[t * 3 + 2]].position);
+        Vector3 normal = Cross(Subtract(p1, p0), Subtract(p2, p0));
+        float length = Length(normal);
+        triangleCentroids[t] = { (p0.x + p1.x + p2.x) / 3.0f, (p0.y + p1.y + p2.y) / 3.0f, (p0.z + p1.z + p2.z) / 3.0f };
+        triangleNormals[t] = length > 0.0f ? Vector3{ normal.x / length, normal.y / length, normal.z / length } : Vector3{ 0.0f, 0.0f, 0.0f };
+    }
+
+    // 頂点ごとに、それを使う三角形の一覧
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < baseIndexCount; ++i) {
+        ++adjacencyOffsets[modelData.indices[i] + 1];
+    }
+    for (size_t v = 0; v < vertexCount; ++v) {
+        adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+    }
+    std::vector<uint32_t> adjacency(baseIndexCount);
+    {
+        std::vector<uint32_t> writePositions(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < baseIndexCount; ++i) {
+            adjacency[writePositions[modelData.indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+
+    // 頂点ごとのまだメッシュレットに入っていない三角形の数
+    std::vector<uint32_t> liveTriangles(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        liveTriangles[v] = adjacencyOffsets[v + 1] - adjacencyOffsets[v];
+    }
+
+    std::vector<bool> used(triangleCount, false);
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> newVertices;
+    MeshletBuilder builder(modelData, triangleNormals, triangleCentroids);
+    for (uint32_t subMeshIndex = baseLod.subMeshStart; subMeshIndex < baseLod.subMeshStart + baseLod.subMeshCount; ++subMeshIndex) {
+        const SubMesh& subMesh = modelData.subMeshes[subMeshIndex];
+        candidates.clear();
+        uint32_t triangleStart = subMesh.indexStart / 3;
+        uint32_t triangleEnd = triangleStart + subMesh.indexCount / 3;
+        auto addTriangle = [&](uint32_t triangle) {
+            used[triangle] = true;
+            for (uint32_t corner = 0; corner < 3; ++corner) {
+                --liveTriangles[modelData.indices[triangle * 3 + corner]];
+            }
+            newVertices.clear();
+            builder.Add(triangle, newVertices);
+            // 新しい頂点を共有する三角形を候補にする
+            for (uint32_t vertex : newVertices) {
+                for (uint32_t a = adjacencyOffsets[vertex]; a < adjacencyOffsets[vertex + 1]; ++a) {
+                    uint32_t neighbor = adjacency[a];
+                    if (!used[neighbor] && neighbor >= triangleStart && neighbor < triangleEnd) {
+                        candidates.push_back(neighbor);
+                    }
+                }
+            }
+        };
+
+        uint32_t cursor = triangleStart;
+        while (true) {
+            // 直前のメッシュレットに接する三角形のうち、周りが最も埋まっているものから始める
+            // 接するものがなければ残っている最初の三角形から始める
+            uint32_t seed = kInvalidIndex;
+            uint32_t seedLiveTriangles = 0;
+            for (uint32_t candidate : candidates) {
+                if (used[candidate]) {
+                    continue;
+                }
+                uint32_t live = 0;
+                for (uint32_t corner = 0; corner < 3; ++corner) {
+                    live += liveTriangles[modelData.indices[candidate * 3 + corner]];
+                }
+                if (seed == kInvalidIndex || live < seedLiveTriangles || (live == seedLiveTriangles && candidate < seed)) {
+                    seed = candidate;
+                    seedLiveTriangles = live;
+                }
+            }
+            if (seed == kInvalidIndex) {
+                while (cursor < triangleEnd && used[cursor]) {
+                    ++cursor;
+                }
+                if (cursor == triangleEnd) {
+                    break;
+                }
+                seed = cursor;
+            }
+            candidates.clear();
+            addTriangle(seed);
+
+            // 増える頂点が少なく、近くて向きがそろっている三角形から加える
+            // 最後の1つになった三角形を持つ頂点は、今取らないと孤立した小さなメッシュレットになるので優先する
+            while (!builder.IsFull()) {
+                uint32_t best = kInvalidIndex;
+                uint32_t bestCost = 4;
+                float bestScore = 0.0f;
+                Vector3 center = builder.GetCenter();
+                Vector3 normalSum = builder.GetNormalSum();
+                float normalLength = Length(normalSum);
+                Vector3 axis = normalLength > 0.0f ? Vector3{ normalSum.x / normalLength, normalSum.y / normalLength, normalSum.z / normalLength } : Vector3{ 0.0f, 0.0f, 0.0f };
+                size_t liveCount = 0;
+                for (uint32_t candidate : candidates) {
+                    if (used[candidate]) {
+                        continue;
+                    }
+                    candidates[liveCount++] = candidate;
+                    if (!builder.CanAdd(candidate)) {
+                        continue;
+                    }
+                    uint32_t cost = builder.CountNewVertices(candidate);
+                    for (uint32_t corner = 0; corner < 3; ++corner) {
+                        if (liveTriangles[modelData.indices[candidate * 3 + corner]] == 1) {
+                            cost = 0;
+                        }
+                    }
+                    // 重心に近いほど丸くまとまり、向きがそろうほど裏向きで除きやすい
+                    float distance = Length(Subtract(triangleCentroids[candidate], center));
+                    float score = distance * (2.0f - Dot(triangleNormals[candidate], axis));
+                    if (cost < bestCost ||
+                        (cost == bestCost && (score < bestScore || (score == bestScore && candidate < best)))) {
+                        best = candidate;
+                        bestCost = cost;
+                        bestScore = score;
+                    }
+                }
+                candidates.resize(liveCount);
+                if (best == kInvalidIndex) {
+                    break;
+                }
+                addTriangle(best);
+            }
+            builder.Flush(modelData, subMesh.materialIndex);
+        }
+    }
+}
+
+MeshletCullingStatistics CullMeshlets(const ModelData& modelData, const Matrix4x4& world, const Matrix4x4& viewProjection, const Vector3& cameraPosition, std::vector<uint32_t>* visibleMeshlets)
+{
+    MeshletCullingStatistics statistics{};
+    if (visibleMeshlets) {
+        visibleMeshlets->clear();
+    }
+
+    // 視錐台の6平面。内側が正
+    Frustum frustum = ExtractFrustum(viewProjection);
+
+    // 拡縮が一様で反転していなければ法線の円錐はそのまま変換できる
+    Vector3 axisX = { world.m[0][0], world.m[0][1], world.m[0][2] };
+    Vector3 axisY = { world.m[1][0], world.m[1][1], world.m[1][2] };
+    Vector3 axisZ = { world.m[2][0], world.m[2][1], world.m[2][2] };
+    float scaleX = Length(axisX);
+    float scaleY = Length(axisY);
+    float scaleZ = Length(axisZ);
+    float maxScale = (std::max)({ scaleX, scaleY, scaleZ });
+    float minScale = (std::min)({ scaleX, scaleY, scaleZ });
+    bool useCone = minScale > 0.0f && maxScale - minScale <= maxScale * 1e-3f && Dot(Cross(axisX, axisY), axisZ) > 0.0f;
+
+    for (uint32_t i = 0; i < modelData.meshlets.size(); ++i) {
+        const Meshlet& meshlet = modelData.meshlets[i];
+        ++statistics.meshletCount;
+        statistics.triangleCount += meshlet.triangleCount;
+
+        Vector3 center = TransformPoint(meshlet.center, world);
+        float radius = meshlet.radius * maxScale;
+        bool outside = false;
+        for (const Vector4& plane : frustum.planes) {
+            if (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius) {
+                outside = true;
+                break;
+            }
+        }
+        if (outside) {
+            ++statistics.frustumCulledMeshletCount;
+            statistics.culledTriangleCount += meshlet.triangleCount;
+            continue;
+        }
+
+        if (useCone && meshlet.coneCutoff < 1.0f) {
+            Vector3 apex = TransformPoint(meshlet.coneApex, world);
+            Vector3 axis = TransformDirection(meshlet.coneAxis, world);
+            Vector3 view = Subtract(apex, cameraPosition);
+            float viewLength = Length(view);
+            if (viewLength > 0.0f && Dot(view, axis) >= meshlet.coneCutoff * viewLength * Length(axis)) {
+                ++statistics.backfaceCulledMeshletCount;
+                statistics.culledTriangleCount += meshlet.triangleCount;
+                continue;
+            }
+        }
+
+        ++statistics.visibleMeshletCount;
+        if (visibleMeshlets) {
+            visibleMeshlets->push_back(i);
+        }
+    }
+    return statistics;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "MathTypes.h"
+#include "ObjLoader.h"
+
+constexpr uint32_t kMaxMeshletVertices = 64;
+constexpr uint32_t kMaxMeshletTriangles = 124;
+
+/// <summary>
+/// メッシュレット単位のカリングの結果
+/// </summary>
+struct MeshletCullingStatistics {
+    uint32_t meshletCount; // 調べたメッシュレットの数
+    uint32_t visibleMeshletCount; // 残ったメッシュレットの数
+    uint32_t frustumCulledMeshletCount; // 視錐台の外で除いた数
+    uint32_t backfaceCulledMeshletCount; // 全三角形が裏向きで除いた数
+    uint32_t triangleCount; // 調べた三角形の数
+    uint32_t culledTriangleCount; // 除いたメッシュレットに含まれる三角形の数
+};
+
+/// <summary>
+/// LOD0のSubMeshごとに三角形をメッシュレットにまとめ、囲む球と法線の円錐を求めてmodelDataに入れる
+/// 既に入っているIndexの順から、頂点を共有する三角形を優先して貪欲に集める
+/// </summary>
+void BuildMeshlets(ModelData& modelData);
+
+/// <summary>
+/// メッシュレットを視錐台と法線の円錐でカリングする(CPUでの参照実装)
+/// worldはモデルのワールド行列、viewProjectionはビュープロジェクション行列、cameraPositionはワールド座標でのカメラの位置
+/// 拡縮が軸ごとに異なるときは法線の円錐が保てないので、裏向きの判定はしない
+/// </summary>
+MeshletCullingStatistics CullMeshlets(const ModelData& modelData, const Matrix4x4& world, const Matrix4x4& viewProjection, const Vector3& cameraPosition, std::vector<uint32_t>* visibleMeshlets = nullptr);
@@ -0,0 +1,338 @@
+#include "ObjLoader.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include "MappedFile.h"
+#include "ObjParser.h"
+#include "ObjTokenizer.h"
+#include "ParallelFor.h"
+
+std::vector<MaterialData> LoadMaterialTemplateFile(const std::string& directoryPath, const std::string& filename)
+{
+    std::vector<MaterialData> materials;
+    std::string line; // ファイルから読んだ1行を格納するもの
+
+    std::ifstream file(directoryPath + "/" + filename); // ファイルを開く
+    assert(file.is_open());
+
+    while (std::getline(file, line)) {
+        std::string identifier;
+        std::istringstream s(line);
+        s >> identifier;
+
+        // identifierに応じた処理
+        if (identifier == "newmtl") {
+            // 以降の設定は新しいマテリアルのもの
+            materials.emplace_back();
+            s >> materials.back().name;
+        } else if (identifier == "map_Kd") {
+            std::string textureFilename;
+            s >> textureFilename;
+            if (materials.empty()) {
+                materials.emplace_back();
+            }
+            // 連結してファイルパスにする
+            materials.back().textureFilePath = directoryPath + "/" + textureFilename;
+        }
+    }
+
+    return materials;
+}
+
+std::vector<MaterialData> ResolveMaterials(const std::string& directoryPath, const std::string& materialLibrary, const std::vector<std::string>& materialNames)
+{
+    std::vector<MaterialData> library;
+    if (!materialLibrary.empty()) {
+        library = LoadMaterialTemplateFile(directoryPath, materialLibrary);
+    }
+
+    std::vector<MaterialData> materials(materialNames.size());
+    for (size_t i = 0; i < materialNames.size(); ++i) {
+        materials[i].name = materialNames[i];
+        for (const MaterialData& material : library) {
+            if (material.name == materialNames[i]) {
+                materials[i] = material;
+                break;
+            }
+        }
+    }
+    return materials;
+}
+
+void ParseObjChunk(const char* begin, const char* end, ObjChunk& chunk)
+{
+    using namespace ObjTokenizer;
+
+    const char* p = begin;
+    while (p < end) {
+        // 行頭の識別子を切り出す
+        p = SkipSpaces(p, end);
+        const char* identifier = p;
+        p = SkipToken(p, end);
+        size_t identifierLength = static_cast<size_t>(p - identifier);
+
+        // identifierに応じた処理
+        if (identifierLength == 1 && identifier[0] == 'v') {
+            Vector4 position;
+            p = ParseFloat(p, end, position.x);
+            p = ParseFloat(p, end, position.y);
+            p = ParseFloat(p, end, position.z);
+            position.x *= -1.0f;
+            position.w = 1.0f;
+            chunk.positions.push_back(position);
+        } else if (identifierLength == 2 && identifier[0] == 'v' && identifier[1] == 't') {
+            Vector2 texcoord;
+            p = ParseFloat(p, end, texcoord.x);
+            p = ParseFloat(p, end, texcoord.y);
+            texcoord.y = 1.0f - texcoord.y;
+            chunk.texcoords.push_back(texcoord);
+        } else if (identifierLength == 2 && identifier[0] == 'v' && identifier[1] == 'n') {
+            Vector3 normal;
+            p = ParseFloat(p, end, normal.x);
+            p = ParseFloat(p, end, normal.y);
+            p = ParseFloat(p, end, normal.z);
+            normal.x *= -1.0f;
+            chunk.normals.push_back(normal);
+        } else if (identifierLength == 1 && identifier[0] == 'f') {
+            // 面は三角形限定。その他は未対応
+            // 頂点の要素へのIndexは、「位置/テクスチャ座標/法線」で格納されているので、分解してIndexを取得する
+            for (int32_t faceVertex = 0; faceVertex < 3; ++faceVertex) {
+                ObjVertexKey key{};
+                p = ParseInt(p, end, key.position);
+                assert(p < end && *p == '/');
+                p = ParseInt(p + 1, end, key.texcoord);
+                assert(p < end && *p == '/');
+                p = ParseInt(p + 1, end, key.normal);
+                chunk.faceVertices.push_back(key);
+            }
+        } else if (identifierLength == 6 && std::memcmp(identifier, "usemtl", 6) == 0) {
+            // 以降の面に適用するマテリアルを切り替える
+            const char* materialName = SkipSpaces(p, end);
+            p = SkipToken(materialName, end);
+            chunk.materialRuns.push_back({ chunk.faceVertices.size() / 3, std::string(materialName, p) });
+        } else if (identifierLength == 6 && std::memcmp(identifier, "mtllib", 6) == 0) {
+            const char* materialFilename = SkipSpaces(p, end);
+            p = SkipToken(materialFilename, end);
+            chunk.materialFilename.assign(materialFilename, p);
+        }
+
+        // 残りは読み捨てて次の行へ
+        p = SkipLine(p, end);
+    }
+}
+
+AABB ComputeBounds(const std::vector<VertexData>& vertices)
+{
+    if (vertices.empty()) {
+        return { { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
+    }
+    const Vector4& first = vertices.front().position;
+    AABB bounds{ { first.x, first.y, first.z }, { first.x, first.y, first.z } };
+    for (const VertexData& vertex : vertices) {
+        bounds.min.x = (std::min)(bounds.min.x, vertex.position.x);
+        bounds.min.y = (std::min)(bounds.min.y, vertex.position.y);
+        bounds.min.z = (std::min)(bounds.min.z, vertex.position.z);
+        bounds.max.x = (std::max)(bounds.max.x, vertex.position.x);
+        bounds.max.y = (std::max)(bounds.max.y, vertex.position.y);
+        bounds.max.z = (std::max)(bounds.max.z, vertex.position.z);
+    }
+    return bounds;
+}
+
+Sphere ComputeBoundingSphere(const std::vector<VertexData>& vertices, const AABB& bounds)
+{
+    Vector3 center = {
+        (bounds.min.x + bounds.max.x) * 0.5f,
+        (bounds.min.y + bounds.max.y) * 0.5f,
+        (bounds.min.z + bounds.max.z) * 0.5f,
+    };
+    float maxDistanceSquared = 0.0f;
+    for (const VertexData& vertex : vertices) {
+        float dx = vertex.position.x - center.x;
+        float dy = vertex.position.y - center.y;
+        float dz = vertex.position.z - center.z;
+        maxDistanceSquared = (std::max)(maxDistanceSquared, dx * dx + dy * dy + dz * dz);
+    }
+    return { center, std::sqrt(maxDistanceSquared) };
+}
+
+uint32_t GetDefaultObjLoadThreadCount()
+{
+    uint32_t threadCount = std::thread::hardware_concurrency();
+    return threadCount == 0 ? 1 : threadCount;
+}
+
+ModelData LoadObjFile(const std::string& directoryPath, const std::string& filename, uint32_t threadCount) {
+    ModelData modelData; // 構築するModelData
+
+    MappedFile file;
+    bool opened = file.Open(directoryPath + "/" + filename); // ファイルを開いてマップする
+    assert(opened);
+    (void)opened;
+
+    const char* data = file.GetData();
+    const char* dataEnd = data + file.GetSize();
+
+    // 小さいファイルはスレッドを起こす方が高くつくので、1チャンクあたり最低限の大きさを確保する
+    constexpr size_t kMinChunkSize = 1 << 20;
+    size_t chunkCount = threadCount == 0 ? 1 : threadCount;
+    chunkCount = (std::min)(chunkCount, file.GetSize() / kMinChunkSize + 1);
+
+    // 行の途中で切らないように、区切りを次の改行の直後までずらす
+    std::vector<const char*> boundaries(chunkCount + 1);
+    boundaries[0] = data;
+    boundaries[chunkCount] = dataEnd;
+    for (size_t i = 1; i < chunkCount; ++i) {
+        const char* split = data + file.GetSize() / chunkCount * i;
+        split = (std::max)(split, boundaries[i - 1]);
+        boundaries[i] = ObjTokenizer::SkipLine(split, dataEnd);
+    }
+
+    // 各チャンクを並列に解析
+    std::vector<ObjChunk> chunks(chunkCount);
+    ParallelFor(chunkCount, threadCount, [&](size_t i) {
+        ParseObjChunk(boundaries[i], boundaries[i + 1], chunks[i]);
+    });
+
+    // 各チャンクの要素がファイル全体のどこから始まるかを求める
+    std::vector<size_t> positionOffsets(chunkCount + 1, 0);
+    std::vector<size_t> texcoordOffsets(chunkCount + 1, 0);
+    std::vector<size_t> normalOffsets(chunkCount + 1, 0);
+    size_t faceVertexCount = 0;
+    for (size_t i = 0; i < chunkCount; ++i) {
+        positionOffsets[i + 1] = positionOffsets[i] + chunks[i].positions.size();
+        texcoordOffsets[i + 1] = texcoordOffsets[i] + chunks[i].texcoords.size();
+        normalOffsets[i + 1] = normalOffsets[i] + chunks[i].normals.size();
+        faceVertexCount += chunks[i].faceVertices.size();
+    }
+
+    // 要素をファイル全体の配列にまとめる
+    std::vector<Vector4> positions(positionOffsets[chunkCount]); // 位置
+    std::vector<Vector3> normals(normalOffsets[chunkCount]); // 法線
+    std::vector<Vector2> texcoords(texcoordOffsets[chunkCount]); // テクスチャ座標
+    ParallelFor(chunkCount, threadCount, [&](size_t i) {
+        std::copy(chunks[i].positions.begin(), chunks[i].positions.end(), positions.begin() + positionOffsets[i]);
+        std::copy(chunks[i].texcoords.begin(), chunks[i].texcoords.end(), texcoords.begin() + texcoordOffsets[i]);
+        std::copy(chunks[i].normals.begin(), chunks[i].normals.end(), normals.begin() + normalOffsets[i]);
+        chunks[i].positions = {};
+        chunks[i].texcoords = {};
+        chunks[i].normals = {};
+    });
+
+    // usemtlの切り替えをファイルの順にたどり、面ごとのマテリアル番号を決める
+    // マテリアル番号は名前が初めて現れた順。usemtlより前の面は名前なしのマテリアルになる
+    std::vector<std::string> materialNames;
+    std::vector<uint32_t> faceMaterials;
+    faceMaterials.reserve(faceVertexCount / 3);
+    {
+        constexpr uint32_t kNoMaterial = 0xFFFFFFFFu;
+        auto findOrAddMaterial = [&materialNames](const std::string& name) {
+            auto it = std::find(materialNames.begin(), materialNames.end(), name);
+            if (it != materialNames.end()) {
+                return static_cast<uint32_t>(it - materialNames.begin());
+            }
+            materialNames.push_back(name);
+            return static_cast<uint32_t>(materialNames.size() - 1);
+        };
+        uint32_t currentMaterial = kNoMaterial;
+        for (const ObjChunk& chunk : chunks) {
+            size_t faceCount = chunk.faceVertices.size() / 3;
+            size_t runIndex = 0;
+            for (size_t face = 0; face <= faceCount; ++face) {
+                while (runIndex < chunk.materialRuns.size() && chunk.materialRuns[runIndex].faceStart == face) {
+                    currentMaterial = findOrAddMaterial(chunk.materialRuns[runIndex].name);
+                    ++runIndex;
+                }
+                if (face == faceCount) {
+                    break;
+                }
+                if (currentMaterial == kNoMaterial) {
+                    currentMaterial = findOrAddMaterial("");
+                }
+                faceMaterials.push_back(currentMaterial);
+            }
+        }
+    }
+
+    // 「位置/テクスチャ座標/法線」の組ごとに頂点を1つだけ作り、面からはIndexで参照する
+    // 登録順がスレッド数に左右されないよう、ファイルの順に1本で処理する
+    std::vector<ObjVertexKey> uniqueVertices;
+    std::vector<uint32_t> fileOrderIndices;
+    VertexKeyTable vertexTable(positions.size());
+    fileOrderIndices.reserve(faceVertexCount);
+    for (ObjChunk& chunk : chunks) {
+        for (size_t face = 0; face < chunk.faceVertices.size(); face += 3) {
+            // 右手系から左手系にするので回り順を逆にする
+            for (size_t faceVertex = 3; faceVertex > 0; --faceVertex) {
+                const ObjVertexKey& key = chunk.faceVertices[face + faceVertex - 1];
+                uint32_t newIndex = static_cast<uint32_t>(uniqueVertices.size());
+                uint32_t index = vertexTable.FindOrAdd(key, newIndex);
+                if (index == newIndex) {
+                    uniqueVertices.push_back(key);
+                }
+                fileOrderIndices.push_back(index);
+            }
+        }
+        chunk.faceVertices = {};
+    }
+
+    // マテリアルごとに1回の描画で済むよう、三角形をマテリアル番号順に並べ替える(同じマテリアル内はファイルの順)
+    std::vector<uint32_t> materialIndexStarts(materialNames.size() + 1, 0);
+    for (uint32_t material : faceMaterials) {
+        materialIndexStarts[material + 1] += 3;
+    }
+    for (size_t material = 0; material < materialNames.size(); ++material) {
+        materialIndexStarts[material + 1] += materialIndexStarts[material];
+    }
+    modelData.indices.resize(fileOrderIndices.size());
+    {
+        std::vector<uint32_t> writePositions(materialIndexStarts.begin(), materialIndexStarts.end() - 1);
+        for (size_t face = 0; face < faceMaterials.size(); ++face) {
+            uint32_t& writePosition = writePositions[faceMaterials[face]];
+            std::copy_n(&fileOrderIndices[face * 3], 3, &modelData.indices[writePosition]);
+            writePosition += 3;
+        }
+    }
+    for (uint32_t material = 0; material < materialNames.size(); ++material) {
+        uint32_t indexCount = materialIndexStarts[material + 1] - materialIndexStarts[material];
+        if (indexCount != 0) {
+            modelData.subMeshes.push_back({ materialIndexStarts[material], indexCount, material });
+        }
+    }
+    modelData.lods.push_back({ 0, static_cast<uint32_t>(modelData.subMeshes.size()), 0.0f });
+
+    // 1始まりの全体Indexを解決して頂点を構築する
+    modelData.vertices.resize(uniqueVertices.size());
+    size_t verticesPerChunk = (uniqueVertices.size() + chunkCount - 1) / chunkCount;
+    ParallelFor(chunkCount, threadCount, [&](size_t i) {
+        size_t begin = (std::min)(i * verticesPerChunk, uniqueVertices.size());
+        size_t end = (std::min)(begin + verticesPerChunk, uniqueVertices.size());
+        for (size_t vertex = begin; vertex < end; ++vertex) {
+            const ObjVertexKey& key = uniqueVertices[vertex];
+            assert(key.position > 0 && static_cast<size_t>(key.position) <= positions.size());
+            assert(key.texcoord > 0 && static_cast<size_t>(key.texcoord) <= texcoords.size());
+            assert(key.normal > 0 && static_cast<size_t>(key.normal) <= normals.size());
+            // 要素へのIndexから、実際の要素の値を取得して、頂点を構築する
+            modelData.vertices[vertex] = { positions[key.position - 1], texcoords[key.texcoord - 1], normals[key.normal - 1] };
+        }
+    });
+
+    modelData.bounds = ComputeBounds(modelData.vertices);
+    modelData.boundingSphere = ComputeBoundingSphere(modelData.vertices, modelData.bounds);
+
+    // mtllibは最後に現れたものが有効
+    for (size_t i = chunkCount; i > 0; --i) {
+        if (!chunks[i - 1].materialFilename.empty()) {
+            modelData.materialLibrary = chunks[i - 1].materialFilename;
+            break;
+        }
+    }
+    modelData.materials = ResolveMaterials(directoryPath, modelData.materialLibrary, materialNames);
+
+    return modelData;
+}
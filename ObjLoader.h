@@ -0,0 +1,134 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MathTypes.h"
+
+struct VertexData {
+    Vector4 position;
+    Vector2 texcoord;
+    Vector3 normal;
+};
+
+/// <summary>
+/// GPUに送る頂点の形式。VertexDataから読み込み時に選ぶ
+/// </summary>
+enum class VertexFormat : uint32_t {
+    Float, // VertexDataそのまま(36byte)
+    PackedFloat3, // floatの位置3つ、halfのテクスチャ座標、八面体の法線(20byte)
+    PackedQuantized, // 範囲で量子化した位置、halfのテクスチャ座標、八面体の法線(16byte)
+};
+
+struct MaterialData
+{
+    std::string name; // newmtlで付けられた名前
+    std::string textureFilePath;
+};
+
+/// <summary>
+/// Indexバッファ中の、1つのマテリアルで描画する範囲
+/// </summary>
+struct SubMesh {
+    uint32_t indexStart; // 最初のIndexの位置
+    uint32_t indexCount; // Indexの数
+    uint32_t materialIndex; // ModelData::materialsの番号
+};
+
+/// <summary>
+/// 頂点64個、三角形124個までの三角形のかたまり。カリングの単位にする
+/// </summary>
+struct Meshlet {
+    uint32_t vertexOffset; // ModelData::meshletVerticesの開始位置
+    uint32_t triangleOffset; // ModelData::meshletTrianglesの開始位置。3つで1つの三角形
+    uint32_t vertexCount; // 頂点の数
+    uint32_t triangleCount; // 三角形の数
+    Vector3 center; // 全頂点を囲む球の中心
+    float radius; // 全頂点を囲む球の半径
+    Vector3 coneApex; // 法線の円錐の頂点
+    float coneCutoff; // 視線と円錐の軸の内積がこれ以上なら全三角形が裏向き。1なら裏向き判定をしない
+    Vector3 coneAxis; // 法線の円錐の軸
+    uint32_t materialIndex; // ModelData::materialsの番号
+};
+
+/// <summary>
+/// 詳細度(LOD)1段分の描画範囲。ModelData::subMeshesの連続した範囲を使う
+/// </summary>
+struct MeshLod {
+    uint32_t subMeshStart; // 最初のSubMeshの番号
+    uint32_t subMeshCount; // SubMeshの数
+    float error; // 元の形からの最大のずれ(モデル座標の長さ)。LOD0は0
+};
+
+struct ModelData {
+    std::vector<VertexData> vertices; // 重複のない頂点
+    std::vector<uint32_t> indices; // 三角形リストのIndex。マテリアルごとにまとまっている
+    std::vector<SubMesh> subMeshes; // マテリアルごとの描画範囲。LODごとにまとまり、その中はマテリアル番号順
+    AABB bounds; // 全頂点を囲む箱
+    Sphere boundingSphere; // 全頂点を囲む球
+    std::string materialLibrary; // mtllibで指定されたファイル名
+    std::vector<MaterialData> materials; // usemtlで初めて使われた順
+    VertexFormat vertexFormat = VertexFormat::Float; // GPUに送るときの頂点の形式
+    std::vector<MeshLod> lods; // 細かい順。lods[0]が読み込んだままの形
+    std::vector<Meshlet> meshlets; // LOD0のSubMeshの順に並んだメッシュレット
+    std::vector<uint32_t> meshletVertices; // メッシュレットの頂点からverticesへのIndex
+    std::vector<uint8_t> meshletTriangles; // メッシュレット内の頂点の番号。3つで1つの三角形
+};
+
+/// <summary>
+/// 頂点数が16bitのIndexで表せる範囲に収まっているか
+/// </summary>
+inline bool CanUse16BitIndices(size_t vertexCount) { return vertexCount <= 0x10000; }
+
+/// <summary>
+/// MTLファイルに定義されたマテリアルを定義順に読み込む
+/// </summary>
+std::vector<MaterialData> LoadMaterialTemplateFile(const std::string& directoryPath, const std::string& filename);
+
+/// <summary>
+/// 名前の並びに対応するマテリアルをMTLファイルから引く。見つからない名前はテクスチャなしのマテリアルになる
+/// </summary>
+std::vector<MaterialData> ResolveMaterials(const std::string& directoryPath, const std::string& materialLibrary, const std::vector<std::string>& materialNames);
+
+/// <summary>
+/// 頂点の位置を囲むAABBを求める
+/// </summary>
+AABB ComputeBounds(const std::vector<VertexData>& vertices);
+
+/// <summary>
+/// 頂点の位置を囲む球を求める。中心はboundsの中心で、半径は最も遠い頂点までの距離
+/// </summary>
+Sphere ComputeBoundingSphere(const std::vector<VertexData>& vertices, const AABB& bounds);
+
+/// <summary>
+/// 頂点を1つずつ見ながら囲む球を広げる。外にある点は、球の反対側の端とその点を直径とする球まで広げる
+/// 全頂点を2回なめられないときに使う。ComputeBoundingSphereより少し大きくなることがある
+/// </summary>
+inline void ExpandBoundingSphere(Sphere& sphere, const Vector3& point)
+{
+    Vector3 toPoint = { point.x - sphere.center.x, point.y - sphere.center.y, point.z - sphere.center.z };
+    float distanceSquared = toPoint.x * toPoint.x + toPoint.y * toPoint.y + toPoint.z * toPoint.z;
+    if (distanceSquared <= sphere.radius * sphere.radius) {
+        return;
+    }
+    float distance = std::sqrt(distanceSquared);
+    float newRadius = (sphere.radius + distance) * 0.5f;
+    float shift = (newRadius - sphere.radius) / distance;
+    sphere.center = { sphere.center.x + toPoint.x * shift, sphere.center.y + toPoint.y * shift, sphere.center.z + toPoint.z * shift };
+    sphere.radius = newRadius;
+}
+
+/// <summary>
+/// OBJファイルの並列読み込みで使うスレッド数の既定値(論理コア数)
+/// </summary>
+uint32_t GetDefaultObjLoadThreadCount();
+
+/// <summary>
+/// OBJファイルを読み込む
+/// ファイルをメモリにマップし、v/vt/vn/fをバイト列から直接解析する
+/// 同じ「位置/テクスチャ座標/法線」の組は1つの頂点にまとめ、面はIndexで表す
+/// usemtlで指定されたマテリアルごとに三角形をまとめ、SubMeshとして範囲を持つ。o/gによる分割は描画範囲に影響しない
+/// threadCountが2以上なら行境界で分割したチャンクを並列に解析し、最後にIndexを解決する。結果はスレッド数によらず同一
+/// </summary>
+ModelData LoadObjFile(const std::string& directoryPath, const std::string& filename, uint32_t threadCount = 1);
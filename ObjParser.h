@@ -0,0 +1,140 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MathTypes.h"
+
+// OBJの解析でLoadObjFileとストリーミング読み込み(ObjStreamingImport)が共有する型と関数
+
+/// <summary>
+/// 面の頂点が参照する「位置/テクスチャ座標/法線」のIndexの組(1始まり)
+/// </summary>
+struct ObjVertexKey {
+    int32_t position;
+    int32_t texcoord;
+    int32_t normal;
+};
+
+/// <summary>
+/// usemtlで切り替わったマテリアルと、それが適用される最初の面
+/// </summary>
+struct ObjMaterialRun {
+    size_t faceStart; // チャンク内の面の番号
+    std::string name; // マテリアル名
+};
+
+/// <summary>
+/// 行境界で区切ったファイルの一部を解析した結果
+/// 面のIndexはファイル全体での1始まりのIndexのまま保持し、統合時に解決する
+/// 最初のusemtlより前の面は、前のチャンクの最後のマテリアルを引き継ぐ
+/// </summary>
+struct ObjChunk {
+    std::vector<Vector4> positions; // 位置
+    std::vector<Vector3> normals; // 法線
+    std::vector<Vector2> texcoords; // テクスチャ座標
+    std::vector<ObjVertexKey> faceVertices; // 1面につき3つ。ファイルに書かれた順
+    std::vector<ObjMaterialRun> materialRuns; // usemtlが現れた順
+    std::string materialFilename; // このチャンク内で最後に現れたmtllib
+};
+
+/// <summary>
+/// ObjVertexKeyから重複のない頂点番号を引くためのオープンアドレス法のハッシュテーブル
+/// </summary>
+class VertexKeyTable {
+public:
+    explicit VertexKeyTable(size_t expectedCount)
+    {
+        size_t capacity = 16;
+        while (capacity < expectedCount * 2) {
+            capacity <<= 1;
+        }
+        Rehash(capacity);
+    }
+
+    /// <summary>
+    /// 登録されているkeyの数
+    /// </summary>
+    size_t GetCount() const { return count_; }
+
+    /// <summary>
+    /// 表が使っているバイト数
+    /// </summary>
+    size_t GetMemorySize() const { return keys_.capacity() * sizeof(ObjVertexKey) + values_.capacity() * sizeof(uint32_t); }
+
+    /// <summary>
+    /// 登録をすべて消す。確保済みの表はそのまま使う
+    /// </summary>
+    void Clear()
+    {
+        std::fill(values_.begin(), values_.end(), kEmpty);
+        count_ = 0;
+    }
+
+    /// <summary>
+    /// keyが登録済みならその番号を、未登録ならnewIndexを登録して返す
+    /// </summary>
+    uint32_t FindOrAdd(const ObjVertexKey& key, uint32_t newIndex)
+    {
+        // 使用率が半分を超えたら広げる
+        if ((count_ + 1) * 2 > values_.size()) {
+            Rehash(values_.size() * 2);
+        }
+        size_t slot = Hash(key) & mask_;
+        while (values_[slot] != kEmpty) {
+            const ObjVertexKey& stored = keys_[slot];
+            if (stored.position == key.position && stored.texcoord == key.texcoord && stored.normal == key.normal) {
+                return values_[slot];
+            }
+            slot = (slot + 1) & mask_;
+        }
+        keys_[slot] = key;
+        values_[slot] = newIndex;
+        ++count_;
+        return newIndex;
+    }
+
+private:
+    static constexpr uint32_t kEmpty = 0xFFFFFFFFu;
+
+    static size_t Hash(const ObjVertexKey& key)
+    {
+        uint64_t h = static_cast<uint32_t>(key.position) * 0x9E3779B97F4A7C15ull;
+        h ^= static_cast<uint32_t>(key.texcoord) * 0xC2B2AE3D27D4EB4Full;
+        h ^= static_cast<uint32_t>(key.normal) * 0x165667B19E3779F9ull;
+        h ^= h >> 29;
+        return static_cast<size_t>(h);
+    }
+
+    void Rehash(size_t capacity)
+    {
+        std::vector<ObjVertexKey> oldKeys = std::move(keys_);
+        std::vector<uint32_t> oldValues = std::move(values_);
+        keys_.assign(capacity, ObjVertexKey{});
+        values_.assign(capacity, kEmpty);
+        mask_ = capacity - 1;
+        for (size_t i = 0; i < oldValues.size(); ++i) {
+            if (oldValues[i] == kEmpty) {
+                continue;
+            }
+            size_t slot = Hash(oldKeys[i]) & mask_;
+            while (values_[slot] != kEmpty) {
+                slot = (slot + 1) & mask_;
+            }
+            keys_[slot] = oldKeys[i];
+            values_[slot] = oldValues[i];
+        }
+    }
+
+    std::vector<ObjVertexKey> keys_;
+    std::vector<uint32_t> values_;
+    size_t mask_ = 0;
+    size_t count_ = 0;
+};
+
+/// <summary>
+/// [begin, end)の範囲を解析する。beginは行頭でなければならない
+/// </summary>
+void ParseObjChunk(const char* begin, const char* end, ObjChunk& chunk);
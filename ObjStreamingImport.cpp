@@ -0,0 +1,585 @@
+#include "ObjStreamingImport.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "Hash.h"
+#include "MeshCache.h"
+#include "ObjParser.h"
+
+namespace {
+
+using namespace MeshCacheFormat;
+
+constexpr uint32_t kNoMaterial = 0xFFFFFFFFu;
+constexpr size_t kMinWindowSize = static_cast<size_t>(1) << 20;
+constexpr size_t kMaxWindowSize = static_cast<size_t>(64) << 20;
+constexpr size_t kIndexBlockSize = static_cast<size_t>(1) << 14; // マテリアルごとにためるIndexの数
+constexpr size_t kVertexBufferSize = static_cast<size_t>(1) << 15; // 出力前にためる頂点の数
+
+/// <summary>
+/// 読み書きできる一時ファイル。破棄するときに消す
+/// </summary>
+class TemporaryFile {
+public:
+    explicit TemporaryFile(const std::filesystem::path& path) : path_(path)
+    {
+        stream_.open(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    }
+
+    ~TemporaryFile()
+    {
+        stream_.close();
+        std::error_code error;
+        std::filesystem::remove(path_, error);
+    }
+
+    TemporaryFile(const TemporaryFile&) = delete;
+    TemporaryFile& operator=(const TemporaryFile&) = delete;
+
+    bool IsGood() const { return stream_.is_open() && !stream_.fail(); }
+
+    void Write(uint64_t offset, const void* data, size_t size)
+    {
+        stream_.seekp(static_cast<std::streamoff>(offset));
+        stream_.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    }
+
+    void Read(uint64_t offset, void* data, size_t size)
+    {
+        stream_.seekg(static_cast<std::streamoff>(offset));
+        stream_.read(static_cast<char*>(data), static_cast<std::streamsize>(size));
+    }
+
+private:
+    std::filesystem::path path_;
+    std::fstream stream_;
+};
+
+/// <summary>
+/// 末尾に足していくだけの配列。要素をページ単位で持ち、maxResidentBytesを超えるページは一時ファイルへ追い出す
+/// 追い出すのは埋まったページだけで、一度書いたページは変わらないので書き出しは1回で済む
+/// </summary>
+template<typename T>
+class SpillableArray {
+public:
+    SpillableArray(const std::filesystem::path& spillPath, size_t maxResidentBytes)
+        : file_(spillPath), maxResidentPages_((std::max)(maxResidentBytes / kPageBytes, static_cast<size_t>(2))) {}
+
+    void PushBack(const T& value)
+    {
+        size_t page = size_ >> kPageShift;
+        if ((size_ & kPageMask) == 0) {
+            pageSlots_.push_back(kNotResident);
+            pageSlots_[page] = AcquireSlot(page);
+        }
+        Slot& slot = slots_[pageSlots_[page]];
+        slot.elements[size_ & kPageMask] = value;
+        slot.lastUse = ++useCounter_;
+        ++size_;
+    }
+
+    /// <summary>
+    /// 要素を取り出す。追い出したページなら読み戻す
+    /// </summary>
+    const T& Get(size_t index)
+    {
+        size_t page = index >> kPageShift;
+        if (pageSlots_[page] == kNotResident) {
+            uint32_t slotIndex = AcquireSlot(page);
+            file_.Read(static_cast<uint64_t>(page) * kPageBytes, slots_[slotIndex].elements.data(), kPageBytes);
+            pageSlots_[page] = slotIndex;
+        }
+        Slot& slot = slots_[pageSlots_[page]];
+        slot.lastUse = ++useCounter_;
+        return slot.elements[index & kPageMask];
+    }
+
+    size_t GetSize() const { return size_; }
+    size_t GetResidentBytes() const { return slots_.size() * kPageBytes; }
+    uint64_t GetSpilledBytes() const { return spilledBytes_; }
+    bool IsGood() const { return file_.IsGood(); }
+
+private:
+    static constexpr size_t kPageShift = 14;
+    static constexpr size_t kPageSize = static_cast<size_t>(1) << kPageShift;
+    static constexpr size_t kPageMask = kPageSize - 1;
+    static constexpr size_t kPageBytes = kPageSize * sizeof(T);
+    static constexpr uint32_t kNotResident = 0xFFFFFFFFu;
+
+    struct Slot {
+        std::vector<T> elements;
+        size_t page;
+        uint64_t lastUse;
+    };
+
+    /// <summary>
+    /// pageを置く場所を用意する。上限に達していれば最も長く使っていないページを追い出す
+    /// </summary>
+    uint32_t AcquireSlot(size_t page)
+    {
+        if (slots_.size() < maxResidentPages_) {
+            slots_.push_back({ std::vector<T>(kPageSize), page, 0 });
+            return static_cast<uint32_t>(slots_.size() - 1);
+        }
+
+        // 書き込み中の末尾のページは追い出さない
+        size_t tailPage = (size_ - 1) >> kPageShift;
+        uint32_t victim = kNotResident;
+        for (uint32_t i = 0; i < slots_.size(); ++i) {
+            bool isTail = slots_[i].page == tailPage && (size_ & kPageMask) != 0;
+            if (!isTail && (victim == kNotResident || slots_[i].lastUse < slots_[victim].lastUse)) {
+                victim = i;
+            }
+        }
+        Slot& slot = slots_[victim];
+        if (slot.page >= pageWritten_.size()) {
+            pageWritten_.resize(slot.page + 1, 0);
+        }
+        if (!pageWritten_[slot.page]) {
+            file_.Write(static_cast<uint64_t>(slot.page) * kPageBytes, slot.elements.data(), kPageBytes);
+            pageWritten_[slot.page] = 1;
+            spilledBytes_ += kPageBytes;
+        }
+        pageSlots_[slot.page] = kNotResident;
+        slot.page = page;
+        return victim;
+    }
+
+    TemporaryFile file_;
+    size_t maxResidentPages_;
+    std::vector<Slot> slots_; //!< メモリに置いているページ
+    std::vector<uint32_t> pageSlots_; //!< ページごとのslots_の番号。追い出していればkNotResident
+    std::vector<uint8_t> pageWritten_; //!< ページを一時ファイルに書いたか
+    size_t size_ = 0;
+    uint64_t useCounter_ = 0;
+    uint64_t spilledBytes_ = 0;
+};
+
+/// <summary>
+/// 一時ファイルに書いたIndexのブロック
+/// </summary>
+struct IndexBlock {
+    uint32_t material;
+    uint32_t indexCount;
+    uint64_t offset; // 一時ファイルの中の位置
+};
+
+uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+/// <summary>
+/// 出力の末尾をkSectionAlignmentの境界まで0で埋める
+/// </summary>
+void PadToAlignment(std::ofstream& output)
+{
+    const char padding[kSectionAlignment] = {};
+    uint64_t position = static_cast<uint64_t>(output.tellp());
+    output.write(padding, static_cast<std::streamsize>(AlignUp(position, kSectionAlignment) - position));
+}
+
+/// <summary>
+/// 出力の末尾にセクションを書き、表に位置を記録する
+/// </summary>
+void WriteSection(std::ofstream& output, Section& section, SectionType type, uint32_t elementSize, const void* data, uint64_t size)
+{
+    PadToAlignment(output);
+    section = { type, elementSize, static_cast<uint64_t>(output.tellp()), size };
+    output.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+}
+
+/// <summary>
+/// 読み込み中の状態
+/// </summary>
+class ObjStreamingImporter {
+public:
+    ObjStreamingImporter(const std::filesystem::path& cachePath, const ObjStreamingImportSettings& settings)
+        : positions_(SpillPath(cachePath, ".positions.tmp"), settings.memoryBudget / 2 * sizeof(Vector4) / kAttributeBytes),
+          texcoords_(SpillPath(cachePath, ".texcoords.tmp"), settings.memoryBudget / 2 * sizeof(Vector2) / kAttributeBytes),
+          normals_(SpillPath(cachePath, ".normals.tmp"), settings.memoryBudget / 2 * sizeof(Vector3) / kAttributeBytes),
+          indexFile_(SpillPath(cachePath, ".indices.tmp")),
+          vertexTable_(1024),
+          maxVertexTableCount_((std::max)(settings.memoryBudget / 8 / kVertexTableBytesPerEntry, static_cast<size_t>(1024)))
+    {
+        vertexBuffer_.reserve(kVertexBufferSize);
+    }
+
+    bool IsGood() const { return positions_.IsGood() && texcoords_.IsGood() && normals_.IsGood() && indexFile_.IsGood(); }
+
+    /// <summary>
+    /// 窓1つ分の解析結果を取り込む。頂点はoutputへ書き出す
+    /// </summary>
+    bool Consume(const ObjChunk& chunk, std::ofstream& output)
+    {
+        for (const Vector4& position : chunk.positions) {
+            positions_.PushBack(position);
+        }
+        for (const Vector2& texcoord : chunk.texcoords) {
+            texcoords_.PushBack(texcoord);
+        }
+        for (const Vector3& normal : chunk.normals) {
+            normals_.PushBack(normal);
+        }
+        if (!chunk.materialFilename.empty()) {
+            materialLibrary_ = chunk.materialFilename;
+        }
+
+        size_t faceCount = chunk.faceVertices.size() / 3;
+        size_t runIndex = 0;
+        for (size_t face = 0; face <= faceCount; ++face) {
+            while (runIndex < chunk.materialRuns.size() && chunk.materialRuns[runIndex].faceStart == face) {
+                currentMaterial_ = FindOrAddMaterial(chunk.materialRuns[runIndex].name);
+                ++runIndex;
+            }
+            if (face == faceCount) {
+                break;
+            }
+            if (currentMaterial_ == kNoMaterial) {
+                currentMaterial_ = FindOrAddMaterial("");
+            }
+
+            // 覚えている頂点が上限に達したら忘れて、表の大きさを保つ
+            if (vertexTable_.GetCount() + 3 > maxVertexTableCount_) {
+                vertexTable_.Clear();
+            }
+            // 右手系から左手系にするので回り順を逆にする
+            for (size_t faceVertex = 3; faceVertex > 0; --faceVertex) {
+                const ObjVertexKey& key = chunk.faceVertices[face * 3 + faceVertex - 1];
+                if (!IsValidKey(key) || vertexCount_ >= 0xFFFFFFFFull) {
+                    return false;
+                }
+                uint32_t newIndex = static_cast<uint32_t>(vertexCount_);
+                uint32_t index = vertexTable_.FindOrAdd(key, newIndex);
+                if (index == newIndex) {
+                    AddVertex(key, output);
+                }
+                AddIndex(index);
+            }
+        }
+        return indexFile_.IsGood();
+    }
+
+    /// <summary>
+    /// ためている頂点を書き出す
+    /// </summary>
+    void FlushVertices(std::ofstream& output)
+    {
+        output.write(reinterpret_cast<const char*>(vertexBuffer_.data()), static_cast<std::streamsize>(sizeof(VertexData) * vertexBuffer_.size()));
+        vertexBuffer_.clear();
+    }
+
+    /// <summary>
+    /// Indexをマテリアル番号順にoutputへ書き出し、マテリアルごとの描画範囲を返す
+    /// </summary>
+    bool WriteIndices(std::ofstream& output, std::vector<SubMesh>& subMeshes)
+    {
+        for (uint32_t material = 0; material < materialBlocks_.size(); ++material) {
+            FlushIndexBlock(material);
+        }
+        if (indexCount_ > 0xFFFFFFFFull) {
+            return false;
+        }
+
+        // 同じマテリアルのブロックは書いた順のまま並べる
+        std::stable_sort(indexBlocks_.begin(), indexBlocks_.end(), [](const IndexBlock& a, const IndexBlock& b) { return a.material < b.material; });
+        std::vector<uint32_t> block(kIndexBlockSize);
+        uint32_t indexStart = 0;
+        for (const IndexBlock& indexBlock : indexBlocks_) {
+            if (subMeshes.empty() || subMeshes.back().materialIndex != indexBlock.material) {
+                subMeshes.push_back({ indexStart, 0, indexBlock.material });
+            }
+            indexFile_.Read(indexBlock.offset, block.data(), sizeof(uint32_t) * indexBlock.indexCount);
+            output.write(reinterpret_cast<const char*>(block.data()), static_cast<std::streamsize>(sizeof(uint32_t) * indexBlock.indexCount));
+            subMeshes.back().indexCount += indexBlock.indexCount;
+            indexStart += indexBlock.indexCount;
+        }
+        return indexFile_.IsGood();
+    }
+
+    /// <summary>
+    /// 今確保しているバッファの合計
+    /// </summary>
+    size_t GetBufferBytes() const
+    {
+        size_t bytes = positions_.GetResidentBytes() + texcoords_.GetResidentBytes() + normals_.GetResidentBytes();
+        bytes += vertexTable_.GetMemorySize();
+        bytes += vertexBuffer_.capacity() * sizeof(VertexData);
+        for (const std::vector<uint32_t>& materialBlock : materialBlocks_) {
+            bytes += materialBlock.capacity() * sizeof(uint32_t);
+        }
+        bytes += indexBlocks_.capacity() * sizeof(IndexBlock);
+        return bytes;
+    }
+
+    uint64_t GetVertexCount() const { return vertexCount_; }
+    uint64_t GetIndexCount() const { return indexCount_; }
+    uint64_t GetSpilledBytes() const { return positions_.GetSpilledBytes() + texcoords_.GetSpilledBytes() + normals_.GetSpilledBytes(); }
+    const AABB& GetBounds() const { return bounds_; }
+    const Sphere& GetBoundingSphere() const { return boundingSphere_; }
+    const std::string& GetMaterialLibrary() const { return materialLibrary_; }
+    const std::vector<std::string>& GetMaterialNames() const { return materialNames_; }
+
+private:
+    static constexpr size_t kAttributeBytes = sizeof(Vector4) + sizeof(Vector2) + sizeof(Vector3);
+    static constexpr size_t kVertexTableBytesPerEntry = (sizeof(ObjVertexKey) + sizeof(uint32_t)) * 4; // 使用率と2の累乗への切り上げの分
+
+    static std::filesystem::path SpillPath(const std::filesystem::path& cachePath, const char* suffix)
+    {
+        std::filesystem::path path = cachePath;
+        path += suffix;
+        return path;
+    }
+
+    bool IsValidKey(const ObjVertexKey& key) const
+    {
+        return key.position > 0 && static_cast<size_t>(key.position) <= positions_.GetSize() &&
+            key.texcoord > 0 && static_cast<size_t>(key.texcoord) <= texcoords_.GetSize() &&
+            key.normal > 0 && static_cast<size_t>(key.normal) <= normals_.GetSize();
+    }
+
+    uint32_t FindOrAddMaterial(const std::string& name)
+    {
+        auto it = std::find(materialNames_.begin(), materialNames_.end(), name);
+        if (it != materialNames_.end()) {
+            return static_cast<uint32_t>(it - materialNames_.begin());
+        }
+        materialNames_.push_back(name);
+        materialBlocks_.emplace_back();
+        return static_cast<uint32_t>(materialNames_.size() - 1);
+    }
+
+    void AddVertex(const ObjVertexKey& key, std::ofstream& output)
+    {
+        VertexData vertex{ positions_.Get(key.position - 1), texcoords_.Get(key.texcoord - 1), normals_.Get(key.normal - 1) };
+        if (vertexCount_ == 0) {
+            bounds_ = { { vertex.position.x, vertex.position.y, vertex.position.z }, { vertex.position.x, vertex.position.y, vertex.position.z } };
+            boundingSphere_ = { { vertex.position.x, vertex.position.y, vertex.position.z }, 0.0f };
+        }
+        bounds_.min.x = (std::min)(bounds_.min.x, vertex.position.x);
+        bounds_.min.y = (std::min)(bounds_.min.y, vertex.position.y);
+        bounds_.min.z = (std::min)(bounds_.min.z, vertex.position.z);
+        bounds_.max.x = (std::max)(bounds_.max.x, vertex.position.x);
+        bounds_.max.y = (std::max)(bounds_.max.y, vertex.position.y);
+        bounds_.max.z = (std::max)(bounds_.max.z, vertex.position.z);
+        ExpandBoundingSphere(boundingSphere_, { vertex.position.x, vertex.position.y, vertex.position.z });
+
+        vertexBuffer_.push_back(vertex);
+        if (vertexBuffer_.size() == kVertexBufferSize) {
+            FlushVertices(output);
+        }
+        ++vertexCount_;
+    }
+
+    void AddIndex(uint32_t index)
+    {
+        std::vector<uint32_t>& materialBlock = materialBlocks_[currentMaterial_];
+        if (materialBlock.capacity() < kIndexBlockSize) {
+            materialBlock.reserve(kIndexBlockSize);
+        }
+        materialBlock.push_back(index);
+        if (materialBlock.size() == kIndexBlockSize) {
+            FlushIndexBlock(currentMaterial_);
+        }
+        ++indexCount_;
+    }
+
+    void FlushIndexBlock(uint32_t material)
+    {
+        std::vector<uint32_t>& materialBlock = materialBlocks_[material];
+        if (materialBlock.empty()) {
+            return;
+        }
+        indexFile_.Write(indexFileSize_, materialBlock.data(), sizeof(uint32_t) * materialBlock.size());
+        indexBlocks_.push_back({ material, static_cast<uint32_t>(materialBlock.size()), indexFileSize_ });
+        indexFileSize_ += sizeof(uint32_t) * materialBlock.size();
+        materialBlock.clear();
+    }
+
+    SpillableArray<Vector4> positions_;
+    SpillableArray<Vector2> texcoords_;
+    SpillableArray<Vector3> normals_;
+    TemporaryFile indexFile_; //!< マテリアルごとのIndexのブロックを書いた順に並べたもの
+    std::vector<IndexBlock> indexBlocks_;
+    uint64_t indexFileSize_ = 0;
+    std::vector<std::vector<uint32_t>> materialBlocks_; //!< マテリアルごとの書き出し前のIndex
+    VertexKeyTable vertexTable_;
+    size_t maxVertexTableCount_;
+    std::vector<VertexData> vertexBuffer_; //!< 書き出し前の頂点
+    uint64_t vertexCount_ = 0;
+    uint64_t indexCount_ = 0;
+    AABB bounds_{};
+    Sphere boundingSphere_{};
+    std::string materialLibrary_; //!< 最後に現れたmtllib
+    std::vector<std::string> materialNames_; //!< usemtlで初めて使われた順
+    uint32_t currentMaterial_ = kNoMaterial;
+};
+
+} // namespace
+
+bool ImportObjFileStreaming(const std::string& directoryPath, const std::string& filename, const ObjStreamingImportSettings& settings, ObjStreamingImportReport* report)
+{
+    std::filesystem::path sourcePath = directoryPath + "/" + filename;
+    std::filesystem::path cachePath = sourcePath;
+    cachePath += ".cmesh";
+    std::filesystem::path temporaryPath = cachePath;
+    temporaryPath += ".tmp";
+
+    std::ifstream input(sourcePath, std::ios::binary);
+    if (!input.is_open()) {
+        return false;
+    }
+
+    size_t peakBufferBytes = 0;
+    ObjStreamingImporter importer(cachePath, settings);
+    Header header{};
+    Section sections[6]{};
+    constexpr uint32_t kSectionCount = static_cast<uint32_t>(sizeof(sections) / sizeof(sections[0]));
+    {
+        std::ofstream output(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!output.is_open() || !importer.IsGood()) {
+            return false;
+        }
+        // ヘッダーとセクション表は最後に書くので場所だけ空けておき、頂点は解析しながら直接書き出す
+        const char padding[kSectionAlignment] = {};
+        uint64_t tableEnd = AlignUp(sizeof(Header) + sizeof(Section) * kSectionCount, kSectionAlignment);
+        for (uint64_t written = 0; written < tableEnd; written += kSectionAlignment) {
+            output.write(padding, kSectionAlignment);
+        }
+
+        // 窓ごとに読み、最後の改行までを解析する。残りは次の窓の先頭へ回す
+        size_t windowSize = std::clamp(settings.memoryBudget / 16, kMinWindowSize, kMaxWindowSize);
+        std::vector<char> window(windowSize);
+        size_t carry = 0;
+        StreamingHash sourceHash;
+        ObjChunk chunk;
+        while (true) {
+            input.read(window.data() + carry, static_cast<std::streamsize>(window.size() - carry));
+            size_t readSize = static_cast<size_t>(input.gcount());
+            sourceHash.Update(window.data() + carry, readSize);
+            size_t filled = carry + readSize;
+            bool isLast = filled < window.size();
+            const char* begin = window.data();
+            const char* end = begin + filled;
+            const char* parseEnd = end;
+            if (!isLast) {
+                const char* lastNewLine = end;
+                while (lastNewLine > begin && lastNewLine[-1] != '\n') {
+                    --lastNewLine;
+                }
+                if (lastNewLine == begin) {
+                    // 窓より長い行は窓を広げて読み直す
+                    carry = filled;
+                    window.resize(window.size() * 2);
+                    continue;
+                }
+                parseEnd = lastNewLine;
+            }
+
+            chunk.positions.clear();
+            chunk.normals.clear();
+            chunk.texcoords.clear();
+            chunk.faceVertices.clear();
+            chunk.materialRuns.clear();
+            chunk.materialFilename.clear();
+            ParseObjChunk(begin, parseEnd, chunk);
+            if (!importer.Consume(chunk, output)) {
+                return false;
+            }
+
+            size_t chunkBytes = chunk.positions.capacity() * sizeof(Vector4) + chunk.normals.capacity() * sizeof(Vector3) +
+                chunk.texcoords.capacity() * sizeof(Vector2) + chunk.faceVertices.capacity() * sizeof(ObjVertexKey);
+            peakBufferBytes = (std::max)(peakBufferBytes, importer.GetBufferBytes() + window.capacity() + chunkBytes);
+
+            carry = static_cast<size_t>(end - parseEnd);
+            std::memmove(window.data(), parseEnd, carry);
+            if (isLast) {
+                break;
+            }
+        }
+        importer.FlushVertices(output);
+        sections[0] = { SectionType::Vertices, sizeof(VertexData), tableEnd, sizeof(VertexData) * importer.GetVertexCount() };
+
+        // Indexはマテリアル番号順につなぐ
+        PadToAlignment(output);
+        uint64_t indexOffset = static_cast<uint64_t>(output.tellp());
+        std::vector<SubMesh> subMeshes;
+        if (!importer.WriteIndices(output, subMeshes)) {
+            return false;
+        }
+        sections[1] = { SectionType::Indices, sizeof(uint32_t), indexOffset, sizeof(uint32_t) * importer.GetIndexCount() };
+
+        std::string materialNames;
+        for (const std::string& name : importer.GetMaterialNames()) {
+            materialNames += name;
+            materialNames += '\0';
+        }
+        MeshLod lod{ 0, static_cast<uint32_t>(subMeshes.size()), 0.0f };
+        WriteSection(output, sections[2], SectionType::SubMeshes, sizeof(SubMesh), subMeshes.data(), sizeof(SubMesh) * subMeshes.size());
+        WriteSection(output, sections[3], SectionType::MaterialLibrary, 1, importer.GetMaterialLibrary().data(), importer.GetMaterialLibrary().size());
+        WriteSection(output, sections[4], SectionType::MaterialNames, 1, materialNames.data(), materialNames.size());
+        WriteSection(output, sections[5], SectionType::Lods, sizeof(MeshLod), &lod, sizeof(lod));
+
+        header.magic = kMagic;
+        header.version = kVersion;
+        header.sourceHash = sourceHash.Finish();
+        header.bounds = importer.GetBounds();
+        header.boundingSphere = importer.GetBoundingSphere();
+        header.sectionCount = kSectionCount;
+        header.vertexFormat = VertexFormat::Float;
+        output.seekp(0);
+        output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        output.write(reinterpret_cast<const char*>(sections), sizeof(sections));
+        if (!output) {
+            return false;
+        }
+    }
+
+    // 書き終わってから差し替える
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, cachePath, error);
+    if (error) {
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+
+    if (report) {
+        report->fileSize = static_cast<uint64_t>(std::filesystem::file_size(sourcePath, error));
+        report->vertexCount = importer.GetVertexCount();
+        report->indexCount = importer.GetIndexCount();
+        report->spilledBytes = importer.GetSpilledBytes();
+        report->peakBufferBytes = peakBufferBytes;
+        report->peakProcessMemory = GetPeakProcessMemory();
+    }
+    return true;
+}
+
+size_t GetPeakProcessMemory()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    counters.cb = sizeof(counters);
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return counters.PeakWorkingSetSize;
+#else
+    // LinuxのRUSAGE_SELFの最大常駐サイズはKB単位
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// <summary>
+/// ImportObjFileStreamingの設定
+/// </summary>
+struct ObjStreamingImportSettings {
+    size_t memoryBudget = static_cast<size_t>(256) << 20; // 読み込み中に確保してよいバッファの合計
+};
+
+/// <summary>
+/// ImportObjFileStreamingの結果
+/// </summary>
+struct ObjStreamingImportReport {
+    uint64_t fileSize; // OBJファイルのバイト数
+    uint64_t vertexCount; // 書き出した頂点の数
+    uint64_t indexCount; // 書き出したIndexの数
+    uint64_t spilledBytes; // 属性を一時ファイルへ追い出したバイト数
+    size_t peakBufferBytes; // 読み込み中に確保していたバッファの合計の最大
+    size_t peakProcessMemory; // 読み込み後に調べた、プロセスの物理メモリ使用量の最大
+};
+
+/// <summary>
+/// OBJファイルを窓ごとに読みながら、調理済みメッシュキャッシュ(.cmesh)を少しずつ書き出す
+/// メモリに収まらない大きさのファイル向けで、LoadObjFileと違いファイル全体の属性や頂点をメモリに持たない
+/// ・位置/テクスチャ座標/法線はページ単位で持ち、memoryBudgetの割り当てを超えたページは一時ファイルへ追い出して、使うときに読み戻す
+/// ・重複をまとめるために覚えておく頂点の数はmemoryBudgetで決まり、超えたら忘れる。離れた面が同じ組を使うと頂点が重複することがある
+/// ・頂点は出力ファイルへ直接、Indexはマテリアルごとのブロックにして一時ファイルへ書き、最後にマテリアル番号順につなぐ
+/// ・面は既に読んだ属性しか参照できない(後ろで定義される属性を参照するとfalse)
+/// ・描画順の最適化、LOD、メッシュレットは作らない
+/// 書き出したキャッシュはLoadModelがそのまま使う。失敗したらfalse
+/// </summary>
+bool ImportObjFileStreaming(const std::string& directoryPath, const std::string& filename, const ObjStreamingImportSettings& settings = {}, ObjStreamingImportReport* report = nullptr);
+
+/// <summary>
+/// プロセスがこれまでに使った物理メモリの最大(バイト)。取得できなければ0
+/// </summary>
+size_t GetPeakProcessMemory();
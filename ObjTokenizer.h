@@ -0,0 +1,158 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <charconv>
+#include <system_error>
+
+/// <summary>
+/// マップしたOBJのバイト列を直接読むための字句解析関数群
+/// istringstreamを使わず、ポインタを進めながら数値を取り出す
+/// </summary>
+namespace ObjTokenizer {
+
+inline bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+inline bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+/// <summary>
+/// 空白(改行は含まない)を読み飛ばす
+/// </summary>
+inline const char* SkipSpaces(const char* p, const char* end)
+{
+    while (p < end && IsSpace(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+/// <summary>
+/// 次の空白か改行までを読み飛ばす
+/// </summary>
+inline const char* SkipToken(const char* p, const char* end)
+{
+    while (p < end && !IsSpace(*p) && *p != '\n') {
+        ++p;
+    }
+    return p;
+}
+
+/// <summary>
+/// 行末まで読み飛ばし、次の行の先頭を返す
+/// </summary>
+inline const char* SkipLine(const char* p, const char* end)
+{
+    const void* newLine = std::memchr(p, '\n', static_cast<size_t>(end - p));
+    return newLine ? static_cast<const char*>(newLine) + 1 : end;
+}
+
+/// <summary>
+/// 整数を読む。stoiと同様に先頭の空白と符号を許容する
+/// int32_tに収まらない値は桁を最後まで読み飛ばし、INT32_MAXかINT32_MINに丸める
+/// 壊れたOBJの桁の多いIndexは、丸めた値が範囲外のIndexとして弾かれる
+/// </summary>
+inline const char* ParseInt(const char* p, const char* end, int32_t& value)
+{
+    // 負の側はINT32_MINの絶対値まで表せる
+    constexpr int64_t kMagnitudeLimit = static_cast<int64_t>(INT32_MAX) + 1;
+
+    p = SkipSpaces(p, end);
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        ++p;
+    }
+    int64_t result = 0;
+    while (p < end && IsDigit(*p)) {
+        if (result < kMagnitudeLimit) {
+            result = (std::min)(result * 10 + (*p - '0'), kMagnitudeLimit);
+        }
+        ++p;
+    }
+    value = static_cast<int32_t>(negative ? -result : (std::min)(result, static_cast<int64_t>(INT32_MAX)));
+    return p;
+}
+
+/// <summary>
+/// 浮動小数点数を読む
+/// 仮数が2^24以下かつ指数が±10以内であればfloatの1回の乗除算で正しく丸められる(Clingerの高速パス)
+/// それ以外はstd::from_charsに任せるので、結果は常に最近接丸めになる
+/// </summary>
+inline const char* ParseFloat(const char* p, const char* end, float& value)
+{
+    // floatで正確に表せる10の累乗
+    static constexpr float kPow10[] = {
+        1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f,
+    };
+    // これを超えたら桁を捨てる。10倍して足してもuint64_tで溢れない
+    constexpr uint64_t kMantissaLimit = 1000000000000000000ull;
+
+    p = SkipSpaces(p, end);
+    const char* start = p;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        ++p;
+        // from_charsは'+'を受け付けないので、フォールバック時は符号の後ろから読ませる
+        if (!negative) {
+            start = p;
+        }
+    }
+
+    uint64_t mantissa = 0;
+    int32_t exponent = 0;
+    bool truncated = false;
+    bool hasDigits = false;
+    while (p < end && IsDigit(*p)) {
+        if (mantissa < kMantissaLimit) {
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+        } else {
+            ++exponent;
+            truncated = true;
+        }
+        hasDigits = true;
+        ++p;
+    }
+    if (p < end && *p == '.') {
+        ++p;
+        while (p < end && IsDigit(*p)) {
+            if (mantissa < kMantissaLimit) {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                --exponent;
+            } else if (*p != '0') {
+                truncated = true;
+            }
+            hasDigits = true;
+            ++p;
+        }
+    }
+    if (hasDigits && p < end && (*p == 'e' || *p == 'E')) {
+        const char* exponentStart = p + 1;
+        int32_t exponentValue = 0;
+        const char* q = exponentStart;
+        if (q < end && (*q == '-' || *q == '+')) {
+            ++q;
+        }
+        if (q < end && IsDigit(*q)) {
+            p = ParseInt(exponentStart, end, exponentValue);
+            exponent += exponentValue;
+        }
+    }
+
+    if (hasDigits && !truncated && mantissa <= (1u << 24) && exponent >= -10 && exponent <= 10) {
+        float result = static_cast<float>(mantissa);
+        result = exponent < 0 ? result / kPow10[-exponent] : result * kPow10[exponent];
+        value = negative ? -result : result;
+        return p;
+    }
+
+    // 高速パスに乗らない値(桁数が多い、inf/nanなど)は標準ライブラリで正確に読む
+    std::from_chars_result parsed = std::from_chars(start, end, value);
+    if (parsed.ec != std::errc()) {
+        value = 0.0f;
+        return SkipToken(p, end);
+    }
+    return parsed.ptr;
+}
+
+} // namespace ObjTokenizer
@@ -1,8 +1,12 @@
 #include "Object3d.hlsli"
 
+// 機能ごとに-Dで特殊化する(ShaderPermutation.hを参照)
+// ENABLE_LIGHTING : DirectionalLightで照らす
+// HALF_LAMBERT : ENABLE_LIGHTINGのとき、lambertの代わりにhalf lambertを使う
+// UV_TRANSFORM : テクスチャ座標をgMaterial.uvTransformで変換する
+
 struct Material {
     float32_t4 color;
-    int32_t enableLighting;
     float32_t4x4 uvTransform;
 };
 
@@ -24,20 +28,25 @@ struct PixelShaderOutput {
 PixelShaderOutput main(VertexShaderOutput input) {
     PixelShaderOutput output;
 
-    float4 transformedUV = mul(float32_t4(input.texcoord, 0.0f, 1.0f), gMaterial.uvTransform);
-
-    float32_t4 textureColor = gTexture.Sample(gSampler, transformedUV.xy);
-    if (gMaterial.enableLighting != 0) {
-        // lambert
-        //float cos = saturate(dot(normalize(input.normal), -gDirectionalLight.direction));
-
-        // half lambert
-        float NdotL = dot(normalize(input.normal), -gDirectionalLight.direction);
-        float cos = pow(NdotL * 0.5f + 0.5f, 2.0f);
-
-        output.color = gMaterial.color * textureColor * gDirectionalLight.color * cos * gDirectionalLight.intensity;
-    } else {
-        output.color = gMaterial.color * textureColor;
-    }
+#ifdef UV_TRANSFORM
+    float32_t2 texcoord = mul(float32_t4(input.texcoord, 0.0f, 1.0f), gMaterial.uvTransform).xy;
+#else
+    float32_t2 texcoord = input.texcoord;
+#endif
+
+    float32_t4 textureColor = gTexture.Sample(gSampler, texcoord);
+#ifdef ENABLE_LIGHTING
+    float NdotL = dot(normalize(input.normal), -gDirectionalLight.direction);
+#ifdef HALF_LAMBERT
+    // half lambert
+    float cos = pow(NdotL * 0.5f + 0.5f, 2.0f);
+#else
+    // lambert
+    float cos = saturate(NdotL);
+#endif
+    output.color = gMaterial.color * textureColor * gDirectionalLight.color * cos * gDirectionalLight.intensity;
+#else
+    output.color = gMaterial.color * textureColor;
+#endif
     return output;
 }
@@ -5,19 +5,63 @@ struct TransformationMatrix {
     float32_t4x4 World;
 };
 
-ConstantBuffer<TransformationMatrix> gTransformationMatrix : register(b0);
+// インスタンスごとのTransformationMatrix。1つだけの描画では要素1個
+StructuredBuffer<TransformationMatrix> gTransformationMatrices : register(t0);
+
+// PACKED_VERTEX : テクスチャ座標はhalf、法線は八面体に展開したsnorm16
+// QUANTIZED_POSITION : 位置はメッシュの範囲で量子化したunorm16
+#ifdef QUANTIZED_POSITION
+struct VertexDecode {
+    float32_t4 positionOffset;
+    float32_t4 positionScale;
+};
+
+ConstantBuffer<VertexDecode> gVertexDecode : register(b1);
+#endif
 
 struct VertexShaderInput {
+#if defined(QUANTIZED_POSITION)
+    float32_t4 position : POSITION0;
+#elif defined(PACKED_VERTEX)
+    float32_t3 position : POSITION0;
+#else
     float32_t4 position : POSITION0;
+#endif
     float32_t2 texcoord : TEXCOORD0;
+#ifdef PACKED_VERTEX
+    float32_t2 normal : NORMAL0;
+#else
     float32_t3 normal : NORMAL0;
+#endif
 };
 
-VertexShaderOutput main(VertexShaderInput input) {
+#ifdef PACKED_VERTEX
+float32_t3 DecodeOctahedral(float32_t2 encoded) {
+    float32_t3 normal = float32_t3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+    float32_t fold = saturate(-normal.z);
+    normal.x += normal.x >= 0.0f ? -fold : fold;
+    normal.y += normal.y >= 0.0f ? -fold : fold;
+    return normalize(normal);
+}
+#endif
+
+VertexShaderOutput main(VertexShaderInput input, uint32_t instanceId : SV_InstanceID) {
     VertexShaderOutput output;
-    output.position = mul(input.position, gTransformationMatrix.WVP);
+    TransformationMatrix transformationMatrix = gTransformationMatrices[instanceId];
+#if defined(QUANTIZED_POSITION)
+    float32_t4 position = float32_t4(gVertexDecode.positionOffset.xyz + input.position.xyz * gVertexDecode.positionScale.xyz, 1.0f);
+#elif defined(PACKED_VERTEX)
+    float32_t4 position = float32_t4(input.position, 1.0f);
+#else
+    float32_t4 position = input.position;
+#endif
+#ifdef PACKED_VERTEX
+    float32_t3 normal = DecodeOctahedral(input.normal);
+#else
+    float32_t3 normal = input.normal;
+#endif
+    output.position = mul(position, transformationMatrix.WVP);
     output.texcoord = input.texcoord;
-    output.normal = normalize(mul(input.normal, (float32_t3x3)gTransformationMatrix.World));
+    output.normal = normalize(mul(normal, (float32_t3x3)transformationMatrix.World));
     return output;
 }
-
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// [0, count)の各indexについて別々のスレッドでfunc(index)を呼ぶ。threadCountが1以下なら呼び出し元で順に実行する
+/// </summary>
+template<typename Func>
+void ParallelFor(size_t count, uint32_t threadCount, const Func& func)
+{
+    if (threadCount <= 1 || count <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            func(i);
+        }
+        return;
+    }
+    std::vector<std::jthread> threads;
+    threads.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        threads.emplace_back([&func, i]() { func(i); });
+    }
+}
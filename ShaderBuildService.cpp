@@ -0,0 +1,69 @@
+#include "ShaderBuildService.h"
+
+#include <algorithm>
+#include <cassert>
+
+void ShaderBuildService::Start(uint32_t threadCount, const std::function<ShaderCompileFunction()>& createCompiler)
+{
+    assert(threadCount >= 1 && workers_.empty());
+    workers_.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; ++i) {
+        // createCompilerは各スレッドが最初に呼ぶだけなので、Startが返るまでにコピーを渡しておく
+        workers_.emplace_back([this, createCompiler](std::stop_token stopToken) { WorkerMain(stopToken, createCompiler); });
+    }
+}
+
+std::shared_future<ShaderBinary> ShaderBuildService::Submit(const ShaderRequest& request)
+{
+    assert(!workers_.empty());
+    std::shared_future<ShaderBinary> result;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [submittedRequest, submittedResult] : submitted_) {
+            if (submittedRequest == request) {
+                return submittedResult;
+            }
+        }
+        Job& job = jobs_.emplace_back();
+        job.request = request;
+        result = job.promise.get_future().share();
+        submitted_.emplace_back(request, result);
+    }
+    jobAdded_.notify_one();
+    return result;
+}
+
+void ShaderBuildService::Invalidate(const std::vector<std::filesystem::path>& filePaths)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::erase_if(submitted_, [&filePaths](const std::pair<ShaderRequest, std::shared_future<ShaderBinary>>& submitted) {
+        std::filesystem::path filePath = std::filesystem::path(submitted.first.filePath).lexically_normal();
+        return std::find(filePaths.begin(), filePaths.end(), filePath) != filePaths.end();
+    });
+}
+
+void ShaderBuildService::Stop()
+{
+    // jthreadは破棄するときに止める要求を出して合流する。スレッドは残りの要求を終えてから抜ける
+    workers_.clear();
+    submitted_.clear();
+}
+
+void ShaderBuildService::WorkerMain(std::stop_token stopToken, const std::function<ShaderCompileFunction()>& createCompiler)
+{
+    ShaderCompileFunction compile = createCompiler();
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            // 止める要求が出ても、積まれている間は取り出して続ける
+            jobAdded_.wait(lock, stopToken, [this]() { return !jobs_.empty(); });
+            if (jobs_.empty()) {
+                return;
+            }
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        job.promise.set_value(compile(job.request));
+    }
+}
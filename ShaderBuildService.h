@@ -0,0 +1,88 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/// <summary>
+/// コンパイルするシェーダー1つ分の指定
+/// </summary>
+struct ShaderRequest {
+    std::wstring filePath;
+    std::wstring profile;
+    std::vector<std::wstring> defines; // 並びも区別する
+    bool optimize; // MakeShaderArgumentsのoptimize
+
+    bool operator==(const ShaderRequest&) const = default;
+};
+
+/// <summary>
+/// コンパイル結果
+/// </summary>
+struct ShaderBinary {
+    std::vector<uint8_t> dxil; // 失敗したら空
+    std::vector<std::filesystem::path> includes; // includeしたファイル。ソースが変わったときにコンパイルし直すものを調べるのに使う
+};
+
+using ShaderCompileFunction = std::function<ShaderBinary(const ShaderRequest&)>;
+
+/// <summary>
+/// シェーダーのコンパイルを複数のスレッドで並行して行う
+/// 要求は積んだ順に空いたスレッドが取り出し、結果はfutureで受け取る。使う側は必要なものだけを待てばよい
+/// </summary>
+class ShaderBuildService {
+public:
+    ShaderBuildService() = default;
+    ~ShaderBuildService() { Stop(); }
+
+    ShaderBuildService(const ShaderBuildService&) = delete;
+    ShaderBuildService& operator=(const ShaderBuildService&) = delete;
+
+    /// <summary>
+    /// threadCount本(1以上)のスレッドを立てる。各スレッドは最初にcreateCompilerを自分のスレッドで1回呼び、
+    /// 返った関数でコンパイルする。DXCのインスタンスはスレッドをまたいで使わないので、スレッドごとに作らせる
+    /// </summary>
+    void Start(uint32_t threadCount, const std::function<ShaderCompileFunction()>& createCompiler);
+
+    /// <summary>
+    /// 要求を積み、結果のfutureを返す。同じ要求を前に積んでいれば、コンパイルし直さずに同じfutureを返す
+    /// </summary>
+    std::shared_future<ShaderBinary> Submit(const ShaderRequest& request);
+
+    /// <summary>
+    /// filePathsのソースを使う要求の結果を忘れ、次に同じ要求を積んだときにコンパイルし直すようにする
+    /// 忘れる前に返したfutureはそのまま使える
+    /// </summary>
+    void Invalidate(const std::vector<std::filesystem::path>& filePaths);
+
+    /// <summary>
+    /// 積んだ要求を全て終えてからスレッドを止める。Startし直すまでSubmitしないこと
+    /// </summary>
+    void Stop();
+
+    uint32_t GetThreadCount() const { return static_cast<uint32_t>(workers_.size()); }
+
+private:
+    /// <summary>
+    /// コンパイル待ちの要求
+    /// </summary>
+    struct Job {
+        ShaderRequest request;
+        std::promise<ShaderBinary> promise;
+    };
+
+    void WorkerMain(std::stop_token stopToken, const std::function<ShaderCompileFunction()>& createCompiler);
+
+    std::mutex mutex_; //!< jobs_とsubmitted_を守る
+    std::condition_variable_any jobAdded_; //!< jobs_に積んだことをスレッドに知らせる
+    std::deque<Job> jobs_; //!< コンパイル待ち。古い順
+    std::vector<std::pair<ShaderRequest, std::shared_future<ShaderBinary>>> submitted_; //!< 積んだ要求と結果
+    std::vector<std::jthread> workers_; //!< 止めるときは止める要求を出してから合流する
+};
@@ -0,0 +1,236 @@
+#include "ShaderCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include "Hash.h"
+
+namespace {
+
+using namespace ShaderCacheFormat;
+
+bool ReadFileBytes(const std::filesystem::path& filePath, std::string& contents)
+{
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !file.bad();
+}
+
+/// <summary>
+/// 1行が#include "name"ならnameを返す。<name>の形はシステム側のファイルとして扱わない
+/// </summary>
+bool ParseIncludeLine(const char* begin, const char* end, std::string& name)
+{
+    const char* p = begin;
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        ++p;
+    }
+    if (p == end || *p != '#') {
+        return false;
+    }
+    ++p;
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        ++p;
+    }
+    constexpr char kInclude[] = "include";
+    constexpr size_t kIncludeLength = sizeof(kInclude) - 1;
+    if (static_cast<size_t>(end - p) < kIncludeLength || std::memcmp(p, kInclude, kIncludeLength) != 0) {
+        return false;
+    }
+    p += kIncludeLength;
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        ++p;
+    }
+    if (p == end || *p != '"') {
+        return false;
+    }
+    const char* nameBegin = ++p;
+    while (p < end && *p != '"') {
+        ++p;
+    }
+    if (p == end) {
+        return false;
+    }
+    name.assign(nameBegin, p);
+    return true;
+}
+
+void CollectIncludesRecursive(const std::filesystem::path& filePath, std::vector<std::filesystem::path>& includes)
+{
+    std::string contents;
+    if (!ReadFileBytes(filePath, contents)) {
+        return;
+    }
+    const char* p = contents.data();
+    const char* end = p + contents.size();
+    while (p < end) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        if (lineEnd == nullptr) {
+            lineEnd = end;
+        }
+        std::string name;
+        if (ParseIncludeLine(p, lineEnd, name)) {
+            std::filesystem::path includePath = (filePath.parent_path() / name).lexically_normal();
+            bool visited = false;
+            for (const std::filesystem::path& include : includes) {
+                visited |= include == includePath;
+            }
+            if (!visited) {
+                includes.push_back(includePath);
+                CollectIncludesRecursive(includePath, includes);
+            }
+        }
+        p = lineEnd + 1;
+    }
+}
+
+/// <summary>
+/// 文字列を文字ごとに32bitにしてハッシュに加える。wchar_tの大きさが違う環境でも同じキーになる
+/// </summary>
+void HashWideString(StreamingHash& hash, const std::wstring& text)
+{
+    uint32_t length = static_cast<uint32_t>(text.size());
+    hash.Update(&length, sizeof(length));
+    for (wchar_t c : text) {
+        uint32_t code = static_cast<uint32_t>(c);
+        hash.Update(&code, sizeof(code));
+    }
+}
+
+} // namespace
+
+std::vector<std::wstring> MakeShaderArguments(const std::wstring& filePath, const std::wstring& profile, const std::vector<std::wstring>& defines, bool optimize)
+{
+    std::vector<std::wstring> arguments = {
+        filePath, // コンパイル対象のhlslファイル名
+        L"-E", L"main", // エントリーポイントの指定。基本的にmain以外にはしない
+        L"-T", profile, // ShaderProfileの設定
+    };
+    if (optimize) {
+        arguments.insert(arguments.end(), {
+            L"-O3", // 最適化する
+            L"-Qstrip_debug", // デバッグ用の情報を外す
+        });
+    } else {
+        arguments.insert(arguments.end(), {
+            L"-Zi", L"-Qembed_debug", // デバッグ用の情報を埋め込む
+            L"-Od", // 最適化を外しておく
+        });
+    }
+    arguments.push_back(L"-Zpr"); // メモリレイアウトは行優先
+    // マクロを定義する
+    for (const std::wstring& define : defines) {
+        arguments.push_back(L"-D");
+        arguments.push_back(define);
+    }
+    return arguments;
+}
+
+std::vector<std::filesystem::path> CollectShaderIncludes(const std::filesystem::path& filePath)
+{
+    std::vector<std::filesystem::path> includes;
+    CollectIncludesRecursive(filePath, includes);
+    return includes;
+}
+
+uint64_t ComputeShaderCacheKey(const std::filesystem::path& filePath, const std::vector<std::wstring>& arguments, const std::string& compilerVersion)
+{
+    std::string source;
+    if (!ReadFileBytes(filePath, source)) {
+        return 0;
+    }
+    StreamingHash hash;
+    hash.Update(&kVersion, sizeof(kVersion));
+    uint32_t argumentCount = static_cast<uint32_t>(arguments.size());
+    hash.Update(&argumentCount, sizeof(argumentCount));
+    for (const std::wstring& argument : arguments) {
+        HashWideString(hash, argument);
+    }
+    uint32_t compilerVersionLength = static_cast<uint32_t>(compilerVersion.size());
+    hash.Update(&compilerVersionLength, sizeof(compilerVersionLength));
+    hash.Update(compilerVersion.data(), compilerVersion.size());
+    uint64_t key = CombineHash(hash.Finish(), HashBytes(source.data(), source.size()));
+
+    // includeしたファイルは見つかった順に内容を合成する。見つからないファイルも、見つからないこととして合成する
+    for (const std::filesystem::path& includePath : CollectShaderIncludes(filePath)) {
+        std::string include;
+        uint64_t includeHash = ReadFileBytes(includePath, include) ? HashBytes(include.data(), include.size()) : 0;
+        key = CombineHash(key, includeHash);
+    }
+    // 0は読めなかったことを表すので避ける
+    return key != 0 ? key : 1;
+}
+
+std::filesystem::path GetShaderCachePath(const std::filesystem::path& cacheDirectory, uint64_t key)
+{
+    char fileName[32];
+    std::snprintf(fileName, sizeof(fileName), "%016llx.dxil", static_cast<unsigned long long>(key));
+    return cacheDirectory / fileName;
+}
+
+bool ReadShaderCache(const std::filesystem::path& cacheDirectory, uint64_t key, std::vector<uint8_t>& dxil)
+{
+    std::string contents;
+    if (!ReadFileBytes(GetShaderCachePath(cacheDirectory, key), contents) || contents.size() < sizeof(Header)) {
+        return false;
+    }
+    Header header;
+    std::memcpy(&header, contents.data(), sizeof(header));
+    if (header.magic != kMagic || header.version != kVersion || header.key != key) {
+        return false;
+    }
+    if (header.size != contents.size() - sizeof(Header)) {
+        return false;
+    }
+    const char* data = contents.data() + sizeof(Header);
+    if (HashBytes(data, header.size) != header.contentHash) {
+        return false;
+    }
+    dxil.assign(data, data + header.size);
+    return true;
+}
+
+bool WriteShaderCache(const std::filesystem::path& cacheDirectory, uint64_t key, const void* dxil, size_t size)
+{
+    std::error_code error;
+    std::filesystem::create_directories(cacheDirectory, error);
+    if (error) {
+        return false;
+    }
+
+    Header header{};
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.key = key;
+    header.size = size;
+    header.contentHash = HashBytes(dxil, size);
+
+    // 一時ファイルに書き出す
+    std::filesystem::path cachePath = GetShaderCachePath(cacheDirectory, key);
+    std::filesystem::path temporaryPath = cachePath;
+    temporaryPath += ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(static_cast<const char*>(dxil), static_cast<std::streamsize>(size));
+        if (!file) {
+            return false;
+        }
+    }
+
+    // 書き終わってから差し替える
+    std::filesystem::rename(temporaryPath, cachePath, error);
+    if (error) {
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// コンパイル済みシェーダー(DXIL)のキャッシュ(.dxil)の形式
+/// ヘッダーの直後にDXCが出力したバイナリがそのまま続く
+/// </summary>
+namespace ShaderCacheFormat {
+
+constexpr uint32_t kMagic = 0x434C5844; // "DXLC"
+constexpr uint32_t kVersion = 1;
+
+struct Header {
+    uint32_t magic; // kMagic
+    uint32_t version; // kVersion
+    uint64_t key; // ComputeShaderCacheKeyの値
+    uint64_t size; // バイナリのバイト数
+    uint64_t contentHash; // バイナリのハッシュ。書きかけや壊れたファイルを使わないため
+};
+
+} // namespace ShaderCacheFormat
+
+/// <summary>
+/// DXCに渡す引数を作る。最初の引数はファイル名(エラーとデバッグ情報に使われる)
+/// optimizeなら-O3でデバッグ情報を付けない(配布用)。そうでなければ-Odでデバッグ情報を埋め込む
+/// </summary>
+std::vector<std::wstring> MakeShaderArguments(const std::wstring& filePath, const std::wstring& profile, const std::vector<std::wstring>& defines, bool optimize);
+
+/// <summary>
+/// filePathから#include "..."でたどれるファイルを、filePathからの相対位置で解決して見つかった順に返す(filePath自身は含まない)
+/// #ifの中も区別せずにたどるので、使われないファイルが入ることはあっても、使うファイルが漏れることはない
+/// </summary>
+std::vector<std::filesystem::path> CollectShaderIncludes(const std::filesystem::path& filePath);
+
+/// <summary>
+/// キャッシュのキー。ソースとincludeしたファイルの内容、DXCに渡す引数(プロファイルとマクロを含む)、DXCの版のハッシュ
+/// compilerVersionはIDxcVersionInfoから作った文字列。DXCを差し替えたら前の版の出力を使わないようにする
+/// ソースが読めなければ0
+/// </summary>
+uint64_t ComputeShaderCacheKey(const std::filesystem::path& filePath, const std::vector<std::wstring>& arguments, const std::string& compilerVersion);
+
+/// <summary>
+/// キーに対応するキャッシュファイルの場所(cacheDirectory/キーの16進.dxil)
+/// </summary>
+std::filesystem::path GetShaderCachePath(const std::filesystem::path& cacheDirectory, uint64_t key);
+
+/// <summary>
+/// キャッシュを読み込む。ファイルがない、形式が違う、keyが一致しない、内容が壊れている場合はfalse
+/// </summary>
+bool ReadShaderCache(const std::filesystem::path& cacheDirectory, uint64_t key, std::vector<uint8_t>& dxil);
+
+/// <summary>
+/// キャッシュを書き出す。一時ファイルに書いてから置き換えるので、途中で失敗しても壊れたキャッシュは残らない
+/// </summary>
+bool WriteShaderCache(const std::filesystem::path& cacheDirectory, uint64_t key, const void* dxil, size_t size);
@@ -0,0 +1,376 @@
+#include "ShaderCostReport.h"
+
+#include <algorithm>
+#include <sstream>
+#include <unordered_map>
+
+namespace {
+
+/// <summary>
+/// 報告の列。並びはFormatとParseで共通
+/// </summary>
+struct CostField {
+    const char* name;
+    uint32_t ShaderCost::*member;
+};
+
+constexpr CostField kCostFields[] = {
+    { "instructions", &ShaderCost::instructionCount },
+    { "alu", &ShaderCost::aluCount },
+    { "transcendental", &ShaderCost::transcendentalCount },
+    { "sample", &ShaderCost::sampleCount },
+    { "memory", &ShaderCost::memoryCount },
+    { "branch", &ShaderCost::branchCount },
+    { "values", &ShaderCost::valueCount },
+    { "peakLive", &ShaderCost::peakLiveValueCount },
+};
+
+/// <summary>
+/// 命令の分類
+/// </summary>
+enum class InstructionClass {
+    Alu,
+    Transcendental,
+    Sample,
+    Memory,
+    Branch,
+    Other, // phiやextractvalue、ハンドルの作成など、数だけに入れるもの
+};
+
+std::string_view Trim(std::string_view text)
+{
+    size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string_view::npos) {
+        return {};
+    }
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+std::string_view FirstWord(std::string_view text)
+{
+    return text.substr(0, text.find(' '));
+}
+
+std::string_view SkipWord(std::string_view text)
+{
+    size_t space = text.find(' ');
+    return space == std::string_view::npos ? std::string_view() : Trim(text.substr(space + 1));
+}
+
+bool IsNameChar(char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '.' || c == '_' || c == '$' || c == '-';
+}
+
+/// <summary>
+/// dx.opの番号(DXIL.rstのOpCode)の分類
+/// </summary>
+InstructionClass ClassifyDxOp(uint32_t opcode)
+{
+    switch (opcode) {
+    case 12: // Cos
+    case 13: // Sin
+    case 14: // Tan
+    case 15: // Acos
+    case 16: // Asin
+    case 17: // Atan
+    case 18: // Hcos
+    case 19: // Hsin
+    case 20: // Htan
+    case 21: // Exp
+    case 23: // Log
+    case 24: // Sqrt
+    case 25: // Rsqrt
+        return InstructionClass::Transcendental;
+    case 60: // Sample
+    case 61: // SampleBias
+    case 62: // SampleLevel
+    case 63: // SampleGrad
+    case 64: // SampleCmp
+    case 65: // SampleCmpLevelZero
+    case 66: // TextureLoad
+    case 73: // TextureGather
+    case 74: // TextureGatherCmp
+        return InstructionClass::Sample;
+    case 0: // TempRegLoad
+    case 1: // TempRegStore
+    case 2: // MinPrecXRegLoad
+    case 3: // MinPrecXRegStore
+    case 4: // LoadInput
+    case 5: // StoreOutput
+    case 58: // CBufferLoad
+    case 59: // CBufferLoadLegacy
+    case 67: // TextureStore
+    case 68: // BufferLoad
+    case 69: // BufferStore
+    case 70: // BufferUpdateCounter
+    case 72: // GetDimensions
+    case 139: // RawBufferLoad
+    case 140: // RawBufferStore
+        return InstructionClass::Memory;
+    case 57: // CreateHandle
+    case 71: // CheckAccessFullyMapped
+    case 216: // AnnotateHandle
+    case 217: // CreateHandleFromBinding
+    case 218: // CreateHandleFromHeap
+        return InstructionClass::Other;
+    default:
+        return InstructionClass::Alu;
+    }
+}
+
+/// <summary>
+/// 命令(結果の"%x = "を除いた部分)の分類
+/// </summary>
+InstructionClass ClassifyInstruction(std::string_view instruction)
+{
+    std::string_view op = FirstWord(instruction);
+    if (op == "tail" || op == "musttail" || op == "notail") {
+        instruction = SkipWord(instruction);
+        op = FirstWord(instruction);
+    }
+    if (op == "call") {
+        // dx.opの最初の引数が番号 : call float @dx.op.unary.f32(i32 23, float %5)
+        size_t dxOp = instruction.find("@dx.op.");
+        if (dxOp == std::string_view::npos) {
+            return InstructionClass::Alu;
+        }
+        size_t argument = instruction.find("(i32 ", dxOp);
+        if (argument == std::string_view::npos) {
+            return InstructionClass::Alu;
+        }
+        uint32_t opcode = 0;
+        for (size_t i = argument + 5; i < instruction.size() && instruction[i] >= '0' && instruction[i] <= '9'; ++i) {
+            opcode = opcode * 10 + static_cast<uint32_t>(instruction[i] - '0');
+        }
+        return ClassifyDxOp(opcode);
+    }
+    if (op == "br") {
+        return instruction.starts_with("br i1 ") ? InstructionClass::Branch : InstructionClass::Other;
+    }
+    if (op == "switch") {
+        return InstructionClass::Branch;
+    }
+    if (op == "load" || op == "store") {
+        return InstructionClass::Memory;
+    }
+    static constexpr std::string_view kAluOps[] = {
+        "fadd", "fsub", "fmul", "fdiv", "frem", "fneg",
+        "add", "sub", "mul", "udiv", "sdiv", "urem", "srem",
+        "shl", "lshr", "ashr", "and", "or", "xor",
+        "fcmp", "icmp", "select",
+        "trunc", "zext", "sext", "fptrunc", "fpext", "fptoui", "fptosi", "uitofp", "sitofp",
+    };
+    for (std::string_view aluOp : kAluOps) {
+        if (op == aluOp) {
+            return InstructionClass::Alu;
+        }
+    }
+    return InstructionClass::Other;
+}
+
+/// <summary>
+/// 関数1つ分の値の生存区間から、同時に生きている値の最大を求める
+/// 値は定義した命令の後から最後に使う命令まで生きているとする
+/// </summary>
+uint32_t ComputePeakLiveValueCount(const std::unordered_map<std::string_view, std::pair<uint32_t, uint32_t>>& values, uint32_t instructionCount)
+{
+    std::vector<int32_t> deltas(instructionCount + 1, 0);
+    for (const auto& [name, range] : values) {
+        if (range.second > range.first) {
+            ++deltas[range.first];
+            --deltas[range.second];
+        }
+    }
+    int32_t live = 0;
+    int32_t peak = 0;
+    for (int32_t delta : deltas) {
+        live += delta;
+        peak = (std::max)(peak, live);
+    }
+    return static_cast<uint32_t>(peak);
+}
+
+} // namespace
+
+ShaderCost AnalyzeDxilDisassembly(std::string_view disassembly)
+{
+    ShaderCost cost{};
+    bool inFunction = false;
+    bool inSwitchTable = false;
+    // 関数の中で定義した値の名前と、定義した命令と最後に使った命令の番号
+    std::unordered_map<std::string_view, std::pair<uint32_t, uint32_t>> values;
+    uint32_t index = 0;
+
+    size_t lineBegin = 0;
+    while (lineBegin < disassembly.size()) {
+        size_t lineEnd = disassembly.find('\n', lineBegin);
+        if (lineEnd == std::string_view::npos) {
+            lineEnd = disassembly.size();
+        }
+        std::string_view line = disassembly.substr(lineBegin, lineEnd - lineBegin);
+        lineBegin = lineEnd + 1;
+
+        // ;から後は注釈(dx.opの名前やラベル)
+        line = Trim(line.substr(0, line.find(';')));
+        if (!inFunction) {
+            // 宣言(declare)は本体がないので数えない
+            if (line.starts_with("define ") && line.ends_with("{")) {
+                inFunction = true;
+                values.clear();
+                index = 0;
+            }
+            continue;
+        }
+        if (line == "}") {
+            inFunction = false;
+            cost.peakLiveValueCount = (std::max)(cost.peakLiveValueCount, ComputePeakLiveValueCount(values, index));
+            continue;
+        }
+        // 空行と基本ブロックのラベル
+        if (line.empty() || line.ends_with(':')) {
+            continue;
+        }
+        // switchの分岐先の表は前の行のswitchの一部
+        if (inSwitchTable) {
+            inSwitchTable = line != "]";
+            continue;
+        }
+
+        std::string_view result;
+        std::string_view instruction = line;
+        if (line.starts_with('%')) {
+            size_t assign = line.find(" = ");
+            if (assign != std::string_view::npos) {
+                result = line.substr(0, assign);
+                instruction = line.substr(assign + 3);
+            }
+        }
+
+        // 使った値の生存区間を延ばす。%dx.types.Handleのような型や、ラベルは値として定義されていないので当たらない
+        for (size_t i = instruction.find('%'); i != std::string_view::npos; i = instruction.find('%', i + 1)) {
+            size_t nameEnd = i + 1;
+            while (nameEnd < instruction.size() && IsNameChar(instruction[nameEnd])) {
+                ++nameEnd;
+            }
+            auto value = values.find(instruction.substr(i, nameEnd - i));
+            if (value != values.end()) {
+                value->second.second = index;
+            }
+        }
+        if (!result.empty()) {
+            values[result] = { index, index };
+            ++cost.valueCount;
+        }
+
+        ++cost.instructionCount;
+        switch (ClassifyInstruction(instruction)) {
+        case InstructionClass::Alu:
+            ++cost.aluCount;
+            break;
+        case InstructionClass::Transcendental:
+            ++cost.transcendentalCount;
+            break;
+        case InstructionClass::Sample:
+            ++cost.sampleCount;
+            break;
+        case InstructionClass::Memory:
+            ++cost.memoryCount;
+            break;
+        case InstructionClass::Branch:
+            ++cost.branchCount;
+            break;
+        case InstructionClass::Other:
+            break;
+        }
+        inSwitchTable = instruction.starts_with("switch ") && instruction.ends_with("[");
+        ++index;
+    }
+    return cost;
+}
+
+std::string FormatShaderCostReport(const std::vector<NamedShaderCost>& costs)
+{
+    std::string report = "# name";
+    for (const CostField& field : kCostFields) {
+        report += ' ';
+        report += field.name;
+    }
+    report += '\n';
+    for (const NamedShaderCost& namedCost : costs) {
+        report += namedCost.name;
+        for (const CostField& field : kCostFields) {
+            report += ' ';
+            report += std::to_string(namedCost.cost.*field.member);
+        }
+        report += '\n';
+    }
+    return report;
+}
+
+bool ParseShaderCostReport(std::string_view text, std::vector<NamedShaderCost>& costs)
+{
+    costs.clear();
+    std::istringstream stream{ std::string(text) };
+    std::string line;
+    while (std::getline(stream, line)) {
+        std::string_view trimmed = Trim(line);
+        if (trimmed.empty() || trimmed.starts_with('#')) {
+            continue;
+        }
+        std::istringstream lineStream{ std::string(trimmed) };
+        NamedShaderCost namedCost{};
+        if (!(lineStream >> namedCost.name)) {
+            return false;
+        }
+        for (const CostField& field : kCostFields) {
+            if (!(lineStream >> namedCost.cost.*field.member)) {
+                return false;
+            }
+        }
+        std::string extra;
+        if (lineStream >> extra) {
+            return false;
+        }
+        costs.push_back(std::move(namedCost));
+    }
+    return true;
+}
+
+std::vector<std::string> CompareShaderCosts(const std::vector<NamedShaderCost>& baseline, const std::vector<NamedShaderCost>& current)
+{
+    std::vector<std::string> regressions;
+    for (const NamedShaderCost& currentCost : current) {
+        const NamedShaderCost* baselineCost = nullptr;
+        for (const NamedShaderCost& candidate : baseline) {
+            if (candidate.name == currentCost.name) {
+                baselineCost = &candidate;
+                break;
+            }
+        }
+        if (baselineCost == nullptr) {
+            continue;
+        }
+        for (const CostField& field : kCostFields) {
+            uint32_t before = baselineCost->cost.*field.member;
+            uint32_t after = currentCost.cost.*field.member;
+            if (after > before) {
+                regressions.push_back(currentCost.name + ": " + field.name + " " + std::to_string(before) + " -> " + std::to_string(after));
+            }
+        }
+    }
+    return regressions;
+}
+
+std::vector<std::string> FindShadersWithoutBaseline(const std::vector<NamedShaderCost>& baseline, const std::vector<NamedShaderCost>& current)
+{
+    std::vector<std::string> names;
+    for (const NamedShaderCost& currentCost : current) {
+        bool found = std::any_of(baseline.begin(), baseline.end(), [&](const NamedShaderCost& candidate) { return candidate.name == currentCost.name; });
+        if (!found) {
+            names.push_back(currentCost.name);
+        }
+    }
+    return names;
+}
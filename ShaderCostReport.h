@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// <summary>
+/// DXILの逆アセンブルから数えた、シェーダー1つ分の命令の内訳
+/// DXILはGPUが実行する命令ではないので目安。変更の前後で比べるのに使う
+/// </summary>
+struct ShaderCost {
+    uint32_t instructionCount; // 関数本体の命令全て
+    uint32_t aluCount; // 四則演算、比較、変換、select、算術のdx.op
+    uint32_t transcendentalCount; // exp、log、sin、cos、sqrt、rsqrtなど。powはlog、mul、expになる
+    uint32_t sampleCount; // テクスチャのSample、Load、Gather
+    uint32_t memoryCount; // 定数バッファやバッファの読み書き、入出力、ローカル配列のload/store
+    uint32_t branchCount; // 条件分岐(br i1とswitch)
+    uint32_t valueCount; // 結果を持つ命令の数(SSAの値)
+    uint32_t peakLiveValueCount; // 同時に生きている値の最大。一時レジスタの目安。ループで戻る分は考えない
+
+    bool operator==(const ShaderCost&) const = default;
+};
+
+/// <summary>
+/// 名前付きのShaderCost。名前は空白を含まないこと
+/// </summary>
+struct NamedShaderCost {
+    std::string name;
+    ShaderCost cost;
+};
+
+/// <summary>
+/// IDxcCompiler3::Disassembleが出力したテキストから、定義された関数の本体の命令を数える
+/// </summary>
+ShaderCost AnalyzeDxilDisassembly(std::string_view disassembly);
+
+/// <summary>
+/// 1行に1シェーダーの名前と数を空白区切りで並べたテキスト。#から始まる行は注釈
+/// そのまま基準としてParseShaderCostReportで読める
+/// </summary>
+std::string FormatShaderCostReport(const std::vector<NamedShaderCost>& costs);
+
+/// <summary>
+/// FormatShaderCostReportの出力を読む。形式が違う行があればfalse
+/// </summary>
+bool ParseShaderCostReport(std::string_view text, std::vector<NamedShaderCost>& costs);
+
+/// <summary>
+/// 基準から増えた数を"名前: 項目 基準 -> 今"の形で返す。空なら悪化していない
+/// 基準にないシェーダーは新しく増えたものとして比べない
+/// </summary>
+std::vector<std::string> CompareShaderCosts(const std::vector<NamedShaderCost>& baseline, const std::vector<NamedShaderCost>& current);
+
+/// <summary>
+/// 基準にないシェーダーの名前。新しく増えたものなので失敗にはせず、基準に加えるまで報告だけする
+/// </summary>
+std::vector<std::string> FindShadersWithoutBaseline(const std::vector<NamedShaderCost>& baseline, const std::vector<NamedShaderCost>& current);
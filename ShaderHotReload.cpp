@@ -0,0 +1,83 @@
+#include "ShaderHotReload.h"
+
+#include <algorithm>
+
+bool DiskShaderFileSystem::GetWriteTime(const std::filesystem::path& filePath, uint64_t& writeTime) const
+{
+    std::error_code error;
+    std::filesystem::file_time_type time = std::filesystem::last_write_time(filePath, error);
+    if (error) {
+        return false;
+    }
+    writeTime = static_cast<uint64_t>(time.time_since_epoch().count());
+    return true;
+}
+
+void ShaderDependencyGraph::SetDependencies(const std::filesystem::path& root, const std::vector<std::filesystem::path>& includes)
+{
+    std::filesystem::path normalizedRoot = root.lexically_normal();
+    std::vector<std::filesystem::path> files = { normalizedRoot };
+    for (const std::filesystem::path& include : includes) {
+        std::filesystem::path normalizedInclude = include.lexically_normal();
+        if (std::find(files.begin(), files.end(), normalizedInclude) == files.end()) {
+            files.push_back(normalizedInclude);
+        }
+    }
+    dependencies_[normalizedRoot] = std::move(files);
+}
+
+std::vector<std::filesystem::path> ShaderDependencyGraph::GetAffectedRoots(const std::filesystem::path& filePath) const
+{
+    std::filesystem::path normalizedPath = filePath.lexically_normal();
+    std::vector<std::filesystem::path> roots;
+    for (const auto& [root, files] : dependencies_) {
+        if (std::find(files.begin(), files.end(), normalizedPath) != files.end()) {
+            roots.push_back(root);
+        }
+    }
+    return roots;
+}
+
+std::vector<std::filesystem::path> ShaderDependencyGraph::GetFiles() const
+{
+    std::vector<std::filesystem::path> result;
+    for (const auto& [root, files] : dependencies_) {
+        for (const std::filesystem::path& file : files) {
+            if (std::find(result.begin(), result.end(), file) == result.end()) {
+                result.push_back(file);
+            }
+        }
+    }
+    return result;
+}
+
+void ShaderHotReload::SetDependencies(const std::filesystem::path& root, const std::vector<std::filesystem::path>& includes)
+{
+    graph_.SetDependencies(root, includes);
+    for (const std::filesystem::path& file : graph_.GetFiles()) {
+        if (files_.find(file) == files_.end()) {
+            FileState state{};
+            state.exists = fileSystem_.GetWriteTime(file, state.writeTime);
+            files_.emplace(file, state);
+        }
+    }
+}
+
+std::vector<std::filesystem::path> ShaderHotReload::PollChangedRoots()
+{
+    std::vector<std::filesystem::path> roots;
+    for (auto& [file, state] : files_) {
+        FileState current{};
+        current.exists = fileSystem_.GetWriteTime(file, current.writeTime);
+        if (current.exists == state.exists && (!current.exists || current.writeTime == state.writeTime)) {
+            continue;
+        }
+        state = current;
+        for (const std::filesystem::path& root : graph_.GetAffectedRoots(file)) {
+            if (std::find(roots.begin(), roots.end(), root) == roots.end()) {
+                roots.push_back(root);
+            }
+        }
+    }
+    return roots;
+}
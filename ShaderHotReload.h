@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <vector>
+
+/// <summary>
+/// ファイルの更新日時を調べる。確かめるときは偽物に置き換える
+/// </summary>
+class ShaderFileSystem {
+public:
+    virtual ~ShaderFileSystem() = default;
+
+    /// <summary>
+    /// 最後に書き込まれた日時。比べて変わったかを知るためだけに使うので、単位は問わない。ファイルがなければfalse
+    /// </summary>
+    virtual bool GetWriteTime(const std::filesystem::path& filePath, uint64_t& writeTime) const = 0;
+};
+
+/// <summary>
+/// ディスク上のファイルの更新日時を調べる
+/// </summary>
+class DiskShaderFileSystem : public ShaderFileSystem {
+public:
+    bool GetWriteTime(const std::filesystem::path& filePath, uint64_t& writeTime) const override;
+};
+
+/// <summary>
+/// シェーダーのソース(root)ごとに、コンパイルで読んだファイル(root自身とinclude)を持つ
+/// ファイルが変わったときに、コンパイルし直すrootだけを引く
+/// </summary>
+class ShaderDependencyGraph {
+public:
+    /// <summary>
+    /// rootが読んだファイルを入れ替える。パスはlexically_normalにそろえて持つ
+    /// </summary>
+    void SetDependencies(const std::filesystem::path& root, const std::vector<std::filesystem::path>& includes);
+
+    /// <summary>
+    /// filePathを読んだroot。filePathがroot自身なら含む
+    /// </summary>
+    std::vector<std::filesystem::path> GetAffectedRoots(const std::filesystem::path& filePath) const;
+
+    /// <summary>
+    /// どれかのrootが読んだファイル全て
+    /// </summary>
+    std::vector<std::filesystem::path> GetFiles() const;
+
+    size_t GetRootCount() const { return dependencies_.size(); }
+
+private:
+    std::map<std::filesystem::path, std::vector<std::filesystem::path>> dependencies_; //!< rootごとの読んだファイル。root自身が先頭
+};
+
+/// <summary>
+/// シェーダーのソースを見張り、変わったファイルからコンパイルし直すrootを求める
+/// 見張るのはDependencyGraphに入れたファイルで、Pollのたびに更新日時を調べる
+/// </summary>
+class ShaderHotReload {
+public:
+    explicit ShaderHotReload(const ShaderFileSystem& fileSystem) : fileSystem_(fileSystem) {}
+
+    /// <summary>
+    /// rootをコンパイルしたときに読んだファイルを入れ、まだ見張っていないファイルは今の更新日時から見張り始める
+    /// </summary>
+    void SetDependencies(const std::filesystem::path& root, const std::vector<std::filesystem::path>& includes);
+
+    /// <summary>
+    /// 前のPollから更新日時が変わった(消えた、現れたを含む)ファイルを調べ、それを読んだrootを重ならないように返す
+    /// </summary>
+    std::vector<std::filesystem::path> PollChangedRoots();
+
+    const ShaderDependencyGraph& GetGraph() const { return graph_; }
+
+private:
+    /// <summary>
+    /// 見張っているファイルの最後に見た状態
+    /// </summary>
+    struct FileState {
+        bool exists;
+        uint64_t writeTime;
+    };
+
+    const ShaderFileSystem& fileSystem_;
+    ShaderDependencyGraph graph_;
+    std::map<std::filesystem::path, FileState> files_; //!< 見張っているファイル
+};
@@ -0,0 +1,41 @@
+#include "ShaderPermutation.h"
+
+const ShaderFeature kShaderFeatures[kShaderFeatureCount] = {
+    { kShaderFeatureLighting, L"ENABLE_LIGHTING", 0 },
+    { kShaderFeatureHalfLambert, L"HALF_LAMBERT", kShaderFeatureLighting },
+    { kShaderFeatureUvTransform, L"UV_TRANSFORM", 0 },
+};
+
+uint32_t NormalizeShaderFeatures(uint32_t features)
+{
+    features &= (1u << kShaderFeatureCount) - 1;
+    // 必要な機能は自分より前に宣言しているので、前から1回見れば連鎖して落ちる
+    for (const ShaderFeature& feature : kShaderFeatures) {
+        if ((features & feature.bit) != 0 && (features & feature.requiredFeatures) != feature.requiredFeatures) {
+            features &= ~feature.bit;
+        }
+    }
+    return features;
+}
+
+std::vector<uint32_t> EnumerateShaderPermutations()
+{
+    std::vector<uint32_t> permutations;
+    for (uint32_t features = 0; features < (1u << kShaderFeatureCount); ++features) {
+        if (NormalizeShaderFeatures(features) == features) {
+            permutations.push_back(features);
+        }
+    }
+    return permutations;
+}
+
+std::vector<std::wstring> GetShaderFeatureDefines(uint32_t features)
+{
+    std::vector<std::wstring> defines;
+    for (const ShaderFeature& feature : kShaderFeatures) {
+        if ((features & feature.bit) != 0) {
+            defines.push_back(feature.define);
+        }
+    }
+    return defines;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// PixelShaderの機能。マテリアルはこの組み合わせ(マスク)を持ち、マスクごとに-Dで特殊化したシェーダーとPSOを使う
+constexpr uint32_t kShaderFeatureLighting = 1u << 0; // DirectionalLightで照らす
+constexpr uint32_t kShaderFeatureHalfLambert = 1u << 1; // lambertの代わりにhalf lambertを使う。Lightingのときだけ
+constexpr uint32_t kShaderFeatureUvTransform = 1u << 2; // テクスチャ座標をマテリアルのuvTransformで変換する
+constexpr uint32_t kShaderFeatureCount = 3;
+
+/// <summary>
+/// 機能の宣言。HLSL側のマクロ名と、その機能が意味を持つために必要な機能
+/// </summary>
+struct ShaderFeature {
+    uint32_t bit;
+    const wchar_t* define;
+    uint32_t requiredFeatures;
+};
+
+extern const ShaderFeature kShaderFeatures[kShaderFeatureCount];
+
+/// <summary>
+/// 必要な機能がない機能を落としたマスク。同じ結果になるマスクを1つにまとめ、余計な組み合わせを作らない
+/// </summary>
+uint32_t NormalizeShaderFeatures(uint32_t features);
+
+/// <summary>
+/// 起こりうるマスクを全て小さい順に返す(NormalizeShaderFeaturesで変わらないもの)
+/// </summary>
+std::vector<uint32_t> EnumerateShaderPermutations();
+
+/// <summary>
+/// マスクの機能のマクロ。kShaderFeaturesの順に並べるので、同じマスクなら同じ並びになる
+/// </summary>
+std::vector<std::wstring> GetShaderFeatureDefines(uint32_t features);
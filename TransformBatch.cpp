@@ -0,0 +1,235 @@
+#include "TransformBatch.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+
+#include "AffineMatrix.h"
+#include "MatrixSimd.h"
+#include "ParallelFor.h"
+
+namespace {
+
+constexpr size_t kBatchSize = 8; // AVX2で一度に計算するオブジェクトの数
+constexpr size_t kMinObjectsPerThread = 16384; // これより少ないとスレッドを作る方が高くつく
+
+/// <summary>
+/// 1オブジェクトのWorldとWVPを計算する。AVX2の関数と同じ式で、端数とAVX2がないときに使う
+/// </summary>
+void ComputeTransformationMatrix(const TransformSoA& transforms, size_t index, const Matrix4x4& viewProjection, TransformationMatrix& result)
+{
+    AffineMatrix world = MakeAffineTransform(
+        { transforms.scaleX[index], transforms.scaleY[index], transforms.scaleZ[index] },
+        { transforms.rotateX[index], transforms.rotateY[index], transforms.rotateZ[index] },
+        { transforms.translateX[index], transforms.translateY[index], transforms.translateZ[index] });
+    result.WVP = Multiply(world, viewProjection);
+    result.World = ToMatrix4x4(world);
+}
+
+/// <summary>
+/// 8つの角度のsinとcosを同時に求める(Cephesのsinf/cosfと同じ多項式)。|x|が8192程度までなら誤差は数ULP
+/// </summary>
+SIMD_TARGET_AVX2 void SinCosAvx2(__m256 x, __m256& sinResult, __m256& cosResult)
+{
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    __m256 sinSign = _mm256_and_ps(x, signMask);
+    x = _mm256_andnot_ps(signMask, x);
+
+    // π/4単位の偶数の象限jに丸め、x - j * π/4 を3つに分けた定数で精度を落とさず求める
+    __m256i quadrant = _mm256_cvttps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(1.27323954473516f)));
+    quadrant = _mm256_and_si256(_mm256_add_epi32(quadrant, _mm256_set1_epi32(1)), _mm256_set1_epi32(~1));
+    __m256 y = _mm256_cvtepi32_ps(quadrant);
+    x = _mm256_fnmadd_ps(y, _mm256_set1_ps(0.78515625f), x);
+    x = _mm256_fnmadd_ps(y, _mm256_set1_ps(2.4187564849853515625e-4f), x);
+    x = _mm256_fnmadd_ps(y, _mm256_set1_ps(3.77489497744594108e-8f), x);
+
+    // jの2のビットが立っていればsinとcosの多項式を入れ替え、4のビットで符号を反転する
+    __m256 swapMask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(quadrant, _mm256_set1_epi32(2)), _mm256_set1_epi32(2)));
+    sinSign = _mm256_xor_ps(sinSign, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(quadrant, _mm256_set1_epi32(4)), 29)));
+    __m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_andnot_si256(_mm256_sub_epi32(quadrant, _mm256_set1_epi32(2)), _mm256_set1_epi32(4)), 29));
+
+    __m256 z = _mm256_mul_ps(x, x);
+    __m256 cosPolynomial = _mm256_fmadd_ps(_mm256_set1_ps(2.443315711809948e-5f), z, _mm256_set1_ps(-1.388731625493765e-3f));
+    cosPolynomial = _mm256_fmadd_ps(cosPolynomial, z, _mm256_set1_ps(4.166664568298827e-2f));
+    cosPolynomial = _mm256_mul_ps(_mm256_mul_ps(cosPolynomial, z), z);
+    cosPolynomial = _mm256_add_ps(_mm256_fnmadd_ps(_mm256_set1_ps(0.5f), z, cosPolynomial), _mm256_set1_ps(1.0f));
+
+    __m256 sinPolynomial = _mm256_fmadd_ps(_mm256_set1_ps(-1.9515295891e-4f), z, _mm256_set1_ps(8.3321608736e-3f));
+    sinPolynomial = _mm256_fmadd_ps(sinPolynomial, z, _mm256_set1_ps(-1.6666654611e-1f));
+    sinPolynomial = _mm256_fmadd_ps(_mm256_mul_ps(sinPolynomial, z), x, x);
+
+    sinResult = _mm256_xor_ps(_mm256_blendv_ps(sinPolynomial, cosPolynomial, swapMask), sinSign);
+    cosResult = _mm256_xor_ps(_mm256_blendv_ps(cosPolynomial, sinPolynomial, swapMask), cosSign);
+}
+
+/// <summary>
+/// rows[k]にk番目の値を8オブジェクト分入れた8x8を転置し、rows[j]にj番目のオブジェクトの連続した8つの値を入れる
+/// </summary>
+SIMD_TARGET_AVX2 void Transpose8x8Avx2(__m256 rows[8])
+{
+    __m256 t0 = _mm256_unpacklo_ps(rows[0], rows[1]);
+    __m256 t1 = _mm256_unpackhi_ps(rows[0], rows[1]);
+    __m256 t2 = _mm256_unpacklo_ps(rows[2], rows[3]);
+    __m256 t3 = _mm256_unpackhi_ps(rows[2], rows[3]);
+    __m256 t4 = _mm256_unpacklo_ps(rows[4], rows[5]);
+    __m256 t5 = _mm256_unpackhi_ps(rows[4], rows[5]);
+    __m256 t6 = _mm256_unpacklo_ps(rows[6], rows[7]);
+    __m256 t7 = _mm256_unpackhi_ps(rows[6], rows[7]);
+    __m256 u0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 u1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 u2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 u3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 u4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 u5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 u6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 u7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+    rows[0] = _mm256_permute2f128_ps(u0, u4, 0x20);
+    rows[1] = _mm256_permute2f128_ps(u1, u5, 0x20);
+    rows[2] = _mm256_permute2f128_ps(u2, u6, 0x20);
+    rows[3] = _mm256_permute2f128_ps(u3, u7, 0x20);
+    rows[4] = _mm256_permute2f128_ps(u0, u4, 0x31);
+    rows[5] = _mm256_permute2f128_ps(u1, u5, 0x31);
+    rows[6] = _mm256_permute2f128_ps(u2, u6, 0x31);
+    rows[7] = _mm256_permute2f128_ps(u3, u7, 0x31);
+}
+
+/// <summary>
+/// 成分ごとに8オブジェクト分並べた値(values[k]がk番目の値)を、各オブジェクトのfloatOffsetからの8つのfloatへ書く
+/// </summary>
+SIMD_TARGET_AVX2 void StoreTransposedAvx2(__m256 values[8], TransformationMatrix* result, size_t floatOffset)
+{
+    Transpose8x8Avx2(values);
+    for (size_t object = 0; object < kBatchSize; ++object) {
+        _mm256_storeu_ps(reinterpret_cast<float*>(&result[object]) + floatOffset, values[object]);
+    }
+}
+
+/// <summary>
+/// [begin, end)のオブジェクトを8個ずつAVX2で計算する。8個に満たない端数は1個ずつ計算する
+/// </summary>
+SIMD_TARGET_AVX2 void ComputeTransformationMatricesAvx2(const TransformSoA& transforms, const Matrix4x4& viewProjection, TransformationMatrix* result, size_t begin, size_t end)
+{
+    const Matrix4x4& vp = viewProjection;
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    size_t index = begin;
+    for (; index + kBatchSize <= end; index += kBatchSize) {
+        __m256 sinX, cosX, sinY, cosY, sinZ, cosZ;
+        SinCosAvx2(_mm256_loadu_ps(&transforms.rotateX[index]), sinX, cosX);
+        SinCosAvx2(_mm256_loadu_ps(&transforms.rotateY[index]), sinY, cosY);
+        SinCosAvx2(_mm256_loadu_ps(&transforms.rotateZ[index]), sinZ, cosZ);
+        __m256 scaleX = _mm256_loadu_ps(&transforms.scaleX[index]);
+        __m256 scaleY = _mm256_loadu_ps(&transforms.scaleY[index]);
+        __m256 scaleZ = _mm256_loadu_ps(&transforms.scaleZ[index]);
+        __m256 translateX = _mm256_loadu_ps(&transforms.translateX[index]);
+        __m256 translateY = _mm256_loadu_ps(&transforms.translateY[index]);
+        __m256 translateZ = _mm256_loadu_ps(&transforms.translateZ[index]);
+
+        // MakeAffineTransformと同じ式を8オブジェクト分まとめて計算する
+        __m256 sinXsinY = _mm256_mul_ps(sinX, sinY);
+        __m256 cosXsinY = _mm256_mul_ps(cosX, sinY);
+        __m256 world[3][3] = {
+            {
+                _mm256_mul_ps(_mm256_mul_ps(cosY, cosZ), scaleX),
+                _mm256_mul_ps(_mm256_mul_ps(cosY, sinZ), scaleX),
+                _mm256_mul_ps(_mm256_sub_ps(zero, sinY), scaleX),
+            },
+            {
+                _mm256_mul_ps(_mm256_fmsub_ps(sinXsinY, cosZ, _mm256_mul_ps(cosX, sinZ)), scaleY),
+                _mm256_mul_ps(_mm256_fmadd_ps(sinXsinY, sinZ, _mm256_mul_ps(cosX, cosZ)), scaleY),
+                _mm256_mul_ps(_mm256_mul_ps(sinX, cosY), scaleY),
+            },
+            {
+                _mm256_mul_ps(_mm256_fmadd_ps(cosXsinY, cosZ, _mm256_mul_ps(sinX, sinZ)), scaleZ),
+                _mm256_mul_ps(_mm256_fmsub_ps(cosXsinY, sinZ, _mm256_mul_ps(sinX, cosZ)), scaleZ),
+                _mm256_mul_ps(_mm256_mul_ps(cosX, cosY), scaleZ),
+            },
+        };
+
+        // WVPの各成分。viewProjectionの要素は全オブジェクト共通なので1つずつ全レーンに広げてかける
+        __m256 wvp[16];
+        for (int row = 0; row < 3; ++row) {
+            for (int column = 0; column < 4; ++column) {
+                __m256 value = _mm256_mul_ps(world[row][0], _mm256_broadcast_ss(&vp.m[0][column]));
+                value = _mm256_fmadd_ps(world[row][1], _mm256_broadcast_ss(&vp.m[1][column]), value);
+                wvp[row * 4 + column] = _mm256_fmadd_ps(world[row][2], _mm256_broadcast_ss(&vp.m[2][column]), value);
+            }
+        }
+        for (int column = 0; column < 4; ++column) {
+            __m256 value = _mm256_fmadd_ps(translateX, _mm256_broadcast_ss(&vp.m[0][column]), _mm256_broadcast_ss(&vp.m[3][column]));
+            value = _mm256_fmadd_ps(translateY, _mm256_broadcast_ss(&vp.m[1][column]), value);
+            wvp[12 + column] = _mm256_fmadd_ps(translateZ, _mm256_broadcast_ss(&vp.m[2][column]), value);
+        }
+
+        // 8つずつ転置して、各オブジェクトのTransformationMatrixへ連続して書く
+        TransformationMatrix* output = result + index;
+        StoreTransposedAvx2(wvp, output, 0);
+        StoreTransposedAvx2(wvp + 8, output, 8);
+        __m256 worldRows01[8] = { world[0][0], world[0][1], world[0][2], zero, world[1][0], world[1][1], world[1][2], zero };
+        StoreTransposedAvx2(worldRows01, output, 16);
+        __m256 worldRows23[8] = { world[2][0], world[2][1], world[2][2], zero, translateX, translateY, translateZ, one };
+        StoreTransposedAvx2(worldRows23, output, 24);
+    }
+    for (; index < end; ++index) {
+        ComputeTransformationMatrix(transforms, index, viewProjection, result[index]);
+    }
+}
+
+} // namespace
+
+void TransformSoA::Resize(size_t count)
+{
+    scaleX.resize(count, 1.0f);
+    scaleY.resize(count, 1.0f);
+    scaleZ.resize(count, 1.0f);
+    rotateX.resize(count, 0.0f);
+    rotateY.resize(count, 0.0f);
+    rotateZ.resize(count, 0.0f);
+    translateX.resize(count, 0.0f);
+    translateY.resize(count, 0.0f);
+    translateZ.resize(count, 0.0f);
+}
+
+void TransformSoA::Set(size_t index, const Transform& transform)
+{
+    scaleX[index] = transform.scale.x;
+    scaleY[index] = transform.scale.y;
+    scaleZ[index] = transform.scale.z;
+    rotateX[index] = transform.rotate.x;
+    rotateY[index] = transform.rotate.y;
+    rotateZ[index] = transform.rotate.z;
+    translateX[index] = transform.translate.x;
+    translateY[index] = transform.translate.y;
+    translateZ[index] = transform.translate.z;
+}
+
+Transform TransformSoA::Get(size_t index) const
+{
+    return {
+        { scaleX[index], scaleY[index], scaleZ[index] },
+        { rotateX[index], rotateY[index], rotateZ[index] },
+        { translateX[index], translateY[index], translateZ[index] },
+    };
+}
+
+void ComputeTransformationMatrices(const TransformSoA& transforms, const Matrix4x4& viewProjection, TransformationMatrix* result, uint32_t threadCount)
+{
+    size_t count = transforms.GetSize();
+    bool useAvx2 = GetSimdLevel() == SimdLevel::Avx2;
+
+    // 各スレッドの範囲は8の倍数で区切り、端数は最後の範囲だけに残す
+    size_t maxChunkCount = (std::max)(count / kMinObjectsPerThread, static_cast<size_t>(1));
+    size_t chunkCount = (std::min)(static_cast<size_t>((std::max)(threadCount, 1u)), maxChunkCount);
+    size_t chunkSize = (count / chunkCount + kBatchSize - 1) / kBatchSize * kBatchSize;
+    ParallelFor(chunkCount, threadCount, [&](size_t chunk) {
+        size_t begin = (std::min)(chunk * chunkSize, count);
+        size_t end = chunk + 1 == chunkCount ? count : (std::min)(begin + chunkSize, count);
+        if (useAvx2) {
+            ComputeTransformationMatricesAvx2(transforms, viewProjection, result, begin, end);
+        } else {
+            for (size_t index = begin; index < end; ++index) {
+                ComputeTransformationMatrix(transforms, index, viewProjection, result[index]);
+            }
+        }
+    });
+}
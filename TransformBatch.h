@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "MathTypes.h"
+
+/// <summary>
+/// 1オブジェクト分のConstantBuffer(インスタンスバッファなら1要素)
+/// </summary>
+struct TransformationMatrix {
+    Matrix4x4 WVP;
+    Matrix4x4 World;
+};
+
+/// <summary>
+/// Transformの列を成分ごとの配列(SoA)で持つ。連続した8個をそのまま256bitで読める
+/// </summary>
+struct TransformSoA {
+    std::vector<float> scaleX;
+    std::vector<float> scaleY;
+    std::vector<float> scaleZ;
+    std::vector<float> rotateX;
+    std::vector<float> rotateY;
+    std::vector<float> rotateZ;
+    std::vector<float> translateX;
+    std::vector<float> translateY;
+    std::vector<float> translateZ;
+
+    size_t GetSize() const { return scaleX.size(); }
+
+    /// <summary>
+    /// 要素数を変える。増えた分は拡縮1、回転と移動は0
+    /// </summary>
+    void Resize(size_t count);
+
+    void Set(size_t index, const Transform& transform);
+    Transform Get(size_t index) const;
+};
+
+/// <summary>
+/// 全オブジェクトのWorld(MakeAffineMatrixと同じ拡縮→X→Y→Z回転→移動)とWVP(World * viewProjection)をresultに書く
+/// resultはtransforms.GetSize()個分の連続した領域で、インスタンスバッファをMapした先をそのまま渡せる
+/// AVX2が使えれば8個ずつまとめてsin/cosから計算する。threadCountが2以上なら範囲を分けて並列に計算する
+/// </summary>
+void ComputeTransformationMatrices(const TransformSoA& transforms, const Matrix4x4& viewProjection, TransformationMatrix* result, uint32_t threadCount = 1);
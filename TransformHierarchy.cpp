@@ -0,0 +1,160 @@
+#include "TransformHierarchy.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "ParallelFor.h"
+
+namespace {
+
+constexpr uint32_t kMinNodesPerThread = 4096; // 1つの深さにこれより少ないとスレッドを作る方が高くつく
+
+/// <summary>
+/// values[newSlot] = values[oldSlotOfNewSlot[newSlot]] に並べ替える
+/// </summary>
+template<typename T>
+void Permute(std::vector<T>& values, const std::vector<uint32_t>& oldSlotOfNewSlot)
+{
+    std::vector<T> sorted(values.size());
+    for (size_t newSlot = 0; newSlot < values.size(); ++newSlot) {
+        sorted[newSlot] = values[oldSlotOfNewSlot[newSlot]];
+    }
+    values.swap(sorted);
+}
+
+} // namespace
+
+uint32_t TransformHierarchy::AddNode(const Transform& local, uint32_t parent)
+{
+    assert(parent == kNoParent || parent < slotOfNode_.size());
+    uint32_t node = static_cast<uint32_t>(slotOfNode_.size());
+    uint32_t slot = static_cast<uint32_t>(local_.size());
+    uint32_t parentSlot = parent == kNoParent ? kNoParent : slotOfNode_[parent];
+    uint32_t depth = parent == kNoParent ? 0 : depth_[parentSlot] + 1;
+
+    // ひとまず末尾に置き、深さ順に並べ直すのは次のUpdateでまとめて行う
+    nodeOfSlot_.push_back(node);
+    parentSlot_.push_back(parentSlot);
+    depth_.push_back(depth);
+    local_.push_back(local);
+    localMatrix_.push_back(MakeIdentityAffine<AffineKind::General>());
+    world_.push_back(MakeIdentityAffine<AffineKind::General>());
+    localDirty_.push_back(1);
+    worldChanged_.push_back(0);
+    slotOfNode_.push_back(slot);
+    depthCount_ = (std::max)(depthCount_, depth + 1);
+    sorted_ = false;
+    return node;
+}
+
+void TransformHierarchy::SetLocalTransform(uint32_t node, const Transform& local)
+{
+    uint32_t slot = slotOfNode_[node];
+    local_[slot] = local;
+    localDirty_[slot] = 1;
+}
+
+uint32_t TransformHierarchy::GetParent(uint32_t node) const
+{
+    uint32_t parentSlot = parentSlot_[slotOfNode_[node]];
+    return parentSlot == kNoParent ? kNoParent : nodeOfSlot_[parentSlot];
+}
+
+uint32_t TransformHierarchy::Update(uint32_t threadCount)
+{
+    if (!sorted_) {
+        SortByDepth();
+    }
+
+    // 親は必ず前の深さにあるので、深さごとに処理すれば親のworld_とworldChanged_は確定している
+    recomputedCount_ = 0;
+    for (uint32_t depth = 0; depth < depthCount_; ++depth) {
+        uint32_t begin = depthBegin_[depth];
+        uint32_t end = depthBegin_[depth + 1];
+        uint32_t count = end - begin;
+        uint32_t chunkCount = (std::min)((std::max)(threadCount, 1u), (std::max)(count / kMinNodesPerThread, 1u));
+        if (chunkCount <= 1) {
+            recomputedCount_ += UpdateRange(begin, end);
+            continue;
+        }
+
+        uint32_t chunkSize = (count + chunkCount - 1) / chunkCount;
+        std::vector<uint32_t> chunkRecomputedCounts(chunkCount, 0);
+        ParallelFor(chunkCount, threadCount, [&](size_t chunk) {
+            uint32_t chunkBegin = begin + (std::min)(static_cast<uint32_t>(chunk) * chunkSize, count);
+            uint32_t chunkEnd = (std::min)(chunkBegin + chunkSize, end);
+            chunkRecomputedCounts[chunk] = UpdateRange(chunkBegin, chunkEnd);
+        });
+        for (uint32_t chunkRecomputedCount : chunkRecomputedCounts) {
+            recomputedCount_ += chunkRecomputedCount;
+        }
+    }
+    return recomputedCount_;
+}
+
+void TransformHierarchy::SortByDepth()
+{
+    // 深さごとの数を数えて各深さの先頭を決める
+    depthBegin_.assign(depthCount_ + 1, 0);
+    for (uint32_t depth : depth_) {
+        ++depthBegin_[depth + 1];
+    }
+    for (uint32_t depth = 0; depth < depthCount_; ++depth) {
+        depthBegin_[depth + 1] += depthBegin_[depth];
+    }
+    sorted_ = true;
+
+    // 根から深さの順に足していれば既に並んでいるので、並べ替えない
+    if (std::is_sorted(depth_.begin(), depth_.end())) {
+        return;
+    }
+
+    // 同じ深さの中では今の順を保つ(安定な数え上げソート)
+    uint32_t slotCount = static_cast<uint32_t>(depth_.size());
+    std::vector<uint32_t> nextSlot(depthBegin_.begin(), depthBegin_.end() - 1);
+    std::vector<uint32_t> newSlotOfOldSlot(slotCount);
+    std::vector<uint32_t> oldSlotOfNewSlot(slotCount);
+    for (uint32_t oldSlot = 0; oldSlot < slotCount; ++oldSlot) {
+        uint32_t newSlot = nextSlot[depth_[oldSlot]]++;
+        newSlotOfOldSlot[oldSlot] = newSlot;
+        oldSlotOfNewSlot[newSlot] = oldSlot;
+    }
+
+    Permute(nodeOfSlot_, oldSlotOfNewSlot);
+    Permute(parentSlot_, oldSlotOfNewSlot);
+    Permute(depth_, oldSlotOfNewSlot);
+    Permute(local_, oldSlotOfNewSlot);
+    Permute(localMatrix_, oldSlotOfNewSlot);
+    Permute(world_, oldSlotOfNewSlot);
+    Permute(localDirty_, oldSlotOfNewSlot);
+    Permute(worldChanged_, oldSlotOfNewSlot);
+    for (uint32_t& parentSlot : parentSlot_) {
+        if (parentSlot != kNoParent) {
+            parentSlot = newSlotOfOldSlot[parentSlot];
+        }
+    }
+    for (uint32_t slot = 0; slot < slotCount; ++slot) {
+        slotOfNode_[nodeOfSlot_[slot]] = slot;
+    }
+}
+
+uint32_t TransformHierarchy::UpdateRange(uint32_t begin, uint32_t end)
+{
+    uint32_t recomputedCount = 0;
+    for (uint32_t slot = begin; slot < end; ++slot) {
+        uint32_t parentSlot = parentSlot_[slot];
+        bool changed = parentSlot != kNoParent && worldChanged_[parentSlot] != 0;
+        if (localDirty_[slot] != 0) {
+            const Transform& local = local_[slot];
+            localMatrix_[slot] = MakeAffineTransform(local.scale, local.rotate, local.translate);
+            localDirty_[slot] = 0;
+            changed = true;
+        }
+        if (changed) {
+            world_[slot] = parentSlot == kNoParent ? localMatrix_[slot] : Multiply(localMatrix_[slot], world_[parentSlot]);
+            ++recomputedCount;
+        }
+        worldChanged_[slot] = changed ? 1 : 0;
+    }
+    return recomputedCount;
+}
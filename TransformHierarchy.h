@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "AffineMatrix.h"
+#include "MathTypes.h"
+
+/// <summary>
+/// 親子関係を持つTransformの集まり。World行列は自分か祖先のTransformが変わったノードだけUpdateで計算し直す
+/// ノードは深さ順に並べた配列で持ち、親は必ず前の深さにあるので、先頭から順に1回なめるだけで全体が更新できる
+/// 同じ深さのノードは互いに依存しないので、深さごとに範囲を分けて並列に計算できる
+/// </summary>
+class TransformHierarchy {
+public:
+    static constexpr uint32_t kNoParent = UINT32_MAX;
+
+    /// <summary>
+    /// ノードを足して番号を返す。番号は足した順の連番で、並べ替えても変わらない
+    /// parentは既にあるノードの番号か、根ならkNoParent
+    /// </summary>
+    uint32_t AddNode(const Transform& local, uint32_t parent = kNoParent);
+
+    /// <summary>
+    /// 親に対するTransformを変え、次のUpdateでこのノードと子孫のWorld行列を計算し直す
+    /// </summary>
+    void SetLocalTransform(uint32_t node, const Transform& local);
+
+    const Transform& GetLocalTransform(uint32_t node) const { return local_[slotOfNode_[node]]; }
+    uint32_t GetParent(uint32_t node) const;
+
+    /// <summary>
+    /// 直前のUpdateで求めたWorld行列(自分のTransform * 親のWorld行列)
+    /// </summary>
+    const AffineMatrix& GetWorldMatrix(uint32_t node) const { return world_[slotOfNode_[node]]; }
+
+    /// <summary>
+    /// 直前のUpdateでWorld行列が計算し直されたか。GPUへ送り直すノードを選ぶのに使う
+    /// </summary>
+    bool IsWorldMatrixChanged(uint32_t node) const { return worldChanged_[slotOfNode_[node]] != 0; }
+
+    uint32_t GetNodeCount() const { return static_cast<uint32_t>(local_.size()); }
+
+    /// <summary>
+    /// 深さの種類の数(根だけなら1)
+    /// </summary>
+    uint32_t GetDepthCount() const { return depthCount_; }
+
+    /// <summary>
+    /// 変わったノードと子孫のWorld行列を計算し直す。threadCountが2以上なら、ノードが多い深さを範囲に分けて並列に計算する
+    /// 計算し直した行列の数を返す(GetRecomputedCountと同じ)
+    /// </summary>
+    uint32_t Update(uint32_t threadCount = 1);
+
+    /// <summary>
+    /// 直前のUpdateで計算し直した行列の数
+    /// </summary>
+    uint32_t GetRecomputedCount() const { return recomputedCount_; }
+
+private:
+    /// <summary>
+    /// 深さ順に並んでいなければ並べ替え、深さごとの範囲を作り直す
+    /// </summary>
+    void SortByDepth();
+
+    /// <summary>
+    /// [begin, end)のWorld行列を必要なものだけ計算し、計算した数を返す
+    /// </summary>
+    uint32_t UpdateRange(uint32_t begin, uint32_t end);
+
+    // 以下は深さ順の位置(slot)で引く
+    std::vector<uint32_t> nodeOfSlot_; //!< そこにあるノードの番号
+    std::vector<uint32_t> parentSlot_; //!< 親の位置。根はkNoParent
+    std::vector<uint32_t> depth_; //!< 根を0とした深さ
+    std::vector<Transform> local_; //!< 親に対するTransform
+    std::vector<AffineMatrix> localMatrix_; //!< local_から作った行列。祖先だけが変わったときに作り直さずに済む
+    std::vector<AffineMatrix> world_; //!< World行列
+    std::vector<uint8_t> localDirty_; //!< local_が変わってlocalMatrix_がまだ古い
+    std::vector<uint8_t> worldChanged_; //!< 直前のUpdateでworld_を計算し直した
+
+    std::vector<uint32_t> slotOfNode_; //!< ノードの番号から位置を引く
+    std::vector<uint32_t> depthBegin_; //!< 深さdのノードは[depthBegin_[d], depthBegin_[d + 1])にある
+    uint32_t depthCount_ = 0; //!< 深さの種類の数
+    bool sorted_ = true; //!< 深さ順に並んでいて、depthBegin_が正しい
+    uint32_t recomputedCount_ = 0; //!< 直前のUpdateで計算し直した行列の数
+};
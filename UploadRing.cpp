@@ -0,0 +1,51 @@
+#include "UploadRing.h"
+
+#include <cassert>
+
+void UploadRingAllocator::Initialize(uint64_t capacity)
+{
+    capacity_ = capacity;
+    head_ = 0;
+    tail_ = 0;
+    frameBegin_ = 0;
+    frames_.clear();
+}
+
+uint64_t UploadRingAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+    assert(alignment != 0 && (alignment & (alignment - 1)) == 0 && capacity_ % alignment == 0);
+    if (size == 0 || size > capacity_) {
+        return kInvalidOffset;
+    }
+
+    // capacity_はalignmentの倍数なので、増え続ける位置で境界に合わせればバッファ上の位置も境界に合う
+    uint64_t begin = (head_ + alignment - 1) & ~(alignment - 1);
+    uint64_t offset = begin % capacity_;
+    if (offset + size > capacity_) {
+        // 末尾に収まらないので残りを飛ばして先頭から切り出す
+        begin += capacity_ - offset;
+        offset = 0;
+    }
+    if (begin + size - tail_ > capacity_) {
+        return kInvalidOffset;
+    }
+    head_ = begin + size;
+    return offset;
+}
+
+void UploadRingAllocator::FinishFrame(uint64_t fenceValue)
+{
+    assert(frames_.empty() || frames_.back().fenceValue <= fenceValue);
+    if (head_ != frameBegin_) {
+        frames_.push_back({ head_, fenceValue });
+    }
+    frameBegin_ = head_;
+}
+
+void UploadRingAllocator::Retire(uint64_t completedFenceValue)
+{
+    while (!frames_.empty() && frames_.front().fenceValue <= completedFenceValue) {
+        tail_ = frames_.front().end;
+        frames_.pop_front();
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+
+/// <summary>
+/// ConstantBufferの置き場所の境界(D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT)
+/// </summary>
+constexpr uint64_t kConstantBufferAlignment = 256;
+
+/// <summary>
+/// 1つの大きなUploadバッファを、フレームごとの一時的なデータ用に先頭から順に切り出す(リングバッファ)
+/// 場所(バッファ先頭からのオフセット)の管理だけを行い、デバイスには触れない。DescriptorHeapの範囲も同じように切り出せる
+/// フレームの終わりにそのフレームのSignal値を渡しておき、GPUがその値に届いたらフレーム分をまとめて再利用する
+/// </summary>
+class UploadRingAllocator {
+public:
+    static constexpr uint64_t kInvalidOffset = UINT64_MAX;
+
+    /// <summary>
+    /// 管理するバッファのサイズを決めて空にする。capacityはAllocateに渡すalignmentの倍数
+    /// </summary>
+    void Initialize(uint64_t capacity);
+
+    /// <summary>
+    /// 今のフレーム用にsizeバイトを切り出し、バッファ先頭からのオフセットを返す。オフセットはalignmentの倍数
+    /// 領域は折り返さず、末尾に収まらなければ先頭から切り出す。GPUが使い終わっていない領域に重なるならkInvalidOffset
+    /// </summary>
+    uint64_t Allocate(uint64_t size, uint64_t alignment = kConstantBufferAlignment);
+
+    /// <summary>
+    /// 今のフレームで切り出した領域を、GPUがfenceValueに届くまで使うものとして閉じる
+    /// </summary>
+    void FinishFrame(uint64_t fenceValue);
+
+    /// <summary>
+    /// GPUがcompletedFenceValueまで届いたので、それまでに閉じたフレームの領域を再利用できるようにする
+    /// </summary>
+    void Retire(uint64_t completedFenceValue);
+
+    uint64_t GetCapacity() const { return capacity_; }
+
+    /// <summary>
+    /// GPUが使い終わっていない領域と今のフレームの領域のバイト数(折り返しで飛ばした末尾を含む)
+    /// </summary>
+    uint64_t GetUsedSize() const { return head_ - tail_; }
+
+    /// <summary>
+    /// 今のフレームで切り出したバイト数(境界合わせと折り返しで飛ばした分を含む)
+    /// </summary>
+    uint64_t GetFrameSize() const { return head_ - frameBegin_; }
+
+private:
+    /// <summary>
+    /// 閉じたフレームの領域。endまでをfenceValueに届いたら再利用する
+    /// </summary>
+    struct FrameSegment {
+        uint64_t end;
+        uint64_t fenceValue;
+    };
+
+    // head_, tail_, frameBegin_は折り返さずに増え続ける位置で、capacity_で割った余りがバッファ上の位置
+    uint64_t capacity_ = 0; //!< バッファのサイズ
+    uint64_t head_ = 0; //!< 次に切り出す位置
+    uint64_t tail_ = 0; //!< GPUが使っているかもしれない最も古い位置
+    uint64_t frameBegin_ = 0; //!< 今のフレームの最初の位置
+    std::deque<FrameSegment> frames_; //!< GPUが使い終わるのを待っているフレーム。古い順
+};
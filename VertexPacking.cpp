@@ -0,0 +1,372 @@
+#include "VertexPacking.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <emmintrin.h>
+
+namespace {
+
+constexpr float kUnorm16Max = 65535.0f;
+constexpr float kSnorm16Max = 32767.0f;
+
+/// <summary>
+/// maskが立っている要素はa、それ以外はbを選ぶ
+/// </summary>
+__m128i Select(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+__m128 Select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+__m128 Abs(__m128 value)
+{
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), value);
+}
+
+/// <summary>
+/// 4つのfloatをhalfに変換する。FloatToHalfと同じ手順で、結果も一致する
+/// </summary>
+__m128i FloatToHalf4(__m128 value)
+{
+    const __m128i signMask = _mm_set1_epi32(static_cast<int>(0x80000000u));
+    const __m128 denormalMagic = _mm_castsi128_ps(_mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23));
+
+    __m128i bits = _mm_castps_si128(value);
+    __m128i sign = _mm_and_si128(bits, signMask);
+    bits = _mm_xor_si128(bits, sign);
+
+    // halfで表せない大きさはInf、NaNはquiet NaNにする
+    __m128i isOverflow = _mm_cmpgt_epi32(bits, _mm_set1_epi32(((127 + 16) << 23) - 1));
+    __m128i isNan = _mm_cmpgt_epi32(bits, _mm_set1_epi32(255 << 23));
+    __m128i overflowResult = _mm_or_si128(_mm_set1_epi32(0x7C00), _mm_and_si128(isNan, _mm_set1_epi32(0x0200)));
+
+    // 非正規化数になるものは、加算の丸めに任せて仮数を合わせる
+    __m128i isSubnormal = _mm_cmplt_epi32(bits, _mm_set1_epi32(113 << 23));
+    __m128i subnormalResult = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(bits), denormalMagic)), _mm_castps_si128(denormalMagic));
+
+    // 正規化数は指数を付け替え、最近接偶数に丸めて仮数を切り詰める
+    __m128i mantissaOdd = _mm_and_si128(_mm_srli_epi32(bits, 13), _mm_set1_epi32(1));
+    __m128i normalResult = _mm_add_epi32(bits, _mm_set1_epi32(-(112 << 23) + 0xFFF));
+    normalResult = _mm_srli_epi32(_mm_add_epi32(normalResult, mantissaOdd), 13);
+
+    __m128i result = Select(isOverflow, overflowResult, Select(isSubnormal, subnormalResult, normalResult));
+    return _mm_or_si128(result, _mm_srli_epi32(sign, 16));
+}
+
+/// <summary>
+/// 0~65535のint32を4つuint16にして書く
+/// </summary>
+void StoreUint16(__m128i value, uint16_t output[4])
+{
+    // 符号付きの飽和パックしかないので、範囲をずらしてから戻す
+    const __m128i bias = _mm_set1_epi32(0x8000);
+    __m128i packed = _mm_packs_epi32(_mm_sub_epi32(value, bias), _mm_setzero_si128());
+    packed = _mm_xor_si128(packed, _mm_set1_epi16(static_cast<short>(0x8000)));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(output), packed);
+}
+
+void StoreInt16(__m128i value, int16_t output[4])
+{
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(output), _mm_packs_epi32(value, _mm_setzero_si128()));
+}
+
+/// <summary>
+/// 4頂点分を符号化した結果
+/// </summary>
+struct EncodedBatch {
+    uint16_t positions[3][4]; // 量子化した位置。成分ごと
+    uint16_t texcoords[2][4]; // half。成分ごと
+    int16_t normals[2][4]; // 八面体の法線。成分ごと
+};
+
+/// <summary>
+/// vertices[first]から4頂点を符号化する。足りない分は最後の頂点で埋める
+/// </summary>
+void EncodeBatch(const VertexData* vertices, size_t first, size_t count, const AABB& bounds, const float quantizeScale[3], bool quantize, EncodedBatch& batch)
+{
+    const VertexData* v[4];
+    for (size_t i = 0; i < 4; ++i) {
+        v[i] = &vertices[(std::min)(first + i, count - 1)];
+    }
+
+    // テクスチャ座標
+    __m128 u = _mm_setr_ps(v[0]->texcoord.x, v[1]->texcoord.x, v[2]->texcoord.x, v[3]->texcoord.x);
+    __m128 t = _mm_setr_ps(v[0]->texcoord.y, v[1]->texcoord.y, v[2]->texcoord.y, v[3]->texcoord.y);
+    StoreUint16(FloatToHalf4(u), batch.texcoords[0]);
+    StoreUint16(FloatToHalf4(t), batch.texcoords[1]);
+
+    // 法線を|x|+|y|+|z|=1の八面体に射影し、下半分は上に折り返す
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 minusOne = _mm_set1_ps(-1.0f);
+    __m128 nx = _mm_setr_ps(v[0]->normal.x, v[1]->normal.x, v[2]->normal.x, v[3]->normal.x);
+    __m128 ny = _mm_setr_ps(v[0]->normal.y, v[1]->normal.y, v[2]->normal.y, v[3]->normal.y);
+    __m128 nz = _mm_setr_ps(v[0]->normal.z, v[1]->normal.z, v[2]->normal.z, v[3]->normal.z);
+    __m128 length = _mm_add_ps(_mm_add_ps(Abs(nx), Abs(ny)), Abs(nz));
+    __m128 inverseLength = _mm_div_ps(one, _mm_max_ps(length, _mm_set1_ps(1e-20f)));
+    nx = _mm_mul_ps(nx, inverseLength);
+    ny = _mm_mul_ps(ny, inverseLength);
+    nz = _mm_mul_ps(nz, inverseLength);
+    __m128 signX = Select(_mm_cmpge_ps(nx, zero), one, minusOne);
+    __m128 signY = Select(_mm_cmpge_ps(ny, zero), one, minusOne);
+    __m128 foldedX = _mm_mul_ps(_mm_sub_ps(one, Abs(ny)), signX);
+    __m128 foldedY = _mm_mul_ps(_mm_sub_ps(one, Abs(nx)), signY);
+    __m128 isLower = _mm_cmplt_ps(nz, zero);
+    __m128 ox = Select(isLower, foldedX, nx);
+    __m128 oy = Select(isLower, foldedY, ny);
+    const __m128 snormScale = _mm_set1_ps(kSnorm16Max);
+    StoreInt16(_mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(ox, minusOne), one), snormScale)), batch.normals[0]);
+    StoreInt16(_mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(oy, minusOne), one), snormScale)), batch.normals[1]);
+
+    // 位置を範囲の中の0~65535にする
+    if (quantize) {
+        const float* minimum = &bounds.min.x;
+        const __m128 unormMax = _mm_set1_ps(kUnorm16Max);
+        for (int axis = 0; axis < 3; ++axis) {
+            const float* components[4] = { &v[0]->position.x, &v[1]->position.x, &v[2]->position.x, &v[3]->position.x };
+            __m128 p = _mm_setr_ps(components[0][axis], components[1][axis], components[2][axis], components[3][axis]);
+            __m128 q = _mm_mul_ps(_mm_sub_ps(p, _mm_set1_ps(minimum[axis])), _mm_set1_ps(quantizeScale[axis]));
+            q = _mm_min_ps(_mm_max_ps(q, zero), unormMax);
+            StoreUint16(_mm_cvtps_epi32(q), batch.positions[axis]);
+        }
+    }
+}
+
+float Length(const Vector3& v)
+{
+    return std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+}
+
+} // namespace
+
+uint32_t GetVertexStride(VertexFormat format)
+{
+    switch (format) {
+    case VertexFormat::PackedFloat3:
+        return sizeof(PackedVertex);
+    case VertexFormat::PackedQuantized:
+        return sizeof(QuantizedVertex);
+    default:
+        return sizeof(VertexData);
+    }
+}
+
+VertexFormat SelectVertexFormat(const ModelData& modelData, const VertexFormatSettings& settings)
+{
+    if (!settings.allowPacking || modelData.vertices.empty()) {
+        return VertexFormat::Float;
+    }
+
+    // halfの間隔は大きさが2倍になるごとに2倍になるので、最も大きいテクスチャ座標で誤差が決まる
+    float maxTexcoord = 0.0f;
+    for (const VertexData& vertex : modelData.vertices) {
+        maxTexcoord = (std::max)(maxTexcoord, (std::max)(std::abs(vertex.texcoord.x), std::abs(vertex.texcoord.y)));
+    }
+    if (!(maxTexcoord < 65504.0f)) {
+        return VertexFormat::Float;
+    }
+    int exponent = maxTexcoord > 0.0f ? std::ilogb(maxTexcoord) : -24;
+    float texcoordError = std::ldexp(0.5f, exponent - 10);
+    if (texcoordError > settings.maxTexcoordError) {
+        return VertexFormat::Float;
+    }
+
+    // 量子化の誤差は最も長い辺で決まる
+    const AABB& bounds = modelData.bounds;
+    float maxExtent = (std::max)({ bounds.max.x - bounds.min.x, bounds.max.y - bounds.min.y, bounds.max.z - bounds.min.z });
+    if (maxExtent / kUnorm16Max * 0.5f <= settings.maxPositionError) {
+        return VertexFormat::PackedQuantized;
+    }
+    return VertexFormat::PackedFloat3;
+}
+
+VertexDecode GetVertexDecode(VertexFormat format, const AABB& bounds)
+{
+    if (format != VertexFormat::PackedQuantized) {
+        return { { 0.0f, 0.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f, 0.0f } };
+    }
+    return {
+        { bounds.min.x, bounds.min.y, bounds.min.z, 0.0f },
+        { bounds.max.x - bounds.min.x, bounds.max.y - bounds.min.y, bounds.max.z - bounds.min.z, 0.0f },
+    };
+}
+
+void EncodeVertices(VertexFormat format, const VertexData* vertices, size_t count, const AABB& bounds, void* output)
+{
+    if (format == VertexFormat::Float) {
+        std::memcpy(output, vertices, sizeof(VertexData) * count);
+        return;
+    }
+
+    // 幅が0の軸は全部0にする
+    float quantizeScale[3];
+    const float* minimum = &bounds.min.x;
+    const float* maximum = &bounds.max.x;
+    for (int axis = 0; axis < 3; ++axis) {
+        float extent = maximum[axis] - minimum[axis];
+        quantizeScale[axis] = extent > 0.0f ? kUnorm16Max / extent : 0.0f;
+    }
+
+    bool quantize = format == VertexFormat::PackedQuantized;
+    EncodedBatch batch;
+    for (size_t first = 0; first < count; first += 4) {
+        EncodeBatch(vertices, first, count, bounds, quantizeScale, quantize, batch);
+        size_t batchCount = (std::min)(count - first, size_t(4));
+        for (size_t i = 0; i < batchCount; ++i) {
+            const VertexData& vertex = vertices[first + i];
+            if (quantize) {
+                QuantizedVertex& packed = static_cast<QuantizedVertex*>(output)[first + i];
+                packed.position[0] = batch.positions[0][i];
+                packed.position[1] = batch.positions[1][i];
+                packed.position[2] = batch.positions[2][i];
+                packed.position[3] = 0xFFFF;
+                packed.texcoord[0] = batch.texcoords[0][i];
+                packed.texcoord[1] = batch.texcoords[1][i];
+                packed.normal[0] = batch.normals[0][i];
+                packed.normal[1] = batch.normals[1][i];
+            } else {
+                PackedVertex& packed = static_cast<PackedVertex*>(output)[first + i];
+                packed.position[0] = vertex.position.x;
+                packed.position[1] = vertex.position.y;
+                packed.position[2] = vertex.position.z;
+                packed.texcoord[0] = batch.texcoords[0][i];
+                packed.texcoord[1] = batch.texcoords[1][i];
+                packed.normal[0] = batch.normals[0][i];
+                packed.normal[1] = batch.normals[1][i];
+            }
+        }
+    }
+}
+
+VertexData DecodeVertex(VertexFormat format, const void* encoded, const AABB& bounds)
+{
+    VertexData vertex{};
+    if (format == VertexFormat::Float) {
+        std::memcpy(&vertex, encoded, sizeof(vertex));
+        return vertex;
+    }
+
+    const uint16_t* texcoord;
+    const int16_t* normal;
+    if (format == VertexFormat::PackedQuantized) {
+        const QuantizedVertex& packed = *static_cast<const QuantizedVertex*>(encoded);
+        VertexDecode decode = GetVertexDecode(format, bounds);
+        vertex.position.x = decode.positionOffset.x + static_cast<float>(packed.position[0]) / kUnorm16Max * decode.positionScale.x;
+        vertex.position.y = decode.positionOffset.y + static_cast<float>(packed.position[1]) / kUnorm16Max * decode.positionScale.y;
+        vertex.position.z = decode.positionOffset.z + static_cast<float>(packed.position[2]) / kUnorm16Max * decode.positionScale.z;
+        texcoord = packed.texcoord;
+        normal = packed.normal;
+    } else {
+        const PackedVertex& packed = *static_cast<const PackedVertex*>(encoded);
+        vertex.position.x = packed.position[0];
+        vertex.position.y = packed.position[1];
+        vertex.position.z = packed.position[2];
+        texcoord = packed.texcoord;
+        normal = packed.normal;
+    }
+    vertex.position.w = 1.0f;
+    vertex.texcoord = { HalfToFloat(texcoord[0]), HalfToFloat(texcoord[1]) };
+
+    // VertexShaderと同じ手順で八面体から戻す
+    float x = (std::max)(static_cast<float>(normal[0]) / kSnorm16Max, -1.0f);
+    float y = (std::max)(static_cast<float>(normal[1]) / kSnorm16Max, -1.0f);
+    float z = 1.0f - std::abs(x) - std::abs(y);
+    float fold = (std::max)(-z, 0.0f);
+    x += x >= 0.0f ? -fold : fold;
+    y += y >= 0.0f ? -fold : fold;
+    float length = Length({ x, y, z });
+    vertex.normal = { x / length, y / length, z / length };
+    return vertex;
+}
+
+VertexEncodingError MeasureVertexEncodingError(VertexFormat format, const VertexData* vertices, size_t count, const AABB& bounds)
+{
+    VertexEncodingError error{};
+    if (count == 0) {
+        return error;
+    }
+
+    uint32_t stride = GetVertexStride(format);
+    std::vector<uint8_t> encoded(static_cast<size_t>(stride) * count);
+    EncodeVertices(format, vertices, count, bounds, encoded.data());
+    for (size_t i = 0; i < count; ++i) {
+        const VertexData& original = vertices[i];
+        VertexData decoded = DecodeVertex(format, encoded.data() + stride * i, bounds);
+        error.position = (std::max)({ error.position,
+            std::abs(decoded.position.x - original.position.x),
+            std::abs(decoded.position.y - original.position.y),
+            std::abs(decoded.position.z - original.position.z) });
+        error.texcoord = (std::max)({ error.texcoord,
+            std::abs(decoded.texcoord.x - original.texcoord.x),
+            std::abs(decoded.texcoord.y - original.texcoord.y) });
+
+        // 長さ0の法線は向きを持たないので比べない
+        float length = Length(original.normal);
+        if (length > 0.0f) {
+            float cosine = (decoded.normal.x * original.normal.x + decoded.normal.y * original.normal.y + decoded.normal.z * original.normal.z) / length;
+            error.normalAngle = (std::max)(error.normalAngle, std::acos((std::min)(cosine, 1.0f)));
+        }
+    }
+    return error;
+}
+
+uint16_t FloatToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+
+    uint32_t result;
+    if (bits >= ((127u + 16u) << 23)) {
+        // halfで表せない大きさはInf、NaNはquiet NaNにする
+        result = bits > (255u << 23) ? 0x7E00u : 0x7C00u;
+    } else if (bits < (113u << 23)) {
+        // 非正規化数になるものは、加算の丸めに任せて仮数を合わせる
+        const uint32_t denormalMagicBits = ((127 - 15) + (23 - 10) + 1) << 23;
+        float denormalMagic;
+        std::memcpy(&denormalMagic, &denormalMagicBits, sizeof(denormalMagic));
+        float absolute;
+        std::memcpy(&absolute, &bits, sizeof(absolute));
+        absolute += denormalMagic;
+        std::memcpy(&result, &absolute, sizeof(result));
+        result -= denormalMagicBits;
+    } else {
+        // 指数を付け替え、最近接偶数に丸めて仮数を切り詰める
+        uint32_t mantissaOdd = (bits >> 13) & 1;
+        bits += (static_cast<uint32_t>(15 - 127) << 23) + 0xFFF;
+        bits += mantissaOdd;
+        result = bits >> 13;
+    }
+    return static_cast<uint16_t>(result | (sign >> 16));
+}
+
+float HalfToFloat(uint16_t value)
+{
+    uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1F;
+    uint32_t mantissa = value & 0x3FF;
+
+    float result;
+    if (exponent == 0) {
+        // 非正規化数
+        result = std::ldexp(static_cast<float>(mantissa), -24);
+    } else if (exponent == 31) {
+        uint32_t bits = 0x7F800000u | (mantissa << 13);
+        std::memcpy(&result, &bits, sizeof(result));
+    } else {
+        uint32_t bits = ((exponent + 127 - 15) << 23) | (mantissa << 13);
+        std::memcpy(&result, &bits, sizeof(result));
+    }
+    uint32_t bits;
+    std::memcpy(&bits, &result, sizeof(bits));
+    bits |= sign;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "ObjLoader.h"
+
+/// <summary>
+/// VertexFormat::PackedFloat3の1頂点(20byte)
+/// </summary>
+struct PackedVertex {
+    float position[3]; // 位置
+    uint16_t texcoord[2]; // half
+    int16_t normal[2]; // 八面体に展開した法線(snorm16)
+};
+
+/// <summary>
+/// VertexFormat::PackedQuantizedの1頂点(16byte)
+/// </summary>
+struct QuantizedVertex {
+    uint16_t position[4]; // ModelData::boundsの中での位置(unorm16)。wは常に65535
+    uint16_t texcoord[2]; // half
+    int16_t normal[2]; // 八面体に展開した法線(snorm16)
+};
+
+/// <summary>
+/// VertexShaderで量子化した位置を戻すための値。position = positionOffset + 量子化した値(0~1) * positionScale
+/// </summary>
+struct VertexDecode {
+    Vector4 positionOffset;
+    Vector4 positionScale;
+};
+
+/// <summary>
+/// 頂点形式を選ぶときに許す誤差
+/// </summary>
+struct VertexFormatSettings {
+    bool allowPacking = true; // falseなら常にVertexFormat::Float
+    float maxPositionError = 1.0f / 4096.0f; // 位置の量子化で許す誤差
+    float maxTexcoordError = 1.0f / 2048.0f; // テクスチャ座標をhalfにして許す誤差
+};
+
+/// <summary>
+/// 符号化した頂点を戻したときの最大の誤差
+/// </summary>
+struct VertexEncodingError {
+    float position; // 位置の各成分の誤差
+    float texcoord; // テクスチャ座標の各成分の誤差
+    float normalAngle; // 法線の向きの誤差(ラジアン)
+};
+
+/// <summary>
+/// 1頂点のバイト数
+/// </summary>
+uint32_t GetVertexStride(VertexFormat format);
+
+/// <summary>
+/// 許す誤差に収まる中で最も小さい頂点形式を選ぶ
+/// </summary>
+VertexFormat SelectVertexFormat(const ModelData& modelData, const VertexFormatSettings& settings = {});
+
+/// <summary>
+/// VertexShaderに渡す、量子化した位置の戻し方
+/// </summary>
+VertexDecode GetVertexDecode(VertexFormat format, const AABB& bounds);
+
+/// <summary>
+/// 頂点をformatに符号化してoutputに書く。outputにはGetVertexStride(format) * count byte必要
+/// 4頂点ずつSSE2でまとめて変換する
+/// </summary>
+void EncodeVertices(VertexFormat format, const VertexData* vertices, size_t count, const AABB& bounds, void* output);
+
+/// <summary>
+/// 符号化した1頂点を戻す
+/// </summary>
+VertexData DecodeVertex(VertexFormat format, const void* encoded, const AABB& bounds);
+
+/// <summary>
+/// 符号化して戻したときの誤差を求める
+/// </summary>
+VertexEncodingError MeasureVertexEncodingError(VertexFormat format, const VertexData* vertices, size_t count, const AABB& bounds);
+
+/// <summary>
+/// floatをhalfに変換する(最近接偶数丸め)
+/// </summary>
+uint16_t FloatToHalf(float value);
+
+/// <summary>
+/// halfをfloatに変換する
+/// </summary>
+float HalfToFloat(uint16_t value);
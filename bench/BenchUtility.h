@@ -0,0 +1,55 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+/// <summary>
+/// ベンチマークで使う時間計測と、結果の先頭に書く環境の情報
+/// </summary>
+namespace BenchUtility {
+
+/// <summary>
+/// funcを1回実行した時間(ミリ秒)
+/// </summary>
+template<typename Func>
+double MeasureMilliseconds(const Func& func)
+{
+    auto start = std::chrono::steady_clock::now();
+    func();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+/// <summary>
+/// funcをrepeatCount回実行したうち最も短い時間(ミリ秒)
+/// </summary>
+template<typename Func>
+double MeasureBestMilliseconds(int repeatCount, const Func& func)
+{
+    double best = MeasureMilliseconds(func);
+    for (int i = 1; i < repeatCount; ++i) {
+        double elapsed = MeasureMilliseconds(func);
+        best = elapsed < best ? elapsed : best;
+    }
+    return best;
+}
+
+/// <summary>
+/// 結果を比べるときに必要な環境(コンパイラ、論理コア数)を書く
+/// </summary>
+inline void PrintEnvironment(const char* benchName)
+{
+#if defined(_MSC_VER)
+    std::string compiler = "MSVC " + std::to_string(_MSC_VER);
+#elif defined(__clang__)
+    std::string compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+    std::string compiler = "gcc " __VERSION__;
+#else
+    std::string compiler = "unknown";
+#endif
+    std::printf("# %s\n# compiler: %s, logical cores: %u\n", benchName, compiler.c_str(), std::thread::hardware_concurrency());
+}
+
+} // namespace BenchUtility
@@ -0,0 +1,48 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "BenchUtility.h"
+#include "FrustumCulling.h"
+#include "MatrixSimd.h"
+#include "SyntheticBounds.h"
+
+// 使い方 : FrustumCullingBench [オブジェクト数...]  既定は10万、100万
+// 命令セットごとにCullObjectsの時間を測り、10万オブジェクトあたりのミリ秒と1オブジェクトあたりのナノ秒を出す
+int main(int argc, char** argv)
+{
+    std::vector<size_t> objectCounts;
+    for (int i = 1; i < argc; ++i) {
+        objectCounts.push_back(std::strtoull(argv[i], nullptr, 10));
+    }
+    if (objectCounts.empty()) {
+        objectCounts = { 100000, 1000000 };
+    }
+
+    BenchUtility::PrintEnvironment("FrustumCullingBench");
+    std::printf("# supported: %s\n", GetSimdLevelName(GetSupportedSimdLevel()));
+    std::printf("%10s %-8s %10s %14s %10s %8s\n", "objects", "level", "visible", "ms per 100k", "ns/object", "speedup");
+    Frustum frustum = MakeSyntheticFrustum();
+    const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::Sse41, SimdLevel::Avx2 };
+    for (size_t objectCount : objectCounts) {
+        CullingBoundsSoA bounds = MakeSyntheticBounds(objectCount, frustum, 1, 16);
+        std::vector<uint32_t> visibleIndices;
+        double scalarTime = 0.0;
+        for (SimdLevel level : levels) {
+            SetSimdLevel(level);
+            if (GetSimdLevel() != level) {
+                continue;
+            }
+            uint32_t visibleCount = 0;
+            double time = BenchUtility::MeasureBestMilliseconds(20, [&]() {
+                visibleCount = CullObjects(bounds, frustum, visibleIndices);
+            });
+            if (level == SimdLevel::Scalar) {
+                scalarTime = time;
+            }
+            std::printf("%10zu %-8s %10u %14.3f %10.2f %7.2fx\n", objectCount, GetSimdLevelName(level), visibleCount,
+                time * 100000.0 / static_cast<double>(objectCount), time * 1.0e6 / static_cast<double>(objectCount), scalarTime / time);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "BenchUtility.h"
+#include "MathFunctions.h"
+
+namespace {
+
+// 最適化で計算が消えないように、結果をここに足し込む
+volatile float gSink = 0.0f;
+
+constexpr size_t kInputCount = 1024;
+constexpr int kRepeatCount = 200;
+
+/// <summary>
+/// 1回あたりのナノ秒。kRepeatCount回のうち最も短い時間から求める
+/// </summary>
+template<typename Func>
+double MeasureNanosecondsPerOp(const Func& func)
+{
+    double milliseconds = BenchUtility::MeasureBestMilliseconds(kRepeatCount, func);
+    return milliseconds * 1.0e6 / static_cast<double>(kInputCount);
+}
+
+void PrintRow(const char* name, double nanoseconds)
+{
+    std::printf("%-26s %10.2f %12.1f\n", name, nanoseconds, 1000.0 / nanoseconds);
+}
+
+} // namespace
+
+// 使い方 : MathBench
+// MathFunctionsの関数ごとに、1回あたりの時間(ns/op)と1秒あたりの回数(Mop/s)を出す
+// 精度はtests/MathAccuracyTest.cppで測る
+int main()
+{
+    BenchUtility::PrintEnvironment("MathBench");
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> angle(-3.14159265f, 3.14159265f);
+    std::vector<Matrix4x4> matrices(kInputCount);
+    for (Matrix4x4& matrix : matrices) {
+        for (int row = 0; row < 4; ++row) {
+            for (int column = 0; column < 4; ++column) {
+                matrix.m[row][column] = distribution(random) + (row == column ? 4.0f : 0.0f);
+            }
+        }
+    }
+    std::vector<Vector3> vectors(kInputCount);
+    for (Vector3& v : vectors) {
+        v = { distribution(random), distribution(random), distribution(random) };
+    }
+    std::vector<Vector3> angles(kInputCount);
+    for (Vector3& v : angles) {
+        v = { angle(random), angle(random), angle(random) };
+    }
+
+    std::printf("%-26s %10s %12s\n", "function", "ns/op", "Mop/s");
+    PrintRow("Multiply", MeasureNanosecondsPerOp([&]() {
+        float sum = 0.0f;
+        for (size_t i = 0; i < kInputCount; ++i) {
+            sum += Multiply(matrices[i], matrices[(i + 1) % kInputCount]).m[3][3];
+        }
+        gSink = gSink + sum;
+    }));
+    PrintRow("Inverse", MeasureNanosecondsPerOp([&]() {
+        float sum = 0.0f;
+        for (size_t i = 0; i < kInputCount; ++i) {
+            sum += Inverse(matrices[i]).m[0][0];
+        }
+        gSink = gSink + sum;
+    }));
+    PrintRow("Transpose", MeasureNanosecondsPerOp([&]() {
+        float sum = 0.0f;
+        for (size_t i = 0; i < kInputCount; ++i) {
+            sum += Transpose(matrices[i]).m[1][2];
+        }
+        gSink = gSink + sum;
+    }));
+    PrintRow("MakeAffineMatrix", MeasureNanosecondsPerOp([&]() {
+        float sum = 0.0f;
+        for (size_t i = 0; i < kInputCount; ++i) {
+            sum += MakeAffineMatrix(vectors[i], angles[i], vectors[(i + 1) % kInputCount]).m[1][1];
+        }
+        gSink = gSink + sum;
+    }));
+    PrintRow("MakePerspectiveFovMatrix", MeasureNanosecondsPerOp([&]() {
+        float sum = 0.0f;
+        for (size_t i = 0; i < kInputCount; ++i) {
+            // 視野角は0.5から1.5ラジアン、アスペクト比は1から2
+            sum += MakePerspectiveFovMatrix(1.0f + vectors[i].x * 0.5f, 1.5f + vectors[i].y * 0.5f, 0.1f, 100.0f).m[0][0];
+        }
+        gSink = gSink + sum;
+    }));
+    PrintRow("Normalize", MeasureNanosecondsPerOp([&]() {
+        float sum = 0.0f;
+        for (size_t i = 0; i < kInputCount; ++i) {
+            sum += Normalize(vectors[i]).x;
+        }
+        gSink = gSink + sum;
+    }));
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "BenchUtility.h"
+#include "MathFunctions.h"
+#include "MatrixSimd.h"
+
+namespace {
+
+// 最適化で計算が消えないように、結果をここに足し込む
+volatile float gSink = 0.0f;
+
+constexpr size_t kMatrixCount = 1024;
+constexpr size_t kVectorCount = 1 << 16;
+constexpr int kRepeatCount = 200;
+
+/// <summary>
+/// 1回あたりのナノ秒。kRepeatCount回のうち最も短い時間から求める
+/// </summary>
+template<typename Func>
+double MeasureNanosecondsPerOp(size_t opCount, const Func& func)
+{
+    double milliseconds = BenchUtility::MeasureBestMilliseconds(kRepeatCount, func);
+    return milliseconds * 1.0e6 / static_cast<double>(opCount);
+}
+
+void PrintRow(const char* name, const char* level, double nanoseconds, double scalarNanoseconds)
+{
+    std::printf("%-18s %-8s %10.2f %12.1f %8.2fx\n", name, level, nanoseconds, 1000.0 / nanoseconds, scalarNanoseconds / nanoseconds);
+}
+
+} // namespace
+
+// 使い方 : MatrixSimdBench
+// MathFunctionsの行列関数と、MatrixSimdの各命令セットの関数で、1回あたりの時間(ns/op)と1秒あたりの回数(Mop/s)を比べる
+// 倍率はMathFunctionsの関数に対する速さ
+int main()
+{
+    BenchUtility::PrintEnvironment("MatrixSimdBench");
+    std::printf("# supported: %s\n", GetSimdLevelName(GetSupportedSimdLevel()));
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    std::vector<Matrix4x4> matrices(kMatrixCount);
+    for (Matrix4x4& matrix : matrices) {
+        for (int row = 0; row < 4; ++row) {
+            for (int column = 0; column < 4; ++column) {
+                matrix.m[row][column] = distribution(random) + (row == column ? 4.0f : 0.0f);
+            }
+        }
+    }
+    std::vector<Matrix4x4A> alignedMatrices(kMatrixCount);
+    for (size_t i = 0; i < kMatrixCount; ++i) {
+        alignedMatrices[i] = ToMatrix4x4A(matrices[i]);
+    }
+    std::vector<Vector4> vectors(kVectorCount);
+    for (Vector4& v : vectors) {
+        v = { distribution(random), distribution(random), distribution(random), 1.0f };
+    }
+    std::vector<Vector4> transformed(kVectorCount);
+
+    std::printf("%-18s %-8s %10s %12s %9s\n", "function", "level", "ns/op", "Mop/s", "speedup");
+
+    double multiplyScalar = MeasureNanosecondsPerOp(kMatrixCount, [&]() {
+        float sum = 0.0f;
+        for (size_t i = 0; i < kMatrixCount; ++i) {
+            sum += Multiply(matrices[i], matrices[(i + 1) % kMatrixCount]).m[3][3];
+        }
+        gSink = gSink + sum;
+    });
+    double transposeScalar = MeasureNanosecondsPerOp(kMatrixCount, [&]() {
+        float sum = 0.0f;
+        for (size_t i = 0; i < kMatrixCount; ++i) {
+            sum += Transpose(matrices[i]).m[1][2];
+        }
+        gSink = gSink + sum;
+    });
+    double inverseScalar = MeasureNanosecondsPerOp(kMatrixCount, [&]() {
+        float sum = 0.0f;
+        for (size_t i = 0; i < kMatrixCount; ++i) {
+            sum += Inverse(matrices[i]).m[3][3];
+        }
+        gSink = gSink + sum;
+    });
+    // MathFunctionsにはベクトルの変換がないので、行ベクトルの積をその場で書いたものを基準にする
+    double transformScalar = MeasureNanosecondsPerOp(kVectorCount, [&]() {
+        const Matrix4x4& m = matrices[0];
+        for (size_t i = 0; i < kVectorCount; ++i) {
+            const Vector4& v = vectors[i];
+            transformed[i] = {
+                v.x * m.m[0][0] + v.y * m.m[1][0] + v.z * m.m[2][0] + v.w * m.m[3][0],
+                v.x * m.m[0][1] + v.y * m.m[1][1] + v.z * m.m[2][1] + v.w * m.m[3][1],
+                v.x * m.m[0][2] + v.y * m.m[1][2] + v.z * m.m[2][2] + v.w * m.m[3][2],
+                v.x * m.m[0][3] + v.y * m.m[1][3] + v.z * m.m[2][3] + v.w * m.m[3][3],
+            };
+        }
+        gSink = gSink + transformed[kVectorCount / 2].x;
+    });
+    PrintRow("Multiply", "Math", multiplyScalar, multiplyScalar);
+    PrintRow("Transpose", "Math", transposeScalar, transposeScalar);
+    PrintRow("Inverse", "Math", inverseScalar, inverseScalar);
+    PrintRow("TransformVectors", "loop", transformScalar, transformScalar);
+
+    const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::Sse41, SimdLevel::Avx2 };
+    for (SimdLevel level : levels) {
+        SetSimdLevel(level);
+        if (GetSimdLevel() != level) {
+            continue;
+        }
+        const char* levelName = GetSimdLevelName(level);
+        PrintRow("Multiply", levelName, MeasureNanosecondsPerOp(kMatrixCount, [&]() {
+            float sum = 0.0f;
+            for (size_t i = 0; i < kMatrixCount; ++i) {
+                sum += Multiply(alignedMatrices[i], alignedMatrices[(i + 1) % kMatrixCount]).m[3][3];
+            }
+            gSink = gSink + sum;
+        }), multiplyScalar);
+        PrintRow("Transpose", levelName, MeasureNanosecondsPerOp(kMatrixCount, [&]() {
+            float sum = 0.0f;
+            for (size_t i = 0; i < kMatrixCount; ++i) {
+                sum += Transpose(alignedMatrices[i]).m[1][2];
+            }
+            gSink = gSink + sum;
+        }), transposeScalar);
+        PrintRow("Inverse", levelName, MeasureNanosecondsPerOp(kMatrixCount, [&]() {
+            float sum = 0.0f;
+            for (size_t i = 0; i < kMatrixCount; ++i) {
+                sum += Inverse(alignedMatrices[i]).m[3][3];
+            }
+            gSink = gSink + sum;
+        }), inverseScalar);
+        PrintRow("TransformVectors", levelName, MeasureNanosecondsPerOp(kVectorCount, [&]() {
+            TransformVectors(vectors.data(), transformed.data(), kVectorCount, alignedMatrices[0]);
+            gSink = gSink + transformed[kVectorCount / 2].x;
+        }), transformScalar);
+    }
+    return 0;
+}
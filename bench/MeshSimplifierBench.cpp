@@ -0,0 +1,119 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "BenchUtility.h"
+#include "MeshSimplifier.h"
+#include "ObjLoader.h"
+
+namespace {
+
+/// <summary>
+/// LOD1つ分の簡略化の結果
+/// </summary>
+struct LodResult {
+    std::vector<uint32_t> indices;
+    std::vector<uint32_t> triangleMaterials;
+    float error; // 前のLODからのずれ
+    double milliseconds;
+};
+
+/// <summary>
+/// (quadCount x quadCount)の格子を三角形2つずつに分けた、なだらかな起伏のある面
+/// マテリアルは横にmaterialCount本の帯に分け、帯の境目は簡略化で動かない頂点になる
+/// </summary>
+void MakeGrid(uint32_t quadCount, uint32_t materialCount, std::vector<VertexData>& vertices, std::vector<uint32_t>& indices, std::vector<uint32_t>& triangleMaterials)
+{
+    uint32_t rowVertexCount = quadCount + 1;
+    vertices.clear();
+    vertices.reserve(static_cast<size_t>(rowVertexCount) * rowVertexCount);
+    for (uint32_t y = 0; y < rowVertexCount; ++y) {
+        for (uint32_t x = 0; x < rowVertexCount; ++x) {
+            float u = static_cast<float>(x) / static_cast<float>(quadCount);
+            float v = static_cast<float>(y) / static_cast<float>(quadCount);
+            // 高さ h = 0.05 * sin(4πu) * cos(3πv) の傾きから法線を求める
+            float pi = 3.14159265f;
+            float height = 0.05f * std::sin(4.0f * pi * u) * std::cos(3.0f * pi * v);
+            float slopeU = 0.05f * 4.0f * pi * std::cos(4.0f * pi * u) * std::cos(3.0f * pi * v);
+            float slopeV = -0.05f * 3.0f * pi * std::sin(4.0f * pi * u) * std::sin(3.0f * pi * v);
+            float length = std::sqrt(slopeU * slopeU + slopeV * slopeV + 1.0f);
+            vertices.push_back({ { u, v, height, 1.0f }, { u, v }, { -slopeU / length, -slopeV / length, 1.0f / length } });
+        }
+    }
+
+    size_t triangleCount = static_cast<size_t>(quadCount) * quadCount * 2;
+    indices.clear();
+    indices.reserve(triangleCount * 3);
+    triangleMaterials.clear();
+    triangleMaterials.reserve(triangleCount);
+    for (uint32_t y = 0; y < quadCount; ++y) {
+        uint32_t material = static_cast<uint32_t>(static_cast<uint64_t>(y) * materialCount / quadCount);
+        for (uint32_t x = 0; x < quadCount; ++x) {
+            uint32_t v00 = y * rowVertexCount + x;
+            uint32_t v10 = v00 + 1;
+            uint32_t v01 = v00 + rowVertexCount;
+            uint32_t v11 = v01 + 1;
+            indices.insert(indices.end(), { v00, v10, v11, v00, v11, v01 });
+            triangleMaterials.insert(triangleMaterials.end(), 2, material);
+        }
+    }
+}
+
+/// <summary>
+/// GenerateLodsと同じく、各LODを1つ前のLODから作る。LODごとにSimplifyMeshの時間を測る
+/// </summary>
+std::vector<LodResult> SimplifyLods(const std::vector<VertexData>& vertices, const std::vector<uint32_t>& indices, const std::vector<uint32_t>& triangleMaterials, const std::vector<float>& ratios)
+{
+    std::vector<LodResult> results;
+    std::vector<uint32_t> currentIndices = indices;
+    std::vector<uint32_t> currentMaterials = triangleMaterials;
+    size_t baseTriangleCount = triangleMaterials.size();
+    for (float ratio : ratios) {
+        size_t targetTriangleCount = static_cast<size_t>(static_cast<double>(baseTriangleCount) * ratio);
+        LodResult result{};
+        result.milliseconds = BenchUtility::MeasureMilliseconds([&]() {
+            result.error = SimplifyMesh(vertices, currentIndices, currentMaterials, targetTriangleCount);
+        });
+        result.indices = currentIndices;
+        result.triangleMaterials = currentMaterials;
+        results.push_back(std::move(result));
+    }
+    return results;
+}
+
+} // namespace
+
+// 使い方 : MeshSimplifierBench [格子の一辺の四角形の数]  既定は708(三角形約100万)
+// 合成の格子をLOD0の50%、25%、12.5%まで順に簡略化し、LODごとの時間(ms)とずれを出す
+// 同じ入力から2回作り、Index、マテリアル、ずれが全て一致すること(同じ入力から同じ結果)を確かめる。一致しなければ1を返す
+int main(int argc, char** argv)
+{
+    uint32_t quadCount = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 708;
+    constexpr uint32_t kMaterialCount = 4;
+    BenchUtility::PrintEnvironment("MeshSimplifierBench");
+
+    std::vector<VertexData> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<uint32_t> triangleMaterials;
+    MakeGrid(quadCount, kMaterialCount, vertices, indices, triangleMaterials);
+    std::printf("# grid %ux%u, vertices %zu, triangles %zu, materials %u\n", quadCount, quadCount, vertices.size(), triangleMaterials.size(), kMaterialCount);
+
+    const std::vector<float> ratios = LodSettings{}.triangleRatios;
+    std::vector<LodResult> first = SimplifyLods(vertices, indices, triangleMaterials, ratios);
+    std::vector<LodResult> second = SimplifyLods(vertices, indices, triangleMaterials, ratios);
+
+    bool identical = first.size() == second.size();
+    std::printf("%-5s %7s %10s %10s %12s %12s %10s\n", "lod", "ratio", "target", "triangles", "ms (run 1)", "ms (run 2)", "error");
+    for (size_t level = 0; level < first.size() && level < second.size(); ++level) {
+        const LodResult& a = first[level];
+        const LodResult& b = second[level];
+        // ずれも浮動小数点のまま一致すること
+        identical = identical && a.indices == b.indices && a.triangleMaterials == b.triangleMaterials && a.error == b.error;
+        size_t targetTriangleCount = static_cast<size_t>(static_cast<double>(triangleMaterials.size()) * ratios[level]);
+        std::printf("LOD%-2zu %6.1f%% %10zu %10zu %12.1f %12.1f %10.3g\n", level + 1, ratios[level] * 100.0f, targetTriangleCount, a.triangleMaterials.size(),
+            a.milliseconds, b.milliseconds, a.error);
+    }
+    std::printf("deterministic: %s\n", identical ? "yes" : "NO");
+    return identical ? 0 : 1;
+}
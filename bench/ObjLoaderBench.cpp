@@ -0,0 +1,74 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "BenchUtility.h"
+#include "ObjLoader.h"
+#include "ReferenceObjLoader.h"
+#include "SyntheticObj.h"
+
+// 使い方 : ObjLoaderBench [--max-threads=N] [面の数...]  既定は100万面と1000万面、Nは論理コア数と8の大きい方
+// 合成したOBJファイルを、置き換える前の読み込み(LoadObjFileReference)とLoadObjFileで読み、時間を比べる
+// 続けて、最も大きいファイルをLoadObjFileで1からNスレッドまで読み、スレッド数ごとの速さを出す
+int main(int argc, char** argv)
+{
+    std::vector<uint64_t> faceCounts;
+    uint32_t maxThreadCount = (std::max)(GetDefaultObjLoadThreadCount(), 8u);
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--max-threads=", 14) == 0) {
+            maxThreadCount = static_cast<uint32_t>((std::max)(1, std::atoi(argv[i] + 14)));
+        } else {
+            faceCounts.push_back(std::strtoull(argv[i], nullptr, 10));
+        }
+    }
+    if (faceCounts.empty()) {
+        faceCounts = { 1000000, 10000000 };
+    }
+
+    BenchUtility::PrintEnvironment("ObjLoaderBench");
+    std::printf("%10s %10s %14s %14s %8s %12s %6s\n", "faces", "file MB", "reference ms", "LoadObj ms", "speedup", "LoadObj MB/s", "same");
+    std::filesystem::path directory = GetTestDataDirectory();
+    for (uint64_t faceCount : faceCounts) {
+        std::string filename = "bench_" + std::to_string(faceCount) + ".obj";
+        if (!std::filesystem::exists(directory / filename) && !WriteSyntheticObj(directory / filename, faceCount)) {
+            std::printf("failed to write %s\n", filename.c_str());
+            return 1;
+        }
+        double fileMegabytes = static_cast<double>(std::filesystem::file_size(directory / filename)) / (1024.0 * 1024.0);
+
+        // 1回目はファイルをページキャッシュに載せるため、どちらも2回ずつ読んで短い方をとる
+        std::vector<VertexData> referenceVertices;
+        double referenceTime = BenchUtility::MeasureBestMilliseconds(2, [&]() {
+            referenceVertices = LoadObjFileReference(directory.string(), filename);
+        });
+        ModelData model;
+        double loadTime = BenchUtility::MeasureBestMilliseconds(2, [&]() {
+            model = LoadObjFile(directory.string(), filename, 1);
+        });
+        std::vector<VertexData> expanded = ExpandModelVertices(model);
+        bool same = expanded.size() == referenceVertices.size() &&
+            std::memcmp(expanded.data(), referenceVertices.data(), expanded.size() * sizeof(VertexData)) == 0;
+
+        std::printf("%10llu %10.1f %14.1f %14.1f %7.1fx %12.1f %6s\n", static_cast<unsigned long long>(faceCount), fileMegabytes,
+            referenceTime, loadTime, referenceTime / loadTime, fileMegabytes / (loadTime / 1000.0), same ? "yes" : "NO");
+    }
+
+    // スレッド数ごとの速さ。論理コア数を超えた分は同じコアを取り合うので、そこから先は伸びない
+    uint64_t scalingFaceCount = faceCounts.back();
+    std::string scalingFilename = "bench_" + std::to_string(scalingFaceCount) + ".obj";
+    double scalingMegabytes = static_cast<double>(std::filesystem::file_size(directory / scalingFilename)) / (1024.0 * 1024.0);
+    std::printf("\n# thread scaling, %llu faces\n", static_cast<unsigned long long>(scalingFaceCount));
+    std::printf("%8s %12s %10s %8s\n", "threads", "LoadObj ms", "MB/s", "scaling");
+    double singleThreadTime = 0.0;
+    for (uint32_t threadCount = 1; threadCount <= maxThreadCount; threadCount *= 2) {
+        double loadTime = BenchUtility::MeasureBestMilliseconds(2, [&]() {
+            LoadObjFile(directory.string(), scalingFilename, threadCount);
+        });
+        if (threadCount == 1) {
+            singleThreadTime = loadTime;
+        }
+        std::printf("%8u %12.1f %10.1f %7.2fx\n", threadCount, loadTime, scalingMegabytes / (loadTime / 1000.0), singleThreadTime / loadTime);
+    }
+    return 0;
+}
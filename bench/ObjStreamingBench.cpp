@@ -0,0 +1,104 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "BenchUtility.h"
+#include "MeshCache.h"
+#include "ObjLoader.h"
+#include "ObjStreamingImport.h"
+#include "SyntheticObj.h"
+
+namespace {
+
+/// <summary>
+/// 読み方
+/// </summary>
+enum class LoadPath {
+    LoadObjFile, // ファイル全体をメモリに読む
+    LoadModel, // LoadObjFileに加えてLOD、最適化、メッシュレットを作ってキャッシュを書く
+    Streaming, // LoadModelがImportObjFileStreamingでキャッシュを書き、それを読む
+};
+
+const char* const kLoadPathNames[] = { "LoadObjFile", "LoadModel", "streaming" };
+
+/// <summary>
+/// 1つの読み方を測って1行書く。プロセスの最大メモリは減らないので、読み方ごとに別のプロセスで呼ぶ
+/// </summary>
+int RunChild(LoadPath path, uint64_t faceCount)
+{
+    std::filesystem::path directory = GetTestDataDirectory();
+    std::string filename = "streaming_bench_" + std::to_string(faceCount) + ".obj";
+    std::filesystem::path cachePath = directory / (filename + ".cmesh");
+    std::filesystem::remove(cachePath);
+    double fileMegabytes = static_cast<double>(std::filesystem::file_size(directory / filename)) / (1024.0 * 1024.0);
+    double startMegabytes = static_cast<double>(GetPeakProcessMemory()) / (1024.0 * 1024.0);
+
+    size_t indexCount = 0;
+    double time = BenchUtility::MeasureMilliseconds([&]() {
+        ModelImportSettings settings;
+        switch (path) {
+        case LoadPath::LoadObjFile:
+            indexCount = LoadObjFile(directory.string(), filename, 1).indices.size();
+            break;
+        case LoadPath::LoadModel:
+            settings.streamingFileSize = UINT64_MAX;
+            indexCount = LoadModel(directory.string(), filename, 1, nullptr, settings).indices.size();
+            break;
+        case LoadPath::Streaming:
+            settings.streamingFileSize = 0;
+            indexCount = LoadModel(directory.string(), filename, 1, nullptr, settings).indices.size();
+            break;
+        }
+    });
+    double peakMegabytes = static_cast<double>(GetPeakProcessMemory()) / (1024.0 * 1024.0);
+    std::filesystem::remove(cachePath);
+    std::printf("%10llu %10.1f %-12s %12.1f %14.1f %14.2f %12zu\n", static_cast<unsigned long long>(faceCount), fileMegabytes,
+        kLoadPathNames[static_cast<int>(path)], time, peakMegabytes - startMegabytes, (peakMegabytes - startMegabytes) / fileMegabytes, indexCount);
+    std::fflush(stdout);
+    return 0;
+}
+
+} // namespace
+
+// 使い方 : ObjStreamingBench [面の数...]  既定は25万、100万、400万
+// 合成したOBJファイルを読み方ごとに別のプロセスで読み、読み込み中に増えたプロセスの物理メモリの最大(peak MB)とファイルの大きさを比べる
+// 子プロセスとしては ObjStreamingBench --child <読み方の番号> <面の数> で呼ばれる
+int main(int argc, char** argv)
+{
+    if (argc == 4 && std::strcmp(argv[1], "--child") == 0) {
+        return RunChild(static_cast<LoadPath>(std::atoi(argv[2])), std::strtoull(argv[3], nullptr, 10));
+    }
+
+    std::vector<uint64_t> faceCounts;
+    for (int i = 1; i < argc; ++i) {
+        faceCounts.push_back(std::strtoull(argv[i], nullptr, 10));
+    }
+    if (faceCounts.empty()) {
+        faceCounts = { 250000, 1000000, 4000000 };
+    }
+
+    BenchUtility::PrintEnvironment("ObjStreamingBench");
+    std::printf("# peak MB : peak RSS during the load minus peak RSS before it, measured in a separate process per row\n");
+    std::printf("%10s %10s %-12s %12s %14s %14s %12s\n", "faces", "file MB", "path", "time ms", "peak MB", "peak / file", "indices");
+    std::fflush(stdout);
+    std::filesystem::path directory = GetTestDataDirectory();
+    for (uint64_t faceCount : faceCounts) {
+        std::filesystem::path filePath = directory / ("streaming_bench_" + std::to_string(faceCount) + ".obj");
+        if (!std::filesystem::exists(filePath) && !WriteSyntheticObj(filePath, faceCount, 4)) {
+            std::printf("failed to write %s\n", filePath.string().c_str());
+            return 1;
+        }
+        for (int path = 0; path < 3; ++path) {
+            std::string command = "\"";
+            command += argv[0];
+            command += "\" --child " + std::to_string(path) + " " + std::to_string(faceCount);
+            if (std::system(command.c_str()) != 0) {
+                std::printf("failed: %s\n", command.c_str());
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
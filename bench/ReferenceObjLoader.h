@@ -0,0 +1,88 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ObjLoader.h"
+
+/// <summary>
+/// 置き換える前のLoadObjFile。1行ごと、面の頂点ごとにistringstreamを作って読む
+/// 速さと結果を比べる基準として残している。重複をまとめず、三角形ごとに3頂点を並べて返す(mtllibは読まない)
+/// </summary>
+inline std::vector<VertexData> LoadObjFileReference(const std::string& directoryPath, const std::string& filename)
+{
+    std::vector<VertexData> vertices; // 構築する頂点
+    std::vector<Vector4> positions; // 位置
+    std::vector<Vector3> normals; // 法線
+    std::vector<Vector2> texcoords; // テクスチャ座標
+    std::string line; // ファイルから読んだ1行を格納するもの
+
+    std::ifstream file(directoryPath + "/" + filename); // ファイルを開く
+    assert(file.is_open());
+
+    while (std::getline(file, line)) {
+        std::string identifier;
+        std::istringstream s(line);
+        s >> identifier;
+
+        // identifierに応じた処理
+        if (identifier == "v") {
+            Vector4 position;
+            s >> position.x >> position.y >> position.z;
+            position.x *= -1.0f;
+            position.w = 1.0f;
+            positions.push_back(position);
+        } else if (identifier == "vt") {
+            Vector2 texcoord;
+            s >> texcoord.x >> texcoord.y;
+            texcoord.y = 1.0f - texcoord.y;
+            texcoords.push_back(texcoord);
+        } else if (identifier == "vn") {
+            Vector3 normal;
+            s >> normal.x >> normal.y >> normal.z;
+            normal.x *= -1.0f;
+            normals.push_back(normal);
+        } else if (identifier == "f") {
+            VertexData triangle[3];
+            // 面は三角形限定。その他は未対応
+            for (int32_t faceVertex = 0; faceVertex < 3; ++faceVertex) {
+                std::string vertexDefinition;
+                s >> vertexDefinition;
+                // 頂点の要素へのIndexは、「位置/テクスチャ座標/法線」で格納されているので、分解してIndexを取得する
+                std::istringstream v(vertexDefinition);
+                uint32_t elementIndices[3];
+                for (int32_t element = 0; element < 3; ++element) {
+                    std::string index;
+                    std::getline(v, index, '/');
+                    elementIndices[element] = std::stoi(index);
+                }
+                // 要素へのIndexから、実際の要素の値を取得して、頂点を構築する
+                Vector4 position = positions[elementIndices[0] - 1];
+                Vector2 texcoord = texcoords[elementIndices[1] - 1];
+                Vector3 normal = normals[elementIndices[2] - 1];
+                triangle[faceVertex] = { position, texcoord, normal };
+            }
+            vertices.push_back(triangle[2]);
+            vertices.push_back(triangle[1]);
+            vertices.push_back(triangle[0]);
+        }
+    }
+
+    return vertices;
+}
+
+/// <summary>
+/// LoadObjFileの結果を、LoadObjFileReferenceと比べられるように三角形ごとの3頂点に戻す
+/// </summary>
+inline std::vector<VertexData> ExpandModelVertices(const ModelData& modelData)
+{
+    std::vector<VertexData> vertices;
+    vertices.reserve(modelData.indices.size());
+    for (uint32_t index : modelData.indices) {
+        vertices.push_back(modelData.vertices[index]);
+    }
+    return vertices;
+}
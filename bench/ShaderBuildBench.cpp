@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "BenchUtility.h"
+#include "ShaderBuildService.h"
+#include "ShaderPermutation.h"
+
+namespace {
+
+// 最適化で待ちの計算が消えないように、結果をここに足し込む
+volatile uint64_t gSink = 0;
+
+/// <summary>
+/// 起動時にコンパイルする組み合わせ。main.cppのGetDistributedShaderRequestsと同じく、頂点形式ごとのVSとPSの全ての組み合わせ
+/// </summary>
+std::vector<ShaderRequest> MakeStartupRequests()
+{
+    std::vector<ShaderRequest> requests;
+    const std::vector<std::wstring> vertexShaderDefines[] = {
+        {},
+        { L"PACKED_VERTEX" },
+        { L"PACKED_VERTEX", L"QUANTIZED_POSITION" },
+    };
+    for (const std::vector<std::wstring>& defines : vertexShaderDefines) {
+        requests.push_back({ L"Object3D.VS.hlsl", L"vs_6_0", defines, true });
+    }
+    for (uint32_t features : EnumerateShaderPermutations()) {
+        requests.push_back({ L"Object3D.PS.hlsl", L"ps_6_0", GetShaderFeatureDefines(features), true });
+    }
+    return requests;
+}
+
+/// <summary>
+/// CPUを使うだけの計算をiterationCount回行う
+/// </summary>
+void Spin(uint64_t iterationCount)
+{
+    uint64_t state = gSink;
+    for (uint64_t i = 0; i < iterationCount; ++i) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+    }
+    gSink = state;
+}
+
+/// <summary>
+/// 1スレッドでSpinがcompileTimeかかる回数
+/// </summary>
+uint64_t CalibrateSpin(std::chrono::microseconds compileTime)
+{
+    constexpr uint64_t kCalibrationCount = 1 << 24;
+    double milliseconds = BenchUtility::MeasureBestMilliseconds(3, [&]() { Spin(kCalibrationCount); });
+    return static_cast<uint64_t>(static_cast<double>(kCalibrationCount) * static_cast<double>(compileTime.count()) / (milliseconds * 1000.0));
+}
+
+/// <summary>
+/// DXCの代わりに時間を使う。spinIterationCountが0でなければその回数だけCPUを使い、0ならcompileTimeだけ眠る
+/// </summary>
+ShaderCompileFunction MakeFakeCompiler(std::chrono::microseconds compileTime, uint64_t spinIterationCount)
+{
+    return [compileTime, spinIterationCount](const ShaderRequest&) {
+        if (spinIterationCount != 0) {
+            Spin(spinIterationCount);
+        } else {
+            std::this_thread::sleep_for(compileTime);
+        }
+        return ShaderBinary{ { 0 }, {} };
+    };
+}
+
+/// <summary>
+/// スレッドを立ててから全ての要求を終えるまでの時間(ミリ秒)
+/// </summary>
+double MeasureStartup(uint32_t threadCount, const std::vector<ShaderRequest>& requests, std::chrono::microseconds compileTime, uint64_t spinIterationCount)
+{
+    return BenchUtility::MeasureBestMilliseconds(3, [&]() {
+        ShaderBuildService service;
+        service.Start(threadCount, [&]() { return MakeFakeCompiler(compileTime, spinIterationCount); });
+        std::vector<std::shared_future<ShaderBinary>> results;
+        for (const ShaderRequest& request : requests) {
+            results.push_back(service.Submit(request));
+        }
+        for (const std::shared_future<ShaderBinary>& result : results) {
+            result.wait();
+        }
+    });
+}
+
+} // namespace
+
+// 使い方 : ShaderBuildBench [1つのコンパイルのミリ秒] [最大のスレッド数]  既定は30ms、論理コア数と8の大きい方
+// 起動時に積むシェーダーの組み合わせを、時間を使うだけの偽のコンパイラでShaderBuildServiceに通し、スレッド数ごとの壁時計の時間を出す
+// sleepはDXCが待つ時間を、spinはCPUを使う時間をまねる。spinは論理コア数を超えると速くならない
+int main(int argc, char** argv)
+{
+    double compileMilliseconds = argc > 1 ? std::atof(argv[1]) : 30.0;
+    uint32_t maxThreadCount = argc > 2 ? static_cast<uint32_t>(std::atoi(argv[2])) : (std::max)(std::thread::hardware_concurrency(), 8u);
+    std::chrono::microseconds compileTime(static_cast<int64_t>(compileMilliseconds * 1000.0));
+    std::vector<ShaderRequest> requests = MakeStartupRequests();
+    uint64_t spinIterationCount = CalibrateSpin(compileTime);
+
+    BenchUtility::PrintEnvironment("ShaderBuildBench");
+    std::printf("# %zu shaders, %.1f ms per compile\n", requests.size(), compileMilliseconds);
+    std::printf("%-6s %8s %12s %9s\n", "mode", "threads", "wall ms", "speedup");
+    for (bool spin : { false, true }) {
+        double singleThreadTime = 0.0;
+        for (uint32_t threadCount = 1; threadCount <= maxThreadCount; ++threadCount) {
+            double time = MeasureStartup(threadCount, requests, compileTime, spin ? spinIterationCount : 0);
+            if (threadCount == 1) {
+                singleThreadTime = time;
+            }
+            std::printf("%-6s %8u %12.2f %8.2fx\n", spin ? "spin" : "sleep", threadCount, time, singleThreadTime / time);
+        }
+    }
+    return 0;
+}
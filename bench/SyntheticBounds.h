@@ -0,0 +1,51 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+#include "FrustumCulling.h"
+#include "MathFunctions.h"
+
+/// <summary>
+/// テストとベンチマークで使う視錐台。原点から+Zを向いたカメラで、near 0.1、far 100
+/// </summary>
+inline Frustum MakeSyntheticFrustum()
+{
+    Matrix4x4 view = Inverse(MakeAffineMatrix({ 1.0f, 1.0f, 1.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -10.0f }));
+    Matrix4x4 projection = MakePerspectiveFovMatrix(0.45f, 16.0f / 9.0f, 0.1f, 100.0f);
+    return ExtractFrustum(Multiply(view, projection));
+}
+
+/// <summary>
+/// 視錐台の周りに散らばったcount個の境界を作る
+/// straddleEveryが0でなければ、その数ごとに1個を、中心が視錐台のどれかの平面の上にある(平面をまたぐ)境界にする
+/// </summary>
+inline CullingBoundsSoA MakeSyntheticBounds(size_t count, const Frustum& frustum, uint32_t seed, size_t straddleEvery)
+{
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> position(-60.0f, 60.0f);
+    std::uniform_real_distribution<float> depth(-20.0f, 110.0f);
+    std::uniform_real_distribution<float> extent(0.01f, 4.0f);
+    std::uniform_int_distribution<int> planeIndex(0, 5);
+    CullingBoundsSoA bounds;
+    bounds.Resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        Vector3 center = { position(random), position(random), depth(random) };
+        if (straddleEvery != 0 && i % straddleEvery == 0) {
+            // 平面へ垂直に下ろした点に中心を移す
+            const Vector4& plane = frustum.planes[planeIndex(random)];
+            float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+            center = { center.x - plane.x * distance, center.y - plane.y * distance, center.z - plane.z * distance };
+        }
+        bounds.centerX[i] = center.x;
+        bounds.centerY[i] = center.y;
+        bounds.centerZ[i] = center.z;
+        bounds.extentX[i] = extent(random);
+        bounds.extentY[i] = extent(random);
+        bounds.extentZ[i] = extent(random);
+        // 球は箱を囲むものから、箱より小さいものまで混ぜる
+        float boxRadius = std::sqrt(bounds.extentX[i] * bounds.extentX[i] + bounds.extentY[i] * bounds.extentY[i] + bounds.extentZ[i] * bounds.extentZ[i]);
+        bounds.radius[i] = boxRadius * std::uniform_real_distribution<float>(0.5f, 1.0f)(random);
+    }
+    return bounds;
+}
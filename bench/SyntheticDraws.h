@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "DrawPacket.h"
+
+/// <summary>
+/// MakeSyntheticDrawsで作る描画の状態の種類の数
+/// </summary>
+struct SyntheticDrawSettings {
+    uint32_t passCount = 2;
+    uint32_t pipelineCount = 16;
+    uint32_t geometryCount = 64;
+    uint32_t materialCount = 256;
+    uint32_t transformCount = 1024;
+    uint32_t textureCount = 128;
+    uint32_t depthBucketCount = 65536; // 1なら深度は全て0
+};
+
+/// <summary>
+/// 状態をsettingsの範囲で一様に選んだcount個の描画
+/// </summary>
+inline std::vector<DrawPacket> MakeSyntheticDraws(size_t count, uint32_t seed, const SyntheticDrawSettings& settings = {})
+{
+    std::mt19937 random(seed);
+    auto pick = [&random](uint32_t stateCount) { return std::uniform_int_distribution<uint32_t>(0, stateCount - 1)(random); };
+    std::vector<DrawPacket> packets(count);
+    for (DrawPacket& packet : packets) {
+        uint32_t pass = pick(settings.passCount);
+        packet.pipeline = pick(settings.pipelineCount);
+        packet.geometry = pick(settings.geometryCount);
+        packet.material = pick(settings.materialCount);
+        packet.transform = pick(settings.transformCount);
+        packet.texture = pick(settings.textureCount);
+        packet.indexStart = 0;
+        packet.indexCount = 3;
+        packet.sortKey = MakeDrawSortKey(pass, packet.pipeline, packet.texture, packet.material, pick(settings.depthBucketCount));
+    }
+    return packets;
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+/// <summary>
+/// テストとベンチマークで読み込む、格子状の合成OBJファイルを書き出す
+/// 頂点ごとに位置、テクスチャ座標、法線を1つずつ持ち、面は格子の1マスを2つの三角形に分けたもの
+/// materialCountが2以上なら、一定の面数ごとにusemtlでマテリアルを順に切り替える(mtllibは書かない)
+/// </summary>
+inline bool WriteSyntheticObj(const std::filesystem::path& filePath, uint64_t faceCount, uint32_t materialCount = 1)
+{
+    std::FILE* file = std::fopen(filePath.string().c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    std::string buffer;
+    buffer.reserve(1 << 20);
+    auto flush = [&]() {
+        std::fwrite(buffer.data(), 1, buffer.size(), file);
+        buffer.clear();
+    };
+    char line[128];
+    auto append = [&](int length) {
+        buffer.append(line, static_cast<size_t>(length));
+        if (buffer.size() >= (1 << 20) - sizeof(line)) {
+            flush();
+        }
+    };
+
+    // 2 * columns * rows >= faceCountになる、正方形に近い格子
+    uint64_t columns = (std::max)(static_cast<uint64_t>(1), static_cast<uint64_t>(std::sqrt(static_cast<double>(faceCount) / 2.0)));
+    uint64_t rows = (std::max)(static_cast<uint64_t>(1), (faceCount + columns * 2 - 1) / (columns * 2));
+    uint64_t vertexCount = (columns + 1) * (rows + 1);
+
+    for (uint64_t i = 0; i < vertexCount; ++i) {
+        uint64_t x = i % (columns + 1);
+        uint64_t y = i / (columns + 1);
+        // 値の桁がそろわないよう、位置ごとに決まる揺らぎを加える
+        double jitter = static_cast<double>((i * 2654435761u) % 1000) / 1000.0;
+        append(std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f\n", static_cast<double>(x) * 0.01, std::sin(jitter * 6.0) * 0.05, static_cast<double>(y) * 0.01));
+    }
+    for (uint64_t i = 0; i < vertexCount; ++i) {
+        uint64_t x = i % (columns + 1);
+        uint64_t y = i / (columns + 1);
+        append(std::snprintf(line, sizeof(line), "vt %.6f %.6f\n", static_cast<double>(x) / static_cast<double>(columns), static_cast<double>(y) / static_cast<double>(rows)));
+    }
+    for (uint64_t i = 0; i < vertexCount; ++i) {
+        double jitter = static_cast<double>((i * 40503u) % 1000) / 1000.0 - 0.5;
+        double length = std::sqrt(1.0 + jitter * jitter * 0.02);
+        append(std::snprintf(line, sizeof(line), "vn %.6f %.6f %.6f\n", jitter * 0.1 / length, 1.0 / length, -jitter * 0.1 / length));
+    }
+
+    uint64_t facesPerMaterialRun = (std::max)(static_cast<uint64_t>(1), faceCount / (static_cast<uint64_t>(materialCount) * 4));
+    for (uint64_t face = 0; face < faceCount; ++face) {
+        if (materialCount > 1 && face % facesPerMaterialRun == 0) {
+            append(std::snprintf(line, sizeof(line), "usemtl material%u\n", static_cast<uint32_t>((face / facesPerMaterialRun) % materialCount)));
+        }
+        uint64_t cell = face / 2;
+        uint64_t x = cell % columns;
+        uint64_t y = cell / columns;
+        uint64_t v00 = y * (columns + 1) + x + 1;
+        uint64_t v10 = v00 + 1;
+        uint64_t v01 = v00 + columns + 1;
+        uint64_t v11 = v01 + 1;
+        uint64_t a = v00;
+        uint64_t b = face % 2 == 0 ? v10 : v11;
+        uint64_t c = face % 2 == 0 ? v11 : v01;
+        append(std::snprintf(line, sizeof(line), "f %llu/%llu/%llu %llu/%llu/%llu %llu/%llu/%llu\n",
+            static_cast<unsigned long long>(a), static_cast<unsigned long long>(a), static_cast<unsigned long long>(a),
+            static_cast<unsigned long long>(b), static_cast<unsigned long long>(b), static_cast<unsigned long long>(b),
+            static_cast<unsigned long long>(c), static_cast<unsigned long long>(c), static_cast<unsigned long long>(c)));
+    }
+    flush();
+    return std::fclose(file) == 0;
+}
+
+/// <summary>
+/// テストとベンチマークが一時ファイルを置くディレクトリ。なければ作る
+/// </summary>
+inline std::filesystem::path GetTestDataDirectory()
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "cg2_test_data";
+    std::filesystem::create_directories(directory);
+    return directory;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <random>
+
+#include "MathFunctions.h"
+#include "TransformBatch.h"
+
+/// <summary>
+/// テストとベンチマークで使う、拡縮、回転、移動がばらばらなcount個のTransform
+/// 回転は1周を超える角度も含める
+/// </summary>
+inline TransformSoA MakeSyntheticTransforms(size_t count, uint32_t seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> scale(0.1f, 4.0f);
+    std::uniform_real_distribution<float> rotate(-20.0f, 20.0f);
+    std::uniform_real_distribution<float> translate(-100.0f, 100.0f);
+    TransformSoA transforms;
+    transforms.Resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        transforms.Set(i, {
+            { scale(random), scale(random), scale(random) },
+            { rotate(random), rotate(random), rotate(random) },
+            { translate(random), translate(random), translate(random) },
+        });
+    }
+    return transforms;
+}
+
+/// <summary>
+/// テストとベンチマークで使うビュープロジェクション行列
+/// </summary>
+inline Matrix4x4 MakeSyntheticViewProjection()
+{
+    Matrix4x4 view = Inverse(MakeAffineMatrix({ 1.0f, 1.0f, 1.0f }, { 0.3f, 0.0f, 0.0f }, { 0.0f, 4.0f, -10.0f }));
+    return Multiply(view, MakePerspectiveFovMatrix(0.45f, 16.0f / 9.0f, 0.1f, 100.0f));
+}
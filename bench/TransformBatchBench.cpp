@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "AffineMatrix.h"
+#include "BenchUtility.h"
+#include "MatrixSimd.h"
+#include "SyntheticTransforms.h"
+#include "TransformBatch.h"
+
+// 使い方 : TransformBatchBench [オブジェクト数...]  既定は1000、10万、100万
+// 1オブジェクトずつWorldとWVPを計算するループ(置き換える前のフレームの処理)と、ComputeTransformationMatricesを
+// 命令セットとスレッド数ごとに比べ、1オブジェクトあたりのナノ秒と1秒あたりのオブジェクト数を出す
+int main(int argc, char** argv)
+{
+    std::vector<size_t> objectCounts;
+    for (int i = 1; i < argc; ++i) {
+        objectCounts.push_back(std::strtoull(argv[i], nullptr, 10));
+    }
+    if (objectCounts.empty()) {
+        objectCounts = { 1000, 100000, 1000000 };
+    }
+    uint32_t threadCount = (std::max)(std::thread::hardware_concurrency(), 1u);
+
+    BenchUtility::PrintEnvironment("TransformBatchBench");
+    std::printf("# supported: %s\n", GetSimdLevelName(GetSupportedSimdLevel()));
+    std::printf("%10s %-12s %8s %10s %12s %8s\n", "objects", "path", "threads", "ns/object", "Mobjects/s", "speedup");
+    Matrix4x4 viewProjection = MakeSyntheticViewProjection();
+    for (size_t objectCount : objectCounts) {
+        TransformSoA transforms = MakeSyntheticTransforms(objectCount, 1);
+        std::vector<TransformationMatrix> result(objectCount);
+        // 小さいほど1回が短いので、回数を増やして測る
+        int repeatCount = objectCount <= 10000 ? 2000 : (objectCount <= 100000 ? 50 : 5);
+        auto print = [&](const char* path, uint32_t threads, double milliseconds, double baseMilliseconds) {
+            double nanoseconds = milliseconds * 1.0e6 / static_cast<double>(objectCount);
+            std::printf("%10zu %-12s %8u %10.2f %12.1f %7.2fx\n", objectCount, path, threads, nanoseconds, 1000.0 / nanoseconds, baseMilliseconds / milliseconds);
+        };
+
+        double loopTime = BenchUtility::MeasureBestMilliseconds(repeatCount, [&]() {
+            for (size_t i = 0; i < objectCount; ++i) {
+                Transform transform = transforms.Get(i);
+                AffineMatrix world = MakeAffineTransform(transform.scale, transform.rotate, transform.translate);
+                result[i] = { Multiply(world, viewProjection), ToMatrix4x4(world) };
+            }
+        });
+        print("per-object", 1, loopTime, loopTime);
+
+        const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::Avx2 };
+        for (SimdLevel level : levels) {
+            SetSimdLevel(level);
+            if (GetSimdLevel() != level) {
+                continue;
+            }
+            std::vector<uint32_t> threadCounts = { 1 };
+            if (threadCount > 1) {
+                threadCounts.push_back(threadCount);
+            }
+            for (uint32_t threads : threadCounts) {
+                double time = BenchUtility::MeasureBestMilliseconds(repeatCount, [&]() {
+                    ComputeTransformationMatrices(transforms, viewProjection, result.data(), threads);
+                });
+                print(level == SimdLevel::Avx2 ? "batch AVX2" : "batch Scalar", threads, time, loopTime);
+            }
+        }
+    }
+    return 0;
+}
@@ -1,13 +1,19 @@
 #include <Windows.h>
 #include <cstdint>
 #include <cassert>
+#include <cstring>
+#include <cstdlib>
 
 #include <string>
 #include <vector>
+#include <deque>
+#include <fstream>
+#include <iterator>
 #include <format>
 #include <numbers>
-#include <fstream>
-#include <sstream>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
 
 #include <d3d12.h>
 #include <dxgi1_6.h>
@@ -30,45 +36,55 @@ extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg
 #pragma comment(lib, "dxguid.lib")
 #pragma comment(lib, "dxcompiler.lib")
 
-struct Vector2 {
-    float x;
-    float y;
-};
-
-
-struct Vector3 {
-    float x;
-    float y;
-    float z;
-};
-
-struct Vector4 {
-    float x;
-    float y;
-    float z;
-    float w;
-};
-
-struct Matrix4x4 {
-    float m[4][4];
-};
-
-struct Transform {
-    Vector3 scale;
-    Vector3 rotate;
-    Vector3 translate;
+#include "AffineMatrix.h"
+#include "MathFunctions.h"
+#include "MathTypes.h"
+#include "MatrixSimd.h"
+#include "ObjLoader.h"
+#include "MeshCache.h"
+#include "MeshSimplifier.h"
+#include "Meshlet.h"
+#include "FrustumCulling.h"
+#include "FrameScheduler.h"
+#include "DescriptorAllocator.h"
+#include "DrawPacket.h"
+#include "ShaderBuildService.h"
+#include "ShaderCache.h"
+#include "ShaderCostReport.h"
+#include "ShaderHotReload.h"
+#include "ShaderPermutation.h"
+#include "TransformBatch.h"
+#include "TransformHierarchy.h"
+#include "UploadRing.h"
+#include "VertexPacking.h"
+
+/// <summary>
+/// モデルの1回分の描画。textureIndexはモデルのTextureの番号で、なければkNoModelTexture
+/// </summary>
+struct ModelDrawRange {
+    uint32_t textureIndex;
+    uint32_t indexStart;
+    uint32_t indexCount;
 };
 
-struct TransformationMatrix {
-    Matrix4x4 WVP;
-    Matrix4x4 World;
-};
-
-struct VertexData {
-    Vector4 position;
-    Vector2 texcoord;
-    Vector3 normal;
-};
+constexpr uint32_t kNoModelTexture = 0xFFFFFFFFu;
+
+// DrawPacketの状態の番号。パスは小さい順に描く。PSOの番号はPipelineStateVariantsが決める
+constexpr uint32_t kDrawPassOpaque = 0;
+constexpr uint32_t kDrawPassSprite = 1;
+constexpr uint32_t kDrawGeometryModel = 0;
+constexpr uint32_t kDrawGeometrySprite = 1;
+constexpr uint32_t kDrawMaterialModel = 0;
+constexpr uint32_t kDrawMaterialSprite = 1;
+constexpr uint32_t kDrawTransformModel = 0;
+constexpr uint32_t kDrawTransformSprite = 1;
+constexpr uint32_t kDrawTransformInstances = 2;
+constexpr uint32_t kDrawTransformCount = 3;
+
+// モデルを並べて描くインスタンスの最大数と、格子に並べるときの1列の数と間隔
+constexpr uint32_t kMaxModelInstances = 4096;
+constexpr uint32_t kModelInstanceColumns = 64;
+constexpr float kModelInstanceSpacing = 2.5f;
 
 struct DirectionalLight {
     Vector4 color; //!< ライトの色
@@ -76,327 +92,15 @@ struct DirectionalLight {
     float intensity; //!< 輝度
 };
 
+// ライティングなどの有無はPSOで切り替えるので、ここには持たない(ShaderPermutation.hを参照)
 struct Material {
     Vector4 color;
-    int32_t enableLighting;
-    float padding[3];
     Matrix4x4 uvTransform;
 };
 
-struct MaterialData
-{
-    std::string textureFilePath;
-};
-
-struct ModelData {
-    std::vector<VertexData> vertices;
-    MaterialData material;
-};
-
-float Dot(const Vector3& v1, const Vector3& v2) { return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z; }
-
-float Length(const Vector3& v) { return std::sqrt(Dot(v, v)); }
-
-Vector3 Normalize(const Vector3& v) {
-    float length = Length(v);
-    if (length == 0.0f) {
-        return v;
-    }
-    return { v.x / length, v.y / length, v.z / length };
-}
-
-Matrix4x4 Add(const Matrix4x4& m1, const Matrix4x4& m2) {
-    Matrix4x4 result;
-    result.m[0][0] = m1.m[0][0] + m2.m[0][0];
-    result.m[0][1] = m1.m[0][1] + m2.m[0][1];
-    result.m[0][2] = m1.m[0][2] + m2.m[0][2];
-    result.m[0][3] = m1.m[0][3] + m2.m[0][3];
-
-    result.m[1][0] = m1.m[1][0] + m2.m[1][0];
-    result.m[1][1] = m1.m[1][1] + m2.m[1][1];
-    result.m[1][2] = m1.m[1][2] + m2.m[1][2];
-    result.m[1][3] = m1.m[1][3] + m2.m[1][3];
-
-    result.m[2][0] = m1.m[2][0] + m2.m[2][0];
-    result.m[2][1] = m1.m[2][1] + m2.m[2][1];
-    result.m[2][2] = m1.m[2][2] + m2.m[2][2];
-    result.m[2][3] = m1.m[2][3] + m2.m[2][3];
-
-    result.m[3][0] = m1.m[3][0] + m2.m[3][0];
-    result.m[3][1] = m1.m[3][1] + m2.m[3][1];
-    result.m[3][2] = m1.m[3][2] + m2.m[3][2];
-    result.m[3][3] = m1.m[3][3] + m2.m[3][3];
-    return result;
-}
-
-// 2. 行列の減法
-Matrix4x4 Subtract(const Matrix4x4& m1, const Matrix4x4& m2) {
-    Matrix4x4 result;
-    result.m[0][0] = m1.m[0][0] - m2.m[0][0];
-    result.m[0][1] = m1.m[0][1] - m2.m[0][1];
-    result.m[0][2] = m1.m[0][2] - m2.m[0][2];
-    result.m[0][3] = m1.m[0][3] - m2.m[0][3];
-
-    result.m[1][0] = m1.m[1][0] - m2.m[1][0];
-    result.m[1][1] = m1.m[1][1] - m2.m[1][1];
-    result.m[1][2] = m1.m[1][2] - m2.m[1][2];
-    result.m[1][3] = m1.m[1][3] - m2.m[1][3];
-
-    result.m[2][0] = m1.m[2][0] - m2.m[2][0];
-    result.m[2][1] = m1.m[2][1] - m2.m[2][1];
-    result.m[2][2] = m1.m[2][2] - m2.m[2][2];
-    result.m[2][3] = m1.m[2][3] - m2.m[2][3];
-
-    result.m[3][0] = m1.m[3][0] - m2.m[3][0];
-    result.m[3][1] = m1.m[3][1] - m2.m[3][1];
-    result.m[3][2] = m1.m[3][2] - m2.m[3][2];
-    result.m[3][3] = m1.m[3][3] - m2.m[3][3];
-    return result;
-}
-
-Matrix4x4 Inverse(const Matrix4x4& m) {
-    // clang-format off
-    float determinant = +m.m[0][0] * m.m[1][1] * m.m[2][2] * m.m[3][3]
-        + m.m[0][0] * m.m[1][2] * m.m[2][3] * m.m[3][1]
-        + m.m[0][0] * m.m[1][3] * m.m[2][1] * m.m[3][2]
-
-        - m.m[0][0] * m.m[1][3] * m.m[2][2] * m.m[3][1]
-        - m.m[0][0] * m.m[1][2] * m.m[2][1] * m.m[3][3]
-        - m.m[0][0] * m.m[1][1] * m.m[2][3] * m.m[3][2]
-
-        - m.m[0][1] * m.m[1][0] * m.m[2][2] * m.m[3][3]
-        - m.m[0][2] * m.m[1][0] * m.m[2][3] * m.m[3][1]
-        - m.m[0][3] * m.m[1][0] * m.m[2][1] * m.m[3][2]
-
-        + m.m[0][3] * m.m[1][0] * m.m[2][2] * m.m[3][1]
-        + m.m[0][2] * m.m[1][0] * m.m[2][1] * m.m[3][3]
-        + m.m[0][1] * m.m[1][0] * m.m[2][3] * m.m[3][2]
-
-        + m.m[0][1] * m.m[1][2] * m.m[2][0] * m.m[3][3]
-        + m.m[0][2] * m.m[1][3] * m.m[2][0] * m.m[3][1]
-        + m.m[0][3] * m.m[1][1] * m.m[2][0] * m.m[3][2]
-
-        - m.m[0][3] * m.m[1][2] * m.m[2][0] * m.m[3][1]
-        - m.m[0][2] * m.m[1][1] * m.m[2][0] * m.m[3][3]
-        - m.m[0][1] * m.m[1][3] * m.m[2][0] * m.m[3][2]
-
-        - m.m[0][1] * m.m[1][2] * m.m[2][3] * m.m[3][0]
-        - m.m[0][2] * m.m[1][3] * m.m[2][1] * m.m[3][0]
-        - m.m[0][3] * m.m[1][1] * m.m[2][2] * m.m[3][0]
-
-        + m.m[0][3] * m.m[1][2] * m.m[2][1] * m.m[3][0]
-        + m.m[0][2] * m.m[1][1] * m.m[2][3] * m.m[3][0]
-        + m.m[0][1] * m.m[1][3] * m.m[2][2] * m.m[3][0];
-
-    Matrix4x4 result;
-    float recpDeterminant = 1.0f / determinant;
-    result.m[0][0] = (m.m[1][1] * m.m[2][2] * m.m[3][3] + m.m[1][2] * m.m[2][3] * m.m[3][1] +
-        m.m[1][3] * m.m[2][1] * m.m[3][2] - m.m[1][3] * m.m[2][2] * m.m[3][1] -
-        m.m[1][2] * m.m[2][1] * m.m[3][3] - m.m[1][1] * m.m[2][3] * m.m[3][2]) * recpDeterminant;
-    result.m[0][1] = (-m.m[0][1] * m.m[2][2] * m.m[3][3] - m.m[0][2] * m.m[2][3] * m.m[3][1] -
-        m.m[0][3] * m.m[2][1] * m.m[3][2] + m.m[0][3] * m.m[2][2] * m.m[3][1] +
-        m.m[0][2] * m.m[2][1] * m.m[3][3] + m.m[0][1] * m.m[2][3] * m.m[3][2]) * recpDeterminant;
-    result.m[0][2] = (m.m[0][1] * m.m[1][2] * m.m[3][3] + m.m[0][2] * m.m[1][3] * m.m[3][1] +
-        m.m[0][3] * m.m[1][1] * m.m[3][2] - m.m[0][3] * m.m[1][2] * m.m[3][1] -
-        m.m[0][2] * m.m[1][1] * m.m[3][3] - m.m[0][1] * m.m[1][3] * m.m[3][2]) * recpDeterminant;
-    result.m[0][3] = (-m.m[0][1] * m.m[1][2] * m.m[2][3] - m.m[0][2] * m.m[1][3] * m.m[2][1] -
-        m.m[0][3] * m.m[1][1] * m.m[2][2] + m.m[0][3] * m.m[1][2] * m.m[2][1] +
-        m.m[0][2] * m.m[1][1] * m.m[2][3] + m.m[0][1] * m.m[1][3] * m.m[2][2]) * recpDeterminant;
-
-    result.m[1][0] = (-m.m[1][0] * m.m[2][2] * m.m[3][3] - m.m[1][2] * m.m[2][3] * m.m[3][0] -
-        m.m[1][3] * m.m[2][0] * m.m[3][2] + m.m[1][3] * m.m[2][2] * m.m[3][0] +
-        m.m[1][2] * m.m[2][0] * m.m[3][3] + m.m[1][0] * m.m[2][3] * m.m[3][2]) * recpDeterminant;
-    result.m[1][1] = (m.m[0][0] * m.m[2][2] * m.m[3][3] + m.m[0][2] * m.m[2][3] * m.m[3][0] +
-        m.m[0][3] * m.m[2][0] * m.m[3][2] - m.m[0][3] * m.m[2][2] * m.m[3][0] -
-        m.m[0][2] * m.m[2][0] * m.m[3][3] - m.m[0][0] * m.m[2][3] * m.m[3][2]) * recpDeterminant;
-    result.m[1][2] = (-m.m[0][0] * m.m[1][2] * m.m[3][3] - m.m[0][2] * m.m[1][3] * m.m[3][0] -
-        m.m[0][3] * m.m[1][0] * m.m[3][2] + m.m[0][3] * m.m[1][2] * m.m[3][0] +
-        m.m[0][2] * m.m[1][0] * m.m[3][3] + m.m[0][0] * m.m[1][3] * m.m[3][2]) * recpDeterminant;
-    result.m[1][3] = (m.m[0][0] * m.m[1][2] * m.m[2][3] + m.m[0][2] * m.m[1][3] * m.m[2][0] +
-        m.m[0][3] * m.m[1][0] * m.m[2][2] - m.m[0][3] * m.m[1][2] * m.m[2][0] -
-        m.m[0][2] * m.m[1][0] * m.m[2][3] - m.m[0][0] * m.m[1][3] * m.m[2][2]) * recpDeterminant;
-
-    result.m[2][0] = (m.m[1][0] * m.m[2][1] * m.m[3][3] + m.m[1][1] * m.m[2][3] * m.m[3][0] +
-        m.m[1][3] * m.m[2][0] * m.m[3][1] - m.m[1][3] * m.m[2][1] * m.m[3][0] -
-        m.m[1][1] * m.m[2][0] * m.m[3][3] - m.m[1][0] * m.m[2][3] * m.m[3][1]) * recpDeterminant;
-    result.m[2][1] = (-m.m[0][0] * m.m[2][1] * m.m[3][3] - m.m[0][1] * m.m[2][3] * m.m[3][0] -
-        m.m[0][3] * m.m[2][0] * m.m[3][1] + m.m[0][3] * m.m[2][1] * m.m[3][0] +
-        m.m[0][1] * m.m[2][0] * m.m[3][3] + m.m[0][0] * m.m[2][3] * m.m[3][1]) * recpDeterminant;
-    result.m[2][2] = (m.m[0][0] * m.m[1][1] * m.m[3][3] + m.m[0][1] * m.m[1][3] * m.m[3][0] +
-        m.m[0][3] * m.m[1][0] * m.m[3][1] - m.m[0][3] * m.m[1][1] * m.m[3][0] -
-        m.m[0][1] * m.m[1][0] * m.m[3][3] - m.m[0][0] * m.m[1][3] * m.m[3][1]) * recpDeterminant;
-    result.m[2][3] = (-m.m[0][0] * m.m[1][1] * m.m[2][3] - m.m[0][1] * m.m[1][3] * m.m[2][0] -
-        m.m[0][3] * m.m[1][0] * m.m[2][1] + m.m[0][3] * m.m[1][1] * m.m[2][0] +
-        m.m[0][1] * m.m[1][0] * m.m[2][3] + m.m[0][0] * m.m[1][3] * m.m[2][1]) * recpDeterminant;
-
-    result.m[3][0] = (-m.m[1][0] * m.m[2][1] * m.m[3][2] - m.m[1][1] * m.m[2][2] * m.m[3][0] -
-        m.m[1][2] * m.m[2][0] * m.m[3][1] + m.m[1][2] * m.m[2][1] * m.m[3][0] +
-        m.m[1][1] * m.m[2][0] * m.m[3][2] + m.m[1][0] * m.m[2][2] * m.m[3][1]) * recpDeterminant;
-    result.m[3][1] = (m.m[0][0] * m.m[2][1] * m.m[3][2] + m.m[0][1] * m.m[2][2] * m.m[3][0] +
-        m.m[0][2] * m.m[2][0] * m.m[3][1] - m.m[0][2] * m.m[2][1] * m.m[3][0] -
-        m.m[0][1] * m.m[2][0] * m.m[3][2] - m.m[0][0] * m.m[2][2] * m.m[3][1]) * recpDeterminant;
-    result.m[3][2] = (-m.m[0][0] * m.m[1][1] * m.m[3][2] - m.m[0][1] * m.m[1][2] * m.m[3][0] -
-        m.m[0][2] * m.m[1][0] * m.m[3][1] + m.m[0][2] * m.m[1][1] * m.m[3][0] +
-        m.m[0][1] * m.m[1][0] * m.m[3][2] + m.m[0][0] * m.m[1][2] * m.m[3][1]) * recpDeterminant;
-    result.m[3][3] = (m.m[0][0] * m.m[1][1] * m.m[2][2] + m.m[0][1] * m.m[1][2] * m.m[2][0] +
-        m.m[0][2] * m.m[1][0] * m.m[2][1] - m.m[0][2] * m.m[1][1] * m.m[2][0] -
-        m.m[0][1] * m.m[1][0] * m.m[2][2] - m.m[0][0] * m.m[1][2] * m.m[2][1]) * recpDeterminant;
-
-    return result;
-    // clang-format on
-}
-
-Matrix4x4 Transpose(const Matrix4x4& m) {
-    Matrix4x4 result;
-    result.m[0][0] = m.m[0][0];
-    result.m[0][1] = m.m[1][0];
-    result.m[0][2] = m.m[2][0];
-    result.m[0][3] = m.m[3][0];
-
-    result.m[1][0] = m.m[0][1];
-    result.m[1][1] = m.m[1][1];
-    result.m[1][2] = m.m[2][1];
-    result.m[1][3] = m.m[3][1];
-
-    result.m[2][0] = m.m[0][2];
-    result.m[2][1] = m.m[1][2];
-    result.m[2][2] = m.m[2][2];
-    result.m[2][3] = m.m[3][2];
-
-    result.m[3][0] = m.m[0][3];
-    result.m[3][1] = m.m[1][3];
-    result.m[3][2] = m.m[2][3];
-    result.m[3][3] = m.m[3][3];
-
-    return result;
-}
-
-Matrix4x4 MakeIdentity4x4() {
-    // clang-format off
-    Matrix4x4 identity;
-    identity.m[0][0] = 1.0f;	identity.m[0][1] = 0.0f;	identity.m[0][2] = 0.0f;	identity.m[0][3] = 0.0f;
-    identity.m[1][0] = 0.0f;	identity.m[1][1] = 1.0f;	identity.m[1][2] = 0.0f;	identity.m[1][3] = 0.0f;
-    identity.m[2][0] = 0.0f;	identity.m[2][1] = 0.0f;	identity.m[2][2] = 1.0f;	identity.m[2][3] = 0.0f;
-    identity.m[3][0] = 0.0f;	identity.m[3][1] = 0.0f;	identity.m[3][2] = 0.0f;	identity.m[3][3] = 1.0f;
-    return identity;
-    // clang-format on
-}
-
-Matrix4x4 MakeTranslateMatrix(const Vector3& translate) {
-    return {
-      1.0f, 0.0f, 0.0f, 0.0f,
-      0.0f, 1.0f, 0.0f, 0.0f,
-      0.0f, 0.0f, 1.0f, 0.0f,
-      translate.x, translate.y, translate.z, 1.0f,
-    };
-}
-
-Matrix4x4 MakeScaleMatrix(const Vector3& scale) {
-    return {
-      scale.x, 0.0f, 0.0f, 0.0f,
-      0.0f, scale.y, 0.0f, 0.0f,
-      0.0f, 0.0f, scale.z, 0.0f,
-      0.0f, 0.0f, 0.0f, 1.0f,
-    };
-}
-
-Matrix4x4 MakeRotateXMatrix(float radian) {
-    float cosTheta = std::cos(radian);
-    float sinTheta = std::sin(radian);
-    return { 1.0f, 0.0f, 0.0f, 0.0f,
-            0.0f, cosTheta, sinTheta, 0.0f,
-            0.0f, -sinTheta, cosTheta, 0.0f,
-            0.0f, 0.0f, 0.0f, 1.0f };
-}
-
-Matrix4x4 MakeRotateYMatrix(float radian) {
-    float cosTheta = std::cos(radian);
-    float sinTheta = std::sin(radian);
-    return { cosTheta, 0.0f, -sinTheta, 0.0f,
-            0.0f, 1.0f, 0.0f, 0.0f,
-            sinTheta, 0.0f, cosTheta, 0.0f,
-            0.0f, 0.0f, 0.0f, 1.0f };
-}
-
-Matrix4x4 MakeRotateZMatrix(float radian) {
-    float cosTheta = std::cos(radian);
-    float sinTheta = std::sin(radian);
-    return { cosTheta, sinTheta, 0.0f, 0.0f,
-            -sinTheta, cosTheta, 0.0f , 0.0f,
-            0.0f, 0.0f, 1.0f, 0.0f,
-            0.0f, 0.0f, 0.0f, 1.0f };
-}
-
-
-Matrix4x4 Multiply(const Matrix4x4& m1, const Matrix4x4& m2) {
-    Matrix4x4 result;
-    result.m[0][0] = m1.m[0][0] * m2.m[0][0] + m1.m[0][1] * m2.m[1][0] + m1.m[0][2] * m2.m[2][0] + m1.m[0][3] * m2.m[3][0];
-    result.m[0][1] = m1.m[0][0] * m2.m[0][1] + m1.m[0][1] * m2.m[1][1] + m1.m[0][2] * m2.m[2][1] + m1.m[0][3] * m2.m[3][1];
-    result.m[0][2] = m1.m[0][0] * m2.m[0][2] + m1.m[0][1] * m2.m[1][2] + m1.m[0][2] * m2.m[2][2] + m1.m[0][3] * m2.m[3][2];
-    result.m[0][3] = m1.m[0][0] * m2.m[0][3] + m1.m[0][1] * m2.m[1][3] + m1.m[0][2] * m2.m[2][3] + m1.m[0][3] * m2.m[3][3];
-
-    result.m[1][0] = m1.m[1][0] * m2.m[0][0] + m1.m[1][1] * m2.m[1][0] + m1.m[1][2] * m2.m[2][0] + m1.m[1][3] * m2.m[3][0];
-    result.m[1][1] = m1.m[1][0] * m2.m[0][1] + m1.m[1][1] * m2.m[1][1] + m1.m[1][2] * m2.m[2][1] + m1.m[1][3] * m2.m[3][1];
-    result.m[1][2] = m1.m[1][0] * m2.m[0][2] + m1.m[1][1] * m2.m[1][2] + m1.m[1][2] * m2.m[2][2] + m1.m[1][3] * m2.m[3][2];
-    result.m[1][3] = m1.m[1][0] * m2.m[0][3] + m1.m[1][1] * m2.m[1][3] + m1.m[1][2] * m2.m[2][3] + m1.m[1][3] * m2.m[3][3];
-
-    result.m[2][0] = m1.m[2][0] * m2.m[0][0] + m1.m[2][1] * m2.m[1][0] + m1.m[2][2] * m2.m[2][0] + m1.m[2][3] * m2.m[3][0];
-    result.m[2][1] = m1.m[2][0] * m2.m[0][1] + m1.m[2][1] * m2.m[1][1] + m1.m[2][2] * m2.m[2][1] + m1.m[2][3] * m2.m[3][1];
-    result.m[2][2] = m1.m[2][0] * m2.m[0][2] + m1.m[2][1] * m2.m[1][2] + m1.m[2][2] * m2.m[2][2] + m1.m[2][3] * m2.m[3][2];
-    result.m[2][3] = m1.m[2][0] * m2.m[0][3] + m1.m[2][1] * m2.m[1][3] + m1.m[2][2] * m2.m[2][3] + m1.m[2][3] * m2.m[3][3];
-
-    result.m[3][0] = m1.m[3][0] * m2.m[0][0] + m1.m[3][1] * m2.m[1][0] + m1.m[3][2] * m2.m[2][0] + m1.m[3][3] * m2.m[3][0];
-    result.m[3][1] = m1.m[3][0] * m2.m[0][1] + m1.m[3][1] * m2.m[1][1] + m1.m[3][2] * m2.m[2][1] + m1.m[3][3] * m2.m[3][1];
-    result.m[3][2] = m1.m[3][0] * m2.m[0][2] + m1.m[3][1] * m2.m[1][2] + m1.m[3][2] * m2.m[2][2] + m1.m[3][3] * m2.m[3][2];
-    result.m[3][3] = m1.m[3][0] * m2.m[0][3] + m1.m[3][1] * m2.m[1][3] + m1.m[3][2] * m2.m[2][3] + m1.m[3][3] * m2.m[3][3];
-
-    return result;
-}
-
-Matrix4x4 MakeAffineMatrix(const Vector3& scale, const Vector3& rotate, const Vector3& translate) {
-    Matrix4x4 result = Multiply(Multiply(MakeRotateXMatrix(rotate.x), MakeRotateYMatrix(rotate.y)), MakeRotateZMatrix(rotate.z));
-    result.m[0][0] *= scale.x;
-    result.m[0][1] *= scale.x;
-    result.m[0][2] *= scale.x;
-
-    result.m[1][0] *= scale.y;
-    result.m[1][1] *= scale.y;
-    result.m[1][2] *= scale.y;
-
-    result.m[2][0] *= scale.z;
-    result.m[2][1] *= scale.z;
-    result.m[2][2] *= scale.z;
-
-    result.m[3][0] = translate.x;
-    result.m[3][1] = translate.y;
-    result.m[3][2] = translate.z;
-    return result;
-}
-
-// clang-format off
-Matrix4x4 MakePerspectiveFovMatrix(float fovY, float aspectRatio, float nearClip, float farClip)
-{
-    float cotHalfFovV = 1.0f / std::tan(fovY / 2.0f);
-    return {
-        (cotHalfFovV / aspectRatio), 0.0f, 0.0f, 0.0f,
-        0.0f, cotHalfFovV, 0.0f, 0.0f,
-        0.0f, 0.0f, farClip / (farClip - nearClip), 1.0f,
-        0.0f, 0.0f, -(nearClip * farClip) / (farClip - nearClip), 0.0f
-    };
-}
-
-Matrix4x4 MakeOrthographicMatrix(float left, float top, float right, float bottom, float nearClip, float farClip)
-{
-    return {
-        2.0f / (right - left), 0.0f, 0.0f, 0.0f,
-        0.0f, 2.0f / (top - bottom), 0.0f, 0.0f,
-        0.0f, 0.0f, 1.0f / (farClip - nearClip), 0.0f,
-        (left + right) / (left - right), (top + bottom) / (bottom - top), nearClip / (nearClip - farClip), 1.0f,
-    };
-}
-
-// clang-format on
-
+// マテリアルの機能の初期値。モデルのuvTransformは単位行列のままなので変換しない
+constexpr uint32_t kModelMaterialFeatures = kShaderFeatureLighting | kShaderFeatureHalfLambert;
+constexpr uint32_t kSpriteMaterialFeatures = kShaderFeatureUvTransform;
 
 std::wstring ConvertString(const std::string& str) {
     if (str.empty()) {
@@ -426,112 +130,51 @@ std::string ConvertString(const std::wstring& str) {
     return result;
 }
 
-MaterialData LoadMaterialTemplateFile(const std::string& directoryPath, const std::string& filename)
-{
-    MaterialData materialData;
-    std::string line; // ファイルから読んだ1行を格納するもの
-
-    std::ifstream file(directoryPath + "/" + filename); // ファイルを開く
-    assert(file.is_open());
-
-    while (std::getline(file, line)) {
-        std::string identifier;
-        std::istringstream s(line);
-        s >> identifier;
-
-        // identifierに応じた処理
-        if (identifier == "map_Kd") {
-            std::string textureFilename;
-            s >> textureFilename;
-            // 連結してファイルパスにする
-            materialData.textureFilePath = directoryPath + "/" + textureFilename;
-        }
-    }
-
-    return materialData;
-}
-
-ModelData LoadObjFile(const std::string& directoryPath, const std::string& filename) {
-    ModelData modelData; // 構築するModelData
-    std::vector<Vector4> positions; // 位置
-    std::vector<Vector3> normals; // 法線
-    std::vector<Vector2> texcoords; // テクスチャ座標
-    std::string line; // ファイルから読んだ1行を格納するもの
-
-    std::ifstream file(directoryPath + "/" + filename); // ファイルを開く
-    assert(file.is_open());
-
-    while (std::getline(file, line)) {
-        std::string identifier;
-        std::istringstream s(line);
-        s >> identifier;
-
-        // identifierに応じた処理
-        if (identifier == "v") {
-            Vector4 position;
-            s >> position.x >> position.y >> position.z;
-            position.x *= -1.0f;
-            position.w = 1.0f;
-            positions.push_back(position);
-        } else if (identifier == "vt") {
-            Vector2 texcoord;
-            s >> texcoord.x >> texcoord.y;
-            texcoord.y = 1.0f - texcoord.y;
-            texcoords.push_back(texcoord);
-        } else if (identifier == "vn") {
-            Vector3 normal;
-            s >> normal.x >> normal.y >> normal.z;
-            normal.x *= -1.0f;
-            normals.push_back(normal);
-        } else if (identifier == "f") {
-            VertexData triangle[3];
-            // 面は三角形限定。その他は未対応
-            for (int32_t faceVertex = 0; faceVertex < 3; ++faceVertex) {
-                std::string vertexDefinition;
-                s >> vertexDefinition;
-                // 頂点の要素へのIndexは、「位置/テクスチャ座標/法線」で格納されているので、分解してIndexを取得する
-                std::istringstream v(vertexDefinition);
-                uint32_t elementIndices[3];
-                for (int32_t element = 0; element < 3; ++element) {
-                    std::string index;
-                    std::getline(v, index, '/');
-                    elementIndices[element] = std::stoi(index);
-                }
-                // 要素へのIndexから、実際の要素の値を取得して、頂点を構築する
-                Vector4 position = positions[elementIndices[0] - 1];
-                Vector2 texcoord = texcoords[elementIndices[1] - 1];
-                Vector3 normal = normals[elementIndices[2] - 1];
-                triangle[faceVertex] = { position, texcoord, normal };
-                //VertexData vertex = { position, texcoord, normal };
-                //modelData.vertices.push_back(vertex);
-            }
-            modelData.vertices.push_back(triangle[2]);
-            modelData.vertices.push_back(triangle[1]);
-            modelData.vertices.push_back(triangle[0]);
-        } else if (identifier == "mtllib") {
-            std::string materialFilename;
-            s >> materialFilename;
-            modelData.material = LoadMaterialTemplateFile(directoryPath, materialFilename);
-        }
-    }
-
-    return modelData;
-}
-
-
 void Log(const std::string& message) {
     OutputDebugStringA(message.c_str());
 }
 
+// Debugビルドではシェーダーをデバッグしやすいよう最適化しない。Releaseビルドは事前コンパイル(--precompile-shaders)と同じ引数にしてキャッシュを共有する
+#ifdef _DEBUG
+constexpr bool kOptimizeShaders = false;
+#else
+constexpr bool kOptimizeShaders = true;
+#endif
+
+// コンパイルしたシェーダーを置くディレクトリ
+constexpr const char* kShaderCacheDirectory = "shadercache";
+// シェーダーの命令の内訳(--shader-cost-report)の出力と、比べる基準。基準は出力をコピーして更新する
+constexpr const char* kShaderCostReportPath = "shadercost.txt";
+constexpr const char* kShaderCostBaselinePath = "shadercost_baseline.txt";
+
 Microsoft::WRL::ComPtr<IDxcBlob> CompileShader(
     const std::wstring& filePath,
     const wchar_t* profile,
     const Microsoft::WRL::ComPtr<IDxcUtils>& dxcUtils,
     const Microsoft::WRL::ComPtr<IDxcCompiler3>& dxcCompiler,
-    const Microsoft::WRL::ComPtr<IDxcIncludeHandler>& includeHandler)
+    const Microsoft::WRL::ComPtr<IDxcIncludeHandler>& includeHandler,
+    const std::string& compilerVersion,
+    const std::vector<std::wstring>& defines = {},
+    bool optimize = kOptimizeShaders)
 {
     // これからシェーダーをコンパイルする旨をログに出す
     Log(ConvertString(std::format(L"Begin CompileShader, path:{}, profile:{}\n", filePath, profile)));
+    auto compileStart = std::chrono::steady_clock::now();
+
+    std::vector<std::wstring> argumentStrings = MakeShaderArguments(filePath, profile, defines, optimize);
+
+    // ソース、include、引数、DXCの版が同じものをコンパイルしたことがあれば、その結果を使う
+    uint64_t cacheKey = ComputeShaderCacheKey(filePath, argumentStrings, compilerVersion);
+    std::vector<uint8_t> cachedShader;
+    if (cacheKey != 0 && ReadShaderCache(kShaderCacheDirectory, cacheKey, cachedShader)) {
+        Microsoft::WRL::ComPtr<IDxcBlobEncoding> cachedShaderBlob = nullptr;
+        HRESULT hr = dxcUtils->CreateBlob(cachedShader.data(), UINT32(cachedShader.size()), DXC_CP_ACP, &cachedShaderBlob);
+        assert(SUCCEEDED(hr));
+        std::chrono::duration<double, std::milli> loadTime = std::chrono::steady_clock::now() - compileStart;
+        Log(ConvertString(std::format(L"Shader Cache Hit, path:{}, profile:{}, {:.3f}ms\n", filePath, profile, loadTime.count())));
+        return cachedShaderBlob;
+    }
+
     // hlslファイルを読む
     IDxcBlobEncoding* shaderSource = nullptr;
     HRESULT hr = dxcUtils->LoadFile(filePath.c_str(), nullptr, &shaderSource);
@@ -543,34 +186,34 @@ Microsoft::WRL::ComPtr<IDxcBlob> CompileShader(
     shaderSourceBuffer.Size = shaderSource->GetBufferSize();
     shaderSourceBuffer.Encoding = DXC_CP_UTF8; // UTF8の文字コードであることを通知
 
-    LPCWSTR arguments[] = {
-        filePath.c_str(), // コンパイル対象のhlslファイル名
-        L"-E", L"main", // エントリーポイントの指定。基本的にmain以外にはしない
-        L"-T", profile, // ShaderProfileの設定
-        L"-Zi", L"-Qembed_debug",   // デバッグ用の情報を埋め込む
-        L"-Od",     // 最適化を外しておく
-        L"-Zpr",    // メモリレイアウトは行優先
-    };
+    // コンパイルオプション。中身はMakeShaderArgumentsを参照
+    std::vector<LPCWSTR> arguments;
+    for (const std::wstring& argument : argumentStrings) {
+        arguments.push_back(argument.c_str());
+    }
 
     // 実際にShaderをコンパイルする
     IDxcResult* shaderResult = nullptr;
     hr = dxcCompiler->Compile(
         &shaderSourceBuffer,    // 読み込んだファイル
-        arguments,              // コンパイルオプション
-        _countof(arguments),    // コンパイルオプションの数
+        arguments.data(),       // コンパイルオプション
+        UINT32(arguments.size()), // コンパイルオプションの数
         includeHandler.Get(),         // includeが含まれた諸々
         IID_PPV_ARGS(&shaderResult) // コンパイル結果
     );
     // コンパイルエラーではなくdxcが起動できないなど致命的な状況
     assert(SUCCEEDED(hr));
 
-    // 警告・エラーが出てたらログに出して止める
+    // 警告・エラーが出てたらログに出してnullptrを返す。起動時は呼び出し側で止め、ホットリロード中は前のシェーダーを使い続ける
     IDxcBlobUtf8* shaderError = nullptr;
     shaderResult->GetOutput(DXC_OUT_ERRORS, IID_PPV_ARGS(&shaderError), nullptr);
     if (shaderError != nullptr && shaderError->GetStringLength() != 0) {
         Log(shaderError->GetStringPointer());
         // 警告・エラーダメゼッタイ
-        assert(false);
+        shaderError->Release();
+        shaderSource->Release();
+        shaderResult->Release();
+        return nullptr;
     }
 
     // コンパイル結果から実行用のバイナリ部分を取得
@@ -578,7 +221,13 @@ Microsoft::WRL::ComPtr<IDxcBlob> CompileShader(
     hr = shaderResult->GetOutput(DXC_OUT_OBJECT, IID_PPV_ARGS(&shaderBlob), nullptr);
     assert(SUCCEEDED(hr));
     // 成功したログを出す
-    Log(ConvertString(std::format(L"Compile Succeeded, path:{}, profile:{}\n", filePath, profile)));
+    std::chrono::duration<double, std::milli> compileTime = std::chrono::steady_clock::now() - compileStart;
+    Log(ConvertString(std::format(L"Compile Succeeded, path:{}, profile:{}, {:.3f}ms\n", filePath, profile, compileTime.count())));
+
+    // 次の起動で使えるようにキャッシュに入れる。書けなくても毎回コンパイルするだけなので続ける
+    if (cacheKey != 0 && !WriteShaderCache(kShaderCacheDirectory, cacheKey, shaderBlob->GetBufferPointer(), shaderBlob->GetBufferSize())) {
+        Log(ConvertString(std::format(L"Shader Cache Write Failed, path:{}\n", filePath)));
+    }
 
     // もう使わないリソースを解放
     shaderSource->Release();
@@ -588,6 +237,268 @@ Microsoft::WRL::ComPtr<IDxcBlob> CompileShader(
     return shaderBlob;
 }
 
+/// <summary>
+/// DXCの既定のIncludeHandlerに任せつつ、読んだファイルを覚える
+/// </summary>
+class RecordingIncludeHandler : public Microsoft::WRL::RuntimeClass<Microsoft::WRL::RuntimeClassFlags<Microsoft::WRL::ClassicCom>, IDxcIncludeHandler> {
+public:
+    explicit RecordingIncludeHandler(const Microsoft::WRL::ComPtr<IDxcIncludeHandler>& defaultIncludeHandler)
+        : defaultIncludeHandler_(defaultIncludeHandler)
+    {
+    }
+
+    HRESULT STDMETHODCALLTYPE LoadSource(LPCWSTR pFilename, IDxcBlob** ppIncludeSource) override
+    {
+        HRESULT hr = defaultIncludeHandler_->LoadSource(pFilename, ppIncludeSource);
+        if (SUCCEEDED(hr)) {
+            includes_.push_back(std::filesystem::path(pFilename).lexically_normal());
+        }
+        return hr;
+    }
+
+    void ClearIncludes() { includes_.clear(); }
+    const std::vector<std::filesystem::path>& GetIncludes() const { return includes_; }
+
+private:
+    Microsoft::WRL::ComPtr<IDxcIncludeHandler> defaultIncludeHandler_;
+    std::vector<std::filesystem::path> includes_; //!< ClearIncludesの後に読んだファイル
+};
+
+/// <summary>
+/// キャッシュのキーに入れるDXCの版。"major.minor"に、取れればコミットの数とハッシュを付ける
+/// 同じ版番号でもビルドが違えば出力が変わりうるので、コミットまで区別する
+/// </summary>
+std::string GetDxcVersionString(const Microsoft::WRL::ComPtr<IDxcCompiler3>& dxcCompiler)
+{
+    Microsoft::WRL::ComPtr<IDxcVersionInfo> versionInfo = nullptr;
+    UINT32 major = 0;
+    UINT32 minor = 0;
+    if (FAILED(dxcCompiler.As(&versionInfo)) || FAILED(versionInfo->GetVersion(&major, &minor))) {
+        return "unknown";
+    }
+    std::string version = std::format("{}.{}", major, minor);
+    Microsoft::WRL::ComPtr<IDxcVersionInfo2> versionInfo2 = nullptr;
+    UINT32 commitCount = 0;
+    char* commitHash = nullptr;
+    if (SUCCEEDED(dxcCompiler.As(&versionInfo2)) && SUCCEEDED(versionInfo2->GetCommitInfo(&commitCount, &commitHash))) {
+        version += std::format(" {} {}", commitCount, commitHash != nullptr ? commitHash : "");
+        // GetCommitInfoの文字列はCoTaskMemAllocで確保されている
+        CoTaskMemFree(commitHash);
+    }
+    return version;
+}
+
+/// <summary>
+/// ShaderBuildServiceのスレッドで呼び、そのスレッド専用のDXCのインスタンスでコンパイルする関数を作る
+/// </summary>
+ShaderCompileFunction CreateShaderCompiler()
+{
+    // dxcCompilerを初期化
+    Microsoft::WRL::ComPtr<IDxcUtils> dxcUtils = nullptr;
+    Microsoft::WRL::ComPtr<IDxcCompiler3> dxcCompiler = nullptr;
+    HRESULT hr = DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&dxcUtils));
+    assert(SUCCEEDED(hr));
+    hr = DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&dxcCompiler));
+    assert(SUCCEEDED(hr));
+
+    // includeに対応するための設定を行っておく。DXCが読んだファイルを覚えておき、ホットリロードの依存関係に使う
+    Microsoft::WRL::ComPtr<IDxcIncludeHandler> defaultIncludeHandler = nullptr;
+    hr = dxcUtils->CreateDefaultIncludeHandler(&defaultIncludeHandler);
+    assert(SUCCEEDED(hr));
+    Microsoft::WRL::ComPtr<RecordingIncludeHandler> includeHandler = Microsoft::WRL::Make<RecordingIncludeHandler>(defaultIncludeHandler);
+    std::string compilerVersion = GetDxcVersionString(dxcCompiler);
+
+    return [dxcUtils, dxcCompiler, includeHandler, compilerVersion](const ShaderRequest& request) {
+        includeHandler->ClearIncludes();
+        ShaderBinary binary;
+        Microsoft::WRL::ComPtr<IDxcBlob> shaderBlob = CompileShader(request.filePath, request.profile.c_str(), dxcUtils, dxcCompiler, includeHandler, compilerVersion, request.defines, request.optimize);
+        if (shaderBlob != nullptr) {
+            const uint8_t* data = static_cast<const uint8_t*>(shaderBlob->GetBufferPointer());
+            binary.dxil.assign(data, data + shaderBlob->GetBufferSize());
+        }
+        // キャッシュを使ったときはDXCがincludeを読まないので、ソースからたどる
+        binary.includes = includeHandler->GetIncludes();
+        if (binary.includes.empty()) {
+            binary.includes = CollectShaderIncludes(request.filePath);
+        }
+        return binary;
+    };
+}
+
+/// <summary>
+/// 機能の組み合わせfeaturesで特殊化したPixelShaderの要求
+/// </summary>
+ShaderRequest MakePixelShaderRequest(uint32_t features, bool optimize = kOptimizeShaders)
+{
+    return { L"Object3D.PS.hlsl", L"ps_6_0", GetShaderFeatureDefines(NormalizeShaderFeatures(features)), optimize };
+}
+
+/// <summary>
+/// 起動引数の--shader-threads=Nで指定したシェーダーのコンパイルに使うスレッドの数。指定がなければ論理コア数
+/// </summary>
+uint32_t GetShaderThreadCount(const char* commandLine)
+{
+    const char* option = std::strstr(commandLine, "--shader-threads=");
+    if (option != nullptr) {
+        int threadCount = std::atoi(option + std::strlen("--shader-threads="));
+        if (threadCount >= 1) {
+            return static_cast<uint32_t>(threadCount);
+        }
+    }
+    uint32_t threadCount = std::thread::hardware_concurrency();
+    return threadCount == 0 ? 1 : threadCount;
+}
+
+/// <summary>
+/// 起動引数の--obj-streaming-mb=Nで指定した、OBJをImportObjFileStreamingで読む大きさ(MB)。0なら常にストリーミングで読む
+/// </summary>
+ModelImportSettings GetModelImportSettings(const char* commandLine)
+{
+    ModelImportSettings settings;
+    const char* option = std::strstr(commandLine, "--obj-streaming-mb=");
+    if (option != nullptr) {
+        settings.streamingFileSize = std::strtoull(option + std::strlen("--obj-streaming-mb="), nullptr, 10) << 20;
+    }
+    return settings;
+}
+
+/// <summary>
+/// 配布用に最適化したシェーダーの、実行時に使う組み合わせ全て
+/// </summary>
+std::vector<ShaderRequest> GetDistributedShaderRequests()
+{
+    std::vector<ShaderRequest> requests;
+    // モデルの頂点形式ごとのVertexShader。マクロの並びはWinMainでモデルのPSOを作るときと同じにする
+    const std::vector<std::wstring> vertexShaderDefines[] = {
+        {},
+        { L"PACKED_VERTEX" },
+        { L"PACKED_VERTEX", L"QUANTIZED_POSITION" },
+    };
+    for (const std::vector<std::wstring>& defines : vertexShaderDefines) {
+        requests.push_back({ L"Object3D.VS.hlsl", L"vs_6_0", defines, true });
+    }
+    // PixelShaderは起こりうる機能の組み合わせ全て
+    for (uint32_t features : EnumerateShaderPermutations()) {
+        requests.push_back(MakePixelShaderRequest(features, true));
+    }
+    return requests;
+}
+
+/// <summary>
+/// 配布用に最適化したシェーダーを、実行時に使う組み合わせ全てについてコンパイルしてキャッシュに入れる
+/// </summary>
+void PrecompileShaders(uint32_t threadCount)
+{
+    auto precompileStart = std::chrono::steady_clock::now();
+    ShaderBuildService shaderBuildService;
+    shaderBuildService.Start(threadCount, CreateShaderCompiler);
+
+    std::vector<std::shared_future<ShaderBinary>> shaders;
+    for (const ShaderRequest& request : GetDistributedShaderRequests()) {
+        shaders.push_back(shaderBuildService.Submit(request));
+    }
+    uint32_t failedCount = 0;
+    for (const std::shared_future<ShaderBinary>& shader : shaders) {
+        if (shader.get().dxil.empty()) {
+            ++failedCount;
+        }
+    }
+    std::chrono::duration<double, std::milli> precompileTime = std::chrono::steady_clock::now() - precompileStart;
+    Log(std::format("PrecompileShaders : {} threads, {:.3f}ms, {} failed\n", threadCount, precompileTime.count(), failedCount));
+}
+
+/// <summary>
+/// 報告に使うシェーダーの名前。ファイル:プロファイル:マクロ(,区切り)
+/// </summary>
+std::string MakeShaderCostName(const ShaderRequest& request)
+{
+    std::wstring name = request.filePath + L":" + request.profile + L":";
+    for (size_t i = 0; i < request.defines.size(); ++i) {
+        name += (i == 0 ? L"" : L",") + request.defines[i];
+    }
+    return ConvertString(name);
+}
+
+/// <summary>
+/// 配布用のシェーダーを逆アセンブルして命令の内訳をkShaderCostReportPathに書き、kShaderCostBaselinePathと比べる
+/// 基準より増えたもの、基準のファイルがない・読めないこと、逆アセンブルの失敗があれば報告の末尾に書いて1を返す。CIはこの戻り値で失敗させる
+/// 基準にないシェーダーは報告の末尾に書くだけで失敗にしない。基準に加えた後から増えたものを失敗にする
+/// </summary>
+int ReportShaderCosts(uint32_t threadCount)
+{
+    ShaderBuildService shaderBuildService;
+    shaderBuildService.Start(threadCount, CreateShaderCompiler);
+    std::vector<ShaderRequest> requests = GetDistributedShaderRequests();
+    std::vector<std::shared_future<ShaderBinary>> shaders;
+    for (const ShaderRequest& request : requests) {
+        shaders.push_back(shaderBuildService.Submit(request));
+    }
+
+    // 逆アセンブルはこのスレッドのDXCで行う
+    Microsoft::WRL::ComPtr<IDxcCompiler3> dxcCompiler = nullptr;
+    HRESULT hr = DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&dxcCompiler));
+    assert(SUCCEEDED(hr));
+
+    std::vector<NamedShaderCost> costs;
+    std::vector<std::string> errors;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        const ShaderBinary& shader = shaders[i].get();
+        std::string name = MakeShaderCostName(requests[i]);
+        if (shader.dxil.empty()) {
+            errors.push_back(name + ": compile failed");
+            continue;
+        }
+        DxcBuffer shaderBuffer{};
+        shaderBuffer.Ptr = shader.dxil.data();
+        shaderBuffer.Size = shader.dxil.size();
+        // 逆アセンブルできなければ、そのシェーダーは数えられないので失敗にする
+        Microsoft::WRL::ComPtr<IDxcResult> disassembleResult = nullptr;
+        hr = dxcCompiler->Disassemble(&shaderBuffer, IID_PPV_ARGS(&disassembleResult));
+        if (FAILED(hr)) {
+            errors.push_back(std::format("{}: disassemble failed (0x{:08x})", name, static_cast<uint32_t>(hr)));
+            continue;
+        }
+        Microsoft::WRL::ComPtr<IDxcBlobUtf8> disassembly = nullptr;
+        hr = disassembleResult->GetOutput(DXC_OUT_DISASSEMBLY, IID_PPV_ARGS(&disassembly), nullptr);
+        if (FAILED(hr) || disassembly == nullptr) {
+            errors.push_back(std::format("{}: no disassembly output (0x{:08x})", name, static_cast<uint32_t>(hr)));
+            continue;
+        }
+        costs.push_back({ name, AnalyzeDxilDisassembly({ disassembly->GetStringPointer(), disassembly->GetStringLength() }) });
+    }
+
+    // 基準のファイルがない、読めない場合は比べられないので失敗にする
+    std::ifstream baselineFile(kShaderCostBaselinePath);
+    std::string baselineText((std::istreambuf_iterator<char>(baselineFile)), std::istreambuf_iterator<char>());
+    std::vector<NamedShaderCost> baseline;
+    std::vector<std::string> notes;
+    if (!baselineFile.is_open() || baselineFile.bad()) {
+        errors.push_back(std::string(kShaderCostBaselinePath) + ": cannot read");
+    } else if (!ParseShaderCostReport(baselineText, baseline)) {
+        errors.push_back(std::string(kShaderCostBaselinePath) + ": invalid format");
+    } else {
+        for (const std::string& name : FindShadersWithoutBaseline(baseline, costs)) {
+            notes.push_back(name + ": not in " + kShaderCostBaselinePath);
+        }
+        for (const std::string& regression : CompareShaderCosts(baseline, costs)) {
+            errors.push_back(regression);
+        }
+    }
+
+    // 悪化と注意は#の行に書くので、報告はそのまま次の基準に使える
+    std::string report = FormatShaderCostReport(costs);
+    for (const std::string& note : notes) {
+        report += "# note " + note + "\n";
+    }
+    for (const std::string& error : errors) {
+        report += "# error " + error + "\n";
+    }
+    std::ofstream reportFile(kShaderCostReportPath, std::ios::trunc);
+    reportFile << report;
+    Log(report);
+    return errors.empty() && reportFile.good() ? 0 : 1;
+}
+
 
 Microsoft::WRL::ComPtr<ID3D12Resource> CreateBufferResource(const Microsoft::WRL::ComPtr<ID3D12Device>& device, size_t sizeInBytes)
 {
@@ -617,6 +528,28 @@ Microsoft::WRL::ComPtr<ID3D12Resource> CreateBufferResource(const Microsoft::WRL
     return resource;
 }
 
+/// <summary>
+/// 毎フレーム書き換えるデータ用の、永続的にMapした大きなUploadバッファ。切り出す場所はallocatorで管理する
+/// </summary>
+struct UploadRing {
+    Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+    uint8_t* mappedData = nullptr;
+    UploadRingAllocator allocator;
+};
+
+/// <summary>
+/// 今のフレーム用にdataをUploadRingへ書き込み、SetGraphicsRootConstantBufferViewに渡すGPUのアドレスを返す
+/// </summary>
+template<typename T>
+D3D12_GPU_VIRTUAL_ADDRESS WriteUpload(UploadRing& ring, const T& data)
+{
+    uint64_t offset = ring.allocator.Allocate(sizeof(T));
+    // リングは同時に進めるフレームの数(kMaxFramesInFlight)分の使用量より十分大きいので足りなくなることはない
+    assert(offset != UploadRingAllocator::kInvalidOffset);
+    std::memcpy(ring.mappedData + offset, &data, sizeof(T));
+    return ring.resource->GetGPUVirtualAddress() + offset;
+}
+
 DirectX::ScratchImage LoadTexture(const std::string& filePath)
 {
     // テクスチャファイルを読んでプログラムで扱えるようにする
@@ -749,6 +682,212 @@ void WaitSignal(const Microsoft::WRL::ComPtr<ID3D12Fence>& fence, uint64_t signa
     }
 }
 
+/// <summary>
+/// コマンドキューとFenceで実装したFrameQueue
+/// </summary>
+class CommandQueueFrameQueue : public FrameQueue {
+public:
+    CommandQueueFrameQueue(const Microsoft::WRL::ComPtr<ID3D12CommandQueue>& commandQueue, const Microsoft::WRL::ComPtr<ID3D12Fence>& fence, HANDLE event)
+        : commandQueue_(commandQueue), fence_(fence), event_(event), fenceValue_(fence->GetCompletedValue())
+    {
+    }
+
+    uint64_t Signal() override
+    {
+        ++fenceValue_;
+        commandQueue_->Signal(fence_.Get(), fenceValue_);
+        return fenceValue_;
+    }
+
+    uint64_t GetCompletedValue() override { return fence_->GetCompletedValue(); }
+
+    void Wait(uint64_t value) override { WaitSignal(fence_, value, event_); }
+
+private:
+    Microsoft::WRL::ComPtr<ID3D12CommandQueue> commandQueue_;
+    Microsoft::WRL::ComPtr<ID3D12Fence> fence_;
+    HANDLE event_; //!< Fenceを待つためのイベント
+    uint64_t fenceValue_; //!< 最後にSignalした値
+};
+
+/// <summary>
+/// シェーダー以外を決めた元の設定ごとに、機能の組み合わせで特殊化したPixelShaderのPSOを持つ
+/// PSOは初めて使われたときに、シェーダーのコンパイルを待って作る
+/// ソースが変わったら、そのソースを使うPSOだけを裏でコンパイルし直し、できたものからフレームの間で差し替える
+/// </summary>
+class PipelineStateVariants {
+public:
+    PipelineStateVariants(const Microsoft::WRL::ComPtr<ID3D12Device>& device, ShaderBuildService& shaderBuildService, ShaderHotReload& shaderHotReload)
+        : device_(device), shaderBuildService_(shaderBuildService), shaderHotReload_(shaderHotReload)
+    {
+    }
+
+    /// <summary>
+    /// 元の設定とVertexShaderを加えてその番号を返す。descのVSとPSは使わない。InputLayoutの指す先は使い終わるまで生きていること
+    /// </summary>
+    uint32_t AddBase(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, const ShaderRequest& vertexShader)
+    {
+        bases_.push_back({ desc, vertexShader });
+        variants_.resize(bases_.size() << kShaderFeatureCount);
+        return static_cast<uint32_t>(bases_.size() - 1);
+    }
+
+    /// <summary>
+    /// 元の設定baseと機能の組み合わせfeaturesのPSOの番号(DrawPacket::pipeline)。まだなければここで作る
+    /// </summary>
+    uint32_t Get(uint32_t base, uint32_t features)
+    {
+        features = NormalizeShaderFeatures(features);
+        uint32_t pipeline = (base << kShaderFeatureCount) | features;
+        Variant& variant = variants_[pipeline];
+        if (variant.pipelineState == nullptr) {
+            variant.vertexShader = shaderBuildService_.Submit(bases_[base].vertexShader);
+            variant.pixelShader = shaderBuildService_.Submit(MakePixelShaderRequest(features));
+            bool created = CreatePipelineState(pipeline, variant.vertexShader.get(), variant.pixelShader.get(), variant.pipelineState);
+            // 起動時や初めて使う組み合わせのシェーダーは直してから起動し直す
+            assert(created);
+            (void)created;
+            ++createdCount_;
+        }
+        return pipeline;
+    }
+
+    /// <summary>
+    /// rootsのソースを使う作成済みのPSOについて、シェーダーのコンパイルをし直し始める。できるまでは今のPSOを使い続ける
+    /// </summary>
+    void Reload(const std::vector<std::filesystem::path>& roots)
+    {
+        shaderBuildService_.Invalidate(roots);
+        for (uint32_t pipeline = 0; pipeline < variants_.size(); ++pipeline) {
+            Variant& variant = variants_[pipeline];
+            if (variant.pipelineState == nullptr) {
+                continue;
+            }
+            ShaderRequest vertexShader = GetVertexShaderRequest(pipeline);
+            ShaderRequest pixelShader = GetPixelShaderRequest(pipeline);
+            if (UsesSource(vertexShader, roots) || UsesSource(pixelShader, roots)) {
+                variant.reloadingVertexShader = shaderBuildService_.Submit(vertexShader);
+                variant.reloadingPixelShader = shaderBuildService_.Submit(pixelShader);
+            }
+        }
+    }
+
+    /// <summary>
+    /// コンパイルし終わったものからPSOを作り直して差し替える。コンパイルは待たない。フレームを始めるときに呼ぶ
+    /// 失敗したら前のPSOを使い続ける
+    /// </summary>
+    void Update()
+    {
+        for (uint32_t pipeline = 0; pipeline < variants_.size(); ++pipeline) {
+            Variant& variant = variants_[pipeline];
+            if (!variant.reloadingVertexShader.valid() || !IsReady(variant.reloadingVertexShader) || !IsReady(variant.reloadingPixelShader)) {
+                continue;
+            }
+            Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineState = nullptr;
+            if (CreatePipelineState(pipeline, variant.reloadingVertexShader.get(), variant.reloadingPixelShader.get(), pipelineState)) {
+                // 前のPSOは実行中のフレームが使っているかもしれないので、GPUが終えるまで持っておく
+                frameRetiredPipelineStates_.push_back(std::move(variant.pipelineState));
+                variant.pipelineState = std::move(pipelineState);
+                variant.vertexShader = std::move(variant.reloadingVertexShader);
+                variant.pixelShader = std::move(variant.reloadingPixelShader);
+                ++reloadedCount_;
+            } else {
+                ++failedReloadCount_;
+            }
+            variant.reloadingVertexShader = {};
+            variant.reloadingPixelShader = {};
+        }
+    }
+
+    /// <summary>
+    /// 今のフレームで差し替えた前のPSOを、GPUがfenceValueに届くまで持っておく
+    /// </summary>
+    void FinishFrame(uint64_t fenceValue)
+    {
+        for (Microsoft::WRL::ComPtr<ID3D12PipelineState>& pipelineState : frameRetiredPipelineStates_) {
+            retiredPipelineStates_.push_back({ std::move(pipelineState), fenceValue });
+        }
+        frameRetiredPipelineStates_.clear();
+    }
+
+    /// <summary>
+    /// GPUがcompletedFenceValueまで届いたので、それまでに差し替えた前のPSOを解放する
+    /// </summary>
+    void Retire(uint64_t completedFenceValue)
+    {
+        while (!retiredPipelineStates_.empty() && retiredPipelineStates_.front().second <= completedFenceValue) {
+            retiredPipelineStates_.pop_front();
+        }
+    }
+
+    ID3D12PipelineState* GetPipelineState(uint32_t pipeline) const { return variants_[pipeline].pipelineState.Get(); }
+    uint32_t GetCreatedCount() const { return createdCount_; }
+    uint32_t GetPermutationCount() const { return static_cast<uint32_t>(bases_.size() * EnumerateShaderPermutations().size()); }
+    uint32_t GetReloadedCount() const { return reloadedCount_; }
+    uint32_t GetFailedReloadCount() const { return failedReloadCount_; }
+
+private:
+    /// <summary>
+    /// 元の設定
+    /// </summary>
+    struct PipelineBase {
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC desc;
+        ShaderRequest vertexShader;
+    };
+
+    /// <summary>
+    /// 1つの組み合わせのPSOと、その元のシェーダー。futureを持つことでシェーダーのバイナリも生きている
+    /// </summary>
+    struct Variant {
+        Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineState;
+        std::shared_future<ShaderBinary> vertexShader;
+        std::shared_future<ShaderBinary> pixelShader;
+        std::shared_future<ShaderBinary> reloadingVertexShader; // コンパイルし直している間だけvalid
+        std::shared_future<ShaderBinary> reloadingPixelShader;
+    };
+
+    static bool IsReady(const std::shared_future<ShaderBinary>& shader)
+    {
+        return shader.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    static bool UsesSource(const ShaderRequest& request, const std::vector<std::filesystem::path>& roots)
+    {
+        return std::find(roots.begin(), roots.end(), std::filesystem::path(request.filePath).lexically_normal()) != roots.end();
+    }
+
+    ShaderRequest GetVertexShaderRequest(uint32_t pipeline) const { return bases_[pipeline >> kShaderFeatureCount].vertexShader; }
+    ShaderRequest GetPixelShaderRequest(uint32_t pipeline) const { return MakePixelShaderRequest(pipeline & ((1u << kShaderFeatureCount) - 1)); }
+
+    /// <summary>
+    /// 2つのシェーダーでPSOを作る。読んだファイルはホットリロードで見張る。どちらかのコンパイルに失敗していたらfalse
+    /// </summary>
+    bool CreatePipelineState(uint32_t pipeline, const ShaderBinary& vertexShader, const ShaderBinary& pixelShader, Microsoft::WRL::ComPtr<ID3D12PipelineState>& pipelineState)
+    {
+        shaderHotReload_.SetDependencies(GetVertexShaderRequest(pipeline).filePath, vertexShader.includes);
+        shaderHotReload_.SetDependencies(GetPixelShaderRequest(pipeline).filePath, pixelShader.includes);
+        if (vertexShader.dxil.empty() || pixelShader.dxil.empty()) {
+            return false;
+        }
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = bases_[pipeline >> kShaderFeatureCount].desc;
+        desc.VS = { vertexShader.dxil.data(), vertexShader.dxil.size() };
+        desc.PS = { pixelShader.dxil.data(), pixelShader.dxil.size() };
+        HRESULT hr = device_->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pipelineState));
+        return SUCCEEDED(hr);
+    }
+
+    Microsoft::WRL::ComPtr<ID3D12Device> device_;
+    ShaderBuildService& shaderBuildService_;
+    ShaderHotReload& shaderHotReload_;
+    std::vector<PipelineBase> bases_; //!< 元の設定
+    std::vector<Variant> variants_; //!< (base << kShaderFeatureCount) | featuresの順。作っていなければpipelineStateがnullptr
+    std::vector<Microsoft::WRL::ComPtr<ID3D12PipelineState>> frameRetiredPipelineStates_; //!< 今のフレームで差し替えた前のPSO
+    std::deque<std::pair<Microsoft::WRL::ComPtr<ID3D12PipelineState>, uint64_t>> retiredPipelineStates_; //!< GPUが使い終わるのを待っている前のPSO。古い順
+    uint32_t createdCount_ = 0; //!< 作ったPSOの数
+    uint32_t reloadedCount_ = 0; //!< ホットリロードで差し替えた数
+    uint32_t failedReloadCount_ = 0; //!< ホットリロードでコンパイルかPSOの作成に失敗した数
+};
+
 D3D12_CPU_DESCRIPTOR_HANDLE GetCPUDescriptorHandle(const Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>& descriptorHeap, uint32_t descriptorSize, uint32_t index)
 {
     D3D12_CPU_DESCRIPTOR_HANDLE handleCPU = descriptorHeap->GetCPUDescriptorHandleForHeapStart();
@@ -796,13 +935,37 @@ struct D3DResourceLeakChecker {
 };
 
 // Windowsアプリでのエントリーポイント(main関数)
-int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
+int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR commandLine, int) {
 
     D3DResourceLeakChecker leakCheck;
 
     // メインスレッドではMTAでCOM利用
     HRESULT hr = CoInitializeEx(0, COINIT_MULTITHREADED);
 
+    // --precompile-shadersを付けて起動したら、ウィンドウを作らずに配布用のシェーダーをキャッシュに入れて終わる
+    uint32_t shaderThreadCount = GetShaderThreadCount(commandLine);
+    if (std::strstr(commandLine, "--precompile-shaders") != nullptr) {
+        PrecompileShaders(shaderThreadCount);
+        CoUninitialize();
+        return 0;
+    }
+    // --shader-cost-reportなら、シェーダーの命令の内訳を書き出して基準と比べて終わる。悪化していれば1を返す
+    if (std::strstr(commandLine, "--shader-cost-report") != nullptr) {
+        int result = ReportShaderCosts(shaderThreadCount);
+        CoUninitialize();
+        return result;
+    }
+
+    // シェーダーはウィンドウやデバイスを作っている間に裏でコンパイルし、PSOを作るときにそのPSOが使うものだけを待つ
+    auto startupStart = std::chrono::steady_clock::now();
+    ShaderBuildService shaderBuildService;
+    shaderBuildService.Start(shaderThreadCount, CreateShaderCompiler);
+    const ShaderRequest spriteVertexShaderRequest = { L"Object3D.VS.hlsl", L"vs_6_0", {}, kOptimizeShaders };
+    shaderBuildService.Submit(spriteVertexShaderRequest);
+    // PixelShaderは最初に使う機能の組み合わせだけ。他の組み合わせは切り替えたときにコンパイルする
+    shaderBuildService.Submit(MakePixelShaderRequest(kModelMaterialFeatures));
+    shaderBuildService.Submit(MakePixelShaderRequest(kSpriteMaterialFeatures));
+
     WNDCLASS wc{};
     // ウィンドウプロシージャ
     wc.lpfnWndProc = WindowProc;
@@ -819,6 +982,8 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
     // クライアント領域のサイズ
     const int32_t kClientWidth = 1280;
     const int32_t kClientHeight = 720;
+    // CPUが先に進めてよいフレームの数の上限。フレームごとのコマンドアロケータとImGuiのバッファをこの数だけ持つ
+    const uint32_t kMaxFramesInFlight = 3;
 
     // ウィンドウサイズを表す構造体にクライアント領域を入れる
     RECT wrc = { 0, 0, kClientWidth, kClientHeight };
@@ -950,15 +1115,17 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
     // コマンドキューの生成がうまくいかなかったので起動できない
     assert(SUCCEEDED(hr));
 
-    // コマンドアロケータを生成する
-    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> commandAllocator = nullptr;
-    hr = device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&commandAllocator));
-    // コマンドアロケータの生成がうまくいかなかったので起動できない
-    assert(SUCCEEDED(hr));
+    // コマンドアロケータを生成する。GPUが実行中のフレームの分は使えないので、同時に進めるフレームの数だけ用意する
+    std::vector<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>> commandAllocators(kMaxFramesInFlight);
+    for (Microsoft::WRL::ComPtr<ID3D12CommandAllocator>& commandAllocator : commandAllocators) {
+        hr = device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&commandAllocator));
+        // コマンドアロケータの生成がうまくいかなかったので起動できない
+        assert(SUCCEEDED(hr));
+    }
 
     // コマンドリストを生成する
     Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> commandList = nullptr;
-    hr = device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocator.Get(), nullptr, IID_PPV_ARGS(&commandList));
+    hr = device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocators[0].Get(), nullptr, IID_PPV_ARGS(&commandList));
     // コマンドリストの生成がうまくいかなかったので起動できない
     assert(SUCCEEDED(hr));
 
@@ -985,8 +1152,14 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
     // ディスクリプタヒープの生成
     // RTV用のヒープでディスクリプタの数は2。RTVはShader内で触るものではないので、ShaderVisibleはfalse
     Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> rtvDescriptorHeap = CreateDescriptorHeap(device, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, 2, false);
-    // SRV用のヒープでディスクリプタの数は128。SRVはShader内で触るものなので、ShaderVisibleはtrue
-    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> srvDescriptorHeap = CreateDescriptorHeap(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 128, true);
+    // SRV用のヒープ。SRVはShader内で触るものなので、ShaderVisibleはtrue
+    // 先頭のkSrvPersistentDescriptorCount個はTextureなど長く使うSRV用、残りはフレームごとのDescriptorTable用
+    const uint32_t kSrvDescriptorCount = 4096;
+    const uint32_t kSrvPersistentDescriptorCount = 3072;
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> srvDescriptorHeap = CreateDescriptorHeap(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, kSrvDescriptorCount, true);
+    // SRVを置く番号は固定せず、ここから確保する
+    DescriptorAllocator srvDescriptorAllocator;
+    srvDescriptorAllocator.Initialize(kSrvDescriptorCount, kSrvPersistentDescriptorCount);
     // DSV用のヒープでディスクリプタの数は1。DSVはShader内で触るものではないので、ShaderVisibleはfalse
     Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> dsvDescriptorHeap = CreateDescriptorHeap(device, D3D12_DESCRIPTOR_HEAP_TYPE_DSV, 1, false);
 
@@ -1039,31 +1212,32 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
     HANDLE fenceEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
     assert(fenceEvent != nullptr);
 
-    // dxcCompilerを初期化
-    Microsoft::WRL::ComPtr<IDxcUtils> dxcUtils = nullptr;
-    Microsoft::WRL::ComPtr<IDxcCompiler3> dxcCompiler = nullptr;
-    hr = DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&dxcUtils));
-    assert(SUCCEEDED(hr));
-    hr = DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&dxcCompiler));
-    assert(SUCCEEDED(hr));
-
-    // 現時点でincludeはしないが、includeに対応するための設定を行っておく
-    Microsoft::WRL::ComPtr<IDxcIncludeHandler> includeHandler = nullptr;
-    hr = dxcUtils->CreateDefaultIncludeHandler(&includeHandler);
-    assert(SUCCEEDED(hr));
+    // フレームごとにSignalし、次に使うコマンドアロケータをGPUが使い終わるまでだけ待つ
+    CommandQueueFrameQueue frameQueue(commandQueue, fence, fenceEvent);
+    FrameScheduler frameScheduler;
+    frameScheduler.Initialize(&frameQueue, kMaxFramesInFlight, 2);
 
     // RootSignature作成
     D3D12_ROOT_SIGNATURE_DESC descriptionRootSignature{};
     descriptionRootSignature.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
 
     // RootParameter作成。PixelShaderのMaterialとVertexShaderのTransform
-    D3D12_ROOT_PARAMETER rootParameters[4] = {};
+    D3D12_ROOT_PARAMETER rootParameters[5] = {};
     rootParameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;    // CBVを使う
     rootParameters[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;   // PixelShaderで使う
     rootParameters[0].Descriptor.ShaderRegister = 0;    // レジスタ番号0を使う
-    rootParameters[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;    // CBVを使う
+    // TransformationMatrixの配列(インスタンスバッファ)。1つだけの描画は要素1個の配列として渡す
+    // SRVはフレームごとにDescriptorAllocatorのフレームごとの領域に作り、要素の数を範囲外の読み取りの境界にする
+    D3D12_DESCRIPTOR_RANGE transformDescriptorRange[1] = {};
+    transformDescriptorRange[0].BaseShaderRegister = 0;  // 0から始まる
+    transformDescriptorRange[0].NumDescriptors = 1;  // 数は1つ
+    transformDescriptorRange[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV; // SRVを使う
+    transformDescriptorRange[0].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND; // Offsetを自動計算
+
+    rootParameters[1].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE; // DescriptorTableを使う
     rootParameters[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;   // VertexShaderで使う
-    rootParameters[1].Descriptor.ShaderRegister = 0;    // レジスタ番号0を使う
+    rootParameters[1].DescriptorTable.pDescriptorRanges = transformDescriptorRange;  // Tableの中身の配列を指定
+    rootParameters[1].DescriptorTable.NumDescriptorRanges = _countof(transformDescriptorRange); // Tableで利用する数
 
     D3D12_DESCRIPTOR_RANGE descriptorRange[1] = {};
     descriptorRange[0].BaseShaderRegister = 0;  // 0から始まる
@@ -1080,6 +1254,11 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
     rootParameters[3].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;   // PixelShdaderで使う
     rootParameters[3].Descriptor.ShaderRegister = 1;    // レジスタ番号1を使う
 
+    rootParameters[4].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;  // 定数を直接渡す
+    rootParameters[4].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;   // VertexShaderで使う
+    rootParameters[4].Constants.ShaderRegister = 1;    // レジスタ番号1を使う
+    rootParameters[4].Constants.Num32BitValues = UINT(sizeof(VertexDecode) / sizeof(uint32_t));  // 量子化した位置の戻し方
+
     descriptionRootSignature.pParameters = rootParameters;  // ルートパラメータ配列へのポインタ
     descriptionRootSignature.NumParameters = _countof(rootParameters);  // 配列の長さ
 
@@ -1147,23 +1326,12 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
     // 比較関数はLessEqual。つまり、近ければ描画される
     depthStencilDesc.DepthFunc = D3D12_COMPARISON_FUNC_LESS_EQUAL;
 
-    // Shaderをコンパイルする
-    Microsoft::WRL::ComPtr<IDxcBlob> vertexShaderBlob = CompileShader(L"Object3D.VS.hlsl", L"vs_6_0", dxcUtils, dxcCompiler, includeHandler);
-    assert(vertexShaderBlob != nullptr);
-
-    Microsoft::WRL::ComPtr<IDxcBlob> pixelShaderBlob = CompileShader(L"Object3D.PS.hlsl", L"ps_6_0", dxcUtils, dxcCompiler, includeHandler);
-    assert(pixelShaderBlob != nullptr);
-
     // GraphicsPipelineStateの生成
     D3D12_GRAPHICS_PIPELINE_STATE_DESC graphicsPipelineStateDesc{};
     // RootSignature
     graphicsPipelineStateDesc.pRootSignature = rootSignature.Get();
     // InputLayout
     graphicsPipelineStateDesc.InputLayout = inputLayoutDesc;
-    // VertexShader
-    graphicsPipelineStateDesc.VS = { vertexShaderBlob->GetBufferPointer(), vertexShaderBlob->GetBufferSize() };
-    // PixelShader
-    graphicsPipelineStateDesc.PS = { pixelShaderBlob->GetBufferPointer(), pixelShaderBlob->GetBufferSize() };
     // BlendState
     graphicsPipelineStateDesc.BlendState = blendDesc;
     // RasterizerState
@@ -1180,19 +1348,61 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
     graphicsPipelineStateDesc.DepthStencilState = depthStencilDesc;
     graphicsPipelineStateDesc.DSVFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
 
-    // 実際に生成
-    Microsoft::WRL::ComPtr<ID3D12PipelineState> graphicsPipelineState = nullptr;
-    hr = device->CreateGraphicsPipelineState(&graphicsPipelineStateDesc, IID_PPV_ARGS(&graphicsPipelineState));
-    assert(SUCCEEDED(hr));
+    // PSOはPixelShaderの機能の組み合わせごとに、使うときに裏でコンパイルしているShaderを待って作る
+    // シェーダーのソースは見張っておき、変わったらそのソースを使うPSOだけを作り直す
+    DiskShaderFileSystem shaderFileSystem;
+    ShaderHotReload shaderHotReload(shaderFileSystem);
+    PipelineStateVariants pipelineStateVariants(device, shaderBuildService, shaderHotReload);
+    const uint32_t spritePipelineBase = pipelineStateVariants.AddBase(graphicsPipelineStateDesc, spriteVertexShaderRequest);
+
+    Log(std::format("Matrix SIMD : {}\n", GetSimdLevelName(GetSimdLevel())));
 
     // モデル読み込み
-    ModelData modelData = LoadObjFile("resources", "plane.obj");
+    auto loadStart = std::chrono::steady_clock::now();
+    MeshOptimizationReport optimizationReport{};
+    ModelData modelData = LoadModel("resources", "plane.obj", GetDefaultObjLoadThreadCount(), &optimizationReport, GetModelImportSettings(commandLine));
+    std::chrono::duration<double, std::milli> loadTime = std::chrono::steady_clock::now() - loadStart;
+    Log(std::format("LoadModel : {} vertices, {} indices, {:.3f}ms\n", modelData.vertices.size(), modelData.indices.size(), loadTime.count()));
+    if (optimizationReport.before.vertexTransformCount != 0) {
+        Log(std::format("OptimizeMesh : ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}\n",
+            optimizationReport.before.acmr, optimizationReport.after.acmr, optimizationReport.before.atvr, optimizationReport.after.atvr));
+    }
+    for (size_t lod = 0; lod < modelData.lods.size(); ++lod) {
+        uint32_t lodIndexCount = 0;
+        for (uint32_t i = 0; i < modelData.lods[lod].subMeshCount; ++i) {
+            lodIndexCount += modelData.subMeshes[modelData.lods[lod].subMeshStart + i].indexCount;
+        }
+        Log(std::format("LOD{} : {} triangles, error {:.6f}\n", lod, lodIndexCount / 3, modelData.lods[lod].error));
+    }
+
+    // モデルの頂点形式に合わせたInputLayoutとVertexShaderでPSOの元の設定を作る
+    D3D12_INPUT_ELEMENT_DESC modelInputElementDescs[3] = { inputElementDescs[0], inputElementDescs[1], inputElementDescs[2] };
+    std::vector<std::wstring> modelShaderDefines;
+    if (modelData.vertexFormat != VertexFormat::Float) {
+        modelInputElementDescs[0].Format = DXGI_FORMAT_R32G32B32_FLOAT;
+        modelInputElementDescs[1].Format = DXGI_FORMAT_R16G16_FLOAT;
+        modelInputElementDescs[2].Format = DXGI_FORMAT_R16G16_SNORM;
+        modelShaderDefines.push_back(L"PACKED_VERTEX");
+    }
+    if (modelData.vertexFormat == VertexFormat::PackedQuantized) {
+        modelInputElementDescs[0].Format = DXGI_FORMAT_R16G16B16A16_UNORM;
+        modelShaderDefines.push_back(L"QUANTIZED_POSITION");
+    }
+    // マクロがなければSprite用と同じ要求なので、コンパイルし直さずに同じ結果を使う
+    const ShaderRequest modelVertexShaderRequest = { L"Object3D.VS.hlsl", L"vs_6_0", modelShaderDefines, kOptimizeShaders };
+    shaderBuildService.Submit(modelVertexShaderRequest);
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC modelPipelineStateDesc = graphicsPipelineStateDesc;
+    modelPipelineStateDesc.InputLayout = { modelInputElementDescs, _countof(modelInputElementDescs) };
+    const uint32_t modelPipelineBase = pipelineStateVariants.AddBase(modelPipelineStateDesc, modelVertexShaderRequest);
+    const VertexDecode modelVertexDecode = GetVertexDecode(modelData.vertexFormat, modelData.bounds);
+
     const uint32_t kSubdivision = 12;
     const uint32_t kNumSphereVertices = kSubdivision * kSubdivision * 6;
     float pi = std::numbers::pi_v<float>;
 
     // 頂点リソースを作る
-    Microsoft::WRL::ComPtr<ID3D12Resource> vertexResource = CreateBufferResource(device, sizeof(VertexData) * modelData.vertices.size());
+    const uint32_t vertexStride = GetVertexStride(modelData.vertexFormat);
+    Microsoft::WRL::ComPtr<ID3D12Resource> vertexResource = CreateBufferResource(device, size_t(vertexStride) * modelData.vertices.size());
 
     // 頂点バッファビューを作成する
     D3D12_VERTEX_BUFFER_VIEW vertexBufferView{};
@@ -1200,16 +1410,47 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
     vertexBufferView.BufferLocation = vertexResource->GetGPUVirtualAddress();
     // 使用するリソースのサイズは頂点のサイズ
     //vertexBufferView.SizeInBytes = sizeof(VertexData) * kNumSphereVertices;
-    vertexBufferView.SizeInBytes = UINT(sizeof(VertexData) * modelData.vertices.size());
+    vertexBufferView.SizeInBytes = UINT(size_t(vertexStride) * modelData.vertices.size());
     // 1頂点あたりのサイズ
-    vertexBufferView.StrideInBytes = sizeof(VertexData);
+    vertexBufferView.StrideInBytes = vertexStride;
 
     // 頂点リソースにデータを書き込む
-    VertexData* vertexData = nullptr;
+    void* vertexData = nullptr;
     // 書き込むためのアドレスを取得
-    vertexResource->Map(0, nullptr, reinterpret_cast<void**>(&vertexData));
-    // ModelDataの頂点データをリソースにコピー
-    std::memcpy(vertexData, modelData.vertices.data(), sizeof(VertexData) * modelData.vertices.size());
+    vertexResource->Map(0, nullptr, &vertexData);
+    // ModelDataの頂点データを選んだ形式にしてリソースに書く
+    EncodeVertices(modelData.vertexFormat, modelData.vertices.data(), modelData.vertices.size(), modelData.bounds, vertexData);
+    if (modelData.vertexFormat != VertexFormat::Float) {
+        VertexEncodingError encodingError = MeasureVertexEncodingError(modelData.vertexFormat, modelData.vertices.data(), modelData.vertices.size(), modelData.bounds);
+        Log(std::format("VertexFormat : {} bytes/vertex, error position {:.6f}, texcoord {:.6f}, normal {:.4f}rad\n",
+            vertexStride, encodingError.position, encodingError.texcoord, encodingError.normalAngle));
+    }
+
+    // 頂点数が少なければ16bitのIndexにしてサイズを半分にする
+    const bool useIndex16 = CanUse16BitIndices(modelData.vertices.size());
+    const size_t indexSize = useIndex16 ? sizeof(uint16_t) : sizeof(uint32_t);
+    Microsoft::WRL::ComPtr<ID3D12Resource> indexResource = CreateBufferResource(device, indexSize * modelData.indices.size());
+
+    // インデックスバッファビューを作成する
+    D3D12_INDEX_BUFFER_VIEW indexBufferView{};
+    // リソースの先頭のアドレスから使う
+    indexBufferView.BufferLocation = indexResource->GetGPUVirtualAddress();
+    // 使用するリソースのサイズはインデックスの数分のサイズ
+    indexBufferView.SizeInBytes = UINT(indexSize * modelData.indices.size());
+    // インデックスの形式
+    indexBufferView.Format = useIndex16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+
+    // インデックスリソースにデータを書き込む
+    void* indexData = nullptr;
+    indexResource->Map(0, nullptr, &indexData);
+    if (useIndex16) {
+        uint16_t* indexData16 = static_cast<uint16_t*>(indexData);
+        for (size_t i = 0; i < modelData.indices.size(); ++i) {
+            indexData16[i] = static_cast<uint16_t>(modelData.indices[i]);
+        }
+    } else {
+        std::memcpy(indexData, modelData.indices.data(), sizeof(uint32_t) * modelData.indices.size());
+    }
 
     /*
     // 経度分割1つ分の角度
@@ -1318,58 +1559,32 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
     indexDataSprite[4] = 3;
     indexDataSprite[5] = 2;
 
-    // マテリアル用のリソースを作る
-    Microsoft::WRL::ComPtr<ID3D12Resource> materialResource = CreateBufferResource(device, sizeof(Material));
-    // マテリアルにデータを書き込む
-    Material* materialData = nullptr;
-    // 書き込むためのアドレスを取得
-    materialResource->Map(0, nullptr, reinterpret_cast<void**>(&materialData));
-    // 今回は赤を書き込んでみる
-    materialData->color = Vector4(1.0f, 1.0f, 1.0f, 1.0f);
-    materialData->enableLighting = true;
-    materialData->uvTransform = MakeIdentity4x4();
-
-    // Sprite用のマテリアルリソースを作る
-    Microsoft::WRL::ComPtr<ID3D12Resource> materialResourceSprite = CreateBufferResource(device, sizeof(Material));
-    // マテリアルにデータを書き込む
-    Material* materialDataSprite = nullptr;
-    // 書き込むためのアドレスを取得
-    materialResourceSprite->Map(0, nullptr, reinterpret_cast<void**>(&materialDataSprite));
-    // 今回は赤を書き込んでみる
-    materialDataSprite->color = Vector4(1.0f, 1.0f, 1.0f, 1.0f);
-    materialDataSprite->enableLighting = false;
-    materialDataSprite->uvTransform = MakeIdentity4x4();
-
-    // TransformationMatrix用のリソースを作る。Matrix4x4 1つ分のサイズを用意する
-    Microsoft::WRL::ComPtr<ID3D12Resource> transformationMatrixResource = CreateBufferResource(device, sizeof(TransformationMatrix));
-    // データを書き込む
-    TransformationMatrix* transformationMatrixData = nullptr;
-    // 書き込むためのアドレスを取得
-    transformationMatrixResource->Map(0, nullptr, reinterpret_cast<void**>(&transformationMatrixData));
-    // 単位行列を書きこんでおく
-    transformationMatrixData->WVP = MakeIdentity4x4();
-    transformationMatrixData->World = MakeIdentity4x4();
-
-    // Sprite用のTransformationMatrix用のリソースを作る。Matrix4x4 1つ分のサイズを用意する
-    Microsoft::WRL::ComPtr<ID3D12Resource> transformationMatrixResourceSprite = CreateBufferResource(device, sizeof(TransformationMatrix));
-    // データを書き込む
-    TransformationMatrix* transformationMatrixDataSprite = nullptr;
-    // 書き込むためのアドレスを取得
-    transformationMatrixResourceSprite->Map(0, nullptr, reinterpret_cast<void**>(&transformationMatrixDataSprite));
-    // 単位行列を書きこんでおく
-    transformationMatrixDataSprite->WVP = MakeIdentity4x4();
-    transformationMatrixDataSprite->World = MakeIdentity4x4();
-
-    // DirectionalLight用のリソースを作る
-    Microsoft::WRL::ComPtr<ID3D12Resource> directionalLightResource = CreateBufferResource(device, sizeof(DirectionalLight));
-    // データを書き込む
-    DirectionalLight* directionalLightData = nullptr;
-    // 書き込むためのアドレスを取得
-    directionalLightResource->Map(0, nullptr, reinterpret_cast<void**>(&directionalLightData));
-    // デフォルト値を書き込んでおく
-    directionalLightData->color = { 1.0f, 1.0f, 1.0f, 1.0f };
-    directionalLightData->direction = { 0.0f, -1.0f, 0.0f };
-    directionalLightData->intensity = 1.0f;
+    // 毎フレーム書き換えるConstantBufferは、1つの大きなUploadバッファからフレームごとに切り出す
+    // 永続的にMapしておき、GPUが読み終わったフレームの領域だけを再利用する
+    // インスタンスバッファもここから切り出すので、最大数のインスタンスをフレームの数だけ置ける大きさにする
+    constexpr uint64_t kUploadRingSize = (1 << 20) + uint64_t(kMaxModelInstances) * sizeof(TransformationMatrix) * (kMaxFramesInFlight + 1);
+    UploadRing uploadRing;
+    uploadRing.resource = CreateBufferResource(device, kUploadRingSize);
+    uploadRing.resource->Map(0, nullptr, reinterpret_cast<void**>(&uploadRing.mappedData));
+    uploadRing.allocator.Initialize(kUploadRingSize);
+
+    // マテリアル。CPU側で持ち、毎フレームUploadRingへ書き込む
+    Material material{};
+    material.color = Vector4(1.0f, 1.0f, 1.0f, 1.0f);
+    material.uvTransform = MakeIdentity4x4();
+    uint32_t materialFeatures = kModelMaterialFeatures;
+
+    // Sprite用のマテリアル
+    Material materialSprite{};
+    materialSprite.color = Vector4(1.0f, 1.0f, 1.0f, 1.0f);
+    materialSprite.uvTransform = MakeIdentity4x4();
+    uint32_t materialFeaturesSprite = kSpriteMaterialFeatures;
+
+    // DirectionalLight。デフォルト値を入れておく
+    DirectionalLight directionalLight{};
+    directionalLight.color = { 1.0f, 1.0f, 1.0f, 1.0f };
+    directionalLight.direction = { 0.0f, -1.0f, 0.0f };
+    directionalLight.intensity = 1.0f;
 
     // ビューポート
     D3D12_VIEWPORT viewport{};
@@ -1394,12 +1609,15 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
     ImGui::CreateContext();
     ImGui::StyleColorsDark();
     ImGui_ImplWin32_Init(hwnd);
+    // ImGuiのフォントTextureのSRV
+    uint32_t imguiSrvIndex = srvDescriptorAllocator.AllocatePersistent();
+    assert(imguiSrvIndex != DescriptorAllocator::kInvalidIndex);
     ImGui_ImplDX12_Init(device.Get(),
-        swapChainDesc.BufferCount,
+        kMaxFramesInFlight,
         rtvDesc.Format,
         srvDescriptorHeap.Get(),
-        GetCPUDescriptorHandle(srvDescriptorHeap, desriptorSizeSRV, 0),
-        GetGPUDescriptorHandle(srvDescriptorHeap, desriptorSizeSRV, 0));
+        GetCPUDescriptorHandle(srvDescriptorHeap, desriptorSizeSRV, imguiSrvIndex),
+        GetGPUDescriptorHandle(srvDescriptorHeap, desriptorSizeSRV, imguiSrvIndex));
 
     // Textureを読んで転送する
     DirectX::ScratchImage mipImages = LoadTexture("resources/uvChecker.png");
@@ -1407,11 +1625,34 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
     Microsoft::WRL::ComPtr<ID3D12Resource> textureResource = CreateTextureResource(device, metadata);
     Microsoft::WRL::ComPtr<ID3D12Resource> intermediateResource = UploadTextureData(textureResource, mipImages, device, commandList);
 
-    //DirectX::ScratchImage mipImages2 = LoadTexture("resources/monsterBall.png");
-    DirectX::ScratchImage mipImages2 = LoadTexture(modelData.material.textureFilePath);
-    const DirectX::TexMetadata& metadata2 = mipImages2.GetMetadata();
-    Microsoft::WRL::ComPtr<ID3D12Resource> textureResource2 = CreateTextureResource(device, metadata2);
-    Microsoft::WRL::ComPtr<ID3D12Resource> intermediateResource2 = UploadTextureData(textureResource2, mipImages2, device, commandList);
+    // モデルのマテリアルが使うTextureを、同じファイルは1回だけ読んで転送する
+    std::vector<std::string> modelTexturePaths;
+    std::vector<uint32_t> materialTextureIndices(modelData.materials.size(), kNoModelTexture);
+    for (size_t i = 0; i < modelData.materials.size(); ++i) {
+        const std::string& textureFilePath = modelData.materials[i].textureFilePath;
+        if (textureFilePath.empty()) {
+            continue;
+        }
+        auto it = std::find(modelTexturePaths.begin(), modelTexturePaths.end(), textureFilePath);
+        materialTextureIndices[i] = static_cast<uint32_t>(it - modelTexturePaths.begin());
+        if (it == modelTexturePaths.end()) {
+            modelTexturePaths.push_back(textureFilePath);
+        }
+    }
+    // モデルのTextureとuvCheckerのSRVが永続領域に収まる
+    assert(srvDescriptorAllocator.GetPersistentUsedCount() + 1 + modelTexturePaths.size() <= kSrvPersistentDescriptorCount);
+    std::vector<DXGI_FORMAT> modelTextureFormats;
+    std::vector<UINT> modelTextureMipLevels;
+    std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> modelTextureResources;
+    std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> modelIntermediateResources;
+    for (const std::string& textureFilePath : modelTexturePaths) {
+        DirectX::ScratchImage modelMipImages = LoadTexture(textureFilePath);
+        const DirectX::TexMetadata& modelMetadata = modelMipImages.GetMetadata();
+        modelTextureFormats.push_back(modelMetadata.format);
+        modelTextureMipLevels.push_back(UINT(modelMetadata.mipLevels));
+        modelTextureResources.push_back(CreateTextureResource(device, modelMetadata));
+        modelIntermediateResources.push_back(UploadTextureData(modelTextureResources.back(), modelMipImages, device, commandList));
+    }
 
     // 実際に実行する
     commandList->Close();
@@ -1419,21 +1660,12 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
     commandQueue->ExecuteCommandLists(1, uploadCommandLists);
 
     // 実行を待つ
-    fenceValue++;
-    commandQueue->Signal(fence.Get(), fenceValue);
-    WaitSignal(fence, fenceValue, fenceEvent);
+    frameQueue.Wait(frameQueue.Signal());
 
     // 実行が終わったのでintermediateResourceはReleaseしても良い。最後にまとめても良い。
     intermediateResource->Release();
     intermediateResource = nullptr;
-    intermediateResource2->Release();
-    intermediateResource2 = nullptr;
-
-    // 次のコマンドを積めるようにReset
-    hr = commandAllocator->Reset();
-    assert(SUCCEEDED(hr));
-    hr = commandList->Reset(commandAllocator.Get(), nullptr);
-    assert(SUCCEEDED(hr));
+    modelIntermediateResources.clear();
 
     // meataDataを基にSRVの設定
     D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc{};
@@ -1443,23 +1675,46 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
     srvDesc.Texture2D.MipLevels = UINT(metadata.mipLevels);
 
     // SRVを作成するDescriptorHeapの場所を決める
-    D3D12_CPU_DESCRIPTOR_HANDLE textureSrvHandleCPU = GetCPUDescriptorHandle(srvDescriptorHeap, desriptorSizeSRV, 1);
-    D3D12_GPU_DESCRIPTOR_HANDLE textureSrvHandleGPU = GetGPUDescriptorHandle(srvDescriptorHeap, desriptorSizeSRV, 1);
+    uint32_t textureSrvIndex = srvDescriptorAllocator.AllocatePersistent();
+    assert(textureSrvIndex != DescriptorAllocator::kInvalidIndex);
+    D3D12_CPU_DESCRIPTOR_HANDLE textureSrvHandleCPU = GetCPUDescriptorHandle(srvDescriptorHeap, desriptorSizeSRV, textureSrvIndex);
     // SRVの生成
     device->CreateShaderResourceView(textureResource.Get(), &srvDesc, textureSrvHandleCPU);
 
-    // meataDataを基にSRVの設定
-    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc2{};
-    srvDesc2.Format = metadata2.format;
-    srvDesc2.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-    srvDesc2.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;//2Dテクスチャ
-    srvDesc2.Texture2D.MipLevels = UINT(metadata2.mipLevels);
+    // モデルのTextureのSRV
+    std::vector<uint32_t> modelTextureSrvIndices;
+    for (size_t i = 0; i < modelTextureResources.size(); ++i) {
+        D3D12_SHADER_RESOURCE_VIEW_DESC modelSrvDesc{};
+        modelSrvDesc.Format = modelTextureFormats[i];
+        modelSrvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        modelSrvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;//2Dテクスチャ
+        modelSrvDesc.Texture2D.MipLevels = modelTextureMipLevels[i];
+
+        uint32_t descriptorIndex = srvDescriptorAllocator.AllocatePersistent();
+        // 永続領域が足りない
+        assert(descriptorIndex != DescriptorAllocator::kInvalidIndex);
+        D3D12_CPU_DESCRIPTOR_HANDLE modelTextureSrvHandleCPU = GetCPUDescriptorHandle(srvDescriptorHeap, desriptorSizeSRV, descriptorIndex);
+        modelTextureSrvIndices.push_back(descriptorIndex);
+        device->CreateShaderResourceView(modelTextureResources[i].Get(), &modelSrvDesc, modelTextureSrvHandleCPU);
+    }
 
-    // SRVを作成するDescriptorHeapの場所を決める
-    D3D12_CPU_DESCRIPTOR_HANDLE textureSrvHandleCPU2 = GetCPUDescriptorHandle(srvDescriptorHeap, desriptorSizeSRV, 2);
-    D3D12_GPU_DESCRIPTOR_HANDLE textureSrvHandleGPU2 = GetGPUDescriptorHandle(srvDescriptorHeap, desriptorSizeSRV, 2);
-    // SRVの生成
-    device->CreateShaderResourceView(textureResource2.Get(), &srvDesc2, textureSrvHandleCPU2);
+    // LODごとのSubMeshの描画範囲。Textureの順に並べるのはDrawQueueで行う
+    std::vector<std::vector<ModelDrawRange>> modelLodDrawRanges(modelData.lods.size());
+    for (size_t lod = 0; lod < modelData.lods.size(); ++lod) {
+        std::vector<ModelDrawRange>& drawRanges = modelLodDrawRanges[lod];
+        for (uint32_t i = 0; i < modelData.lods[lod].subMeshCount; ++i) {
+            const SubMesh& subMesh = modelData.subMeshes[modelData.lods[lod].subMeshStart + i];
+            drawRanges.push_back({ materialTextureIndices[subMesh.materialIndex], subMesh.indexStart, subMesh.indexCount });
+        }
+    }
+    uint32_t modelLod = 0;
+    float lodMaxPixelError = 1.0f;
+
+    // 最初に使うPSOを作っておく。コンパイル用のスレッドは、機能の切り替えとホットリロードのために残しておく
+    pipelineStateVariants.Get(modelPipelineBase, materialFeatures);
+    pipelineStateVariants.Get(spritePipelineBase, materialFeaturesSprite);
+    std::chrono::duration<double, std::milli> startupTime = std::chrono::steady_clock::now() - startupStart;
+    Log(std::format("Startup : {} shader threads, {:.3f}ms\n", shaderThreadCount, startupTime.count()));
 
     // ウィンドウを表示する
     ShowWindow(hwnd, SW_SHOW);
@@ -1469,6 +1724,26 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
     Transform transformSprite{ {1.0f, 1.0f, 1.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f} };
     Transform cameraTransform{ {1.0f, 1.0f, 1.0f}, {0.3f, 0.0f, 0.0f}, {0.0f, 4.0f, -10.0f} };
     bool useMonsterBall = true;
+    bool drawSprite = false;
+    // モデルの周りに格子状に並べて、インスタンスバッファでまとめて描くもの。World/WVPは毎フレームまとめて計算する
+    TransformSoA modelInstances;
+    int modelInstanceCount = 0;
+    bool spinModelInstances = true;
+    // シェーダーのソースの更新日時を調べる間隔
+    const std::chrono::milliseconds kShaderPollInterval(250);
+    auto lastShaderPollTime = std::chrono::steady_clock::now();
+
+    // 描画はDrawPacketとして集め、キーの順に並べて変わった状態だけを設定する
+    DrawQueue drawQueue;
+
+    // 球は階層の根として持ち、Transformが変わったフレームだけWorld行列を計算し直す
+    TransformHierarchy sceneHierarchy;
+    uint32_t modelNode = sceneHierarchy.AddNode(transform);
+
+    // 描くオブジェクトのワールド座標での境界。毎フレーム視錐台と比べ、残ったものだけコマンドを積む
+    CullingBoundsSoA objectBounds;
+    objectBounds.Resize(1);
+    std::vector<uint32_t> visibleObjects;
 
     // UVTransform
     Transform uvTransformSprite{
@@ -1484,6 +1759,27 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
             TranslateMessage(&msg);
             DispatchMessage(&msg);
         } else {
+            // このフレームで使うコマンドアロケータを、前に使ったフレームをGPUが終えるまで待ってからResetする
+            uint32_t frameSlot = frameScheduler.BeginFrame();
+            uploadRing.allocator.Retire(frameQueue.GetCompletedValue());
+            srvDescriptorAllocator.Retire(frameQueue.GetCompletedValue());
+            hr = commandAllocators[frameSlot]->Reset();
+            assert(SUCCEEDED(hr));
+            hr = commandList->Reset(commandAllocators[frameSlot].Get(), nullptr);
+            assert(SUCCEEDED(hr));
+
+            // シェーダーのソースが変わっていたら、そのソースを使うPSOだけを裏でコンパイルし直し、できたものから差し替える
+            auto shaderPollTime = std::chrono::steady_clock::now();
+            if (shaderPollTime - lastShaderPollTime >= kShaderPollInterval) {
+                lastShaderPollTime = shaderPollTime;
+                std::vector<std::filesystem::path> changedShaderRoots = shaderHotReload.PollChangedRoots();
+                if (!changedShaderRoots.empty()) {
+                    pipelineStateVariants.Reload(changedShaderRoots);
+                }
+            }
+            pipelineStateVariants.Update();
+            pipelineStateVariants.Retire(frameQueue.GetCompletedValue());
+
             ImGui_ImplDX12_NewFrame();
             ImGui_ImplWin32_NewFrame();
             ImGui::NewFrame();
@@ -1498,48 +1794,205 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
             ImGui::SliderAngle("CameraRotateX", &cameraTransform.rotate.x);
             ImGui::SliderAngle("CameraRotateY", &cameraTransform.rotate.y);
             ImGui::SliderAngle("CameraRotateZ", &cameraTransform.rotate.z);
-            ImGui::SliderAngle("SphereRotateX", &transform.rotate.x);
-            ImGui::SliderAngle("SphereRotateY", &transform.rotate.y);
-            ImGui::SliderAngle("SphereRotateZ", &transform.rotate.z);
-            ImGui::ColorEdit4("color", &materialData->color.x, ImGuiColorEditFlags_AlphaPreview | ImGuiColorEditFlags_HDR);
-            ImGui::Checkbox("enableLighting", reinterpret_cast<bool*>(&materialData->enableLighting));
-            ImGui::ColorEdit4("colorSprite", &materialDataSprite->color.x, ImGuiColorEditFlags_AlphaPreview | ImGuiColorEditFlags_HDR);
+            bool transformChanged = false;
+            transformChanged |= ImGui::SliderAngle("SphereRotateX", &transform.rotate.x);
+            transformChanged |= ImGui::SliderAngle("SphereRotateY", &transform.rotate.y);
+            transformChanged |= ImGui::SliderAngle("SphereRotateZ", &transform.rotate.z);
+            ImGui::ColorEdit4("color", &material.color.x, ImGuiColorEditFlags_AlphaPreview | ImGuiColorEditFlags_HDR);
+            ImGui::CheckboxFlags("enableLighting", &materialFeatures, kShaderFeatureLighting);
+            ImGui::CheckboxFlags("halfLambert", &materialFeatures, kShaderFeatureHalfLambert);
+            ImGui::ColorEdit4("colorSprite", &materialSprite.color.x, ImGuiColorEditFlags_AlphaPreview | ImGuiColorEditFlags_HDR);
             ImGui::SliderFloat3("translateSprite", &transformSprite.translate.x, 0.0f, 1000.0f);
+            ImGui::CheckboxFlags("uvTransformSprite", &materialFeaturesSprite, kShaderFeatureUvTransform);
             ImGui::Checkbox("useMonsterBall", &useMonsterBall);
-            ImGui::ColorEdit3("LightColor", &directionalLightData->color.x);
-            ImGui::SliderFloat3("LightDirection", &directionalLightData->direction.x, -1.0f, 1.0f);
-            ImGui::DragFloat("Intensity", &directionalLightData->intensity, 0.01f, 0.0f, 3.0f);
+            ImGui::Checkbox("drawSprite", &drawSprite);
+            if (ImGui::SliderInt("modelInstances", &modelInstanceCount, 0, static_cast<int>(kMaxModelInstances))) {
+                // 増えた分を格子に並べる。既にあるものの回転はそのまま
+                size_t oldCount = modelInstances.GetSize();
+                modelInstances.Resize(static_cast<size_t>(modelInstanceCount));
+                for (size_t i = oldCount; i < modelInstances.GetSize(); ++i) {
+                    float column = static_cast<float>(i % kModelInstanceColumns) - static_cast<float>(kModelInstanceColumns - 1) * 0.5f;
+                    float row = static_cast<float>(i / kModelInstanceColumns) + 1.0f;
+                    modelInstances.Set(i, { transform.scale, { 0.0f, 0.0f, 0.0f }, { column * kModelInstanceSpacing, 0.0f, row * kModelInstanceSpacing } });
+                }
+            }
+            ImGui::Checkbox("spinModelInstances", &spinModelInstances);
+            ImGui::ColorEdit3("LightColor", &directionalLight.color.x);
+            ImGui::SliderFloat3("LightDirection", &directionalLight.direction.x, -1.0f, 1.0f);
+            ImGui::DragFloat("Intensity", &directionalLight.intensity, 0.01f, 0.0f, 3.0f);
 
             ImGui::DragFloat2("UVTranslate", &uvTransformSprite.translate.x, 0.01f, -10.0f, 10.0f);
             ImGui::DragFloat2("UVScale", &uvTransformSprite.scale.x, 0.01f, -10.0f, 10.0f);
             ImGui::SliderAngle("UVRotate", &uvTransformSprite.rotate.z);
 
             // 方向は正規化
-            directionalLightData->direction = Normalize(directionalLightData->direction);
+            directionalLight.direction = Normalize(directionalLight.direction);
 
             ImGui::End();
 
             Matrix4x4 uvTransformMatrix = MakeScaleMatrix(uvTransformSprite.scale);
             uvTransformMatrix = Multiply(uvTransformMatrix, MakeRotateZMatrix(uvTransformSprite.rotate.z));
             uvTransformMatrix = Multiply(uvTransformMatrix, MakeTranslateMatrix(uvTransformSprite.translate));
-            materialDataSprite->uvTransform = uvTransformMatrix;
+            materialSprite.uvTransform = uvTransformMatrix;
 
             //transform.rotate.y += 0.01f;
-            Matrix4x4 worldMatrix = MakeAffineMatrix(transform.scale, transform.rotate, transform.translate);
-            Matrix4x4 cameraMatrix = MakeAffineMatrix(cameraTransform.scale, cameraTransform.rotate, cameraTransform.translate);
-            Matrix4x4 viewMatrix = Inverse(cameraMatrix);
+            if (transformChanged) {
+                sceneHierarchy.SetLocalTransform(modelNode, transform);
+            }
+            sceneHierarchy.Update();
+            int framesInFlight = static_cast<int>(frameScheduler.GetFramesInFlight());
+            ImGui::Begin("Frames");
+            if (ImGui::SliderInt("FramesInFlight", &framesInFlight, 1, static_cast<int>(kMaxFramesInFlight))) {
+                frameScheduler.SetFramesInFlight(static_cast<uint32_t>(framesInFlight));
+            }
+            ImGui::Text("Latency : %u frames queued, waited %.2f ms", frameScheduler.GetPendingFrameCount(), frameScheduler.GetWaitTime() * 1000.0);
+            ImGui::End();
+
+            ImGui::Begin("Descriptors");
+            ImGui::Text("Persistent : %u / %u (pending free %u)", srvDescriptorAllocator.GetPersistentUsedCount(), srvDescriptorAllocator.GetPersistentCount(), srvDescriptorAllocator.GetPendingFreeCount());
+            ImGui::Text("Fragmentation : %.2f (largest free %u)", srvDescriptorAllocator.GetFragmentation(), srvDescriptorAllocator.GetLargestFreeRange());
+            ImGui::Text("Transient : %u / %u", srvDescriptorAllocator.GetTransientUsedCount(), srvDescriptorAllocator.GetTransientCount());
+            ImGui::End();
+
+            ImGui::Begin("Hierarchy");
+            ImGui::Text("World matrices recomputed : %u / %u", sceneHierarchy.GetRecomputedCount(), sceneHierarchy.GetNodeCount());
+            ImGui::End();
+
+            // World、カメラ、Viewは4列目が(0, 0, 0, 1)の行列のまま計算し、Matrix4x4にするのは送るときと投影をかけるときだけにする
+            const AffineMatrix& worldMatrix = sceneHierarchy.GetWorldMatrix(modelNode);
+            RigidTransform cameraMatrix = MakeRigidTransform(cameraTransform.rotate, cameraTransform.translate);
+            RigidTransform viewMatrix = Inverse(cameraMatrix);
             Matrix4x4 projectionMatrix = MakePerspectiveFovMatrix(0.45f, float(kClientWidth) / float(kClientHeight), 0.1f, 100.0f);
-            Matrix4x4 worldViewProjectionMatrix = Multiply(worldMatrix, Multiply(viewMatrix, projectionMatrix));
-            transformationMatrixData->WVP = worldViewProjectionMatrix;
-            transformationMatrixData->World = worldMatrix;
+            Matrix4x4 viewProjectionMatrix = Multiply(viewMatrix, projectionMatrix);
+            Matrix4x4 worldViewProjectionMatrix = Multiply(worldMatrix, viewProjectionMatrix);
+            TransformationMatrix transformationMatrix{ worldViewProjectionMatrix, ToMatrix4x4(worldMatrix) };
+
+            // モデル全体が視錐台の外なら描画コマンドを積まない
+            objectBounds.Set(0, modelData.bounds, modelData.boundingSphere, worldMatrix);
+            CullObjects(objectBounds, ExtractFrustum(viewProjectionMatrix), visibleObjects);
+            bool modelVisible = !visibleObjects.empty();
+
+            // このカメラでメッシュレット単位のカリングがどれだけ三角形を除けるかを調べる
+            MeshletCullingStatistics meshletCulling = CullMeshlets(modelData, ToMatrix4x4(worldMatrix), viewProjectionMatrix, cameraTransform.translate);
+            ImGui::Begin("MeshletCulling");
+            ImGui::Text("Objects : %u / %u visible", static_cast<uint32_t>(visibleObjects.size()), static_cast<uint32_t>(objectBounds.GetSize()));
+            ImGui::Text("Meshlets : %u / %u visible", meshletCulling.visibleMeshletCount, meshletCulling.meshletCount);
+            ImGui::Text("Frustum culled : %u, Backface culled : %u", meshletCulling.frustumCulledMeshletCount, meshletCulling.backfaceCulledMeshletCount);
+            ImGui::Text("Triangles culled : %u / %u", meshletCulling.culledTriangleCount, meshletCulling.triangleCount);
+            ImGui::End();
+
+            // 画面上のずれが許す範囲に収まる最も粗いLODを選ぶ。距離はモデルを囲む球の手前までで測る
+            Vector3 boundsCenter = {
+                (modelData.bounds.min.x + modelData.bounds.max.x) * 0.5f,
+                (modelData.bounds.min.y + modelData.bounds.max.y) * 0.5f,
+                (modelData.bounds.min.z + modelData.bounds.max.z) * 0.5f,
+            };
+            Vector3 boundsExtent = {
+                modelData.bounds.max.x - boundsCenter.x, modelData.bounds.max.y - boundsCenter.y, modelData.bounds.max.z - boundsCenter.z,
+            };
+            Vector3 worldCenter = TransformPoint(boundsCenter, worldMatrix);
+            float worldScale = (std::max)({ std::fabs(transform.scale.x), std::fabs(transform.scale.y), std::fabs(transform.scale.z) });
+            Vector3 toCenter = { worldCenter.x - cameraTransform.translate.x, worldCenter.y - cameraTransform.translate.y, worldCenter.z - cameraTransform.translate.z };
+            float lodDistance = (std::max)(Length(toCenter) - Length(boundsExtent) * worldScale, 0.1f);
+            float pixelsPerUnit = float(kClientHeight) * 0.5f * projectionMatrix.m[1][1] * worldScale / lodDistance;
+            modelLod = SelectLod(modelData, pixelsPerUnit, lodMaxPixelError);
+            ImGui::Begin("Lod");
+            ImGui::SliderFloat("MaxPixelError", &lodMaxPixelError, 0.1f, 16.0f);
+            ImGui::Text("LOD : %u / %u, error %.2f px", modelLod, static_cast<uint32_t>(modelData.lods.size()) - 1, modelData.lods[modelLod].error * pixelsPerUnit);
+            ImGui::End();
+
+            // インスタンスのWorldとWVPを、このフレームのインスタンスバッファへ直接まとめて書き込む
+            if (spinModelInstances) {
+                for (size_t i = 0; i < modelInstances.GetSize(); ++i) {
+                    modelInstances.rotateY[i] += 0.01f * static_cast<float>(1 + i % 7);
+                }
+            }
+            D3D12_GPU_VIRTUAL_ADDRESS modelInstancesAddress = 0;
+            uint32_t drawnModelInstanceCount = static_cast<uint32_t>(modelInstances.GetSize());
+            if (drawnModelInstanceCount != 0) {
+                uint64_t offset = uploadRing.allocator.Allocate(drawnModelInstanceCount * sizeof(TransformationMatrix));
+                assert(offset != UploadRingAllocator::kInvalidOffset);
+                ComputeTransformationMatrices(modelInstances, viewProjectionMatrix, reinterpret_cast<TransformationMatrix*>(uploadRing.mappedData + offset));
+                modelInstancesAddress = uploadRing.resource->GetGPUVirtualAddress() + offset;
+            }
 
             // Sprite用のWorldViewProjectionMatrixを作る
-            Matrix4x4 worldMatrixSprite = MakeAffineMatrix(transformSprite.scale, transformSprite.rotate, transformSprite.translate);
-            Matrix4x4 viewMatrixSprite = MakeIdentity4x4();
+            AffineMatrix worldMatrixSprite = MakeAffineTransform(transformSprite.scale, transformSprite.rotate, transformSprite.translate);
             Matrix4x4 projectionMatrixSprite = MakeOrthographicMatrix(0.0f, 0.0f, float(kClientWidth), float(kClientHeight), 0.0f, 100.0f);
-            Matrix4x4 worldViewProjectionMatrixSprite = Multiply(worldMatrixSprite, Multiply(viewMatrixSprite, projectionMatrixSprite));
-            transformationMatrixDataSprite->WVP = worldViewProjectionMatrixSprite;
-            transformationMatrixDataSprite->World = worldMatrixSprite;
+            // Viewは単位行列なのでWorldに直接投影をかける
+            Matrix4x4 worldViewProjectionMatrixSprite = Multiply(worldMatrixSprite, projectionMatrixSprite);
+            TransformationMatrix transformationMatrixSprite{ worldViewProjectionMatrixSprite, ToMatrix4x4(worldMatrixSprite) };
+
+            // このフレームのConstantBufferをUploadRingに書き込む。前のフレームの分はGPUが読み終わるまで上書きしない
+            D3D12_GPU_VIRTUAL_ADDRESS materialAddress = WriteUpload(uploadRing, material);
+            D3D12_GPU_VIRTUAL_ADDRESS transformationMatrixAddress = WriteUpload(uploadRing, transformationMatrix);
+            D3D12_GPU_VIRTUAL_ADDRESS directionalLightAddress = WriteUpload(uploadRing, directionalLight);
+            D3D12_GPU_VIRTUAL_ADDRESS materialAddressSprite = WriteUpload(uploadRing, materialSprite);
+            D3D12_GPU_VIRTUAL_ADDRESS transformationMatrixAddressSprite = WriteUpload(uploadRing, transformationMatrixSprite);
+            D3D12_GPU_VIRTUAL_ADDRESS drawMaterialAddresses[] = { materialAddress, materialAddressSprite };
+            D3D12_GPU_VIRTUAL_ADDRESS drawTransformAddresses[] = { transformationMatrixAddress, transformationMatrixAddressSprite, modelInstancesAddress };
+            const uint32_t drawTransformCounts[] = { 1, 1, drawnModelInstanceCount };
+
+            // TransformationMatrixの配列のSRVを、このフレームだけ使うDescriptorに作る。GPUが読み終わるまでは次に切り出されない
+            uint32_t drawTransformSrvIndex = srvDescriptorAllocator.AllocateTransient(kDrawTransformCount);
+            assert(drawTransformSrvIndex != DescriptorAllocator::kInvalidIndex);
+            for (uint32_t i = 0; i < kDrawTransformCount; ++i) {
+                D3D12_SHADER_RESOURCE_VIEW_DESC transformSrvDesc{};
+                transformSrvDesc.Format = DXGI_FORMAT_UNKNOWN;
+                transformSrvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+                transformSrvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+                transformSrvDesc.Buffer.StructureByteStride = sizeof(TransformationMatrix);
+                ID3D12Resource* transformResource = nullptr;
+                // インスタンスがなければ読むと0になるnullのSRVにする
+                if (drawTransformCounts[i] != 0) {
+                    transformResource = uploadRing.resource.Get();
+                    transformSrvDesc.Buffer.FirstElement = (drawTransformAddresses[i] - uploadRing.resource->GetGPUVirtualAddress()) / sizeof(TransformationMatrix);
+                    transformSrvDesc.Buffer.NumElements = drawTransformCounts[i];
+                }
+                device->CreateShaderResourceView(transformResource, &transformSrvDesc, GetCPUDescriptorHandle(srvDescriptorHeap, desriptorSizeSRV, drawTransformSrvIndex + i));
+            }
+
+            // このフレームの描画を集めて並べる。Textureは描画ごとにSRVの番号で持つ
+            drawQueue.Clear();
+            // マテリアルの機能の組み合わせでPSOを選ぶ。初めての組み合わせならここでコンパイルを待って作る
+            uint32_t modelPipeline = pipelineStateVariants.Get(modelPipelineBase, materialFeatures);
+            uint32_t spritePipeline = pipelineStateVariants.Get(spritePipelineBase, materialFeaturesSprite);
+            if (modelVisible) {
+                uint32_t modelDepth = QuantizeDrawDepth(Length(toCenter), 0.1f, 100.0f);
+                for (const ModelDrawRange& drawRange : modelLodDrawRanges[modelLod]) {
+                    uint32_t texture = textureSrvIndex;
+                    if (useMonsterBall && drawRange.textureIndex != kNoModelTexture) {
+                        texture = modelTextureSrvIndices[drawRange.textureIndex];
+                    }
+                    drawQueue.Add({ MakeDrawSortKey(kDrawPassOpaque, modelPipeline, texture, kDrawMaterialModel, modelDepth),
+                        modelPipeline, kDrawGeometryModel, kDrawMaterialModel, kDrawTransformModel, texture, drawRange.indexStart, drawRange.indexCount });
+                }
+            }
+            if (drawnModelInstanceCount != 0) {
+                // 並べたインスタンスは1つの描画で全部描く。視錐台の外のものもGPUに任せる
+                for (const ModelDrawRange& drawRange : modelLodDrawRanges[0]) {
+                    uint32_t texture = textureSrvIndex;
+                    if (useMonsterBall && drawRange.textureIndex != kNoModelTexture) {
+                        texture = modelTextureSrvIndices[drawRange.textureIndex];
+                    }
+                    drawQueue.Add({ MakeDrawSortKey(kDrawPassOpaque, modelPipeline, texture, kDrawMaterialModel, 0),
+                        modelPipeline, kDrawGeometryModel, kDrawMaterialModel, kDrawTransformInstances, texture, drawRange.indexStart, drawRange.indexCount, drawnModelInstanceCount });
+                }
+            }
+            if (drawSprite) {
+                drawQueue.Add({ MakeDrawSortKey(kDrawPassSprite, spritePipeline, textureSrvIndex, kDrawMaterialSprite, 0),
+                    spritePipeline, kDrawGeometrySprite, kDrawMaterialSprite, kDrawTransformSprite, textureSrvIndex, 0, 6 });
+            }
+            drawQueue.Sort();
+            const DrawQueueStats& drawStats = drawQueue.GetStats();
+            ImGui::Begin("DrawQueue");
+            ImGui::Text("Draws : %u", drawStats.drawCount);
+            ImGui::Text("State changes : %u / %u (%u avoided)", drawStats.stateChangeCount, drawStats.naiveStateChangeCount, drawStats.naiveStateChangeCount - drawStats.stateChangeCount);
+            ImGui::Text("PSO variants : %u / %u created", pipelineStateVariants.GetCreatedCount(), pipelineStateVariants.GetPermutationCount());
+            ImGui::Text("Shader reloads : %u (failed %u), watching %u sources", pipelineStateVariants.GetReloadedCount(), pipelineStateVariants.GetFailedReloadCount(),
+                static_cast<uint32_t>(shaderHotReload.GetGraph().GetRootCount()));
+            ImGui::Text("PSO %u, Geometry %u, Material %u, Transform %u, Texture %u", drawStats.stateChanges[0], drawStats.stateChanges[1], drawStats.stateChanges[2], drawStats.stateChanges[3], drawStats.stateChanges[4]);
+            ImGui::End();
 
             // ImGuiの内部コマンドを生成する
             ImGui::Render();
@@ -1582,33 +2035,41 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
             commandList->RSSetViewports(1, &viewport);  // Viewportを設定
             commandList->RSSetScissorRects(1, &scissorRect);    // Scirssorを設定
             commandList->SetGraphicsRootSignature(rootSignature.Get());   // RootSignatureを設定。PSOに設定しているけど別途設定が必要
-            commandList->SetPipelineState(graphicsPipelineState.Get());   // PSOを設定
-            commandList->IASetVertexBuffers(0, 1, &vertexBufferView);   // VBVを設定
             // 形状を設定。PSOに設定しているものとはまた別。同じものを設定すると考えておけば良い
             commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-            // マテリアルCBufferの場所を設定
-            commandList->SetGraphicsRootConstantBufferView(0, materialResource->GetGPUVirtualAddress());
-            // TransformationMatrixCBufferの場所を設定
-            commandList->SetGraphicsRootConstantBufferView(1, transformationMatrixResource->GetGPUVirtualAddress());
-            // SRVのDescriptorTableの先頭を設定
-            commandList->SetGraphicsRootDescriptorTable(2, useMonsterBall ? textureSrvHandleGPU2 : textureSrvHandleGPU);
-            // DirectionalLightのCBufferの場所を設定
-            commandList->SetGraphicsRootConstantBufferView(3, directionalLightResource->GetGPUVirtualAddress());
-            // 描画！（DrawCall/ドローコール）
-            //commandList->DrawInstanced(kNumSphereVertices, 1, 0, 0);
-            commandList->DrawInstanced(UINT(modelData.vertices.size()), 1, 0, 0);
-
-            // Spriteの描画。変更が必要なものだけ変更する
-            commandList->IASetVertexBuffers(0, 1, &vertexBufferViewSprite);   // VBVを設定
-            commandList->IASetIndexBuffer(&indexBufferViewSprite);// IBVを設定
-            // マテリアルCBufferの場所を設定
-            commandList->SetGraphicsRootConstantBufferView(0, materialResourceSprite->GetGPUVirtualAddress());
-            // TransformationMatrixCBufferの場所を設定
-            commandList->SetGraphicsRootConstantBufferView(1, transformationMatrixResourceSprite->GetGPUVirtualAddress());
-            // SRVのDescriptorTableの先頭を設定
-            commandList->SetGraphicsRootDescriptorTable(2, textureSrvHandleGPU);
-            // 描画！（DrawCall/ドローコール）6個のインデックスを使用し1つのインスタンスを描画。その他は当面0で良い
-            //commandList->DrawIndexedInstanced(6, 1, 0, 0, 0);
+            // DirectionalLightのCBufferの場所を設定。全ての描画で共通
+            commandList->SetGraphicsRootConstantBufferView(3, directionalLightAddress);
+            // 描画！（DrawCall/ドローコール）。並べた順に、前の描画から変わった状態だけを設定して描く
+            for (const DrawCommand& drawCommand : drawQueue.GetCommands()) {
+                const DrawPacket& packet = drawQueue.GetPacket(drawCommand.packetIndex);
+                if (drawCommand.changedStates & kDrawStatePipeline) {
+                    commandList->SetPipelineState(pipelineStateVariants.GetPipelineState(packet.pipeline));   // PSOを設定
+                }
+                if (drawCommand.changedStates & kDrawStateGeometry) {
+                    if (packet.geometry == kDrawGeometryModel) {
+                        commandList->IASetVertexBuffers(0, 1, &vertexBufferView);   // VBVを設定
+                        commandList->IASetIndexBuffer(&indexBufferView);    // IBVを設定
+                        // 量子化した位置の戻し方を設定
+                        commandList->SetGraphicsRoot32BitConstants(4, UINT(sizeof(VertexDecode) / sizeof(uint32_t)), &modelVertexDecode, 0);
+                    } else {
+                        commandList->IASetVertexBuffers(0, 1, &vertexBufferViewSprite);   // VBVを設定
+                        commandList->IASetIndexBuffer(&indexBufferViewSprite);// IBVを設定
+                    }
+                }
+                if (drawCommand.changedStates & kDrawStateMaterial) {
+                    // マテリアルCBufferの場所を設定
+                    commandList->SetGraphicsRootConstantBufferView(0, drawMaterialAddresses[packet.material]);
+                }
+                if (drawCommand.changedStates & kDrawStateTransform) {
+                    // TransformationMatrixの配列のSRVのDescriptorTableを設定
+                    commandList->SetGraphicsRootDescriptorTable(1, GetGPUDescriptorHandle(srvDescriptorHeap, desriptorSizeSRV, drawTransformSrvIndex + packet.transform));
+                }
+                if (drawCommand.changedStates & kDrawStateTexture) {
+                    // SRVのDescriptorTableの先頭を設定
+                    commandList->SetGraphicsRootDescriptorTable(2, GetGPUDescriptorHandle(srvDescriptorHeap, desriptorSizeSRV, packet.texture));
+                }
+                commandList->DrawIndexedInstanced(packet.indexCount, packet.instanceCount, packet.indexStart, 0, 0);
+            }
 
             // 実際のcommandListのImGuiの描画コマンドを積む
             ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), commandList.Get());
@@ -1631,21 +2092,18 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
             // GPUとOSに画面の交換を行うよう通知する
             swapChain->Present(1, 0);
 
-            // Fenceの値を更新
-            fenceValue++;
-            // GPUがここまでたどり着いたときに、Fenceの値を指定した値に代入するようにSignalを送る
-            commandQueue->Signal(fence.Get(), fenceValue);
-            // Signalを待つ
-            WaitSignal(fence, fenceValue, fenceEvent);
-
-            // 次のフレーム用のコマンドリストを準備
-            hr = commandAllocator->Reset();
-            assert(SUCCEEDED(hr));
-            hr = commandList->Reset(commandAllocator.Get(), nullptr);
-            assert(SUCCEEDED(hr));
+            // GPUがここまでたどり着いたときに、Fenceの値を指定した値に代入するようにSignalを送る。ここでは待たずに次のフレームへ進む
+            uint64_t frameFenceValue = frameScheduler.EndFrame();
+            // このフレームでUploadRingから切り出した領域は、GPUがこのSignal値に届くまで使われる
+            uploadRing.allocator.FinishFrame(frameFenceValue);
+            srvDescriptorAllocator.FinishFrame(frameFenceValue);
+            pipelineStateVariants.FinishFrame(frameFenceValue);
         }
     }
 
+    // GPUが実行中のフレームを終えてからリソースを解放する
+    frameScheduler.WaitIdle();
+
     ImGui_ImplDX12_Shutdown();
     ImGui_ImplWin32_Shutdown();
     ImGui::DestroyContext();
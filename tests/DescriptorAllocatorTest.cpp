@@ -0,0 +1,91 @@
+#include "DescriptorAllocator.h"
+#include "TestUtility.h"
+
+namespace {
+
+/// <summary>
+/// 永続領域の確保と、解放したものがGPUが届くまで再利用されないこと
+/// </summary>
+void TestPersistent()
+{
+    DescriptorAllocator allocator;
+    allocator.Initialize(16, 8);
+    CHECK(allocator.GetPersistentCount() == 8);
+    CHECK(allocator.GetTransientCount() == 8);
+
+    uint32_t a = allocator.AllocatePersistent(2);
+    uint32_t b = allocator.AllocatePersistent(3);
+    uint32_t c = allocator.AllocatePersistent(3);
+    CHECK(a == 0 && b == 2 && c == 5);
+    CHECK(allocator.GetPersistentUsedCount() == 8);
+    CHECK(allocator.AllocatePersistent() == DescriptorAllocator::kInvalidIndex);
+
+    // 解放してもフレームを閉じてGPUが届くまでは空きに戻らない
+    allocator.FreePersistent(b, 3);
+    CHECK(allocator.GetPendingFreeCount() == 3);
+    CHECK(allocator.AllocatePersistent() == DescriptorAllocator::kInvalidIndex);
+    allocator.FinishFrame(1);
+    allocator.Retire(0);
+    CHECK(allocator.AllocatePersistent() == DescriptorAllocator::kInvalidIndex);
+    allocator.Retire(1);
+    CHECK(allocator.GetPendingFreeCount() == 0);
+    CHECK(allocator.GetLargestFreeRange() == 3);
+    CHECK(allocator.GetFragmentation() == 0.0f);
+
+    // 空きの先頭から切り出す。離れた空きは断片化として数える
+    uint32_t d = allocator.AllocatePersistent();
+    CHECK(d == 2);
+    allocator.FreePersistent(a, 2);
+    allocator.FinishFrame(2);
+    allocator.Retire(2);
+    CHECK(allocator.GetLargestFreeRange() == 2);
+    CHECK(allocator.GetFragmentation() == 0.5f);
+    CHECK(allocator.AllocatePersistent(3) == DescriptorAllocator::kInvalidIndex);
+
+    // 間を解放すると前後の空きとつながる
+    allocator.FreePersistent(d);
+    allocator.FinishFrame(3);
+    allocator.Retire(3);
+    CHECK(allocator.GetLargestFreeRange() == 5);
+    CHECK(allocator.GetFragmentation() == 0.0f);
+    CHECK(allocator.AllocatePersistent(5) == 0);
+}
+
+/// <summary>
+/// フレームごとの領域は永続領域の後ろから切り出し、GPUが届くまで同じ番号を返さない
+/// </summary>
+void TestTransient()
+{
+    DescriptorAllocator allocator;
+    allocator.Initialize(16, 8);
+
+    uint32_t frame1 = allocator.AllocateTransient(3);
+    CHECK(frame1 == 8);
+    allocator.FinishFrame(1);
+    uint32_t frame2 = allocator.AllocateTransient(3);
+    CHECK(frame2 == 11);
+    allocator.FinishFrame(2);
+    CHECK(allocator.GetTransientUsedCount() == 6);
+
+    // 末尾の2個には収まらず、先頭はフレーム1が使っている
+    CHECK(allocator.AllocateTransient(3) == DescriptorAllocator::kInvalidIndex);
+    allocator.Retire(1);
+    uint32_t frame3 = allocator.AllocateTransient(3);
+    CHECK(frame3 == 8);
+    allocator.FinishFrame(3);
+
+    allocator.Retire(3);
+    CHECK(allocator.GetTransientUsedCount() == 0);
+    // フレームごとの領域は永続領域の番号と重ならない
+    CHECK(allocator.GetPersistentUsedCount() == 0);
+    CHECK(allocator.AllocatePersistent(8) == 0);
+}
+
+} // namespace
+
+int main()
+{
+    TestPersistent();
+    TestTransient();
+    return TEST_RESULT();
+}
@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include "DrawPacket.h"
+#include "SyntheticDraws.h"
+#include "TestUtility.h"
+
+namespace {
+
+/// <summary>
+/// キーのstd::stable_sortと同じ並びになり、状態の変化が全ての状態を前の描画と比べた結果と一致することを確かめる
+/// </summary>
+void CheckSorted(const std::vector<DrawPacket>& packets, DrawQueue& queue)
+{
+    queue.Clear();
+    for (const DrawPacket& packet : packets) {
+        queue.Add(packet);
+    }
+    queue.Sort();
+
+    std::vector<uint32_t> expected(packets.size());
+    std::iota(expected.begin(), expected.end(), 0u);
+    std::stable_sort(expected.begin(), expected.end(), [&](uint32_t a, uint32_t b) { return packets[a].sortKey < packets[b].sortKey; });
+
+    const std::vector<DrawCommand>& commands = queue.GetCommands();
+    CHECK(commands.size() == packets.size());
+    if (commands.size() != packets.size()) {
+        return;
+    }
+    DrawQueueStats expectedStats{};
+    bool sameOrder = true;
+    bool sameChanges = true;
+    for (size_t i = 0; i < commands.size(); ++i) {
+        sameOrder &= commands[i].packetIndex == expected[i];
+        const DrawPacket& packet = packets[expected[i]];
+        uint32_t changedStates = 0;
+        if (i == 0) {
+            changedStates = kDrawStateAll;
+        } else {
+            const DrawPacket& previous = packets[expected[i - 1]];
+            const uint32_t current[kDrawStateCount] = { packet.pipeline, packet.geometry, packet.material, packet.transform, packet.texture };
+            const uint32_t before[kDrawStateCount] = { previous.pipeline, previous.geometry, previous.material, previous.transform, previous.texture };
+            for (uint32_t state = 0; state < kDrawStateCount; ++state) {
+                changedStates |= current[state] != before[state] ? 1u << state : 0u;
+            }
+        }
+        sameChanges &= commands[i].changedStates == changedStates;
+        for (uint32_t state = 0; state < kDrawStateCount; ++state) {
+            expectedStats.stateChanges[state] += (changedStates >> state) & 1u;
+            expectedStats.stateChangeCount += (changedStates >> state) & 1u;
+        }
+    }
+    CHECK(sameOrder);
+    CHECK(sameChanges);
+    const DrawQueueStats& stats = queue.GetStats();
+    CHECK(stats.drawCount == packets.size());
+    CHECK(stats.naiveStateChangeCount == packets.size() * kDrawStateCount);
+    CHECK(stats.stateChangeCount == expectedStats.stateChangeCount);
+    CHECK(std::equal(std::begin(stats.stateChanges), std::end(stats.stateChanges), std::begin(expectedStats.stateChanges)));
+}
+
+} // namespace
+
+int main()
+{
+    DrawQueue queue;
+
+    // 全ての桁がばらばらの描画
+    SyntheticDrawSettings allDigits;
+    allDigits.passCount = 16;
+    allDigits.pipelineCount = 4096;
+    allDigits.materialCount = 65536;
+    allDigits.textureCount = 65536;
+    CheckSorted(MakeSyntheticDraws(100000, 1, allDigits), queue);
+    CHECK(queue.GetStats().sortedDigitCount == 8);
+    // 同じキーが多い描画で、同じキーがAddした順に並ぶことも確かめる
+    SyntheticDrawSettings fewStates;
+    fewStates.pipelineCount = 3;
+    fewStates.materialCount = 4;
+    fewStates.textureCount = 5;
+    fewStates.depthBucketCount = 2;
+    CheckSorted(MakeSyntheticDraws(20000, 2, fewStates), queue);
+
+    // パスが1つで深度を使わないと、パスとPSOの上位、深度の2桁、マテリアルの上位は全て同じなので並べない
+    SyntheticDrawSettings constantDigits;
+    constantDigits.passCount = 1;
+    constantDigits.pipelineCount = 16;
+    constantDigits.materialCount = 256;
+    constantDigits.textureCount = 65536;
+    constantDigits.depthBucketCount = 1;
+    CheckSorted(MakeSyntheticDraws(50000, 3, constantDigits), queue);
+    // 残るのはテクスチャの2桁、PSOの下位を含む桁、マテリアルの下位の桁
+    CHECK(queue.GetStats().sortedDigitCount == 4);
+
+    // 全て同じキーなら1桁も並べず、Addした順のまま
+    std::vector<DrawPacket> sameKey = MakeSyntheticDraws(1000, 4);
+    for (DrawPacket& packet : sameKey) {
+        packet.sortKey = MakeDrawSortKey(1, 2, 3, 4, 5);
+    }
+    CheckSorted(sameKey, queue);
+    CHECK(queue.GetStats().sortedDigitCount == 0);
+
+    // 空と1個
+    CheckSorted({}, queue);
+    CheckSorted(MakeSyntheticDraws(1, 5), queue);
+    CHECK(queue.GetStats().stateChangeCount == kDrawStateCount);
+    return TEST_RESULT();
+}
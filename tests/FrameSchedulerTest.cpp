@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <vector>
+
+#include "FrameScheduler.h"
+#include "TestUtility.h"
+
+namespace {
+
+/// <summary>
+/// GPUの代わりのキュー。completedValueはテストが進め、Waitは待った値を覚えてそこまで進める
+/// </summary>
+class FakeFrameQueue : public FrameQueue {
+public:
+    uint64_t Signal() override { return ++signaledValue; }
+    uint64_t GetCompletedValue() override { return completedValue; }
+    void Wait(uint64_t value) override
+    {
+        waits.push_back(value);
+        completedValue = (std::max)(completedValue, value);
+    }
+
+    uint64_t signaledValue = 0;
+    uint64_t completedValue = 0;
+    std::vector<uint64_t> waits; // Waitに渡された値
+};
+
+/// <summary>
+/// 組のフェンスが終わっていなければだけ待ち、未完了のフレームはframesInFlightを超えない
+/// </summary>
+void TestBeginFrameWaits()
+{
+    FakeFrameQueue queue;
+    FrameScheduler scheduler;
+    scheduler.Initialize(&queue, 3, 3);
+
+    // 最初の3フレームは組が空なので待たない
+    for (uint32_t frame = 0; frame < 3; ++frame) {
+        CHECK(scheduler.BeginFrame() == frame);
+        CHECK(scheduler.GetPendingFrameCount() == frame);
+        CHECK(scheduler.EndFrame() == frame + 1);
+    }
+    CHECK(queue.waits.empty());
+
+    // 4フレーム目は組0を使ったフレーム(Signal値1)を待つ
+    CHECK(scheduler.BeginFrame() == 0);
+    CHECK(queue.waits.size() == 1 && queue.waits.back() == 1);
+    CHECK(scheduler.GetPendingFrameCount() == 2);
+    scheduler.EndFrame();
+
+    // GPUが先に終えていれば待たない
+    queue.completedValue = 3;
+    CHECK(scheduler.BeginFrame() == 1);
+    CHECK(queue.waits.size() == 1);
+    CHECK(scheduler.GetPendingFrameCount() == 1);
+    scheduler.EndFrame();
+
+    // GPUが進まなくても、未完了のフレームは始めたフレームを含めてframesInFlightまで
+    for (uint32_t frame = 0; frame < 20; ++frame) {
+        scheduler.BeginFrame();
+        CHECK(scheduler.GetPendingFrameCount() < scheduler.GetFramesInFlight());
+        scheduler.EndFrame();
+        CHECK(queue.signaledValue - queue.completedValue <= scheduler.GetFramesInFlight());
+    }
+}
+
+/// <summary>
+/// framesInFlightが1なら毎フレーム前のフレームを待つ
+/// </summary>
+void TestSingleFrameInFlight()
+{
+    FakeFrameQueue queue;
+    FrameScheduler scheduler;
+    scheduler.Initialize(&queue, 3, 1);
+    for (uint32_t frame = 0; frame < 4; ++frame) {
+        CHECK(scheduler.BeginFrame() == 0);
+        CHECK(scheduler.GetPendingFrameCount() == 0);
+        scheduler.EndFrame();
+    }
+    CHECK(queue.waits == std::vector<uint64_t>({ 1, 2, 3 }));
+}
+
+/// <summary>
+/// SetFramesInFlightは送ったフレームを全て待ってから切り替え、組0から使い直す
+/// </summary>
+void TestSetFramesInFlight()
+{
+    FakeFrameQueue queue;
+    FrameScheduler scheduler;
+    scheduler.Initialize(&queue, 3, 2);
+    scheduler.BeginFrame();
+    scheduler.EndFrame();
+    scheduler.BeginFrame();
+    scheduler.EndFrame();
+    CHECK(queue.completedValue == 0);
+
+    // 同じ数なら何もしない
+    scheduler.SetFramesInFlight(2);
+    CHECK(queue.waits.empty());
+
+    scheduler.SetFramesInFlight(3);
+    CHECK(queue.waits.size() == 1 && queue.waits.back() == 2);
+    CHECK(queue.completedValue == queue.signaledValue);
+    CHECK(scheduler.GetFramesInFlight() == 3);
+    CHECK(scheduler.BeginFrame() == 0);
+    CHECK(scheduler.GetPendingFrameCount() == 0);
+    scheduler.EndFrame();
+
+    // 範囲外は1~maxFramesInFlightに丸める
+    scheduler.SetFramesInFlight(0);
+    CHECK(scheduler.GetFramesInFlight() == 1);
+    scheduler.SetFramesInFlight(8);
+    CHECK(scheduler.GetFramesInFlight() == 3);
+}
+
+/// <summary>
+/// WaitIdleは最後に送ったフレームを待ち、何も送っていなければ待たない
+/// </summary>
+void TestWaitIdle()
+{
+    FakeFrameQueue queue;
+    FrameScheduler scheduler;
+    scheduler.Initialize(&queue, 3, 3);
+    scheduler.WaitIdle();
+    CHECK(queue.waits.empty());
+
+    for (uint32_t frame = 0; frame < 3; ++frame) {
+        scheduler.BeginFrame();
+        scheduler.EndFrame();
+    }
+    scheduler.WaitIdle();
+    CHECK(queue.waits.size() == 1 && queue.waits.back() == 3);
+    scheduler.WaitIdle();
+    CHECK(queue.waits.size() == 1);
+
+    // 待った後は未完了のフレームがない
+    scheduler.BeginFrame();
+    CHECK(scheduler.GetPendingFrameCount() == 0);
+}
+
+} // namespace
+
+int main()
+{
+    TestBeginFrameWaits();
+    TestSingleFrameInFlight();
+    TestSetFramesInFlight();
+    TestWaitIdle();
+    return TEST_RESULT();
+}
@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "FrustumCulling.h"
+#include "MatrixSimd.h"
+#include "SyntheticBounds.h"
+#include "TestUtility.h"
+
+namespace {
+
+/// <summary>
+/// CullObjectsと同じ式を倍精度で1平面ずつ調べる基準
+/// </summary>
+enum class ReferenceResult {
+    Inside,
+    Outside,
+    Ambiguous, // どれかの平面との差が丸め誤差の範囲に入り、floatの結果がどちらになってもよいもの
+};
+
+ReferenceResult CullReference(const CullingBoundsSoA& bounds, size_t index, const Frustum& frustum)
+{
+    constexpr double kTolerance = 1e-4;
+    bool ambiguous = false;
+    for (const Vector4& plane : frustum.planes) {
+        double distance = static_cast<double>(plane.x) * bounds.centerX[index] + static_cast<double>(plane.y) * bounds.centerY[index] +
+            static_cast<double>(plane.z) * bounds.centerZ[index] + plane.w;
+        double boxRadius = std::abs(static_cast<double>(plane.x)) * bounds.extentX[index] + std::abs(static_cast<double>(plane.y)) * bounds.extentY[index] +
+            std::abs(static_cast<double>(plane.z)) * bounds.extentZ[index];
+        double margin = distance + (std::min)(boxRadius, static_cast<double>(bounds.radius[index]));
+        if (margin < -kTolerance) {
+            return ReferenceResult::Outside;
+        }
+        ambiguous = ambiguous || margin < kTolerance;
+    }
+    return ambiguous ? ReferenceResult::Ambiguous : ReferenceResult::Inside;
+}
+
+/// <summary>
+/// 今の命令セットのCullObjectsの結果を基準と比べる
+/// </summary>
+void TestMatchesReference(const CullingBoundsSoA& bounds, const Frustum& frustum)
+{
+    std::vector<uint32_t> visibleIndices;
+    uint32_t visibleCount = CullObjects(bounds, frustum, visibleIndices);
+    CHECK(visibleCount == visibleIndices.size());
+    CHECK(std::is_sorted(visibleIndices.begin(), visibleIndices.end()));
+
+    std::vector<bool> visible(bounds.GetSize(), false);
+    for (uint32_t index : visibleIndices) {
+        visible[index] = true;
+    }
+    size_t insideCount = 0;
+    size_t outsideCount = 0;
+    size_t ambiguousCount = 0;
+    for (size_t i = 0; i < bounds.GetSize(); ++i) {
+        switch (CullReference(bounds, i, frustum)) {
+        case ReferenceResult::Inside:
+            CHECK(visible[i]);
+            ++insideCount;
+            break;
+        case ReferenceResult::Outside:
+            CHECK(!visible[i]);
+            ++outsideCount;
+            break;
+        case ReferenceResult::Ambiguous:
+            ++ambiguousCount;
+            break;
+        }
+    }
+    // 内と外の両方を十分に含み、曖昧なものはほとんどない
+    CHECK(insideCount > bounds.GetSize() / 20);
+    CHECK(outsideCount > bounds.GetSize() / 20);
+    CHECK(ambiguousCount < bounds.GetSize() / 1000 + 1);
+}
+
+/// <summary>
+/// 平面をまたぐ箱は、中心が平面の上にあるので必ず残る
+/// </summary>
+void TestStraddlingBoxesStay(const Frustum& frustum)
+{
+    for (int planeIndex = 0; planeIndex < 6; ++planeIndex) {
+        const Vector4& plane = frustum.planes[planeIndex];
+        CullingBoundsSoA bounds;
+        // 8個ずつと端数の両方を通るよう、8の倍数でない数にする
+        constexpr size_t kCount = 13;
+        bounds.Resize(kCount);
+        for (size_t i = 0; i < kCount; ++i) {
+            // 視錐台の中の点(0, 0, 20)から平面へ下ろした点を中心にする
+            Vector3 point = { 0.0f, 0.0f, 20.0f };
+            float distance = plane.x * point.x + plane.y * point.y + plane.z * point.z + plane.w;
+            bounds.centerX[i] = point.x - plane.x * distance;
+            bounds.centerY[i] = point.y - plane.y * distance;
+            bounds.centerZ[i] = point.z - plane.z * distance;
+            float extent = 0.05f + 0.1f * static_cast<float>(i);
+            bounds.extentX[i] = extent;
+            bounds.extentY[i] = extent;
+            bounds.extentZ[i] = extent;
+            bounds.radius[i] = extent * 2.0f;
+        }
+        std::vector<uint32_t> visibleIndices;
+        CHECK(CullObjects(bounds, frustum, visibleIndices) == kCount);
+    }
+}
+
+} // namespace
+
+int main()
+{
+    Frustum frustum = MakeSyntheticFrustum();
+    // 8個ずつと4個ずつのどちらでも端数が出る数
+    CullingBoundsSoA bounds = MakeSyntheticBounds(100003, frustum, 42, 4);
+
+    const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::Sse41, SimdLevel::Avx2 };
+    std::vector<uint32_t> scalarIndices;
+    for (SimdLevel level : levels) {
+        SetSimdLevel(level);
+        if (GetSimdLevel() != level) {
+            // このCPUにない命令セットは確かめられない
+            std::printf("%s: not supported, skipped\n", GetSimdLevelName(level));
+            continue;
+        }
+        std::printf("%s\n", GetSimdLevelName(level));
+        TestMatchesReference(bounds, frustum);
+        TestStraddlingBoxesStay(frustum);
+
+        // SSE4.1は1個ずつの式と同じ順に計算するので完全に一致する
+        std::vector<uint32_t> visibleIndices;
+        CullObjects(bounds, frustum, visibleIndices);
+        if (level == SimdLevel::Scalar) {
+            scalarIndices = visibleIndices;
+        } else if (level == SimdLevel::Sse41) {
+            CHECK(visibleIndices == scalarIndices);
+        }
+    }
+    return TEST_RESULT();
+}
@@ -0,0 +1,383 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <utility>
+
+#include "MathFunctions.h"
+#include "TestUtility.h"
+
+namespace {
+
+// 1つの関数あたりの入力の数
+constexpr int kSampleCount = 200000;
+
+struct Matrix4x4D {
+    double m[4][4];
+};
+
+Matrix4x4D ToDouble(const Matrix4x4& matrix)
+{
+    Matrix4x4D result;
+    for (int row = 0; row < 4; ++row) {
+        for (int column = 0; column < 4; ++column) {
+            result.m[row][column] = matrix.m[row][column];
+        }
+    }
+    return result;
+}
+
+Matrix4x4D MultiplyDouble(const Matrix4x4D& m1, const Matrix4x4D& m2)
+{
+    Matrix4x4D result{};
+    for (int row = 0; row < 4; ++row) {
+        for (int column = 0; column < 4; ++column) {
+            for (int k = 0; k < 4; ++k) {
+                result.m[row][column] += m1.m[row][k] * m2.m[k][column];
+            }
+        }
+    }
+    return result;
+}
+
+/// <summary>
+/// 部分ピボット付きのGauss-Jordan法で求めた逆行列。条件数1e7程度までなら倍精度で十分正確
+/// </summary>
+Matrix4x4D InverseDouble(const Matrix4x4D& matrix)
+{
+    double a[4][8] = {};
+    for (int row = 0; row < 4; ++row) {
+        for (int column = 0; column < 4; ++column) {
+            a[row][column] = matrix.m[row][column];
+        }
+        a[row][4 + row] = 1.0;
+    }
+    for (int column = 0; column < 4; ++column) {
+        int pivot = column;
+        for (int row = column + 1; row < 4; ++row) {
+            if (std::abs(a[row][column]) > std::abs(a[pivot][column])) {
+                pivot = row;
+            }
+        }
+        for (int k = 0; k < 8; ++k) {
+            std::swap(a[column][k], a[pivot][k]);
+        }
+        double scale = 1.0 / a[column][column];
+        for (int k = 0; k < 8; ++k) {
+            a[column][k] *= scale;
+        }
+        for (int row = 0; row < 4; ++row) {
+            if (row != column) {
+                double factor = a[row][column];
+                for (int k = 0; k < 8; ++k) {
+                    a[row][k] -= factor * a[column][k];
+                }
+            }
+        }
+    }
+    Matrix4x4D result;
+    for (int row = 0; row < 4; ++row) {
+        for (int column = 0; column < 4; ++column) {
+            result.m[row][column] = a[row][4 + column];
+        }
+    }
+    return result;
+}
+
+/// <summary>
+/// 基準の値referenceの位置でのfloatの1ULPの大きさ
+/// </summary>
+double GetUlp(double reference)
+{
+    float value = static_cast<float>(std::abs(reference));
+    if (value < FLT_MIN) {
+        return std::ldexp(1.0, -149);
+    }
+    return static_cast<double>(std::nextafter(value, FLT_MAX)) - value;
+}
+
+/// <summary>
+/// 行列の最大の要素の1%以上の要素について、誤差のULPの最大を求める
+/// 0に近い要素は打ち消し合いの結果で、要素の大きさに対するULPに意味がないので除く
+/// </summary>
+double MaxMatrixUlpError(const Matrix4x4& result, const Matrix4x4D& reference)
+{
+    double scale = 0.0;
+    for (int row = 0; row < 4; ++row) {
+        for (int column = 0; column < 4; ++column) {
+            scale = (std::max)(scale, std::abs(reference.m[row][column]));
+        }
+    }
+    double maxError = 0.0;
+    for (int row = 0; row < 4; ++row) {
+        for (int column = 0; column < 4; ++column) {
+            double expected = reference.m[row][column];
+            if (std::abs(expected) >= scale * 0.01) {
+                maxError = (std::max)(maxError, std::abs(result.m[row][column] - expected) / GetUlp(expected));
+            }
+        }
+    }
+    return maxError;
+}
+
+/// <summary>
+/// 行列の最大の要素に対する、誤差の最大の割合
+/// </summary>
+double MaxRelativeError(const Matrix4x4& result, const Matrix4x4D& reference)
+{
+    double scale = 0.0;
+    double maxError = 0.0;
+    for (int row = 0; row < 4; ++row) {
+        for (int column = 0; column < 4; ++column) {
+            scale = (std::max)(scale, std::abs(reference.m[row][column]));
+            maxError = (std::max)(maxError, std::abs(result.m[row][column] - reference.m[row][column]));
+        }
+    }
+    return maxError / scale;
+}
+
+bool IsFinite(const Matrix4x4& matrix)
+{
+    for (int row = 0; row < 4; ++row) {
+        for (int column = 0; column < 4; ++column) {
+            if (!std::isfinite(matrix.m[row][column])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+Matrix4x4 MakeRandomMatrix(std::mt19937& random, float range)
+{
+    std::uniform_real_distribution<float> distribution(-range, range);
+    Matrix4x4 result;
+    for (int row = 0; row < 4; ++row) {
+        for (int column = 0; column < 4; ++column) {
+            result.m[row][column] = distribution(random);
+        }
+    }
+    return result;
+}
+
+/// <summary>
+/// 乱数の4本のベクトルをGram-Schmidt法で直交させた行列
+/// </summary>
+Matrix4x4D MakeRandomOrthogonal(std::mt19937& random)
+{
+    std::normal_distribution<double> distribution(0.0, 1.0);
+    Matrix4x4D result;
+    for (int row = 0; row < 4; ++row) {
+        double* v = result.m[row];
+        for (int k = 0; k < 4; ++k) {
+            v[k] = distribution(random);
+        }
+        for (int previous = 0; previous < row; ++previous) {
+            const double* u = result.m[previous];
+            double dot = v[0] * u[0] + v[1] * u[1] + v[2] * u[2] + v[3] * u[3];
+            for (int k = 0; k < 4; ++k) {
+                v[k] -= dot * u[k];
+            }
+        }
+        double length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2] + v[3] * v[3]);
+        for (int k = 0; k < 4; ++k) {
+            v[k] /= length;
+        }
+    }
+    return result;
+}
+
+/// <summary>
+/// 条件数(最大と最小の特異値の比)がconditionNumberになる行列 U * diag(1, ..., 1/conditionNumber) * V
+/// </summary>
+Matrix4x4 MakeConditionedMatrix(std::mt19937& random, double conditionNumber)
+{
+    Matrix4x4D u = MakeRandomOrthogonal(random);
+    Matrix4x4D v = MakeRandomOrthogonal(random);
+    for (int row = 0; row < 4; ++row) {
+        double singularValue = std::pow(conditionNumber, -row / 3.0);
+        for (int k = 0; k < 4; ++k) {
+            v.m[row][k] *= singularValue;
+        }
+    }
+    Matrix4x4D product = MultiplyDouble(u, v);
+    Matrix4x4 result;
+    for (int row = 0; row < 4; ++row) {
+        for (int column = 0; column < 4; ++column) {
+            result.m[row][column] = static_cast<float>(product.m[row][column]);
+        }
+    }
+    return result;
+}
+
+Matrix4x4D MakeRotateXDouble(double radian)
+{
+    double c = std::cos(radian);
+    double s = std::sin(radian);
+    return { { { 1, 0, 0, 0 }, { 0, c, s, 0 }, { 0, -s, c, 0 }, { 0, 0, 0, 1 } } };
+}
+
+Matrix4x4D MakeRotateYDouble(double radian)
+{
+    double c = std::cos(radian);
+    double s = std::sin(radian);
+    return { { { c, 0, -s, 0 }, { 0, 1, 0, 0 }, { s, 0, c, 0 }, { 0, 0, 0, 1 } } };
+}
+
+Matrix4x4D MakeRotateZDouble(double radian)
+{
+    double c = std::cos(radian);
+    double s = std::sin(radian);
+    return { { { c, s, 0, 0 }, { -s, c, 0, 0 }, { 0, 0, 1, 0 }, { 0, 0, 0, 1 } } };
+}
+
+/// <summary>
+/// 各関数の誤差の最大を出し、上限を超えていないか確かめる
+/// 上限はbench/baselines/MathAccuracyTest.txtの値に余裕を持たせたもので、計算の手順を変えて精度が落ちたら気付けるようにする
+/// </summary>
+void CheckUlp(const char* name, double maxUlp, double limit)
+{
+    std::printf("%-26s %10.1f ulp (limit %g)\n", name, maxUlp, limit);
+    CHECK(maxUlp <= limit);
+}
+
+void TestMultiply(std::mt19937& random)
+{
+    double maxUlp = 0.0;
+    for (int i = 0; i < kSampleCount; ++i) {
+        Matrix4x4 m1 = MakeRandomMatrix(random, 10.0f);
+        Matrix4x4 m2 = MakeRandomMatrix(random, 10.0f);
+        maxUlp = (std::max)(maxUlp, MaxMatrixUlpError(Multiply(m1, m2), MultiplyDouble(ToDouble(m1), ToDouble(m2))));
+    }
+    CheckUlp("Multiply", maxUlp, 384.0);
+}
+
+void TestInverse(std::mt19937& random)
+{
+    std::uniform_real_distribution<double> exponent(0.0, 3.0);
+    double maxUlp = 0.0;
+    for (int i = 0; i < kSampleCount; ++i) {
+        Matrix4x4 m = MakeConditionedMatrix(random, std::pow(10.0, exponent(random)));
+        maxUlp = (std::max)(maxUlp, MaxMatrixUlpError(Inverse(m), InverseDouble(ToDouble(m))));
+    }
+    CheckUlp("Inverse (cond < 1e3)", maxUlp, 49152.0);
+}
+
+/// <summary>
+/// 特異に近い行列の逆行列。条件数の桁ごとに、最大の要素に対する誤差の割合と有限でない結果の数を出す
+/// 余因子展開は行列式の打ち消し合いで桁を失うので、誤差は条件数のほぼ2乗で増え、1e4を超えると行列式が0になって有限でなくなる
+/// </summary>
+void TestInverseNearSingular(std::mt19937& random)
+{
+    // 条件数の桁ごとの、最大の要素に対する誤差の割合の上限。1e4以上は結果が使えないので出すだけにする
+    const double relativeErrorLimits[] = { 5e-5, 3e-3, 0.5 };
+    std::uniform_real_distribution<double> fraction(0.0, 1.0);
+    constexpr int kDecadeSampleCount = kSampleCount / 6;
+    std::printf("Inverse near singular : max abs error / max |inverse|\n");
+    for (int decade = 1; decade <= 6; ++decade) {
+        double maxRelativeError = 0.0;
+        int nonFiniteCount = 0;
+        for (int i = 0; i < kDecadeSampleCount; ++i) {
+            Matrix4x4 m = MakeConditionedMatrix(random, std::pow(10.0, decade + fraction(random)));
+            Matrix4x4 inverse = Inverse(m);
+            if (!IsFinite(inverse)) {
+                ++nonFiniteCount;
+                continue;
+            }
+            maxRelativeError = (std::max)(maxRelativeError, MaxRelativeError(inverse, InverseDouble(ToDouble(m))));
+        }
+        std::printf("  cond 1e%d-1e%d %12.3g  %d of %d non-finite\n", decade, decade + 1, maxRelativeError, nonFiniteCount, kDecadeSampleCount);
+        if (decade <= 3) {
+            CHECK(maxRelativeError <= relativeErrorLimits[decade - 1]);
+            CHECK(nonFiniteCount == 0);
+        }
+    }
+}
+
+void TestMakeAffineMatrix(std::mt19937& random)
+{
+    std::uniform_real_distribution<float> scale(0.1f, 10.0f);
+    std::uniform_real_distribution<float> angle(-3.14159265f, 3.14159265f);
+    std::uniform_real_distribution<float> translate(-100.0f, 100.0f);
+    double maxUlp = 0.0;
+    for (int i = 0; i < kSampleCount; ++i) {
+        Vector3 s = { scale(random), scale(random), scale(random) };
+        Vector3 r = { angle(random), angle(random), angle(random) };
+        Vector3 t = { translate(random), translate(random), translate(random) };
+        Matrix4x4D expected = MultiplyDouble(MultiplyDouble(MakeRotateXDouble(r.x), MakeRotateYDouble(r.y)), MakeRotateZDouble(r.z));
+        const double scales[3] = { s.x, s.y, s.z };
+        for (int row = 0; row < 3; ++row) {
+            for (int column = 0; column < 3; ++column) {
+                expected.m[row][column] *= scales[row];
+            }
+        }
+        expected.m[3][0] = t.x;
+        expected.m[3][1] = t.y;
+        expected.m[3][2] = t.z;
+        maxUlp = (std::max)(maxUlp, MaxMatrixUlpError(MakeAffineMatrix(s, r, t), expected));
+    }
+    CheckUlp("MakeAffineMatrix", maxUlp, 64.0);
+}
+
+void TestMakePerspectiveFovMatrix(std::mt19937& random)
+{
+    std::uniform_real_distribution<float> fov(0.1f, 2.5f);
+    std::uniform_real_distribution<float> aspect(0.5f, 3.0f);
+    std::uniform_real_distribution<float> nearClip(0.01f, 1.0f);
+    std::uniform_real_distribution<float> farClip(10.0f, 10000.0f);
+    double maxUlp = 0.0;
+    for (int i = 0; i < kSampleCount; ++i) {
+        float f = fov(random);
+        float a = aspect(random);
+        float n = nearClip(random);
+        float z = farClip(random);
+        double cot = 1.0 / std::tan(static_cast<double>(f) / 2.0);
+        Matrix4x4D expected = { {
+            { cot / a, 0, 0, 0 },
+            { 0, cot, 0, 0 },
+            { 0, 0, static_cast<double>(z) / (static_cast<double>(z) - n), 1 },
+            { 0, 0, -(static_cast<double>(n) * z) / (static_cast<double>(z) - n), 0 },
+        } };
+        maxUlp = (std::max)(maxUlp, MaxMatrixUlpError(MakePerspectiveFovMatrix(f, a, n, z), expected));
+    }
+    CheckUlp("MakePerspectiveFovMatrix", maxUlp, 4.0);
+}
+
+void TestNormalize(std::mt19937& random)
+{
+    std::uniform_real_distribution<float> component(-1000.0f, 1000.0f);
+    double maxUlp = 0.0;
+    for (int i = 0; i < kSampleCount; ++i) {
+        Vector3 v = { component(random), component(random), component(random) };
+        Vector3 result = Normalize(v);
+        double length = std::sqrt(static_cast<double>(v.x) * v.x + static_cast<double>(v.y) * v.y + static_cast<double>(v.z) * v.z);
+        const double expected[3] = { v.x / length, v.y / length, v.z / length };
+        const float actual[3] = { result.x, result.y, result.z };
+        for (int k = 0; k < 3; ++k) {
+            // 長さ1に対して小さすぎる成分は、ULPではなく絶対誤差でしか意味がないので除く
+            if (std::abs(expected[k]) >= 0.01) {
+                maxUlp = (std::max)(maxUlp, std::abs(actual[k] - expected[k]) / GetUlp(expected[k]));
+            }
+        }
+    }
+    CheckUlp("Normalize", maxUlp, 4.0);
+    // 長さ0はそのまま返す
+    Vector3 zero = Normalize({ 0.0f, 0.0f, 0.0f });
+    CHECK(zero.x == 0.0f && zero.y == 0.0f && zero.z == 0.0f);
+}
+
+} // namespace
+
+int main()
+{
+    std::mt19937 random(2024);
+    std::printf("max ulp error versus a double precision reference, %d inputs per function\n", kSampleCount);
+    TestMultiply(random);
+    TestInverse(random);
+    TestMakeAffineMatrix(random);
+    TestMakePerspectiveFovMatrix(random);
+    TestNormalize(random);
+    TestInverseNearSingular(random);
+    return TEST_RESULT();
+}
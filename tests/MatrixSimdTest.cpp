@@ -0,0 +1,248 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <utility>
+
+#include "MatrixSimd.h"
+#include "TestUtility.h"
+
+namespace {
+
+struct Matrix4x4D {
+    double m[4][4];
+};
+
+Matrix4x4D ToDouble(const Matrix4x4A& matrix)
+{
+    Matrix4x4D result;
+    for (int row = 0; row < 4; ++row) {
+        for (int column = 0; column < 4; ++column) {
+            result.m[row][column] = matrix.m[row][column];
+        }
+    }
+    return result;
+}
+
+Matrix4x4D MultiplyDouble(const Matrix4x4D& m1, const Matrix4x4D& m2)
+{
+    Matrix4x4D result{};
+    for (int row = 0; row < 4; ++row) {
+        for (int column = 0; column < 4; ++column) {
+            for (int k = 0; k < 4; ++k) {
+                result.m[row][column] += m1.m[row][k] * m2.m[k][column];
+            }
+        }
+    }
+    return result;
+}
+
+/// <summary>
+/// 部分ピボット付きのGauss-Jordan法で求めた逆行列
+/// </summary>
+Matrix4x4D InverseDouble(const Matrix4x4D& matrix)
+{
+    double a[4][8] = {};
+    for (int row = 0; row < 4; ++row) {
+        for (int column = 0; column < 4; ++column) {
+            a[row][column] = matrix.m[row][column];
+        }
+        a[row][4 + row] = 1.0;
+    }
+    for (int column = 0; column < 4; ++column) {
+        int pivot = column;
+        for (int row = column + 1; row < 4; ++row) {
+            if (std::abs(a[row][column]) > std::abs(a[pivot][column])) {
+                pivot = row;
+            }
+        }
+        for (int k = 0; k < 8; ++k) {
+            std::swap(a[column][k], a[pivot][k]);
+        }
+        double scale = 1.0 / a[column][column];
+        for (int k = 0; k < 8; ++k) {
+            a[column][k] *= scale;
+        }
+        for (int row = 0; row < 4; ++row) {
+            if (row != column) {
+                double factor = a[row][column];
+                for (int k = 0; k < 8; ++k) {
+                    a[row][k] -= factor * a[column][k];
+                }
+            }
+        }
+    }
+    Matrix4x4D result;
+    for (int row = 0; row < 4; ++row) {
+        for (int column = 0; column < 4; ++column) {
+            result.m[row][column] = a[row][4 + column];
+        }
+    }
+    return result;
+}
+
+double MaxAbs(const Matrix4x4D& matrix)
+{
+    double result = 0.0;
+    for (int row = 0; row < 4; ++row) {
+        for (int column = 0; column < 4; ++column) {
+            result = (std::max)(result, std::abs(matrix.m[row][column]));
+        }
+    }
+    return result;
+}
+
+/// <summary>
+/// 各要素が[-range, range]の行列。diagonalBiasを対角に足して条件数を抑える
+/// </summary>
+Matrix4x4A MakeRandomMatrix(std::mt19937& random, float range, float diagonalBias)
+{
+    std::uniform_real_distribution<float> distribution(-range, range);
+    Matrix4x4A result;
+    for (int row = 0; row < 4; ++row) {
+        for (int column = 0; column < 4; ++column) {
+            result.m[row][column] = distribution(random) + (row == column ? diagonalBias : 0.0f);
+        }
+    }
+    return result;
+}
+
+/// <summary>
+/// 拡縮、回転、移動からなるアフィン行列
+/// </summary>
+Matrix4x4A MakeRandomAffineMatrix(std::mt19937& random)
+{
+    std::uniform_real_distribution<float> angle(-3.14159f, 3.14159f);
+    std::uniform_real_distribution<float> scale(0.1f, 10.0f);
+    std::uniform_real_distribution<float> translate(-100.0f, 100.0f);
+    float sx = scale(random);
+    float sy = scale(random);
+    float sz = scale(random);
+    float a = angle(random);
+    float b = angle(random);
+    float c = std::cos(a);
+    float s = std::sin(a);
+    float cb = std::cos(b);
+    float sb = std::sin(b);
+    // Y回転してからZ回転
+    Matrix4x4A result = { {
+        { sx * c * cb, sx * s, -sx * c * sb, 0.0f },
+        { -sy * s * cb, sy * c, sy * s * sb, 0.0f },
+        { sz * sb, 0.0f, sz * cb, 0.0f },
+        { translate(random), translate(random), translate(random), 1.0f },
+    } };
+    return result;
+}
+
+void TestMultiply(std::mt19937& random)
+{
+    constexpr double kEpsilon = 1.1920928955078125e-07;
+    for (int i = 0; i < 2000; ++i) {
+        Matrix4x4A m1 = i % 2 == 0 ? MakeRandomMatrix(random, 10.0f, 0.0f) : MakeRandomAffineMatrix(random);
+        Matrix4x4A m2 = i % 3 == 0 ? MakeRandomMatrix(random, 10.0f, 0.0f) : MakeRandomAffineMatrix(random);
+        Matrix4x4A result = Multiply(m1, m2);
+        Matrix4x4D expected = MultiplyDouble(ToDouble(m1), ToDouble(m2));
+        for (int row = 0; row < 4; ++row) {
+            for (int column = 0; column < 4; ++column) {
+                // 4項の積和の丸め誤差の上限 : 4 * eps * sum(|a||b|)
+                double magnitude = 0.0;
+                for (int k = 0; k < 4; ++k) {
+                    magnitude += std::abs(static_cast<double>(m1.m[row][k]) * m2.m[k][column]);
+                }
+                CHECK(std::abs(result.m[row][column] - expected.m[row][column]) <= 4.0 * kEpsilon * magnitude);
+            }
+        }
+    }
+}
+
+void TestTranspose(std::mt19937& random)
+{
+    for (int i = 0; i < 100; ++i) {
+        Matrix4x4A m = MakeRandomMatrix(random, 10.0f, 0.0f);
+        Matrix4x4A result = Transpose(m);
+        for (int row = 0; row < 4; ++row) {
+            for (int column = 0; column < 4; ++column) {
+                CHECK(result.m[row][column] == m.m[column][row]);
+            }
+        }
+    }
+}
+
+void TestInverse(std::mt19937& random)
+{
+    for (int i = 0; i < 2000; ++i) {
+        Matrix4x4A m = i % 2 == 0 ? MakeRandomMatrix(random, 1.0f, 4.0f) : MakeRandomAffineMatrix(random);
+        Matrix4x4A result = Inverse(m);
+        Matrix4x4D expected = InverseDouble(ToDouble(m));
+        // 条件数の小さい行列なので、逆行列の最大要素に対して相対1e-5以内
+        double tolerance = 1e-5 * MaxAbs(expected);
+        for (int row = 0; row < 4; ++row) {
+            for (int column = 0; column < 4; ++column) {
+                CHECK(std::abs(result.m[row][column] - expected.m[row][column]) <= tolerance);
+            }
+        }
+    }
+
+    // 行列式が0なら有限の値にならない
+    Matrix4x4A singular = { { { 1, 2, 3, 4 }, { 2, 4, 6, 8 }, { 0, 1, 0, 1 }, { 1, 0, 1, 0 } } };
+    Matrix4x4A result = Inverse(singular);
+    CHECK(!std::isfinite(result.m[0][0]));
+}
+
+void TestTransformVectors(std::mt19937& random)
+{
+    constexpr double kEpsilon = 1.1920928955078125e-07;
+    std::uniform_real_distribution<float> distribution(-100.0f, 100.0f);
+    // 8個ずつと端数の両方を通るよう、8の倍数でない数にする
+    constexpr size_t kCount = 37;
+    Vector4 vectors[kCount];
+    for (Vector4& v : vectors) {
+        v = { distribution(random), distribution(random), distribution(random), 1.0f };
+    }
+    Matrix4x4A m = MakeRandomAffineMatrix(random);
+    Vector4 result[kCount];
+    TransformVectors(vectors, result, kCount, m);
+    for (size_t i = 0; i < kCount; ++i) {
+        const float* input = &vectors[i].x;
+        const float* output = &result[i].x;
+        for (int column = 0; column < 4; ++column) {
+            double expected = 0.0;
+            double magnitude = 0.0;
+            for (int k = 0; k < 4; ++k) {
+                expected += static_cast<double>(input[k]) * m.m[k][column];
+                magnitude += std::abs(static_cast<double>(input[k]) * m.m[k][column]);
+            }
+            CHECK(std::abs(output[column] - expected) <= 4.0 * kEpsilon * magnitude);
+        }
+    }
+
+    // 1個だけの関数と、入力と出力が同じ配列の場合も同じ結果になる
+    Vector4 single = TransformVector(vectors[5], m);
+    CHECK(single.x == result[5].x && single.y == result[5].y && single.z == result[5].z && single.w == result[5].w);
+    TransformVectors(vectors, vectors, kCount, m);
+    for (size_t i = 0; i < kCount; ++i) {
+        CHECK(vectors[i].x == result[i].x && vectors[i].y == result[i].y && vectors[i].z == result[i].z && vectors[i].w == result[i].w);
+    }
+}
+
+} // namespace
+
+int main()
+{
+    const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::Sse41, SimdLevel::Avx2 };
+    for (SimdLevel level : levels) {
+        SetSimdLevel(level);
+        if (GetSimdLevel() != level) {
+            // このCPUにない命令セットは確かめられない
+            std::printf("%s: not supported, skipped\n", GetSimdLevelName(level));
+            continue;
+        }
+        std::printf("%s\n", GetSimdLevelName(level));
+        std::mt19937 random(1234);
+        TestMultiply(random);
+        TestTranspose(random);
+        TestInverse(random);
+        TestTransformVectors(random);
+    }
+    return TEST_RESULT();
+}
@@ -0,0 +1,83 @@
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "MeshCache.h"
+#include "SyntheticObj.h"
+#include "TestUtility.h"
+
+namespace {
+
+/// <summary>
+/// キャッシュファイルの中から指定したセクションの位置を探す。なければfalse
+/// </summary>
+bool FindSection(const std::vector<char>& bytes, MeshCacheFormat::SectionType type, MeshCacheFormat::Section& result)
+{
+    MeshCacheFormat::Header header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    for (uint32_t i = 0; i < header.sectionCount; ++i) {
+        std::memcpy(&result, bytes.data() + sizeof(header) + sizeof(MeshCacheFormat::Section) * i, sizeof(result));
+        if (result.type == type) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<char> ReadBytes(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void WriteBytes(const std::filesystem::path& path, const std::vector<char>& bytes)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+} // namespace
+
+int main()
+{
+    std::filesystem::path directory = GetTestDataDirectory();
+    std::filesystem::path sourcePath = directory / "mesh_cache.obj";
+    std::filesystem::path cachePath = directory / "mesh_cache.obj.cmesh";
+    CHECK(WriteSyntheticObj(sourcePath, 2000, 2));
+    std::filesystem::remove(cachePath);
+
+    // OBJから作ったときにキャッシュを書き出し、同じ内容を読み戻せる
+    ModelData model = LoadModel(directory.string(), "mesh_cache.obj", 1);
+    CHECK(std::filesystem::exists(cachePath));
+    uint64_t sourceHash = HashFileContents(sourcePath);
+    ModelData cached;
+    std::vector<std::string> materialNames;
+    CHECK(ReadMeshCache(cachePath, sourceHash, cached, materialNames));
+    CHECK(cached.vertices.size() == model.vertices.size());
+    CHECK(cached.indices == model.indices);
+    CHECK(!ReadMeshCache(cachePath, sourceHash + 1, cached, materialNames));
+
+    // Indexが1つでも頂点の数以上なら、キャッシュを使わない
+    std::vector<char> bytes = ReadBytes(cachePath);
+    MeshCacheFormat::Section indices{};
+    CHECK(FindSection(bytes, MeshCacheFormat::SectionType::Indices, indices));
+    CHECK(indices.size >= sizeof(uint32_t) * 2);
+    const uint32_t corruptValues[] = { static_cast<uint32_t>(model.vertices.size()), 0xFFFFFFFFu };
+    for (uint32_t corruptValue : corruptValues) {
+        std::vector<char> corrupted = bytes;
+        // 最後のIndexを壊す。SubMeshやメッシュレットの確認には引っかからない
+        std::memcpy(corrupted.data() + indices.offset + indices.size - sizeof(uint32_t), &corruptValue, sizeof(corruptValue));
+        WriteBytes(cachePath, corrupted);
+        ModelData rejected;
+        rejected.indices = { 1, 2, 3 };
+        CHECK(!ReadMeshCache(cachePath, sourceHash, rejected, materialNames));
+        // 失敗したときは渡したものを書き換えない
+        CHECK(rejected.indices.size() == 3);
+    }
+
+    // 壊れたキャッシュは次のLoadModelで作り直される
+    ModelData reloaded = LoadModel(directory.string(), "mesh_cache.obj", 1);
+    CHECK(reloaded.indices == model.indices);
+    CHECK(ReadMeshCache(cachePath, sourceHash, cached, materialNames));
+    return TEST_RESULT();
+}
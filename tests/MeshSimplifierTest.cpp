@@ -0,0 +1,85 @@
+#include <cstdio>
+
+#include "MeshSimplifier.h"
+#include "ObjLoader.h"
+#include "SyntheticObj.h"
+#include "TestUtility.h"
+
+namespace {
+
+uint64_t GetLodIndexCount(const ModelData& model, const MeshLod& lod)
+{
+    uint64_t indexCount = 0;
+    for (uint32_t i = 0; i < lod.subMeshCount; ++i) {
+        indexCount += model.subMeshes[lod.subMeshStart + i].indexCount;
+    }
+    return indexCount;
+}
+
+/// <summary>
+/// 各LODはIndexの数が前のLODより減り、全てのIndexがLOD0の頂点を指す
+/// </summary>
+void TestLods(const std::filesystem::path& directory, const char* filename, uint32_t materialCount)
+{
+    ModelData model = LoadObjFile(directory.string(), filename);
+    size_t vertexCount = model.vertices.size();
+    GenerateLods(model);
+    CHECK(model.vertices.size() == vertexCount);
+    CHECK(model.lods.size() >= 2);
+    CHECK(model.lods[0].error == 0.0f);
+
+    uint64_t previousIndexCount = 0;
+    float previousError = 0.0f;
+    for (size_t level = 0; level < model.lods.size(); ++level) {
+        const MeshLod& lod = model.lods[level];
+        CHECK(static_cast<uint64_t>(lod.subMeshStart) + lod.subMeshCount <= model.subMeshes.size());
+        if (static_cast<uint64_t>(lod.subMeshStart) + lod.subMeshCount > model.subMeshes.size()) {
+            return;
+        }
+        CHECK(lod.subMeshCount <= materialCount);
+        uint64_t indexCount = GetLodIndexCount(model, lod);
+        CHECK(indexCount % 3 == 0);
+        if (level > 0) {
+            CHECK(indexCount < previousIndexCount);
+            CHECK(lod.error >= previousError);
+        }
+        size_t outOfRangeCount = 0;
+        for (uint32_t i = 0; i < lod.subMeshCount; ++i) {
+            const SubMesh& subMesh = model.subMeshes[lod.subMeshStart + i];
+            CHECK(static_cast<uint64_t>(subMesh.indexStart) + subMesh.indexCount <= model.indices.size());
+            for (uint32_t j = 0; j < subMesh.indexCount; ++j) {
+                outOfRangeCount += model.indices[subMesh.indexStart + j] < vertexCount ? 0 : 1;
+            }
+        }
+        CHECK(outOfRangeCount == 0);
+        std::printf("%s LOD%zu : %llu indices, error %g\n", filename, level, static_cast<unsigned long long>(indexCount), lod.error);
+        previousIndexCount = indexCount;
+        previousError = lod.error;
+    }
+
+    // 許すずれが小さいほど細かいLODを選ぶ
+    uint32_t previousLod = static_cast<uint32_t>(model.lods.size()) - 1;
+    for (float maxPixelError : { 1000.0f, 10.0f, 1.0f, 0.1f, 0.0f }) {
+        uint32_t lod = SelectLod(model, 100.0f, maxPixelError);
+        CHECK(lod <= previousLod);
+        previousLod = lod;
+    }
+    CHECK(SelectLod(model, 100.0f, 0.0f) == 0);
+
+    // 同じ入力からは同じLODになる
+    ModelData again = LoadObjFile(directory.string(), filename);
+    GenerateLods(again);
+    CHECK(again.indices == model.indices);
+}
+
+} // namespace
+
+int main()
+{
+    std::filesystem::path directory = GetTestDataDirectory();
+    CHECK(WriteSyntheticObj(directory / "lod_single.obj", 20000, 1));
+    CHECK(WriteSyntheticObj(directory / "lod_materials.obj", 20000, 3));
+    TestLods(directory, "lod_single.obj", 1);
+    TestLods(directory, "lod_materials.obj", 3);
+    return TEST_RESULT();
+}
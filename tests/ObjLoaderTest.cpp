@@ -0,0 +1,124 @@
+#include <cstring>
+#include <fstream>
+
+#include "ObjLoader.h"
+#include "ObjTokenizer.h"
+#include "ReferenceObjLoader.h"
+#include "SyntheticObj.h"
+#include "TestUtility.h"
+
+namespace {
+
+bool SameVertices(const std::vector<VertexData>& a, const std::vector<VertexData>& b)
+{
+    return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(VertexData)) == 0);
+}
+
+/// <summary>
+/// X反転、V反転、回り順の反転を小さなファイルで確かめる
+/// </summary>
+void TestHandedness(const std::filesystem::path& directory)
+{
+    {
+        std::ofstream file(directory / "handedness.obj", std::ios::trunc);
+        file << "v 1 2 3\nv 4 5 6\nv 7 8 9\n"
+                "vt 0.25 0.75\nvt 0.5 0.5\nvt 1 0\n"
+                "vn 1 0 0\nvn 0 1 0\nvn 0 0 -1\n"
+                "f 1/1/1 2/2/2 3/3/3\n";
+    }
+    ModelData model = LoadObjFile(directory.string(), "handedness.obj");
+    std::vector<VertexData> vertices = ExpandModelVertices(model);
+    CHECK(vertices.size() == 3);
+    if (vertices.size() != 3) {
+        return;
+    }
+    // 回り順を逆にするので、3番目の頂点が先頭に来る
+    CHECK(vertices[0].position.x == -7.0f && vertices[0].position.y == 8.0f && vertices[0].position.z == 9.0f && vertices[0].position.w == 1.0f);
+    CHECK(vertices[2].position.x == -1.0f);
+    CHECK(vertices[2].texcoord.x == 0.25f && vertices[2].texcoord.y == 0.25f);
+    CHECK(vertices[0].texcoord.y == 1.0f);
+    CHECK(vertices[2].normal.x == -1.0f);
+    CHECK(vertices[0].normal.z == -1.0f);
+    CHECK(SameVertices(vertices, LoadObjFileReference(directory.string(), "handedness.obj")));
+}
+
+/// <summary>
+/// 合成した格子で、置き換える前の読み込みと頂点がビット単位で同じになることを確かめる
+/// </summary>
+void TestMatchesReference(const std::filesystem::path& directory)
+{
+    CHECK(WriteSyntheticObj(directory / "reference.obj", 20000));
+    ModelData model = LoadObjFile(directory.string(), "reference.obj");
+    CHECK(model.indices.size() == 20000 * 3);
+    CHECK(SameVertices(ExpandModelVertices(model), LoadObjFileReference(directory.string(), "reference.obj")));
+    // 格子の頂点は位置、テクスチャ座標、法線が同じ番号なので、重複をまとめると格子の頂点数になる
+    CHECK(model.vertices.size() < model.indices.size() / 4);
+}
+
+/// <summary>
+/// 1からkMaxThreadCountスレッドで読んだ結果が全て1スレッドと同一であることを確かめる
+/// チャンクは1MB以上なので、スレッド数だけチャンクに分かれる大きさのファイルで、マテリアルの切り替えがチャンクをまたぐようにする
+/// </summary>
+void TestThreadCountDeterminism(const std::filesystem::path& directory)
+{
+    constexpr uint32_t kMaxThreadCount = 8;
+    CHECK(WriteSyntheticObj(directory / "determinism.obj", 200000, 3));
+    CHECK(std::filesystem::file_size(directory / "determinism.obj") > (static_cast<uintmax_t>(kMaxThreadCount) << 20));
+    ModelData serial = LoadObjFile(directory.string(), "determinism.obj", 1);
+    CHECK(serial.subMeshes.size() == 3);
+    for (uint32_t threadCount = 2; threadCount <= kMaxThreadCount; ++threadCount) {
+        ModelData parallel = LoadObjFile(directory.string(), "determinism.obj", threadCount);
+        CHECK(SameVertices(parallel.vertices, serial.vertices));
+        CHECK(parallel.indices == serial.indices);
+        CHECK(parallel.subMeshes.size() == serial.subMeshes.size());
+        for (size_t i = 0; i < serial.subMeshes.size() && i < parallel.subMeshes.size(); ++i) {
+            CHECK(parallel.subMeshes[i].indexStart == serial.subMeshes[i].indexStart);
+            CHECK(parallel.subMeshes[i].indexCount == serial.subMeshes[i].indexCount);
+            CHECK(parallel.subMeshes[i].materialIndex == serial.subMeshes[i].materialIndex);
+        }
+        CHECK(parallel.materials.size() == serial.materials.size());
+        for (size_t i = 0; i < serial.materials.size() && i < parallel.materials.size(); ++i) {
+            CHECK(parallel.materials[i].name == serial.materials[i].name);
+        }
+        CHECK(std::memcmp(&parallel.bounds, &serial.bounds, sizeof(AABB)) == 0);
+        CHECK(std::memcmp(&parallel.boundingSphere, &serial.boundingSphere, sizeof(Sphere)) == 0);
+    }
+}
+
+/// <summary>
+/// int32_tに収まらない整数は丸め、桁は最後まで読み進める
+/// </summary>
+void TestParseIntOverflow()
+{
+    auto parse = [](const char* text, const char** next = nullptr) {
+        int32_t value = 0;
+        const char* end = text + std::strlen(text);
+        const char* p = ObjTokenizer::ParseInt(text, end, value);
+        if (next != nullptr) {
+            *next = p;
+        }
+        return value;
+    };
+    CHECK(parse("2147483647") == INT32_MAX);
+    CHECK(parse("-2147483648") == INT32_MIN);
+    CHECK(parse("2147483648") == INT32_MAX);
+    CHECK(parse("-2147483649") == INT32_MIN);
+    // 2^32+1は切り詰めると1になるが、丸めるので正しいIndexにはならない
+    CHECK(parse("4294967297") == INT32_MAX);
+    const char* next = nullptr;
+    CHECK(parse(" +123456789012345678901234567890/5", &next) == INT32_MAX);
+    CHECK(next != nullptr && *next == '/');
+    CHECK(parse("-42") == -42);
+}
+
+} // namespace
+
+int main()
+{
+    std::filesystem::path directory = GetTestDataDirectory();
+    TestHandedness(directory);
+    TestMatchesReference(directory);
+    TestThreadCountDeterminism(directory);
+    TestParseIntOverflow();
+    return TEST_RESULT();
+}
@@ -0,0 +1,75 @@
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "MeshCache.h"
+#include "ObjLoader.h"
+#include "ObjStreamingImport.h"
+#include "ReferenceObjLoader.h"
+#include "SyntheticObj.h"
+#include "TestUtility.h"
+
+namespace {
+
+bool SameVertices(const std::vector<VertexData>& a, const std::vector<VertexData>& b)
+{
+    return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(VertexData)) == 0);
+}
+
+/// <summary>
+/// streamingFileSizeを超えるファイルは、LoadModelがストリーミングで書き出したキャッシュから読む
+/// 三角形の並びはLoadObjFileと同じで、LODとメッシュレットは作らない
+/// </summary>
+void TestLoadModelStreams(const std::filesystem::path& directory, size_t memoryBudget)
+{
+    std::filesystem::remove(directory / "streaming.obj.cmesh");
+    ModelImportSettings settings;
+    settings.streamingFileSize = 0;
+    settings.streaming.memoryBudget = memoryBudget;
+    ModelData streamed = LoadModel(directory.string(), "streaming.obj", 1, nullptr, settings);
+    ModelData expected = LoadObjFile(directory.string(), "streaming.obj");
+    CHECK(SameVertices(ExpandModelVertices(streamed), ExpandModelVertices(expected)));
+    CHECK(streamed.subMeshes.size() == expected.subMeshes.size());
+    CHECK(streamed.lods.size() == 1);
+    CHECK(streamed.meshlets.empty());
+    CHECK(streamed.vertexFormat == VertexFormat::Float);
+
+    // 書き出したキャッシュは次からそのまま使う
+    ModelData cached = LoadModel(directory.string(), "streaming.obj", 1);
+    CHECK(cached.indices == streamed.indices);
+    CHECK(cached.lods.size() == 1);
+}
+
+} // namespace
+
+int main()
+{
+    std::filesystem::path directory = GetTestDataDirectory();
+    CHECK(WriteSyntheticObj(directory / "streaming.obj", 200000, 3));
+
+    // 既定の予算と、属性を一時ファイルへ追い出すほど小さい予算
+    TestLoadModelStreams(directory, ObjStreamingImportSettings{}.memoryBudget);
+    TestLoadModelStreams(directory, static_cast<size_t>(1) << 20);
+
+    ObjStreamingImportSettings small;
+    small.memoryBudget = static_cast<size_t>(1) << 20;
+    ObjStreamingImportReport report{};
+    CHECK(ImportObjFileStreaming(directory.string(), "streaming.obj", small, &report));
+    CHECK(report.spilledBytes > 0);
+    CHECK(report.indexCount == 200000ull * 3);
+    CHECK(report.peakProcessMemory > 0);
+
+    // 桁の多いIndexは切り詰めて別の頂点を指すことはなく、範囲外として読み込みに失敗する
+    {
+        std::ofstream file(directory / "overflow.obj", std::ios::trunc);
+        file << "v 0 0 0\nv 1 0 0\nv 0 1 0\nvt 0 0\nvn 0 0 1\n"
+                "f 1/1/1 2/1/1 4294967297/1/1\n";
+    }
+    CHECK(!ImportObjFileStreaming(directory.string(), "overflow.obj", small));
+
+    // 予算より小さいファイルは今まで通りメモリに読んでLODを作る
+    std::filesystem::remove(directory / "streaming.obj.cmesh");
+    ModelData inMemory = LoadModel(directory.string(), "streaming.obj", 1);
+    CHECK(inMemory.lods.size() > 1);
+    return TEST_RESULT();
+}
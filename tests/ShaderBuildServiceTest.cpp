@@ -0,0 +1,127 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "ShaderBuildService.h"
+#include "TestUtility.h"
+
+namespace {
+
+/// <summary>
+/// DXCの代わりに、コンパイルした回数を数えてファイル名をそのままバイナリにする
+/// </summary>
+struct FakeCompiler {
+    std::atomic<uint32_t> compileCount = 0;
+    std::atomic<uint32_t> compilerCount = 0; // createCompilerを呼んだ回数
+    std::chrono::milliseconds delay{ 0 };
+
+    std::function<ShaderCompileFunction()> MakeFactory()
+    {
+        return [this]() {
+            ++compilerCount;
+            return [this](const ShaderRequest& request) {
+                std::this_thread::sleep_for(delay);
+                ++compileCount;
+                ShaderBinary binary;
+                binary.dxil.assign(request.filePath.begin(), request.filePath.end());
+                return binary;
+            };
+        };
+    }
+};
+
+bool IsReady(const std::shared_future<ShaderBinary>& future)
+{
+    return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+/// <summary>
+/// 同じ要求はコンパイルし直さずに同じ結果を返し、違う要求(マクロの並びを含む)は別にコンパイルする
+/// </summary>
+void TestSubmitDeduplicates()
+{
+    FakeCompiler compiler;
+    ShaderBuildService service;
+    service.Start(2, compiler.MakeFactory());
+    const ShaderRequest request = { L"Object3D.PS.hlsl", L"ps_6_0", { L"A", L"B" }, true };
+    std::shared_future<ShaderBinary> first = service.Submit(request);
+    std::shared_future<ShaderBinary> second = service.Submit(request);
+    CHECK(first.get().dxil == second.get().dxil);
+    CHECK(compiler.compileCount == 1);
+
+    service.Submit({ L"Object3D.PS.hlsl", L"ps_6_0", { L"B", L"A" }, true }).wait();
+    service.Submit({ L"Object3D.PS.hlsl", L"ps_6_0", { L"A", L"B" }, false }).wait();
+    CHECK(compiler.compileCount == 3);
+    service.Stop();
+    CHECK(compiler.compilerCount == 2);
+}
+
+/// <summary>
+/// Invalidateしたファイルの要求は次にSubmitしたときにコンパイルし直す。前のfutureはそのまま使える
+/// </summary>
+void TestInvalidate()
+{
+    FakeCompiler compiler;
+    ShaderBuildService service;
+    service.Start(1, compiler.MakeFactory());
+    const ShaderRequest pixelShader = { L"shaders/Object3D.PS.hlsl", L"ps_6_0", {}, true };
+    const ShaderRequest vertexShader = { L"shaders/Object3D.VS.hlsl", L"vs_6_0", {}, true };
+    std::shared_future<ShaderBinary> before = service.Submit(pixelShader);
+    service.Submit(vertexShader).wait();
+    before.wait();
+    CHECK(compiler.compileCount == 2);
+
+    // 関係ないファイルでは何も忘れない
+    service.Invalidate({ std::filesystem::path("shaders/Other.hlsl") });
+    service.Submit(pixelShader).wait();
+    CHECK(compiler.compileCount == 2);
+
+    // 要求のパスは正規化して比べる
+    service.Invalidate({ std::filesystem::path("shaders/./Object3D.PS.hlsl").lexically_normal() });
+    std::shared_future<ShaderBinary> after = service.Submit(pixelShader);
+    after.wait();
+    CHECK(compiler.compileCount == 3);
+    CHECK(IsReady(before) && !before.get().dxil.empty());
+    service.Submit(vertexShader).wait();
+    CHECK(compiler.compileCount == 3);
+    service.Stop();
+}
+
+/// <summary>
+/// Stopは積まれている要求を全て終えてから戻る
+/// </summary>
+void TestStopDrains()
+{
+    FakeCompiler compiler;
+    compiler.delay = std::chrono::milliseconds(2);
+    ShaderBuildService service;
+    service.Start(2, compiler.MakeFactory());
+    std::vector<std::shared_future<ShaderBinary>> results;
+    for (int i = 0; i < 32; ++i) {
+        results.push_back(service.Submit({ L"Shader" + std::to_wstring(i) + L".hlsl", L"ps_6_0", {}, true }));
+    }
+    service.Stop();
+    CHECK(service.GetThreadCount() == 0);
+    CHECK(compiler.compileCount == 32);
+    bool allReady = true;
+    for (const std::shared_future<ShaderBinary>& result : results) {
+        allReady &= IsReady(result) && !result.get().dxil.empty();
+    }
+    CHECK(allReady);
+
+    // Stopの後はStartし直せば使える。前の結果は忘れているのでコンパイルし直す
+    service.Start(1, compiler.MakeFactory());
+    service.Submit({ L"Shader0.hlsl", L"ps_6_0", {}, true }).wait();
+    CHECK(compiler.compileCount == 33);
+}
+
+} // namespace
+
+int main()
+{
+    TestSubmitDeduplicates();
+    TestInvalidate();
+    TestStopDrains();
+    return TEST_RESULT();
+}
@@ -0,0 +1,56 @@
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ShaderCache.h"
+#include "SyntheticObj.h"
+#include "TestUtility.h"
+
+namespace {
+
+void WriteText(const std::filesystem::path& path, const std::string& text)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << text;
+}
+
+} // namespace
+
+int main()
+{
+    std::filesystem::path directory = GetTestDataDirectory() / "shader_cache";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    std::filesystem::path sourcePath = directory / "Test.PS.hlsl";
+    std::filesystem::path includePath = directory / "Common.hlsli";
+    WriteText(sourcePath, "#include \"Common.hlsli\"\nfloat4 main() : SV_TARGET { return kColor; }\n");
+    WriteText(includePath, "static const float4 kColor = float4(1, 0, 0, 1);\n");
+
+    std::vector<std::wstring> arguments = MakeShaderArguments(sourcePath.wstring(), L"ps_6_0", {}, true);
+    uint64_t key = ComputeShaderCacheKey(sourcePath, arguments, "1.8 4712 abcdef");
+    CHECK(key != 0);
+    CHECK(key == ComputeShaderCacheKey(sourcePath, arguments, "1.8 4712 abcdef"));
+
+    // DXCの版かコミットが違えば別のキーになる
+    CHECK(key != ComputeShaderCacheKey(sourcePath, arguments, "1.7 4712 abcdef"));
+    CHECK(key != ComputeShaderCacheKey(sourcePath, arguments, "1.8 4713 012345"));
+    CHECK(key != ComputeShaderCacheKey(sourcePath, arguments, ""));
+
+    // 引数とincludeしたファイルの内容もキーに入る
+    CHECK(key != ComputeShaderCacheKey(sourcePath, MakeShaderArguments(sourcePath.wstring(), L"ps_6_0", { L"FEATURE" }, true), "1.8 4712 abcdef"));
+    WriteText(includePath, "static const float4 kColor = float4(0, 1, 0, 1);\n");
+    CHECK(key != ComputeShaderCacheKey(sourcePath, arguments, "1.8 4712 abcdef"));
+
+    // ソースが読めなければ0
+    CHECK(ComputeShaderCacheKey(directory / "Missing.hlsl", arguments, "1.8 4712 abcdef") == 0);
+
+    // 書いたキャッシュは同じキーでだけ読める
+    const std::vector<uint8_t> dxil = { 'D', 'X', 'B', 'C', 1, 2, 3, 4 };
+    std::filesystem::path cacheDirectory = directory / "cache";
+    CHECK(WriteShaderCache(cacheDirectory, key, dxil.data(), dxil.size()));
+    std::vector<uint8_t> cached;
+    CHECK(ReadShaderCache(cacheDirectory, key, cached));
+    CHECK(cached == dxil);
+    CHECK(!ReadShaderCache(cacheDirectory, key + 1, cached));
+    return TEST_RESULT();
+}
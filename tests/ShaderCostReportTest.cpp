@@ -0,0 +1,156 @@
+#include <string>
+#include <vector>
+
+#include "ShaderCostReport.h"
+#include "TestUtility.h"
+
+namespace {
+
+// 手で書いたDXILの逆アセンブル。右の番号は関数の中の命令の番号
+// pow(sample, input)はLog(23)、fmul、Exp(21)になる
+constexpr const char* kDisassembly = R"(;
+; Input signature:
+;
+; Name                 Index   Mask Register SysValue  Format   Used
+target datalayout = "e-m:e-p:32:32-i1:32-i8:32-i16:32-i32:32-i64:64-f16:32-f32:32-f64:64-n8:16:32:64"
+target triple = "dxil-ms-dx"
+
+%dx.types.Handle = type { i8* }
+%dx.types.ResRet.f32 = type { float, float, float, float, i32 }
+
+define void @main() {
+entry:
+  %0 = call %dx.types.Handle @dx.op.createHandle(i32 57, i8 0, i32 0, i32 0, i1 false)  ; CreateHandle(resourceClass,rangeId,index,nonUniformIndex)
+  %1 = call float @dx.op.loadInput.f32(i32 4, i32 0, i32 0, i8 0, i32 undef)  ; LoadInput(inputSigId,rowIndex,colIndex,gsVertexAxis)
+  %2 = call float @dx.op.loadInput.f32(i32 4, i32 1, i32 0, i8 0, i32 undef)  ; LoadInput(inputSigId,rowIndex,colIndex,gsVertexAxis)
+  %3 = call %dx.types.ResRet.f32 @dx.op.sample.f32(i32 60, %dx.types.Handle %0, %dx.types.Handle undef, float %1, float %1, float undef, float undef, i32 0, i32 0, i32 undef, float undef)  ; Sample
+  %4 = extractvalue %dx.types.ResRet.f32 %3, 0
+  %5 = call float @dx.op.unary.f32(i32 23, float %4)  ; Log(value)
+  %6 = fmul fast float %5, %2
+  %7 = call float @dx.op.unary.f32(i32 21, float %6)  ; Exp(value)
+  %8 = fcmp fast ogt float %7, 5.000000e-01
+  br i1 %8, label %9, label %11
+
+; <label>:9                                       ; preds = %entry
+  %10 = fadd fast float %7, 1.000000e+00
+  br label %11
+
+; <label>:11                                      ; preds = %9, %entry
+  %12 = phi float [ %7, %entry ], [ %10, %9 ]
+  call void @dx.op.storeOutput.f32(i32 5, i32 0, i32 0, i8 0, float %12)  ; StoreOutput(outputSigId,rowIndex,colIndex,value)
+  ret void
+}
+
+; Function Attrs: nounwind readnone
+declare float @dx.op.unary.f32(i32, float) #0
+)";
+
+void TestAnalyze()
+{
+    ShaderCost cost = AnalyzeDxilDisassembly(kDisassembly);
+    CHECK(cost.instructionCount == 15);
+    CHECK(cost.aluCount == 3); // fmul、fcmp、fadd
+    CHECK(cost.transcendentalCount == 2); // Log(23)とExp(21)
+    CHECK(cost.sampleCount == 1);
+    CHECK(cost.memoryCount == 3); // LoadInputが2つとStoreOutput
+    CHECK(cost.branchCount == 1); // br i1だけ。無条件のbrは数えない
+    CHECK(cost.valueCount == 11);
+    // 2番の命令で%0、%1、%2が生きている
+    CHECK(cost.peakLiveValueCount == 3);
+}
+
+void TestBranch()
+{
+    // 同じ関数で、無条件のbrは分岐に入らず命令の数だけ増える
+    ShaderCost conditional = AnalyzeDxilDisassembly(
+        "define void @main() {\n"
+        "  %0 = icmp eq i32 0, 0\n"
+        "  br i1 %0, label %1, label %1\n"
+        "  ret void\n"
+        "}\n");
+    ShaderCost unconditional = AnalyzeDxilDisassembly(
+        "define void @main() {\n"
+        "  %0 = icmp eq i32 0, 0\n"
+        "  br label %1\n"
+        "  ret void\n"
+        "}\n");
+    CHECK(conditional.branchCount == 1);
+    CHECK(unconditional.branchCount == 0);
+    CHECK(conditional.instructionCount == unconditional.instructionCount);
+    // 使われない値は生存区間を持たない
+    CHECK(unconditional.peakLiveValueCount == 0);
+    CHECK(conditional.peakLiveValueCount == 1);
+}
+
+void TestFormatAndParse()
+{
+    std::vector<NamedShaderCost> costs = {
+        { "Object3d.PS", AnalyzeDxilDisassembly(kDisassembly) },
+        { "Object3d.VS", ShaderCost{ 20, 8, 0, 0, 6, 0, 14, 5 } },
+    };
+    std::vector<NamedShaderCost> parsed;
+    CHECK(ParseShaderCostReport(FormatShaderCostReport(costs), parsed));
+    CHECK(parsed.size() == 2);
+    for (size_t i = 0; i < parsed.size() && i < costs.size(); ++i) {
+        CHECK(parsed[i].name == costs[i].name);
+        CHECK(parsed[i].cost == costs[i].cost);
+    }
+
+    // 注釈だけなら空
+    CHECK(ParseShaderCostReport("# name instructions\n# note\n", parsed));
+    CHECK(parsed.empty());
+    // 列が足りない、多い、数でない
+    CHECK(!ParseShaderCostReport("Object3d.PS 1 2 3\n", parsed));
+    CHECK(!ParseShaderCostReport("Object3d.PS 1 2 3 4 5 6 7 8 9\n", parsed));
+    CHECK(!ParseShaderCostReport("Object3d.PS 1 2 3 4 5 6 7 x\n", parsed));
+}
+
+void TestCompare()
+{
+    std::vector<NamedShaderCost> baseline = {
+        { "Object3d.PS", AnalyzeDxilDisassembly(kDisassembly) },
+    };
+
+    // 同じ数なら悪化なし
+    std::vector<NamedShaderCost> current = baseline;
+    CHECK(CompareShaderCosts(baseline, current).empty());
+    CHECK(FindShadersWithoutBaseline(baseline, current).empty());
+
+    // 減ったものは悪化に入らない
+    current[0].cost.memoryCount -= 1;
+    CHECK(CompareShaderCosts(baseline, current).empty());
+
+    // 増えたものは列ごとに報告する
+    current = baseline;
+    current[0].cost.transcendentalCount += 1;
+    current[0].cost.peakLiveValueCount += 2;
+    std::vector<std::string> regressions = CompareShaderCosts(baseline, current);
+    CHECK(regressions.size() == 2);
+    if (regressions.size() == 2) {
+        CHECK(regressions[0] == "Object3d.PS: transcendental 2 -> 3");
+        CHECK(regressions[1] == "Object3d.PS: peakLive 3 -> 5");
+    }
+
+    // 基準にないシェーダーは悪化にせず、別に名前を返す
+    current = baseline;
+    current.push_back({ "Sprite.PS", ShaderCost{ 100, 50, 10, 4, 8, 2, 80, 20 } });
+    CHECK(CompareShaderCosts(baseline, current).empty());
+    std::vector<std::string> missing = FindShadersWithoutBaseline(baseline, current);
+    CHECK(missing.size() == 1);
+    CHECK(!missing.empty() && missing[0] == "Sprite.PS");
+
+    // 空の基準ならすべてが基準にない
+    CHECK(CompareShaderCosts({}, current).empty());
+    CHECK(FindShadersWithoutBaseline({}, current).size() == 2);
+}
+
+} // namespace
+
+int main()
+{
+    TestAnalyze();
+    TestBranch();
+    TestFormatAndParse();
+    TestCompare();
+    return TEST_RESULT();
+}
@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "ShaderHotReload.h"
+#include "TestUtility.h"
+
+namespace {
+
+/// <summary>
+/// メモリ上のファイルシステム。Touchで更新日時を進め、Removeで消す
+/// </summary>
+class FakeShaderFileSystem : public ShaderFileSystem {
+public:
+    bool GetWriteTime(const std::filesystem::path& filePath, uint64_t& writeTime) const override
+    {
+        ++queryCount;
+        auto it = writeTimes_.find(filePath.lexically_normal());
+        if (it == writeTimes_.end()) {
+            return false;
+        }
+        writeTime = it->second;
+        return true;
+    }
+
+    void Touch(const std::filesystem::path& filePath) { writeTimes_[filePath.lexically_normal()] = ++clock_; }
+    void Remove(const std::filesystem::path& filePath) { writeTimes_.erase(filePath.lexically_normal()); }
+
+    mutable uint32_t queryCount = 0;
+
+private:
+    std::map<std::filesystem::path, uint64_t> writeTimes_;
+    uint64_t clock_ = 0;
+};
+
+using Paths = std::vector<std::filesystem::path>;
+
+/// <summary>
+/// 順番を問わずに比べる
+/// </summary>
+bool SameRoots(Paths actual, Paths expected)
+{
+    std::sort(actual.begin(), actual.end());
+    std::sort(expected.begin(), expected.end());
+    return actual == expected;
+}
+
+} // namespace
+
+int main()
+{
+    FakeShaderFileSystem fileSystem;
+    const std::filesystem::path vertexShader = "Object3d.VS.hlsl";
+    const std::filesystem::path pixelShader = "Object3d.PS.hlsl";
+    const std::filesystem::path spriteShader = "Sprite.PS.hlsl";
+    const std::filesystem::path shared = "Object3d.hlsli";
+    const std::filesystem::path lighting = "Lighting.hlsli";
+    for (const std::filesystem::path& file : { vertexShader, pixelShader, spriteShader, shared, lighting }) {
+        fileSystem.Touch(file);
+    }
+
+    // DXCが返すincludeは"./"付きのこともある。rootの側も正規化してそろえる
+    ShaderHotReload hotReload(fileSystem);
+    hotReload.SetDependencies(vertexShader, { "./Object3d.hlsli" });
+    hotReload.SetDependencies("./Object3d.PS.hlsl", { shared, "shaders/../Lighting.hlsli" });
+    hotReload.SetDependencies(spriteShader, {});
+    CHECK(hotReload.GetGraph().GetRootCount() == 3);
+    CHECK(hotReload.GetGraph().GetFiles().size() == 5);
+    CHECK(SameRoots(hotReload.GetGraph().GetAffectedRoots("./Object3d.hlsli"), { vertexShader, pixelShader }));
+    CHECK(SameRoots(hotReload.GetGraph().GetAffectedRoots(shared), { vertexShader, pixelShader }));
+
+    // 見張り始めた状態から何も変わっていなければ、最初のPollは何も返さない
+    CHECK(hotReload.PollChangedRoots().empty());
+    CHECK(fileSystem.queryCount > 0);
+
+    // 共有の.hlsliを触ると、それをincludeした全てのrootを1回ずつ返す
+    fileSystem.Touch(shared);
+    CHECK(SameRoots(hotReload.PollChangedRoots(), { vertexShader, pixelShader }));
+    CHECK(hotReload.PollChangedRoots().empty());
+
+    // root自身を触るとそのrootだけ
+    fileSystem.Touch(spriteShader);
+    CHECK(SameRoots(hotReload.PollChangedRoots(), { spriteShader }));
+    fileSystem.Touch("./Object3d.PS.hlsl");
+    CHECK(SameRoots(hotReload.PollChangedRoots(), { pixelShader }));
+
+    // 同じPollの間に複数のファイルが変わっても、rootは重ならない
+    fileSystem.Touch(shared);
+    fileSystem.Touch(lighting);
+    fileSystem.Touch(pixelShader);
+    Paths roots = hotReload.PollChangedRoots();
+    CHECK(roots.size() == 2);
+    CHECK(SameRoots(roots, { vertexShader, pixelShader }));
+
+    // 消えたファイルと、また現れたファイルも変化として数える
+    fileSystem.Remove(lighting);
+    CHECK(SameRoots(hotReload.PollChangedRoots(), { pixelShader }));
+    CHECK(hotReload.PollChangedRoots().empty());
+    fileSystem.Touch(lighting);
+    CHECK(SameRoots(hotReload.PollChangedRoots(), { pixelShader }));
+
+    // includeを入れ替えると、外したファイルの変化では引かれない
+    hotReload.SetDependencies(pixelShader, { shared });
+    fileSystem.Touch(lighting);
+    CHECK(hotReload.PollChangedRoots().empty());
+    CHECK(SameRoots(hotReload.GetGraph().GetAffectedRoots(lighting), {}));
+    return TEST_RESULT();
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdio>
+
+/// <summary>
+/// テストで使う確認用のマクロ
+/// 失敗しても続けて全ての確認を行い、最後にTEST_RESULT()で失敗があったかをmainの戻り値にする
+/// </summary>
+namespace TestUtility {
+
+inline int& FailureCount()
+{
+    static int failureCount = 0;
+    return failureCount;
+}
+
+} // namespace TestUtility
+
+// condが偽なら場所と式を出して失敗を数える
+#define CHECK(cond)                                                                  \
+    do {                                                                             \
+        if (!(cond)) {                                                               \
+            std::printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond);     \
+            ++TestUtility::FailureCount();                                           \
+        }                                                                            \
+    } while (false)
+
+// mainの最後で返す。失敗がなければ0
+#define TEST_RESULT() (std::printf("%s\n", TestUtility::FailureCount() == 0 ? "OK" : "FAILED"), TestUtility::FailureCount() == 0 ? 0 : 1)
@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "AffineMatrix.h"
+#include "MatrixSimd.h"
+#include "SyntheticTransforms.h"
+#include "TestUtility.h"
+#include "TransformBatch.h"
+
+namespace {
+
+/// <summary>
+/// 1オブジェクトずつ計算したWorldとWVP。TransformBatch.cppのComputeTransformationMatrixと同じ式
+/// </summary>
+TransformationMatrix ComputeTransformationMatrixReference(const TransformSoA& transforms, size_t index, const Matrix4x4& viewProjection)
+{
+    AffineMatrix world = MakeAffineTransform(
+        { transforms.scaleX[index], transforms.scaleY[index], transforms.scaleZ[index] },
+        { transforms.rotateX[index], transforms.rotateY[index], transforms.rotateZ[index] },
+        { transforms.translateX[index], transforms.translateY[index], transforms.translateZ[index] });
+    return { Multiply(world, viewProjection), ToMatrix4x4(world) };
+}
+
+float MaxAbs(const Matrix4x4& matrix)
+{
+    float result = 0.0f;
+    for (int row = 0; row < 4; ++row) {
+        for (int column = 0; column < 4; ++column) {
+            result = (std::max)(result, std::fabs(matrix.m[row][column]));
+        }
+    }
+    return result;
+}
+
+/// <summary>
+/// 要素の差が、行列の最大の要素に対して相対toleranceより小さい
+/// </summary>
+bool IsNear(const Matrix4x4& actual, const Matrix4x4& expected, float tolerance)
+{
+    float limit = tolerance * (std::max)(MaxAbs(expected), 1.0f);
+    for (int row = 0; row < 4; ++row) {
+        for (int column = 0; column < 4; ++column) {
+            if (!(std::fabs(actual.m[row][column] - expected.m[row][column]) <= limit)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/// <summary>
+/// 今の命令セットとthreadCountで計算した全オブジェクトを、1個ずつの計算と比べる
+/// Scalarは同じ関数を呼ぶので完全に一致し、AVX2はsin/cosの多項式の分だけずれる
+/// </summary>
+void TestMatchesPerObject(const TransformSoA& transforms, const Matrix4x4& viewProjection, uint32_t threadCount)
+{
+    // 書かれなかった要素が分かるようにNaNで埋めておく
+    std::vector<TransformationMatrix> result(transforms.GetSize());
+    std::memset(result.data(), 0xFF, result.size() * sizeof(TransformationMatrix));
+    ComputeTransformationMatrices(transforms, viewProjection, result.data(), threadCount);
+
+    bool exact = GetSimdLevel() != SimdLevel::Avx2;
+    size_t mismatchCount = 0;
+    for (size_t i = 0; i < transforms.GetSize(); ++i) {
+        TransformationMatrix expected = ComputeTransformationMatrixReference(transforms, i, viewProjection);
+        bool same = exact ? std::memcmp(&result[i], &expected, sizeof(TransformationMatrix)) == 0
+                          : IsNear(result[i].World, expected.World, 2e-6f) && IsNear(result[i].WVP, expected.WVP, 2e-6f);
+        mismatchCount += same ? 0 : 1;
+    }
+    CHECK(mismatchCount == 0);
+}
+
+} // namespace
+
+int main()
+{
+    Matrix4x4 viewProjection = MakeSyntheticViewProjection();
+    // 8個ずつの端数が出る数と、スレッドに分けられる(1スレッドあたり16384個以上)数
+    TransformSoA small = MakeSyntheticTransforms(1003, 7);
+    TransformSoA large = MakeSyntheticTransforms(70001, 8);
+
+    const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::Avx2 };
+    for (SimdLevel level : levels) {
+        SetSimdLevel(level);
+        if (GetSimdLevel() != level) {
+            // このCPUにない命令セットは確かめられない
+            std::printf("%s: not supported, skipped\n", GetSimdLevelName(level));
+            continue;
+        }
+        std::printf("%s\n", GetSimdLevelName(level));
+        TestMatchesPerObject(small, viewProjection, 1);
+        TestMatchesPerObject(large, viewProjection, 1);
+        TestMatchesPerObject(large, viewProjection, 4);
+    }
+    return TEST_RESULT();
+}
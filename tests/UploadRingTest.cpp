@@ -0,0 +1,90 @@
+#include "TestUtility.h"
+#include "UploadRing.h"
+
+namespace {
+
+/// <summary>
+/// 切り出す位置は既定で256バイト境界に合い、指定した境界にも合う
+/// </summary>
+void TestAlignment()
+{
+    UploadRingAllocator ring;
+    ring.Initialize(4096);
+    CHECK(ring.Allocate(100) == 0);
+    CHECK(ring.Allocate(1) == 256);
+    CHECK(ring.Allocate(300) == 512);
+    CHECK(ring.Allocate(4, 16) == 816);
+    CHECK(ring.Allocate(4, 4) == 820);
+    CHECK(ring.GetFrameSize() == 824);
+    CHECK(ring.Allocate(0) == UploadRingAllocator::kInvalidOffset);
+    CHECK(ring.Allocate(4097) == UploadRingAllocator::kInvalidOffset);
+}
+
+/// <summary>
+/// 末尾に収まらなければ残りを飛ばして先頭から切り出す。飛ばした分も使用中として数え、そのフレームが終わるまで返らない
+/// </summary>
+void TestWrapAround()
+{
+    UploadRingAllocator ring;
+    ring.Initialize(1024);
+    CHECK(ring.Allocate(512) == 0);
+    ring.FinishFrame(1);
+    CHECK(ring.Allocate(256) == 512);
+    ring.FinishFrame(2);
+    ring.Retire(1);
+    CHECK(ring.GetUsedSize() == 256);
+
+    // 末尾の256バイトには512バイトが収まらないので、先頭から切り出す
+    CHECK(ring.Allocate(512) == 0);
+    CHECK(ring.GetFrameSize() == 256 + 512);
+    CHECK(ring.GetUsedSize() == 256 + 256 + 512);
+    ring.FinishFrame(3);
+    ring.Retire(3);
+    CHECK(ring.GetUsedSize() == 0);
+    CHECK(ring.Allocate(512) == 512);
+}
+
+/// <summary>
+/// GPUが使い終わっていない領域に重なる切り出しは断り、偽のSignal値がその領域の値に届いてから再利用する
+/// </summary>
+void TestInFlight()
+{
+    UploadRingAllocator ring;
+    ring.Initialize(1024);
+    CHECK(ring.Allocate(256) == 0);
+    CHECK(ring.Allocate(256) == 256);
+    ring.FinishFrame(10);
+    CHECK(ring.Allocate(512) == 512);
+    ring.FinishFrame(11);
+
+    // 満杯。フレーム10の領域はまだGPUが使っている
+    CHECK(ring.Allocate(256) == UploadRingAllocator::kInvalidOffset);
+    ring.Retire(9);
+    CHECK(ring.Allocate(256) == UploadRingAllocator::kInvalidOffset);
+
+    // フレーム10に届けばその512バイトだけ返る
+    ring.Retire(10);
+    CHECK(ring.GetUsedSize() == 512);
+    CHECK(ring.Allocate(512) == 0);
+    CHECK(ring.Allocate(256) == UploadRingAllocator::kInvalidOffset);
+    ring.FinishFrame(12);
+
+    // 閉じていないフレームは何もないので、FinishFrameは空のフレームを積まない
+    ring.FinishFrame(13);
+    ring.Retire(11);
+    CHECK(ring.GetUsedSize() == 512);
+    CHECK(ring.Allocate(512) == 512);
+    ring.FinishFrame(14);
+    ring.Retire(14);
+    CHECK(ring.GetUsedSize() == 0);
+}
+
+} // namespace
+
+int main()
+{
+    TestAlignment();
+    TestWrapAround();
+    TestInFlight();
+    return TEST_RESULT();
+}
@@ -0,0 +1,278 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "TestUtility.h"
+#include "VertexPacking.h"
+
+namespace {
+
+float BitsToFloat(uint32_t bits)
+{
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/// <summary>
+/// 倍精度の最近接偶数丸め(nearbyint)で求めたhalf。FloatToHalfとは別の手順で作る基準
+/// </summary>
+uint16_t FloatToHalfReference(float value)
+{
+    uint16_t sign = std::signbit(value) ? 0x8000 : 0;
+    double absolute = std::fabs(static_cast<double>(value));
+    if (std::isnan(value)) {
+        return sign | 0x7E00;
+    }
+    if (absolute < std::ldexp(1.0, -14)) {
+        // 非正規化数は2^-24単位。2^-14ちょうどに丸まれば正規化数の最小値と同じビットになる
+        return sign | static_cast<uint16_t>(std::nearbyint(absolute * std::ldexp(1.0, 24)));
+    }
+    int exponent = std::ilogb(absolute);
+    double mantissa = std::nearbyint((absolute / std::ldexp(1.0, exponent) - 1.0) * 1024.0);
+    if (mantissa == 1024.0) {
+        mantissa = 0.0;
+        ++exponent;
+    }
+    if (exponent + 15 >= 31) {
+        return sign | 0x7C00;
+    }
+    return sign | static_cast<uint16_t>(((exponent + 15) << 10) | static_cast<int>(mantissa));
+}
+
+/// <summary>
+/// valuesをテクスチャ座標に入れてEncodeVerticesを通し、SSE2で変換したhalfを取り出す
+/// 4個ずつと端数の両方を通るよう、uとvに別々の値を入れる
+/// </summary>
+std::vector<uint16_t> FloatToHalfSse2(const std::vector<float>& values)
+{
+    std::vector<VertexData> vertices((values.size() + 1) / 2);
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        vertices[i] = { { 0.0f, 0.0f, 0.0f, 1.0f }, { values[i * 2], i * 2 + 1 < values.size() ? values[i * 2 + 1] : 0.0f }, { 0.0f, 0.0f, 1.0f } };
+    }
+    std::vector<PackedVertex> packed(vertices.size());
+    AABB bounds = { { 0.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f } };
+    EncodeVertices(VertexFormat::PackedFloat3, vertices.data(), vertices.size(), bounds, packed.data());
+    std::vector<uint16_t> halves(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        halves[i] = packed[i / 2].texcoord[i % 2];
+    }
+    return halves;
+}
+
+bool IsHalfNan(uint16_t half)
+{
+    return (half & 0x7C00) == 0x7C00 && (half & 0x03FF) != 0;
+}
+
+/// <summary>
+/// 基準、FloatToHalf、SSE2の3つが一致するか確かめる。NaNは符号を残したquiet NaNであればよい
+/// </summary>
+void CheckHalfConversions(const std::vector<float>& values)
+{
+    std::vector<uint16_t> sse2 = FloatToHalfSse2(values);
+    size_t mismatchCount = 0;
+    for (size_t i = 0; i < values.size(); ++i) {
+        uint16_t expected = FloatToHalfReference(values[i]);
+        uint16_t scalar = FloatToHalf(values[i]);
+        bool same = scalar == expected && sse2[i] == expected;
+        if (!same && mismatchCount < 8) {
+            uint32_t bits;
+            std::memcpy(&bits, &values[i], sizeof(bits));
+            std::printf("0x%08X: reference 0x%04X, scalar 0x%04X, SSE2 0x%04X\n", bits, expected, scalar, sse2[i]);
+        }
+        mismatchCount += same ? 0 : 1;
+    }
+    CHECK(mismatchCount == 0);
+}
+
+void TestHalfSpecialValues()
+{
+    const float infinity = std::numeric_limits<float>::infinity();
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    std::vector<float> values = {
+        0.0f, -0.0f, 1.0f, -1.0f, 65504.0f, -65504.0f,
+        // Infと、halfの範囲を超えるもの。65520はhalfの最大値と次の間のちょうど真ん中で、偶数(Inf)に丸まる
+        infinity, -infinity, 65520.0f, 65519.996f, -65520.0f, 1.0e6f, FLT_MAX,
+        nan, -nan, BitsToFloat(0x7F800001u), BitsToFloat(0xFFC00000u), BitsToFloat(0x7FFFFFFFu),
+        // floatの非正規化数と、halfの非正規化数
+        FLT_TRUE_MIN, -FLT_TRUE_MIN, FLT_MIN, std::ldexp(1.0f, -24), std::ldexp(1.0f, -25), std::ldexp(3.0f, -26),
+        std::ldexp(1023.0f, -24), std::ldexp(1.0f, -14), std::ldexp(2047.0f, -25), std::ldexp(1.0f, -26),
+        // ちょうど真ん中の値は偶数に丸める
+        1.0f + std::ldexp(1.0f, -11), 1.0f + std::ldexp(3.0f, -11), 1.0f + std::ldexp(1.0f, -11) + std::ldexp(1.0f, -20),
+        std::ldexp(3.0f, -25), std::ldexp(5.0f, -25), 2048.0f + 1.0f, 2048.0f + 3.0f,
+    };
+    CheckHalfConversions(values);
+
+    // 特別な値の結果そのもの
+    CHECK(FloatToHalf(infinity) == 0x7C00);
+    CHECK(FloatToHalf(-infinity) == 0xFC00);
+    CHECK(IsHalfNan(FloatToHalf(nan)));
+    CHECK(FloatToHalf(65520.0f) == 0x7C00);
+    CHECK(FloatToHalf(65504.0f) == 0x7BFF);
+    CHECK(FloatToHalf(1.0f + std::ldexp(1.0f, -11)) == 0x3C00);
+    CHECK(FloatToHalf(1.0f + std::ldexp(3.0f, -11)) == 0x3C02);
+    CHECK(FloatToHalf(std::ldexp(1.0f, -25)) == 0x0000);
+    CHECK(FloatToHalf(std::ldexp(3.0f, -25)) == 0x0002);
+    CHECK(FloatToHalf(FLT_TRUE_MIN) == 0x0000);
+    CHECK(FloatToHalf(-FLT_TRUE_MIN) == 0x8000);
+}
+
+/// <summary>
+/// floatのビットを一定の間隔で全域から選んで比べる
+/// </summary>
+void TestHalfSweep()
+{
+    std::vector<float> values;
+    for (uint64_t bits = 0; bits <= 0xFFFFFFFFull; bits += 4099) {
+        values.push_back(BitsToFloat(static_cast<uint32_t>(bits)));
+    }
+    // halfの範囲にある値は仮数の下位13bitの境目を細かく調べる
+    for (uint32_t half = 0; half < 0x7C00; half += 7) {
+        uint32_t bits;
+        float value = HalfToFloat(static_cast<uint16_t>(half));
+        std::memcpy(&bits, &value, sizeof(bits));
+        for (uint32_t offset : { 0x0FFFu, 0x1000u, 0x1001u, 0x1FFFu }) {
+            values.push_back(BitsToFloat(bits + offset));
+        }
+    }
+    CheckHalfConversions(values);
+}
+
+/// <summary>
+/// 全てのhalfは、floatにしてから戻すと同じビットになる
+/// </summary>
+void TestHalfRoundTrip()
+{
+    size_t mismatchCount = 0;
+    for (uint32_t half = 0; half <= 0xFFFF; ++half) {
+        float value = HalfToFloat(static_cast<uint16_t>(half));
+        if (IsHalfNan(static_cast<uint16_t>(half))) {
+            mismatchCount += std::isnan(value) ? 0 : 1;
+        } else {
+            mismatchCount += FloatToHalf(value) == half ? 0 : 1;
+        }
+    }
+    CHECK(mismatchCount == 0);
+}
+
+/// <summary>
+/// 大きさrangeの箱に散らばった頂点。テクスチャ座標は0~maxTexcoord、法線は全方向と軸の向き
+/// </summary>
+ModelData MakeModel(float range, float maxTexcoord, uint32_t seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> position(0.0f, range);
+    std::uniform_real_distribution<float> texcoord(0.0f, maxTexcoord);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    ModelData model;
+    const Vector3 axisNormals[] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 }, { 0.6f, 0.0f, -0.8f }, { 0.0f, -0.6f, -0.8f } };
+    for (const Vector3& axisNormal : axisNormals) {
+        model.vertices.push_back({ { 0.0f, 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f }, axisNormal });
+    }
+    for (int i = 0; i < 10001; ++i) {
+        Vector3 n = { normal(random), normal(random), normal(random) };
+        float length = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+        model.vertices.push_back({ { position(random), position(random), position(random), 1.0f }, { texcoord(random), texcoord(random) }, { n.x / length, n.y / length, n.z / length } });
+    }
+    // 箱の角を必ず含める
+    model.vertices.push_back({ { range, range, range, 1.0f }, { maxTexcoord, maxTexcoord }, { 0.0f, 0.0f, 1.0f } });
+    model.bounds = { { 0.0f, 0.0f, 0.0f }, { range, range, range } };
+    return model;
+}
+
+/// <summary>
+/// 倍精度で求めた、符号化して戻したときの最大の誤差
+/// </summary>
+struct EncodingErrorD {
+    double position;
+    double texcoord;
+    double normalAngle;
+};
+
+EncodingErrorD MeasureError(VertexFormat format, const ModelData& model)
+{
+    uint32_t stride = GetVertexStride(format);
+    std::vector<uint8_t> encoded(static_cast<size_t>(stride) * model.vertices.size());
+    EncodeVertices(format, model.vertices.data(), model.vertices.size(), model.bounds, encoded.data());
+    EncodingErrorD error{};
+    for (size_t i = 0; i < model.vertices.size(); ++i) {
+        const VertexData& original = model.vertices[i];
+        VertexData decoded = DecodeVertex(format, encoded.data() + stride * i, model.bounds);
+        error.position = (std::max)({ error.position,
+            std::fabs(static_cast<double>(decoded.position.x) - original.position.x),
+            std::fabs(static_cast<double>(decoded.position.y) - original.position.y),
+            std::fabs(static_cast<double>(decoded.position.z) - original.position.z) });
+        error.texcoord = (std::max)({ error.texcoord,
+            std::fabs(static_cast<double>(decoded.texcoord.x) - original.texcoord.x),
+            std::fabs(static_cast<double>(decoded.texcoord.y) - original.texcoord.y) });
+        // 小さい角度でも桁落ちしないよう、外積の大きさと内積から求める
+        double ax = original.normal.x, ay = original.normal.y, az = original.normal.z;
+        double bx = decoded.normal.x, by = decoded.normal.y, bz = decoded.normal.z;
+        double cx = ay * bz - az * by, cy = az * bx - ax * bz, cz = ax * by - ay * bx;
+        double angle = std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), ax * bx + ay * by + az * bz);
+        error.normalAngle = (std::max)(error.normalAngle, angle);
+    }
+    return error;
+}
+
+void TestFormatErrorBounds()
+{
+    VertexFormatSettings settings;
+    // 八面体のsnorm16は、1目盛りの半分のずれが球の上で最も広がる所でも1e-4ラジアンに収まる
+    constexpr double kMaxNormalAngle = 1e-4;
+
+    // 小さいモデルは位置を量子化する。誤差は最も長い辺の1/65535の半分と、戻すときのfloatの丸め
+    {
+        ModelData model = MakeModel(10.0f, 1.0f, 1);
+        CHECK(SelectVertexFormat(model, settings) == VertexFormat::PackedQuantized);
+        EncodingErrorD error = MeasureError(VertexFormat::PackedQuantized, model);
+        double positionBound = 10.0 / 65535.0 * 0.5 + 10.0 * 4.0 * FLT_EPSILON;
+        CHECK(error.position <= positionBound);
+        CHECK(error.position <= settings.maxPositionError);
+        CHECK(error.texcoord <= std::ldexp(0.5, std::ilogb(1.0f) - 10));
+        CHECK(error.normalAngle <= kMaxNormalAngle);
+        std::printf("PackedQuantized : position %.3g (bound %.3g), texcoord %.3g, normal %.3g rad\n", error.position, positionBound, error.texcoord, error.normalAngle);
+    }
+    // 量子化すると誤差が大きすぎるモデルは位置をfloatのまま持つ
+    {
+        ModelData model = MakeModel(100.0f, 1.0f, 2);
+        CHECK(SelectVertexFormat(model, settings) == VertexFormat::PackedFloat3);
+        EncodingErrorD error = MeasureError(VertexFormat::PackedFloat3, model);
+        CHECK(error.position == 0.0);
+        CHECK(error.texcoord <= std::ldexp(0.5, std::ilogb(1.0f) - 10));
+        CHECK(error.texcoord <= settings.maxTexcoordError);
+        CHECK(error.normalAngle <= kMaxNormalAngle);
+        std::printf("PackedFloat3 : texcoord %.3g, normal %.3g rad\n", error.texcoord, error.normalAngle);
+    }
+    // halfでテクスチャ座標の誤差が大きすぎるモデルは元の形式のまま。誤差はない
+    {
+        ModelData model = MakeModel(10.0f, 8.0f, 3);
+        CHECK(SelectVertexFormat(model, settings) == VertexFormat::Float);
+        EncodingErrorD error = MeasureError(VertexFormat::Float, model);
+        CHECK(error.position == 0.0 && error.texcoord == 0.0 && error.normalAngle == 0.0);
+    }
+    // 圧縮しない設定なら常に元の形式
+    {
+        ModelData model = MakeModel(10.0f, 1.0f, 4);
+        VertexFormatSettings noPacking;
+        noPacking.allowPacking = false;
+        CHECK(SelectVertexFormat(model, noPacking) == VertexFormat::Float);
+    }
+}
+
+} // namespace
+
+int main()
+{
+    TestHalfSpecialValues();
+    TestHalfSweep();
+    TestHalfRoundTrip();
+    TestFormatErrorBounds();
+    return TEST_RESULT();
+}